@@ -0,0 +1,50 @@
+// Arcade.ino
+//
+// Tetris and Breakout in one firmware image: a menu picks the game, and
+// both share the strip, the input and the frame clock (Arcade.h). Each
+// game is compiled from its own folder by one .cpp here, so build with
+// the Games folder on the include path:
+//
+//   arduino-cli compile --build-property "compiler.cpp.extra_flags=-I<sketchbook>/Games" Games/Arcade
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include <PixelGridCore.h>
+
+#include "Pins.h"
+
+// Hardware objects
+Adafruit_NeoPixel strip(PIXEL_BUFFER_SIZE, PIN_LED, NEO_GRB + NEO_KHZ800);
+GameInput input;
+Cabinet cabinet;
+
+Arcade arcade;
+HostRuntime hostRuntime;
+
+void setup() {
+  randomSeed(analogRead(A0));
+  Serial.begin(HOST_DEFAULT_BAUD); // the host may negotiate a faster rate (PBBR)
+
+  // In the host input byte order (Arcade.h)
+  static const uint8_t pins[] = { PIN_BTN1, PIN_BTN2, PIN_BTN3, PIN_JOY_UP,
+                                  PIN_JOY_DOWN, PIN_JOY_LEFT, PIN_JOY_RIGHT, PIN_BTN4 };
+  input.begin(pins, sizeof(pins), DEBOUNCE_MS);
+  cabinet.begin(strip, input, W, MATRIX_ROWS);
+  hostRuntime.begin(cabinet.strip, cabinet.grid, cabinet.lcd, W, MATRIX_ROWS);
+
+  // The games registered themselves (Breakout.cpp, Tetris.cpp) before setup()
+  arcade.begin(cabinet, millis());
+}
+
+void loop() {
+  switch (hostRuntime.step(input)) {
+    case HOST_STEP_HOST:
+      return;
+    case HOST_STEP_TIMED_OUT:
+      // The host went away: back to the menu or the game it interrupted
+      arcade.resume(millis());
+      return;
+    case HOST_STEP_GAME:
+      break;
+  }
+  arcade.loop(millis());
+}
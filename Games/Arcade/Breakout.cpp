@@ -0,0 +1,9 @@
+// Breakout.cpp
+// Breakout's sources, compiled here against its own Pins.h (Breakout/)
+#include <Breakout/Game.cpp>
+#include <Breakout/Input.cpp>
+#include <Breakout/Render.cpp>
+#include <Breakout/BreakoutArcade.h>
+
+static BreakoutArcade breakoutArcade;
+PIXELGRID_REGISTER_GAME(breakoutArcade);
@@ -0,0 +1,31 @@
+// Pins.h
+#pragma once
+#include <Arduino.h>
+
+// =====================
+// Cabinet pinout, shared by every game in the image
+// =====================
+#define PIXEL_BUFFER_SIZE 256
+
+#define PIN_LED 5
+
+// Buttons. BTN4 is on 12 as in Tetris; the Breakout sketch has it on 11
+#define PIN_BTN1 3
+#define PIN_BTN2 4
+#define PIN_BTN3 10
+#define PIN_BTN4 12
+
+// Joystick
+#define PIN_JOY_UP 6
+#define PIN_JOY_LEFT 7
+#define PIN_JOY_RIGHT 8
+#define PIN_JOY_DOWN 9
+
+// =====================
+// Grid dimensions
+// =====================
+static const uint8_t W = 10;
+static const uint8_t MATRIX_ROWS = 20;
+
+// Debounce
+static const uint16_t DEBOUNCE_MS = 18;
@@ -0,0 +1,6 @@
+// Tetris.cpp
+// Tetris's game and renderer, compiled here against its own Pins.h (Tetris/)
+#include <Tetris/TetrisArcade.h>
+
+static TetrisArcade tetrisArcade;
+PIXELGRID_REGISTER_GAME(tetrisArcade);
@@ -8,16 +8,42 @@
 #include "Game.h"
 #include "Render.h"
 
+// Hardware objects
+Adafruit_NeoPixel strip(PIXEL_BUFFER_SIZE, PIN_LED, NEO_GRB + NEO_KHZ800);
+GameInput input;
+Cabinet cabinet;
+
+HostRuntime hostRuntime;
+
 void setup() {
   randomSeed(analogRead(A0));
-  Serial.begin(115200);
+  Serial.begin(HOST_DEFAULT_BAUD); // the host may negotiate a faster rate (PBBR)
 
-  Render_begin();
-  Input_begin();
-  Game_reset();
+  Input_beginPins(input);
+  cabinet.begin(strip, input, W, MATRIX_ROWS);
+  Render_begin(cabinet);
+  Input_begin(input);
+  hostRuntime.begin(cabinet.strip, cabinet.grid, cabinet.lcd, W, MATRIX_ROWS);
+  game.seed((uint32_t)random(1, 0x7FFFFFFF));
+  game.reset(millis());
 }
 
 void loop() {
+  // Every pass, not just on frames: the host's bytes are parsed as they
+  // come, and while it is driving the display the game waits
+  switch (hostRuntime.step(input)) {
+    case HOST_STEP_HOST:
+      return;
+    case HOST_STEP_TIMED_OUT:
+      // The host went away: a fresh game for whoever is at the cabinet
+      game.reset(millis());
+      Render_resetDigits();
+      Render_renderFrame();
+      return;
+    case HOST_STEP_GAME:
+      break;
+  }
+
   static uint32_t tFrame = 0;
   uint32_t now = millis();
   if (now - tFrame < FRAME_MS) return;
@@ -29,42 +55,23 @@ void loop() {
   // Any button serves or restarts (edge)
   bool servePressed = Input_servePressedEdge();
 
-  if (Game_isOver()) {
-    if (servePressed) Game_reset();
+  if (game.isOver()) {
+    if (servePressed) game.reset(now);
     Render_renderFrame();
     Input_latch();
     return;
   }
 
-  // Bricks drop every 15 seconds
-  if (now - tBrickDrop >= BRICK_DROP_MS) {
-    tBrickDrop = now;
-    Game_brickDropTick();
-    if (Game_isOver()) {
-      Render_renderFrame();
-      Input_latch();
-      return;
-    }
-  }
-
-  // Joystick movement (left/right only, with repeat)
+  // Joystick movement (left/right only, with repeat; may be several cells)
   int8_t step = Input_paddleStepFromJoystickRepeat(now);
-  if (step != 0) Game_movePaddle(step);
+  if (step != 0) game.movePaddle(step);
 
   // Serve ball on any button press
-  if (servePressed) Game_serveBall();
+  if (servePressed) game.serveBall();
 
-  // Ball update
-  if (!ballStuck) {
-    if (now - tBall >= ballStepMs) {
-      tBall = now;
-      Game_stepBallOnce();
-    }
-  } else {
-    // Keep ball glued to paddle (same as original)
-    ballX = (int8_t)(paddleX + (PADDLE_W / 2));
-    ballY = (int8_t)(PADDLE_Y - 1);
-  }
+  // Bricks drop every BRICK_DROP_MS, then balls and power-ups move one
+  // frame (the ball rides the paddle until served)
+  game.update(now);
 
   Render_renderFrame();
 
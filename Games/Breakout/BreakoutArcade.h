@@ -0,0 +1,55 @@
+// BreakoutArcade.h
+#pragma once
+#include <Arduino.h>
+#include <PixelGridCore.h>
+#include "Pins.h"
+#include "Input.h"
+#include "Game.h"
+#include "Render.h"
+
+// Breakout as a Game for the arcade image (Games/Arcade): the same frame as
+// Breakout.ino, except that a button on the game-over screen goes back to
+// the menu instead of starting again. Plays the global game (Game.cpp).
+class BreakoutArcade : public Game {
+public:
+  const char* name() const override { return "BREAKOUT"; }
+  uint16_t frameMs() const override { return FRAME_MS; }
+
+  void begin(Cabinet& cabinet) override {
+    Render_begin(cabinet);
+    Input_begin(*cabinet.input);
+  }
+
+  void reset(uint32_t nowMs) override {
+    done_ = false;
+    if (!seeded_) {
+      game.seed((uint32_t)random(1, 0x7FFFFFFF));
+      seeded_ = true;
+    }
+    game.reset(nowMs);
+    Render_resetDigits();
+  }
+
+  void update(uint32_t nowMs) override {
+    bool servePressed = Input_servePressedEdge();
+    if (game.isOver()) {
+      done_ = servePressed;
+      return;
+    }
+    int8_t step = Input_paddleStepFromJoystickRepeat(nowMs);
+    if (step != 0) game.movePaddle(step);
+    if (servePressed) game.serveBall();
+    game.update(nowMs);
+  }
+
+  void render() override { Render_renderFrame(); }
+
+  bool finished() const override { return done_; }
+
+  uint16_t serialize(uint8_t* out, uint16_t cap) const override { return gameSaveState(game, out, cap); }
+  bool deserialize(const uint8_t* in, uint16_t len) override { return gameLoadState(game, in, len); }
+
+private:
+  bool seeded_ = false;
+  bool done_ = false;
+};
@@ -0,0 +1,44 @@
+// Entities.h
+#pragma once
+#include <Arduino.h>
+
+// A fixed number of moving things of one kind (balls, falling power-ups),
+// one array per field so a frame's update walks each field in order. Live
+// entries are packed at the front: [0, count). remove() moves the last one
+// into the gap, so indices aren't stable across a removal.
+template <uint8_t N>
+struct EntityPool {
+  // Q8.8 cells, velocity per frame
+  int16_t x[N];
+  int16_t y[N];
+  int16_t vx[N];
+  int16_t vy[N];
+  uint8_t kind[N];  // what the entity is, for pools that mix kinds
+  uint8_t count = 0;
+
+  static const uint8_t CAPACITY = N;
+
+  // Index of the new entity, or N when the pool is full
+  uint8_t add(int16_t px, int16_t py, int16_t pvx, int16_t pvy, uint8_t k = 0) {
+    if (count == N) return N;
+    uint8_t i = count++;
+    x[i] = px;
+    y[i] = py;
+    vx[i] = pvx;
+    vy[i] = pvy;
+    kind[i] = k;
+    return i;
+  }
+
+  void remove(uint8_t i) {
+    uint8_t last = --count;
+    if (i == last) return;
+    x[i] = x[last];
+    y[i] = y[last];
+    vx[i] = vx[last];
+    vy[i] = vy[last];
+    kind[i] = kind[last];
+  }
+
+  void clear() { count = 0; }
+};
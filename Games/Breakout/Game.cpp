@@ -1,200 +1,321 @@
 // Game.cpp
 #include "Game.h"
-#include "Render.h"
 
-// State
-uint32_t bricksGrid[BRICK_H][W];
+BreakoutGame game;
 
-int8_t paddleX = 3;
-bool ballStuck = true;
-int8_t ballX = 0;
-int8_t ballY = 0;
-int8_t ballVX = 1;
-int8_t ballVY = -1;
+// Directions off the paddle, outer edge to outer edge: 60, 45, 30 and 15
+// degrees from vertical, as Q8.8 unit vectors (x, upward y)
+static const uint8_t BOUNCE_DIRS = 8;
+static const int16_t BOUNCE_DX[BOUNCE_DIRS] = { -222, -181, -128, -66, 66, 128, 181, 222 };
+static const int16_t BOUNCE_UP[BOUNCE_DIRS] = { 128, 181, 222, 247, 247, 222, 181, 128 };
+static const int16_t DIAGONAL = 181;
 
-uint32_t score = 0;
-bool gameOver = false;
+// Cell edges the ball may cross in one frame; more than the cap speed needs
+static const uint8_t BALL_MAX_CROSSINGS = 8;
 
-uint16_t ballStepMs = BALL_STEP_MS;
-uint32_t tBall = 0;
-uint32_t tBrickDrop = 0;
-uint16_t bricksHit = 0;
+// Distance along one axis to where the ball is in the next cell: the far
+// edge moving right/down, one unit past the near edge moving left/up
+static int16_t edgeDistance(int16_t p, int16_t v) {
+  int16_t cellStart = (int16_t)(p & ~(BALL_ONE - 1));
+  return v > 0 ? (int16_t)(cellStart + BALL_ONE - p) : (int16_t)(p - cellStart + 1);
+}
 
-uint8_t wheelPos = 0;
+// xorshift32; 0..n-1
+uint32_t BreakoutGame::nextRandom(uint32_t n) {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng % n;
+}
 
 // ---------- Brick helpers ----------
-static void clearBricks() {
+void BreakoutGame::clearBricks() {
   for (uint8_t y = 0; y < BRICK_H; ++y) {
-    for (uint8_t x = 0; x < W; ++x) bricksGrid[y][x] = 0;
+    brickRows[y] = 0;
+    brickRowWheel[y] = 0;
   }
 }
 
-static void generateBrickRowAt(uint8_t row, uint32_t c) {
+// A full row in the next wheel colour
+void BreakoutGame::generateBrickRowAt(uint8_t row) {
   if (row >= BRICK_H) return;
-  for (uint8_t x = 0; x < W; ++x) bricksGrid[row][x] = c;
+  brickRows[row] = BRICK_ROW_FULL;
+  brickRowWheel[row] = wheelPos;
+  wheelPos = (uint8_t)(wheelPos + COLOR_STEP);
 }
 
-static void fillInitialBricks() {
+void BreakoutGame::fillInitialBricks() {
   clearBricks();
-  for (uint8_t y = 0; y < INITIAL_FILLED_ROWS; ++y) {
-    uint32_t c = Render_wheelColor(wheelPos);
-    wheelPos = (uint8_t)(wheelPos + COLOR_STEP);
-    generateBrickRowAt(y, c);
+  for (uint8_t y = 0; y < INITIAL_FILLED_ROWS; ++y) generateBrickRowAt(y);
+}
+
+// Rescales every ball's velocity, keeping its direction
+void BreakoutGame::setBallSpeed(uint16_t speed) {
+  for (uint8_t i = 0; i < balls.count; ++i) {
+    balls.vx[i] = (int16_t)((int32_t)balls.vx[i] * speed / ballSpeed);
+    balls.vy[i] = (int16_t)((int32_t)balls.vy[i] * speed / ballSpeed);
   }
+  ballSpeed = speed;
 }
 
-static bool hitBrickAt(int8_t x, int8_t y) {
+bool BreakoutGame::hitBrickAt(int8_t x, int8_t y) {
   if (x < 0 || x >= (int8_t)W) return false;
-  if (y < (int8_t)BRICK_TOP || y > (int8_t)BRICK_BOTTOM) return false;
-
-  uint32_t v = bricksGrid[(uint8_t)y][(uint8_t)x];
-  if (v == 0) return false;
+  if (!brickAt(x, y)) return false;
 
-  bricksGrid[(uint8_t)y][(uint8_t)x] = 0;
+  brickRows[(uint8_t)y] &= (uint16_t)~(1u << x);
 
   score += 10UL;
   bricksHit++;
 
-  if (bricksHit % BALL_SPEEDUP_EVERY == 0) {
-    if (ballStepMs > BALL_STEP_MIN_MS) {
-      ballStepMs = (uint16_t)max((int)BALL_STEP_MIN_MS, (int)ballStepMs - 6);
-    }
+  if (speedupEvery && bricksHit % speedupEvery == 0 && ballSpeed < BALL_SPEED_MAX) {
+    uint16_t faster = (uint16_t)(ballSpeed + BALL_SPEEDUP);
+    setBallSpeed(faster < BALL_SPEED_MAX ? faster : BALL_SPEED_MAX);
   }
 
-  Render_updateScoreDigits(score);
+  if (nextRandom(POWERUP_ONE_IN) == 0) {
+    uint8_t kind = (uint8_t)nextRandom(POWERUP_KINDS);
+    powerUps.add((int16_t)(x * BALL_ONE + BALL_ONE / 2), (int16_t)(y * BALL_ONE + BALL_ONE / 2), 0, POWERUP_FALL, kind);
+  }
   return true;
 }
 
 // ---------- Ball / Paddle helpers ----------
-static void clampPaddle() {
+void BreakoutGame::clampPaddle() {
   if (paddleX < 0) paddleX = 0;
-  if (paddleX > (int8_t)(W - PADDLE_W)) paddleX = (int8_t)(W - PADDLE_W);
+  if (paddleX > (int8_t)(W - paddleW)) paddleX = (int8_t)(W - paddleW);
+}
+
+// Grows or shrinks the paddle about its middle
+void BreakoutGame::setPaddleWidth(uint8_t w) {
+  paddleX = (int8_t)(paddleX + (paddleW - w) / 2);
+  paddleW = w;
+  clampPaddle();
+}
+
+void BreakoutGame::aimBall(uint8_t i, int16_t ux, int16_t uy) {
+  balls.vx[i] = (int16_t)((int32_t)ux * ballSpeed / BALL_ONE);
+  balls.vy[i] = (int16_t)((int32_t)uy * ballSpeed / BALL_ONE);
+}
+
+void BreakoutGame::glueBallToPaddle() {
+  balls.x[0] = (int16_t)((paddleX + (paddleW / 2)) * BALL_ONE + BALL_ONE / 2);
+  balls.y[0] = (int16_t)((PADDLE_Y - 1) * BALL_ONE + BALL_ONE / 2);
 }
 
-static void resetBallOnPaddle() {
+void BreakoutGame::resetBallOnPaddle() {
   ballStuck = true;
-  ballVX = (random(0, 2) == 0) ? -1 : 1;
-  ballVY = -1;
+  balls.clear();
+  balls.add(0, 0, 0, 0);
+  aimBall(0, nextRandom(2) == 0 ? -DIAGONAL : DIAGONAL, -DIAGONAL);
+  glueBallToPaddle();
+}
+
+// The further from the middle of the paddle, the flatter the ball leaves
+void BreakoutGame::bounceOffPaddle(uint8_t b) {
+  int16_t span = (int16_t)(paddleW * BALL_ONE);
+  int16_t along = (int16_t)(balls.x[b] - paddleX * BALL_ONE);
+  int16_t i = (int16_t)((int32_t)along * BOUNCE_DIRS / span);
+  if (i < 0) i = 0;
+  if (i >= BOUNCE_DIRS) i = BOUNCE_DIRS - 1;
+  aimBall(b, BOUNCE_DX[i], (int16_t)-BOUNCE_UP[i]);
+}
+
+BreakoutGame::BallCell BreakoutGame::ballCell(int8_t x, int8_t y) const {
+  if (x < 0 || x >= (int8_t)W || y < 0) return CELL_WALL;
+  if (brickAt(x, y)) return CELL_BRICK;
+  if (y == (int8_t)PADDLE_Y && onPaddle(x)) return CELL_PADDLE;
+  return CELL_OPEN;
+}
+
+// One frame of movement for ball i. False once it has gone past the paddle.
+bool BreakoutGame::stepBall(uint8_t i) {
+  int16_t& bx = balls.x[i];
+  int16_t& by = balls.y[i];
+  int16_t& bvx = balls.vx[i];
+  int16_t& bvy = balls.vy[i];
+
+  // This frame's move, walked one cell edge at a time (a DDA over the
+  // grid): whatever is in the next cell reflects the axis that crossed
+  // into it, so no speed can carry the ball through a brick.
+  int16_t mx = bvx;
+  int16_t my = bvy;
+  for (uint8_t n = 0; n < BALL_MAX_CROSSINGS && (mx != 0 || my != 0); ++n) {
+    int16_t ax = (int16_t)abs(mx);
+    int16_t ay = (int16_t)abs(my);
+    int16_t ex = mx ? edgeDistance(bx, mx) : INT16_MAX;
+    int16_t ey = my ? edgeDistance(by, my) : INT16_MAX;
+    bool crossX = ex <= ax;
+    bool crossY = ey <= ay;
+    if (!crossX && !crossY) {
+      bx += mx;
+      by += my;
+      break;
+    }
+
+    // Which edge comes first: ex/ax against ey/ay. A tie is the corner.
+    int32_t tx = crossX ? (int32_t)ex * ay : INT32_MAX;
+    int32_t ty = crossY ? (int32_t)ey * ax : INT32_MAX;
+    bool hitX = tx <= ty;
+    bool hitY = ty <= tx;
+
+    int8_t cx = (int8_t)(bx >> BALL_FRAC_BITS);
+    int8_t cy = (int8_t)(by >> BALL_FRAC_BITS);
+    int8_t sx = mx > 0 ? 1 : -1;
+    int8_t sy = my > 0 ? 1 : -1;
+
+    int16_t dx = hitX ? (int16_t)(sx * ex) : (int16_t)((int32_t)mx * ey / ay);
+    int16_t dy = hitY ? (int16_t)(sy * ey) : (int16_t)((int32_t)my * ex / ax);
+
+    BallCell cellX = hitX ? ballCell((int8_t)(cx + sx), cy) : CELL_OPEN;
+    BallCell cellY = hitY ? ballCell(cx, (int8_t)(cy + sy)) : CELL_OPEN;
+    bool bounceX = cellX != CELL_OPEN;
+    bool bounceY = cellY != CELL_OPEN;
+    if (hitX && hitY && !bounceX && !bounceY) {
+      // Through the corner, only the diagonal cell can be in the way
+      BallCell cellD = ballCell((int8_t)(cx + sx), (int8_t)(cy + sy));
+      if (cellD == CELL_PADDLE) {
+        cellY = cellD;
+        bounceY = true;
+      } else if (cellD != CELL_OPEN) {
+        bounceX = bounceY = true;
+        if (cellD == CELL_BRICK) hitBrickAt((int8_t)(cx + sx), (int8_t)(cy + sy));
+      }
+    }
+    if (cellX == CELL_BRICK) hitBrickAt((int8_t)(cx + sx), cy);
+    if (cellY == CELL_BRICK) hitBrickAt(cx, (int8_t)(cy + sy));
+
+    bx += dx;
+    by += dy;
+    mx -= dx;
+    my -= dy;
+
+    // A bounce leaves the ball on its side of the edge
+    if (bounceX) {
+      bx -= sx;
+      mx = (int16_t)-mx;
+      bvx = (int16_t)-bvx;
+    }
+    if (cellY == CELL_PADDLE && sy > 0) {
+      by -= sy;
+      // The rest of the move goes the new way, at the same share of the frame
+      int16_t left = my;
+      bounceOffPaddle(i);
+      mx = (int16_t)((int32_t)bvx * left / ay);
+      my = (int16_t)((int32_t)bvy * left / ay);
+    } else if (bounceY) {
+      by -= sy;
+      my = (int16_t)-my;
+      bvy = (int16_t)-bvy;
+    }
+  }
 
-  ballX = (int8_t)(paddleX + (PADDLE_W / 2));
-  ballY = (int8_t)(PADDLE_Y - 1);
+  return (by >> BALL_FRAC_BITS) <= (int8_t)PADDLE_Y;
+}
 
-  tBall = millis();
+// ---------- Power-ups ----------
+void BreakoutGame::applyPowerUp(uint8_t kind) {
+  switch (kind) {
+    case POWERUP_WIDE:
+      setPaddleWidth(PADDLE_W_WIDE);
+      widePaddleFrames = WIDE_PADDLE_FRAMES;
+      break;
+    case POWERUP_SLOW:
+      setBallSpeed(ballSpeed > BALL_SPEED + BALL_SLOWDOWN ? (uint16_t)(ballSpeed - BALL_SLOWDOWN) : BALL_SPEED);
+      break;
+    case POWERUP_MULTI: {
+      // Each ball in play gains a twin heading the other way across
+      uint8_t n = balls.count;
+      for (uint8_t i = 0; i < n; ++i) {
+        balls.add(balls.x[i], balls.y[i], (int16_t)-balls.vx[i], balls.vy[i]);
+      }
+      break;
+    }
+  }
 }
 
-void Game_movePaddle(int8_t dx) {
+// One frame of fall for power-up i. False once it is caught or lost.
+bool BreakoutGame::stepPowerUp(uint8_t i) {
+  powerUps.y[i] += powerUps.vy[i];
+  int8_t cy = (int8_t)(powerUps.y[i] >> BALL_FRAC_BITS);
+  if (cy < (int8_t)PADDLE_Y) return true;
+  if (cy == (int8_t)PADDLE_Y && !onPaddle((int8_t)(powerUps.x[i] >> BALL_FRAC_BITS))) return true;
+  if (cy == (int8_t)PADDLE_Y) applyPowerUp(powerUps.kind[i]);
+  return false;
+}
+
+// ---------- Game ----------
+void BreakoutGame::movePaddle(int8_t dx) {
   paddleX += dx;
   clampPaddle();
-  if (ballStuck) {
-    ballX = (int8_t)(paddleX + (PADDLE_W / 2));
-    ballY = (int8_t)(PADDLE_Y - 1);
-  }
+  if (ballStuck) glueBallToPaddle();
 }
 
-void Game_serveBall() {
+void BreakoutGame::serveBall() {
   if (!ballStuck) return;
   ballStuck = false;
-  tBall = millis();
 }
 
-void Game_reset() {
+void BreakoutGame::reset(uint32_t nowMs) {
   score = 0;
   gameOver = false;
 
+  paddleW = PADDLE_W;
+  widePaddleFrames = 0;
   paddleX = (W - PADDLE_W) / 2;
 
-  ballStepMs = BALL_STEP_MS;
+  ballSpeed = BALL_SPEED;
   bricksHit = 0;
 
   wheelPos = 0;
   fillInitialBricks();
 
-  Render_updateScoreDigits(score);
+  powerUps.clear();
   resetBallOnPaddle();
 
-  tBrickDrop = millis();
+  tBrickDrop = nowMs;
 }
 
-void Game_brickDropTick() {
+void BreakoutGame::update(uint32_t nowMs) {
+  if (nowMs - tBrickDrop >= brickDropMs) {
+    tBrickDrop = nowMs;
+    brickDropTick();
+    if (gameOver) return;
+  }
+  stepFrame();
+}
+
+void BreakoutGame::brickDropTick() {
   // If bottom brick row already occupied, next shift would push into paddle lane -> game over.
-  for (uint8_t x = 0; x < W; ++x) {
-    if (bricksGrid[BRICK_BOTTOM][x] != 0) {
-      gameOver = true;
-      return;
-    }
+  if (brickRows[BRICK_BOTTOM] != 0) {
+    gameOver = true;
+    return;
   }
 
   // Shift down
-  for (int8_t y = (int8_t)BRICK_BOTTOM; y > (int8_t)BRICK_TOP; --y) {
-    for (uint8_t x = 0; x < W; ++x) {
-      bricksGrid[(uint8_t)y][x] = bricksGrid[(uint8_t)(y - 1)][x];
-    }
+  for (uint8_t y = BRICK_BOTTOM; y > BRICK_TOP; --y) {
+    brickRows[y] = brickRows[y - 1];
+    brickRowWheel[y] = brickRowWheel[y - 1];
   }
 
   // New top row
-  uint32_t c = Render_wheelColor(wheelPos);
-  wheelPos = (uint8_t)(wheelPos + COLOR_STEP);
-  generateBrickRowAt(BRICK_TOP, c);
+  generateBrickRowAt(BRICK_TOP);
 }
 
-void Game_stepBallOnce() {
+void BreakoutGame::stepFrame() {
   if (ballStuck) return;
 
-  int8_t nx = (int8_t)(ballX + ballVX);
-  int8_t ny = (int8_t)(ballY + ballVY);
-
-  // side bounds bounce (no drawn walls)
-  if (nx < 0) {
-    nx = 0;
-    ballVX = 1;
-  } else if (nx >= (int8_t)W) {
-    nx = (int8_t)(W - 1);
-    ballVX = -1;
-  }
-
-  // top bounce
-  if (ny < 0) {
-    ny = 0;
-    ballVY = 1;
-  }
-
-  // brick collision
-  if (hitBrickAt(nx, ny)) {
-    ballVY = (int8_t)(-ballVY);
-    ny = (int8_t)(ballY + ballVY);
-  } else {
-    if (hitBrickAt(nx, ballY)) {
-      ballVX = (int8_t)(-ballVX);
-      nx = (int8_t)(ballX + ballVX);
-    } else if (hitBrickAt(ballX, ny)) {
-      ballVY = (int8_t)(-ballVY);
-      ny = (int8_t)(ballY + ballVY);
-    }
+  // Each pool in one pass; a removal moves the last entry into slot i
+  for (uint8_t i = 0; i < balls.count;) {
+    if (stepBall(i)) ++i;
+    else balls.remove(i);
   }
-
-  // paddle collision
-  if (ny == (int8_t)PADDLE_Y && ballVY > 0) {
-    if (nx >= paddleX && nx < paddleX + (int8_t)PADDLE_W) {
-      ballVY = -1;
-      ny = (int8_t)(PADDLE_Y - 1);
-
-      int8_t center = (int8_t)(paddleX + (PADDLE_W / 2));
-      if (nx < center) ballVX = -1;
-      else if (nx > center) ballVX = 1;
-      else {
-        if (ballVX == 0) ballVX = (random(0, 2) == 0) ? -1 : 1;
-      }
-    }
+  for (uint8_t i = 0; i < powerUps.count;) {
+    if (stepPowerUp(i)) ++i;
+    else powerUps.remove(i);
   }
 
-  // miss -> game over
-  if (ny > (int8_t)PADDLE_Y) {
-    gameOver = true;
-    return;
-  }
+  if (widePaddleFrames && --widePaddleFrames == 0) setPaddleWidth(PADDLE_W);
 
-  ballX = nx;
-  ballY = ny;
+  // last ball lost -> game over
+  if (balls.count == 0) gameOver = true;
 }
-
-bool Game_isOver() { return gameOver; }
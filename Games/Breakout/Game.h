@@ -2,31 +2,94 @@
 #pragma once
 #include <Arduino.h>
 #include "Pins.h"
+#include "Entities.h"
 
-// per-cell brick colour, 0 = empty
-extern uint32_t bricksGrid[BRICK_H][W];
+// Bricks, one row per word: bit x set = a brick in column x. Each row is a
+// single colour, kept as its Render_wheelColor() position.
+static_assert(W <= 16, "a brick row is a uint16_t mask");
+static const uint16_t BRICK_ROW_FULL = (uint16_t)((1u << W) - 1);
 
-extern int8_t paddleX;
-extern bool ballStuck;
-extern int8_t ballX, ballY;
-extern int8_t ballVX, ballVY;
+// Balls and power-ups: position and velocity in Q8.8 fixed point, 256 = one
+// cell, velocity per frame. An entity is in cell (x >> 8, y >> 8).
+static const uint8_t BALL_FRAC_BITS = 8;
+static const int16_t BALL_ONE = 1 << BALL_FRAC_BITS;
 
-extern uint32_t score;
-extern bool gameOver;
+// Falling power-ups, powerUps.kind[] is a PowerUpKind
+enum PowerUpKind : uint8_t { POWERUP_WIDE, POWERUP_SLOW, POWERUP_MULTI, POWERUP_KINDS };
 
-extern uint16_t ballStepMs;
-extern uint32_t tBall;
-extern uint32_t tBrickDrop;
-extern uint16_t bricksHit;
+// One game of Breakout. No hardware: the sketch draws it (Render.cpp) and
+// the host tests and simulator run as many as they like. Time is passed
+// in, and random choices come from the game's own generator (seed()).
+struct BreakoutGame {
+  uint16_t brickRows[BRICK_H];
+  uint8_t brickRowWheel[BRICK_H];
 
-extern uint8_t wheelPos;
+  int8_t paddleX = 3;
+  uint8_t paddleW = PADDLE_W;
+  uint16_t widePaddleFrames = 0;
 
-void Game_reset();
-void Game_movePaddle(int8_t dx);
+  // Ball 0 rides the paddle until served
+  bool ballStuck = true;
+  EntityPool<BALL_MAX> balls;
+  // Every ball moves ballSpeed per frame
+  uint16_t ballSpeed = BALL_SPEED;
+  EntityPool<POWERUP_MAX> powerUps;
 
-void Game_serveBall();
-void Game_brickDropTick();
-void Game_stepBallOnce();
+  uint32_t score = 0;
+  bool gameOver = false;
 
-// Small helpers
-bool Game_isOver();
+  uint32_t tBrickDrop = 0;
+  uint16_t bricksHit = 0;
+
+  uint8_t wheelPos = 0;
+
+  // Tuning, Pins.h values unless a test or the simulator changes them
+  uint16_t speedupEvery = BALL_SPEEDUP_EVERY;
+  uint16_t brickDropMs = BRICK_DROP_MS;
+
+  void seed(uint32_t s) { rng = s ? s : 1; }
+  void reset(uint32_t nowMs);
+  void movePaddle(int8_t dx);
+  void serveBall();
+
+  // A brick drop when one is due, then stepFrame(). Call once per frame.
+  void update(uint32_t nowMs);
+  void brickDropTick();
+  // One frame of every ball and power-up
+  void stepFrame();
+
+  bool isOver() const { return gameOver; }
+  bool brickAt(int8_t x, int8_t y) const {
+    return y >= (int8_t)BRICK_TOP && y <= (int8_t)BRICK_BOTTOM && (brickRows[(uint8_t)y] >> x) & 1u;
+  }
+
+  // Ball i's velocity: ballSpeed long along the Q8.8 unit vector (ux, uy)
+  void aimBall(uint8_t i, int16_t ux, int16_t uy);
+
+private:
+  enum BallCell : uint8_t { CELL_OPEN, CELL_WALL, CELL_BRICK, CELL_PADDLE };
+
+  uint32_t rng = 1;
+  uint32_t nextRandom(uint32_t n);
+
+  void clearBricks();
+  void generateBrickRowAt(uint8_t row);
+  void fillInitialBricks();
+  bool hitBrickAt(int8_t x, int8_t y);
+
+  void setBallSpeed(uint16_t speed);
+  void clampPaddle();
+  void setPaddleWidth(uint8_t w);
+  void glueBallToPaddle();
+  void resetBallOnPaddle();
+  void bounceOffPaddle(uint8_t b);
+  bool onPaddle(int8_t x) const { return x >= paddleX && x < paddleX + (int8_t)paddleW; }
+  BallCell ballCell(int8_t x, int8_t y) const;
+  bool stepBall(uint8_t i);
+
+  void applyPowerUp(uint8_t kind);
+  bool stepPowerUp(uint8_t i);
+};
+
+// The game the sketch plays
+extern BreakoutGame game;
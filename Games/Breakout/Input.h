@@ -1,57 +1,28 @@
 // Input.h
 #pragma once
 #include <Arduino.h>
+#include <GameInput.h>
 #include "Pins.h"
 
-struct Btn {
-  uint8_t pin = 0;
-  bool stable = false;
-  bool prevStable = false;
-  bool lastRaw = false;
-  uint32_t lastChange = 0;
-
-  void begin(uint8_t p) {
-    pin = p;
-    pinMode(pin, INPUT_PULLUP);
-    stable = false;
-    prevStable = false;
-    lastRaw = false;
-    lastChange = millis();
-  }
-
-  void update() {
-    bool raw = (digitalRead(pin) == LOW);
-    uint32_t now = millis();
-    if (raw != lastRaw) {
-      lastRaw = raw;
-      lastChange = now;
-      return;
-    }
-    if (now - lastChange >= DEBOUNCE_MS) stable = raw;
-  }
-
-  bool pressedEdge() const { return stable && !prevStable; }
-  bool releasedEdge() const { return !stable && prevStable; }
-  void latch() { prevStable = stable; }
+// Input lines (bit i of the masks is line i), in the bit order of the host
+// input byte, so in host mode the debounced mask is the byte that is sent
+enum InputLine : uint8_t {
+  LINE_BTN1, LINE_BTN2, LINE_BTN3, LINE_JOY_UP,
+  LINE_JOY_DOWN, LINE_JOY_LEFT, LINE_JOY_RIGHT, LINE_BTN4,
+  INPUT_LINE_COUNT
 };
 
-// Buttons / joystick instances (global)
-extern Btn btn1, btn2, btn3, btn4;
-extern Btn joyL, joyR, joyU_unused, joyD_unused;
-
-// Repeat state (global)
-extern uint32_t tMoveL;
-extern uint32_t tMoveR;
-extern bool moveLRepeating;
-extern bool moveRRepeating;
-
-void Input_begin();
+// Binds Breakout's pins to the sketch's input; call once
+void Input_beginPins(GameInput& in);
+// Breakout's repeat timing on in, which the Input_* calls read from here on
+void Input_begin(GameInput& in);
+// Applies the edges captured since the last call, then debounces
 void Input_update();
 void Input_latch();
 
 // True on this frame if ANY serve/restart button was pressed (edge)
 bool Input_servePressedEdge();
 
-// Returns -1, 0, +1 based on joystick repeat logic (left/right only).
-// Call once per frame; if non-zero, apply one paddle step.
+// Returns the paddle steps the joystick repeat owes (left negative, right
+// positive, at most W). Call once per frame and move the paddle that far.
 int8_t Input_paddleStepFromJoystickRepeat(uint32_t now);
@@ -1,12 +1,4 @@
 // Pins.h
-
-I cannot edit files directly in this Ask-only session, but this is the exact source update needed to make Breakout match the ESP32-S3 mapping you chose (option 1).
-
-Update only this file:
-Pins.h
-
-Replace the hardware pin section with this:
-
 #pragma once
 #include <Arduino.h>
 
@@ -42,8 +34,11 @@ static const uint8_t MATRIX_ROWS = PREVIEW_ROWS + PLAY_H;
 // =====================
 static const uint16_t FRAME_MS = 16;
 
-static const uint16_t BALL_STEP_MS = 110;
-static const uint16_t BALL_STEP_MIN_MS = 55;
+// Ball speed in Q8.8 cells per frame: 53 is a diagonal cell every 110 ms,
+// the cap one every 55 ms
+static const uint16_t BALL_SPEED = 53;
+static const uint16_t BALL_SPEED_MAX = 105;
+static const uint16_t BALL_SPEEDUP = 6;
 static const uint16_t BALL_SPEEDUP_EVERY = 10;
 
 static const uint16_t BRICK_DROP_MS = 15000; // 15 seconds
@@ -69,3 +64,14 @@ static const uint8_t INITIAL_FILLED_ROWS = 8;
 
 // RGB wheel stepping
 static const uint8_t COLOR_STEP = 9;
+
+// =====================
+// Balls and power-ups
+// =====================
+static const uint8_t BALL_MAX = 4;
+static const uint8_t POWERUP_MAX = 4;
+static const uint8_t POWERUP_ONE_IN = 8;          // chance a broken brick drops one
+static const int16_t POWERUP_FALL = 20;           // Q8.8 cells per frame
+static const uint8_t PADDLE_W_WIDE = 5;
+static const uint16_t WIDE_PADDLE_FRAMES = 625;   // 10 seconds
+static const uint16_t BALL_SLOWDOWN = 3 * BALL_SPEEDUP;
@@ -2,15 +2,16 @@
 #include "Render.h"
 #include "Game.h"
 
-// Hardware objects
-Adafruit_NeoPixel strip(PIXEL_BUFFER_SIZE, PIN_LED, NEO_GRB + NEO_KHZ800);
-Pixel_Grid* pixelGrid = nullptr;
-LCD_Panel* lcdPanel = nullptr;
+// The cabinet's hardware (Render_begin)
+static Adafruit_NeoPixel* strip = nullptr;
+static Pixel_Grid* pixelGrid = nullptr;
+static LCD_Panel* lcdPanel = nullptr;
 
 // Colours
 uint32_t PLAY_BG_COLOR_U32;
 uint32_t PADDLE_COLOR_U32;
 uint32_t BALL_COLOR_U32;
+uint32_t POWERUP_COLORS_U32[POWERUP_KINDS];
 
 // Map logical play row (0..PLAY_H-1) to PixelGrid row index.
 static inline uint16_t playRowToPixelRow(uint8_t logicalRow) {
@@ -28,14 +29,14 @@ void Render_updateScoreDigits(uint32_t s) {
 uint32_t Render_wheelColor(uint8_t pos) {
   pos = (uint8_t)(255 - pos);
   if (pos < 85) {
-    return strip.Color((uint8_t)(255 - pos * 3), 0, (uint8_t)(pos * 3));
+    return strip->Color((uint8_t)(255 - pos * 3), 0, (uint8_t)(pos * 3));
   }
   if (pos < 170) {
     pos = (uint8_t)(pos - 85);
-    return strip.Color(0, (uint8_t)(pos * 3), (uint8_t)(255 - pos * 3));
+    return strip->Color(0, (uint8_t)(pos * 3), (uint8_t)(255 - pos * 3));
   }
   pos = (uint8_t)(pos - 170);
-  return strip.Color((uint8_t)(pos * 3), (uint8_t)(255 - pos * 3), 0);
+  return strip->Color((uint8_t)(pos * 3), (uint8_t)(255 - pos * 3), 0);
 }
 
 static void drawBackground() {
@@ -49,10 +50,14 @@ static void drawBackground() {
 
 static void drawBricks() {
   for (uint8_t y = BRICK_TOP; y <= BRICK_BOTTOM; ++y) {
+    uint16_t bits = game.brickRows[y];
+    if (bits == 0) continue;
     uint16_t pixelRow = playRowToPixelRow(y);
-    for (uint8_t x = 0; x < W; ++x) {
-      uint32_t c = bricksGrid[y][x];
-      if (c == 0) continue;
+    uint32_t c = Render_wheelColor(game.brickRowWheel[y]);
+    // Set bits only, lowest column first
+    while (bits) {
+      uint8_t x = (uint8_t)__builtin_ctz(bits);
+      bits &= (uint16_t)(bits - 1);
       pixelGrid->setGridCellColour(pixelRow, x, c);
     }
   }
@@ -60,30 +65,58 @@ static void drawBricks() {
 
 static void drawPaddle() {
   uint16_t pixelRow = playRowToPixelRow(PADDLE_Y);
-  for (uint8_t x = 0; x < PADDLE_W; ++x) {
-    uint8_t px = (uint8_t)(paddleX + x);
+  for (uint8_t x = 0; x < game.paddleW; ++x) {
+    uint8_t px = (uint8_t)(game.paddleX + x);
     if (px < W) pixelGrid->setGridCellColour(pixelRow, px, PADDLE_COLOR_U32);
   }
 }
 
-static void drawBall() {
-  if (gameOver) return;
-  if (ballX < 0 || ballX >= (int8_t)W) return;
-  if (ballY < 0 || ballY >= (int8_t)PLAY_H) return;
+static void drawCellAt(int16_t x, int16_t y, uint32_t c) {
+  int16_t cellX = (int16_t)(x >> BALL_FRAC_BITS);
+  int16_t cellY = (int16_t)(y >> BALL_FRAC_BITS);
+  if (cellX < 0 || cellX >= (int16_t)W) return;
+  if (cellY < 0 || cellY >= (int16_t)PLAY_H) return;
 
-  uint16_t pixelRow = playRowToPixelRow((uint8_t)ballY);
-  pixelGrid->setGridCellColour(pixelRow, (uint16_t)ballX, BALL_COLOR_U32);
+  uint16_t pixelRow = playRowToPixelRow((uint8_t)cellY);
+  pixelGrid->setGridCellColour(pixelRow, (uint16_t)cellX, c);
+}
+
+static void drawEntities() {
+  if (game.gameOver) return;
+  for (uint8_t i = 0; i < game.powerUps.count; ++i) {
+    drawCellAt(game.powerUps.x[i], game.powerUps.y[i], POWERUP_COLORS_U32[game.powerUps.kind[i]]);
+  }
+  for (uint8_t i = 0; i < game.balls.count; ++i) drawCellAt(game.balls.x[i], game.balls.y[i], BALL_COLOR_U32);
 }
 
 static void finalizeDigitsAndShow() {
   lcdPanel->render();
   pixelGrid->render();
-  strip.show();
+  strip->show();
+}
+
+// Score on the LCD, so the digits are only rewritten when it changes
+static uint32_t shownScore = 0;
+
+void Render_resetDigits() {
+  const uint32_t white = strip->Color(255, 255, 255);
+  const uint32_t off = strip->Color(0, 0, 0);
+  for (uint8_t d = 0; d < 6; ++d) {
+    lcdPanel->setDigitOnColour(d, white);
+    lcdPanel->setDigitOffColour(d, off);
+  }
+  shownScore = game.score;
+  Render_updateScoreDigits(shownScore);
 }
 
 void Render_renderFrame() {
-  if (gameOver) {
-    uint32_t c = strip.Color(30, 0, 0);
+  if (game.score != shownScore) {
+    shownScore = game.score;
+    Render_updateScoreDigits(shownScore);
+  }
+
+  if (game.gameOver) {
+    uint32_t c = strip->Color(30, 0, 0);
     for (uint8_t pr = 0; pr < PLAY_H; ++pr) {
       uint16_t r = playRowToPixelRow(pr);
       for (uint8_t x = 0; x < W; ++x) pixelGrid->setGridCellColour(r, x, c);
@@ -95,22 +128,23 @@ void Render_renderFrame() {
   drawBackground();
   drawBricks();
   drawPaddle();
-  drawBall();
+  drawEntities();
   finalizeDigitsAndShow();
 }
 
-void Render_begin() {
-  strip.begin();
-  strip.show();
-
-  PLAY_BG_COLOR_U32 = strip.Color(6, 6, 12);
-  PADDLE_COLOR_U32  = strip.Color(220, 220, 220);
-  BALL_COLOR_U32    = strip.Color(255, 255, 255);
+void Render_begin(const Cabinet& cabinet) {
+  strip = cabinet.strip;
+  pixelGrid = cabinet.grid;
+  lcdPanel = cabinet.lcd;
 
-  pixelGrid = new Pixel_Grid(&strip, 0, MATRIX_ROWS, W);
-  lcdPanel  = new LCD_Panel(&strip, 214, 6, strip.Color(255, 255, 255));
+  PLAY_BG_COLOR_U32 = strip->Color(6, 6, 12);
+  PADDLE_COLOR_U32  = strip->Color(220, 220, 220);
+  BALL_COLOR_U32    = strip->Color(255, 255, 255);
+  POWERUP_COLORS_U32[POWERUP_WIDE]  = strip->Color(0, 200, 60);
+  POWERUP_COLORS_U32[POWERUP_SLOW]  = strip->Color(0, 90, 255);
+  POWERUP_COLORS_U32[POWERUP_MULTI] = strip->Color(255, 160, 0);
 
-  Render_updateScoreDigits(0);
+  Render_resetDigits();
   lcdPanel->render();
 
   // Clear once
@@ -119,5 +153,5 @@ void Render_begin() {
     for (uint8_t x = 0; x < W; ++x) pixelGrid->setGridCellColour(r, x, PLAY_BG_COLOR_U32);
   }
   pixelGrid->render();
-  strip.show();
+  strip->show();
 }
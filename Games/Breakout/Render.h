@@ -5,17 +5,16 @@
 #include <PixelGridCore.h>
 #include "Pins.h"
 
-// Hardware objects (global)
-extern Adafruit_NeoPixel strip;
-extern Pixel_Grid* pixelGrid;
-extern LCD_Panel* lcdPanel;
-
 // Colours (global)
 extern uint32_t PLAY_BG_COLOR_U32;
 extern uint32_t PADDLE_COLOR_U32;
 extern uint32_t BALL_COLOR_U32;
+extern uint32_t POWERUP_COLORS_U32[];  // by PowerUpKind
 
-void Render_begin();
+// Draws on the cabinet's grid and LCD from here on; clears the play area
+void Render_begin(const Cabinet& cabinet);
+// Puts the LCD back as Render_begin() left it, after host mode wrote to it
+void Render_resetDigits();
 void Render_updateScoreDigits(uint32_t s);
 uint32_t Render_wheelColor(uint8_t pos);
 
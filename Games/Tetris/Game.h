@@ -114,6 +114,51 @@ struct TetrisGame {
     return validAtParams((uint8_t)curPiece.type, nrot, nx, ny);
   }
 
+  // Row y as bits, column x at bit x + SLIDE_PAD; the walls and the floor
+  // read as filled
+  static const uint8_t SLIDE_PAD = 4;
+  static const uint32_t SLIDE_WALLS = ~(uint32_t)(((1UL << W) - 1) << SLIDE_PAD);
+
+  uint32_t rowBits(int8_t y) const {
+    if (y >= (int8_t)PLAY_H) return 0xFFFFFFFFUL;
+    uint32_t bits = SLIDE_WALLS;
+    if (y < 0) return bits;
+    for (uint8_t x = 0; x < W; ++x) {
+      if (board[y][x]) bits |= 1UL << (x + SLIDE_PAD);
+    }
+    return bits;
+  }
+
+  // Moves the piece up to |dx| cells sideways, stopping at the first cell
+  // it can't enter. The rows under the piece are read once and each step is
+  // a shift and an AND per row. Returns the cells moved, signed.
+  int8_t slideX(int8_t dx) {
+    uint16_t mask = shapeMask((uint8_t)curPiece.type, curPiece.rot);
+    uint32_t piece[4];
+    uint32_t rows[4];
+    for (uint8_t cy = 0; cy < 4; ++cy) {
+      piece[cy] = 0;
+      for (uint8_t cx = 0; cx < 4; ++cx) {
+        if (maskCell(mask, cx, cy)) piece[cy] |= 1UL << cx;
+      }
+      rows[cy] = piece[cy] ? rowBits((int8_t)(curY + cy)) : 0;
+    }
+
+    int8_t dir = dx < 0 ? -1 : 1;
+    int8_t x = curX;
+    for (int8_t n = dx < 0 ? -dx : dx; n > 0; --n) {
+      int8_t nx = (int8_t)(x + dir);
+      if (nx + (int8_t)SLIDE_PAD < 0) break;
+      bool hit = false;
+      for (uint8_t cy = 0; cy < 4; ++cy) hit |= ((piece[cy] << (nx + SLIDE_PAD)) & rows[cy]) != 0;
+      if (hit) break;
+      x = nx;
+    }
+    int8_t moved = (int8_t)(x - curX);
+    curX = x;
+    return moved;
+  }
+
   uint8_t clearLines() {
     uint8_t lines = 0;
     for (int8_t y = (int8_t)PLAY_H - 1; y >= 0; --y) {
@@ -337,8 +382,8 @@ struct TetrisGame {
     if (in.rotLeftPressed) rotateLeft();
     if (in.rotRightPressed) rotateRight();
 
-    // horizontal movement via joystick repeat
-    if (repeatDx != 0) tryMove(repeatDx, 0);
+    // horizontal movement via joystick repeat, as many cells as fell due
+    if (repeatDx != 0) slideX(repeatDx);
 
     // gravity / soft drop
     uint16_t fallMs = currentFallDelay(in.downHeld);
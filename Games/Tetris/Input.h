@@ -1,38 +1,20 @@
 #pragma once
 #include <Arduino.h>
+#include <GameInput.h>
 #include "Pins.h"
 
-struct Btn {
-  uint8_t pin = 0;
-  bool stable = false;
-  bool prevStable = false;
-  bool lastRaw = false;
-  uint32_t lastChange = 0;
-
-  void begin(uint8_t p) {
-    pin = p;
-    pinMode(pin, INPUT_PULLUP);
-    stable = false;
-    prevStable = false;
-    lastRaw = false;
-    lastChange = millis();
-  }
+// Input lines, in the bit order of the host input byte, so the debounced
+// mask is the byte HostRuntime::reportInput() sends
+enum InputLine : uint8_t {
+  LINE_BTN1, LINE_BTN2, LINE_BTN3, LINE_JOY_UP,
+  LINE_JOY_DOWN, LINE_JOY_LEFT, LINE_JOY_RIGHT, LINE_BTN4,
+  INPUT_LINE_COUNT
+};
 
-  void update() {
-    bool raw = (digitalRead(pin) == LOW);
-    uint32_t now = millis();
-    if (raw != lastRaw) {
-      lastRaw = raw;
-      lastChange = now;
-      return;
-    }
-    if (now - lastChange >= DEBOUNCE_MS) stable = raw;
-  }
+#define INPUT_BIT(line) ((uint8_t)(1u << (line)))
 
-  bool pressedEdge() const  { return stable && !prevStable; }
-  bool releasedEdge() const { return !stable && prevStable; }
-  void latch() { prevStable = stable; }
-};
+static const uint8_t INPUT_BUTTONS =
+    INPUT_BIT(LINE_BTN1) | INPUT_BIT(LINE_BTN2) | INPUT_BIT(LINE_BTN3) | INPUT_BIT(LINE_BTN4);
 
 struct InputState {
   // edges
@@ -48,109 +30,55 @@ struct InputState {
   bool downHeld  = false;
 };
 
-struct Input {
-  Btn btn1, btn2, btn3, btn4;
-  Btn joyU, joyL, joyR, joyD;
-
-  // repeat state
-  uint32_t tMoveL = 0;
-  uint32_t tMoveR = 0;
-  bool moveLRepeating = false;
-  bool moveRRepeating = false;
-
+// Tetris on the shared input (GameInput): which line is which action, and
+// the joystick's DAS/ARR. The Input_* helpers work on any GameInput, so the
+// arcade image (TetrisArcade.h) reads the cabinet's shared one with them.
+static inline void Input_setRepeats(GameInput& in) {
+  in.setRepeat(LINE_JOY_LEFT, MOVE_REPEAT_START_MS, MOVE_REPEAT_MS);
+  in.setRepeat(LINE_JOY_RIGHT, MOVE_REPEAT_START_MS, MOVE_REPEAT_MS);
+}
+
+static inline void Input_beginPins(GameInput& in) {
+  static const uint8_t pins[INPUT_LINE_COUNT] = { PIN_BTN1, PIN_BTN2, PIN_BTN3, PIN_JOY_UP,
+                                                  PIN_JOY_DOWN, PIN_JOY_LEFT, PIN_JOY_RIGHT, PIN_BTN4 };
+  in.begin(pins, INPUT_LINE_COUNT, DEBOUNCE_MS);
+}
+
+static inline InputState Input_sampleEdgesOnly(const GameInput& in) {
+  InputState s;
+  uint8_t p = in.pressed();
+
+  s.rotLeftPressed  = p & (INPUT_BIT(LINE_BTN1) | INPUT_BIT(LINE_BTN3));
+  s.rotRightPressed = p & (INPUT_BIT(LINE_BTN2) | INPUT_BIT(LINE_BTN4));
+  s.holdPressed     = p & INPUT_BIT(LINE_JOY_UP);
+
+  s.anyButtonPressed = p & INPUT_BUTTONS;
+
+  s.leftHeld  = in.held() & INPUT_BIT(LINE_JOY_LEFT);
+  s.rightHeld = in.held() & INPUT_BIT(LINE_JOY_RIGHT);
+  s.downHeld  = in.held() & INPUT_BIT(LINE_JOY_DOWN);
+
+  return s;
+}
+
+// Returns dx movement from joystick repeat logic: every repeat that fell
+// due since the last call, at most a board width either way
+static inline int8_t Input_joystickRepeatDx(GameInput& in, uint32_t now) {
+  uint8_t steps = in.repeat(LINE_JOY_LEFT, now);
+  if (steps) return (int8_t)-(steps < W ? steps : W);
+  // RIGHT only if not moving left this tick
+  steps = in.repeat(LINE_JOY_RIGHT, now);
+  if (steps) return (int8_t)(steps < W ? steps : W);
+  return 0;
+}
+
+struct Input : GameInput {
   void begin() {
-    btn1.begin(PIN_BTN1);
-    btn2.begin(PIN_BTN2);
-    btn3.begin(PIN_BTN3);
-    btn4.begin(PIN_BTN4);
-
-    joyU.begin(PIN_JOY_UP);
-    joyL.begin(PIN_JOY_LEFT);
-    joyR.begin(PIN_JOY_RIGHT);
-    joyD.begin(PIN_JOY_DOWN);
-
-    uint32_t now = millis();
-    tMoveL = tMoveR = now;
-    moveLRepeating = moveRRepeating = false;
-  }
-
-  void update() {
-    btn1.update(); btn2.update(); btn3.update(); btn4.update();
-    joyU.update(); joyL.update(); joyR.update(); joyD.update();
-  }
-
-  InputState sampleEdgesOnly() const {
-    InputState s;
-
-    bool leftEdge  = (btn1.pressedEdge() || btn3.pressedEdge());
-    bool rightEdge = (btn2.pressedEdge() || btn4.pressedEdge());
-
-    s.rotLeftPressed  = leftEdge;
-    s.rotRightPressed = rightEdge;
-    s.holdPressed     = joyU.pressedEdge();
-
-    s.anyButtonPressed = (btn1.pressedEdge() || btn2.pressedEdge() || btn3.pressedEdge() || btn4.pressedEdge());
-
-    s.leftHeld  = joyL.stable;
-    s.rightHeld = joyR.stable;
-    s.downHeld  = joyD.stable;
-
-    return s;
+    Input_beginPins(*this);
+    Input_setRepeats(*this);
   }
 
-  // Call once per loop after you’re done using edges
-  void latch() {
-    btn1.latch(); btn2.latch(); btn3.latch(); btn4.latch();
-    joyU.latch(); joyL.latch(); joyR.latch(); joyD.latch();
-  }
-
-  // Returns dx movement from joystick repeat logic: -1, 0, or +1
-  int8_t joystickRepeatDx(uint32_t now) {
-    int8_t dx = 0;
-
-    // LEFT
-    if (joyL.stable) {
-      if (joyL.pressedEdge()) {
-        dx = -1;
-        tMoveL = now;
-        moveLRepeating = false;
-      } else {
-        uint16_t waitMs = moveLRepeating ? MOVE_REPEAT_MS : MOVE_REPEAT_START_MS;
-        if (now - tMoveL >= waitMs) {
-          dx = -1;
-          tMoveL = now;
-          moveLRepeating = true;
-        }
-      }
-    } else if (joyL.releasedEdge()) {
-      moveLRepeating = false;
-    }
-
-    // RIGHT (only if not moving left this tick)
-    if (dx == 0) {
-      if (joyR.stable) {
-        if (joyR.pressedEdge()) {
-          dx = +1;
-          tMoveR = now;
-          moveRRepeating = false;
-        } else {
-          uint16_t waitMs = moveRRepeating ? MOVE_REPEAT_MS : MOVE_REPEAT_START_MS;
-          if (now - tMoveR >= waitMs) {
-            dx = +1;
-            tMoveR = now;
-            moveRRepeating = true;
-          }
-        }
-      } else if (joyR.releasedEdge()) {
-        moveRRepeating = false;
-      }
-    }
-
-    return dx;
-  }
-
-  void resetRepeatTimers(uint32_t now) {
-    tMoveL = tMoveR = now;
-    moveLRepeating = moveRRepeating = false;
-  }
+  InputState sampleEdgesOnly() const { return Input_sampleEdgesOnly(*this); }
+  int8_t joystickRepeatDx(uint32_t now) { return Input_joystickRepeatDx(*this, now); }
+  void resetRepeatTimers(uint32_t now) { resetRepeat(now); }
 };
@@ -3,14 +3,22 @@
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
 #include <HTTPClient.h>
+#include <LittleFS.h>
+#include <DeviceSigner.h>
+#include <mbedtls/ssl.h>
+#include <NetJson.h>
+#include <NetLink.h>
+#include <ScoreJournal.h>
 #include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 extern "C" {
   #include "esp_wifi.h"
   #include "esp_eap_client.h"
+  #include "esp_sntp.h"
 }
 
-#include "mbedtls/md.h"
-#include "mbedtls/base64.h"
 #include "NetConfig.h"
 
 
@@ -22,73 +30,40 @@ static inline String joinUrl(const char* base, const char* path) {
   return b + p;
 }
 
-static inline String b64url_from_bytes(const uint8_t* data, size_t len) {
-  // Standard base64 to buffer then translate to base64url and strip '='
-  size_t outLen = 0;
-  // base64 length upper bound: 4*ceil(n/3) + 1
-  size_t cap = 4 * ((len + 2) / 3) + 1;
-  char* out = (char*)malloc(cap);
-  if (!out) return "";
-
-  int rc = mbedtls_base64_encode((unsigned char*)out, cap, &outLen, data, len);
-  if (rc != 0) { free(out); return ""; }
-  out[outLen] = 0;
-
-  String s(out);
-  free(out);
-
-  s.replace("+", "-");
-  s.replace("/", "_");
-  while (s.endsWith("=")) s.remove(s.length() - 1);
-  return s;
-}
-static inline bool netEnsureTime(uint32_t timeoutMs = 15000) {
-  // If time already looks sane, don't re-sync.
-  time_t now = time(nullptr);
-  if (now > 1700000000) return true; // ~2023-11
-
-  // Configure NTP. These pool hosts usually work on campus networks.
-  // If eduroam blocks NTP, this may hang/fail and you’ll need your uni’s NTP host.
-  configTime(0, 0, "pool.ntp.org", "time.google.com", "time.cloudflare.com");
-
-  const uint32_t start = millis();
-  while (time(nullptr) < 1700000000) {
-    if (millis() - start > timeoutMs) {
-      Serial.println("[NET] NTP sync timeout (time still not set).");
-      return false;
-    }
-    delay(250);
-    Serial.print("t");
+// Host and port of an http:// or https:// URL
+static inline bool urlServer(const String& url, String& host, uint16_t& port) {
+  int start = url.indexOf("://");
+  if (start < 0) return false;
+  start += 3;
+  int end = url.indexOf('/', start);
+  host = end < 0 ? url.substring(start) : url.substring(start, end);
+  port = url.startsWith("https") ? 443 : 80;
+  int colon = host.indexOf(':');
+  if (colon >= 0) {
+    port = (uint16_t)atoi(host.substring(colon + 1).c_str());
+    host = host.substring(0, colon);
   }
-  Serial.println();
-  Serial.printf("[NET] Time OK: %ld\n", (long)time(nullptr));
-  return true;
-}
-static inline String canonicalDeviceMessage(const char* game_code, int score, int ts, const char* nonce) {
-  // MUST match server.py canonical_device_message()
-  String msg;
-  msg.reserve(128);
-  msg += "game_code="; msg += game_code;
-  msg += "&score=";    msg += String(score);
-  msg += "&ts=";       msg += String(ts);
-  msg += "&nonce=";    msg += nonce;
-  return msg;
+  return host.length() > 0 && port != 0;
 }
 
-static inline String computeDeviceSig(const char* secret, const char* game_code, int score, int ts, const char* nonce) {
-  String msg = canonicalDeviceMessage(game_code, score, ts, nonce);
+// Bytes of an HMAC-SHA256 device signature, and of the canonical message it signs
+static const uint8_t NET_SIG_BYTES = SHA256_BYTES;
+static const uint8_t NET_CANONICAL_MAX = 128;
 
-  uint8_t mac[32];
-  const mbedtls_md_info_t* info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
-  if (!info) return "";
+// GAME_SECRET's HMAC key schedule; set up once by netSignerBegin()
+static DeviceSigner deviceSigner;
 
-  int rc = mbedtls_md_hmac(info,
-                          (const unsigned char*)secret, strlen(secret),
-                          (const unsigned char*)msg.c_str(), msg.length(),
-                          mac);
-  if (rc != 0) return "";
+// Call once at boot, before any score is signed.
+static inline void netSignerBegin() {
+  deviceSigner.begin(GAME_SECRET);
+}
 
-  return b64url_from_bytes(mac, sizeof(mac));
+static inline bool computeDeviceSig(const char* game_code, int score, int ts, const char* nonce,
+                                    uint8_t mac[NET_SIG_BYTES]) {
+  char msg[NET_CANONICAL_MAX];
+  size_t len = canonicalDeviceMessage(msg, sizeof(msg), game_code, score, ts, nonce);
+  if (!len) return false;
+  return deviceSigner.sign((const uint8_t*)msg, len, mac);
 }
 
 static inline void eapConfigure() {
@@ -109,120 +84,535 @@ static inline void eapConfigure() {
   esp_wifi_sta_enterprise_enable();
 }
 
-static inline bool netEnsureWifi(uint32_t timeoutMs = 45000) {
-  if (WiFi.status() == WL_CONNECTED) return true;
+// Wi-Fi and the clock are brought up at boot and kept up by netLink (see
+// NetLink.h), so a score is posted as soon as the game ends rather than after
+// a cold join and NTP sync.
+static const time_t NET_TIME_VALID_AFTER = 1700000000; // ~2023-11
+
+struct NetLinkDriver {
+  void join() {
+    WiFi.disconnect(true, true);
+    WiFi.mode(WIFI_STA);
+    eapConfigure();
+    Serial.println("[NET] Connecting to eduroam...");
+    WiFi.begin(EDUROAM_SSID);
+  }
+
+  void leave() {
+    Serial.printf("[NET] WiFi down, status=%d\n", (int)WiFi.status());
+    WiFi.disconnect(true);
+  }
+
+  void startTimeSync() {
+    // These pool hosts usually work on campus networks. If eduroam blocks
+    // NTP, the sync is retried every NET_LINK_SYNC_TIMEOUT_MS; you may need
+    // your uni's NTP host.
+    configTime(0, 0, "pool.ntp.org", "time.google.com", "time.cloudflare.com");
+  }
+
+  bool timeValid() { return time(nullptr) > NET_TIME_VALID_AFTER; }
+};
+
+static NetLinkDriver netLinkDriver;
+static NetLink<NetLinkDriver> netLink(netLinkDriver);
+
+// Runs in the Wi-Fi event task
+static void netWifiEvent(arduino_event_id_t event) {
+  if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) netLink.onConnected();
+  else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) netLink.onDisconnected();
+}
+
+// Runs in the SNTP task
+static void netTimeSynced(struct timeval*) {
+  netLink.onTimeSynced();
+}
 
-  WiFi.disconnect(true, true);
-  delay(250);
-  WiFi.mode(WIFI_STA);
+// Starts joining Wi-Fi. Call once from setup().
+static inline void netLinkBegin() {
+  WiFi.onEvent(netWifiEvent);
+  sntp_set_time_sync_notification_cb(netTimeSynced);
+  netLink.begin(millis());
+}
 
-  eapConfigure();
+// Call every pass of loop(); never blocks.
+static inline void netLinkPoll() {
+  const bool wasReady = netLink.ready();
+  netLink.poll(millis());
+  if (netLink.ready() && !wasReady) {
+    Serial.print("[NET] Link ready, IP: "); Serial.println(WiFi.localIP());
+    Serial.printf("[NET] Time OK: %ld\n", (long)time(nullptr));
+  }
+}
 
-  Serial.println("[NET] Connecting to eduroam...");
-  WiFi.begin(EDUROAM_SSID);
+// Connected with a valid clock: a score posted now goes straight out
+static inline bool netLinkReady() {
+  return netLink.ready();
+}
 
-  uint32_t start = millis();
-  while (WiFi.status() != WL_CONNECTED) {
-    if (millis() - start > timeoutMs) {
-      Serial.printf("[NET] WiFi connect timeout, status=%d\n", (int)WiFi.status());
+// TLS client that remembers the session of its last handshake and offers it
+// on the next connection, so a server that still holds it (session ID cache
+// or ticket) resumes with an abbreviated handshake instead of a full one.
+// WiFiClientSecure::connect() runs the handshake itself, so the connection
+// opens in plain-start mode and startTLS() runs it once the session is set.
+class NetTlsClient : public WiFiClientSecure {
+ public:
+  bool resumeOffered = false;  // the last open() offered a saved session
+
+  NetTlsClient() { mbedtls_ssl_session_init(&session_); }
+  ~NetTlsClient() { mbedtls_ssl_session_free(&session_); }
+
+  bool open(const char* host, uint16_t port) {
+    setPlainStart();
+    if (!connect(host, port)) return false;
+    resumeOffered = saved_ && mbedtls_ssl_set_session(&sslclient->ssl_ctx, &session_) == 0;
+    if (!startTLS()) {
+      stop();
       return false;
     }
-    delay(500);
-    Serial.print(".");
+    mbedtls_ssl_session_free(&session_);
+    mbedtls_ssl_session_init(&session_);
+    saved_ = mbedtls_ssl_get_session(&sslclient->ssl_ctx, &session_) == 0;
+    return true;
   }
 
-  Serial.println();
-  Serial.print("[NET] IP: "); Serial.println(WiFi.localIP());
+  void forgetSession() {
+    mbedtls_ssl_session_free(&session_);
+    mbedtls_ssl_session_init(&session_);
+    saved_ = false;
+  }
 
-  if (!netEnsureTime()) return false;
+ private:
+  mbedtls_ssl_session session_;
+  bool saved_ = false;
+};
+
+// HTTPS connection kept open between submissions. A TLS handshake takes
+// seconds on the ESP32, so back-to-back games share one connection through
+// HTTP/1.1 keep-alive. Servers close idle connections on their own schedule
+// and a write to a closed socket only fails once the response is awaited,
+// so the session closes the connection itself after NET_SESSION_IDLE_MS and
+// sends a request that fails on a reused connection once more on a new one.
+// A new connection offers the last TLS session; whether the server resumes
+// it is up to the server, and mbedTLS does not report which one happened.
+static const uint32_t NET_SESSION_IDLE_MS = 30000;
+
+struct NetSession {
+  NetTlsClient client;
+  HTTPClient http;
+  bool configured = false;
+  bool lastReused = false;   // the last request went over a kept connection
+  uint32_t lastUseMs = 0;
+  uint32_t handshakes = 0;
+  uint32_t reuses = 0;
+  uint32_t resumeOffers = 0;  // new connections that offered a saved session
+
+  void close() {
+    http.end();
+    client.stop();
+  }
 
-  return true;
-}
+  // Failures before any response, as when the server already closed a kept
+  // connection. Read timeouts are not retried: the score may have been stored.
+  static bool retryable(int code) {
+    return code == HTTPC_ERROR_SEND_HEADER_FAILED || code == HTTPC_ERROR_SEND_PAYLOAD_FAILED ||
+           code == HTTPC_ERROR_NOT_CONNECTED || code == HTTPC_ERROR_CONNECTION_LOST;
+  }
 
-static inline bool httpJsonPost(const String& url, const String& jsonBody, int& httpCodeOut, String& responseOut) {
-  WiFiClientSecure client;
-  client.setInsecure(); // ngrok/testing; for production you should validate certs
+  // Same contract as HTTPClient::POST: false if the request couldn't be
+  // started, otherwise httpCodeOut is the status or a negative HTTPC error.
+  // The response body is written to response as it arrives.
+  bool post(const String& url, const char* jsonBody, size_t len, int& httpCodeOut, Stream& response) {
+    if (!configured) {
+      client.setInsecure(); // ngrok/testing; for production you should validate certs
+      http.setReuse(true);
+      configured = true;
+    }
+    if (client.connected() && millis() - lastUseMs > NET_SESSION_IDLE_MS) close();
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      lastReused = client.connected();
+      if (!http.begin(client, url)) return false;
+      if (!lastReused) {
+        // HTTPClient uses a connected client as it is
+        String host;
+        uint16_t port;
+        if (!urlServer(url, host, port)) return false;
+        if (!client.open(host.c_str(), port)) {
+          close();
+          httpCodeOut = HTTPC_ERROR_CONNECTION_REFUSED;
+          return true;
+        }
+        if (client.resumeOffered) resumeOffers++;
+      }
+
+      http.addHeader("Content-Type", "application/json");
+      httpCodeOut = http.POST((uint8_t*)jsonBody, len);
+      if (httpCodeOut > 0) {
+        http.writeToStream(&response);
+        http.end(); // keeps the connection unless the server asked to close it
+        lastUseMs = millis();
+        if (lastReused) reuses++;
+        else handshakes++;
+        return true;
+      }
+
+      close();
+      if (!lastReused || !retryable(httpCodeOut)) break;
+      Serial.printf("[NET] Kept connection failed (%d), reconnecting.\n", httpCodeOut);
+    }
+    return true;
+  }
+};
 
-  HTTPClient http;
-  if (!http.begin(client, url)) return false;
+static NetSession netSession;
 
-  http.addHeader("Content-Type", "application/json");
-  httpCodeOut = http.POST((uint8_t*)jsonBody.c_str(), jsonBody.length());
-  responseOut = http.getString();
-  http.end();
-  return true;
+static inline bool httpJsonPost(const String& url, const char* jsonBody, size_t len, int& httpCodeOut,
+                                Stream& response) {
+  return netSession.post(url, jsonBody, len, httpCodeOut, response);
 }
 
-static inline bool extractJsonStringField(const String& json, const char* field, String& out) {
-  // Minimal, non-robust field extractor: looks for "field":"value"
-  // Good enough for your server responses.
-  String key = String("\"") + field + "\":";
-  int i = json.indexOf(key);
-  if (i < 0) return false;
-  i = json.indexOf('"', i + key.length());
-  if (i < 0) return false;
-  int j = json.indexOf('"', i + 1);
-  if (j < 0) return false;
-  out = json.substring(i + 1, j);
-  return true;
+// Response sink: feeds the body to a JsonScanner and keeps its start for the
+// log, so no copy of the body is made.
+static const uint8_t NET_LOG_BODY_MAX = 95;
+
+class NetResponse : public Stream {
+public:
+  NetResponse(JsonScanner::Callback cb, void* ctx) { scanner.begin(cb, ctx); }
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* data, size_t n) override {
+    scanner.feed(data, n);
+    for (size_t i = 0; i < n && headLen < NET_LOG_BODY_MAX; ++i) head[headLen++] = (char)data[i];
+    head[headLen] = 0;
+    return n;
+  }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+
+  JsonScanner scanner;
+  char head[NET_LOG_BODY_MAX + 1] = {0};
+  uint8_t headLen = 0;
+};
+
+// Largest /api/codes record: five fields, a 43-character signature
+static const uint16_t NET_RECORD_JSON_MAX = 192;
+
+static inline void makeNonce(char* out, size_t cap) {
+  uint32_t r1 = (uint32_t)esp_random();
+  uint32_t r2 = (uint32_t)esp_random();
+  snprintf(out, cap, "%08lx%08lx", (unsigned long)r1, (unsigned long)r2);
 }
 
-static inline bool submitScoreToServer(uint32_t score, String& outCode) {
-  outCode = "";
+// Appends one signed /api/codes record. False if signing failed.
+static inline bool writeScoreJson(JsonWriter& w, uint32_t score, int ts, const char* nonce) {
+  uint8_t mac[NET_SIG_BYTES];
+  if (!computeDeviceSig(GAME_CODE, (int)score, ts, nonce, mac)) {
+    Serial.println("[NET] Failed to compute HMAC signature.");
+    return false;
+  }
 
-  if (!netEnsureWifi()) return false;
+  w.beginObject();
+  w.field("score", (long)score);
+  w.field("game_code", GAME_CODE);
+  w.field("ts", (long)ts);
+  w.field("nonce", nonce);
+  w.fieldBase64Url("sig", mac, sizeof(mac));
+  w.endObject();
+  return true;
+}
 
+// Unix time for signing, or 0 if the clock isn't set.
+static inline int netSigningTime() {
   // IMPORTANT: server enforces abs(now - ts) <= 120
   const int ts = (int)(time(nullptr));
-  if (ts < 1700000000) {
+  if (ts < NET_TIME_VALID_AFTER) {
     Serial.println("[NET] Time not set; cannot sign request. (Need NTP sync)");
+    return 0;
+  }
+  return ts;
+}
+
+// Captures the top-level "code" string of a /api/codes response
+struct NetCodeResult {
+  char code[JSON_VALUE_MAX + 1] = {0};
+};
+
+static void netCodeEvent(void* ctx, JsonEvent event, uint8_t depth, const char* key, const char* value) {
+  NetCodeResult* r = (NetCodeResult*)ctx;
+  if (event == JSON_STRING && depth == 1 && strcmp(key, "code") == 0) {
+    strncpy(r->code, value, JSON_VALUE_MAX);
+  }
+}
+
+static inline bool submitScoreToServer(uint32_t score, String& outCode) {
+  outCode = "";
+
+  if (!netLinkReady()) {
+    Serial.println("[NET] Not connected; score not sent.");
     return false;
   }
 
+  const int ts = netSigningTime();
+  if (!ts) return false;
+
   char nonceBuf[24];
-  uint32_t r1 = (uint32_t)esp_random();
-  uint32_t r2 = (uint32_t)esp_random();
-  snprintf(nonceBuf, sizeof(nonceBuf), "%08lx%08lx", (unsigned long)r1, (unsigned long)r2);
+  makeNonce(nonceBuf, sizeof(nonceBuf));
 
-  String sig = computeDeviceSig(GAME_SECRET, GAME_CODE, (int)score, ts, nonceBuf);
-  if (sig.length() == 0) {
-    Serial.println("[NET] Failed to compute HMAC signature.");
+  char body[NET_RECORD_JSON_MAX];
+  JsonWriter w(body, sizeof(body));
+  if (!writeScoreJson(w, score, ts, nonceBuf)) return false;
+  if (!w.ok()) {
+    Serial.println("[NET] Request body too large.");
     return false;
   }
 
   String codesUrl = joinUrl(API_BASE, "/api/codes");
-
-  String body1;
-  body1.reserve(256);
-  body1 += "{";
-  body1 += "\"score\":"; body1 += String((int)score); body1 += ",";
-  body1 += "\"game_code\":\""; body1 += GAME_CODE; body1 += "\",";
-  body1 += "\"ts\":"; body1 += String(ts); body1 += ",";
-  body1 += "\"nonce\":\""; body1 += nonceBuf; body1 += "\",";
-  body1 += "\"sig\":\""; body1 += sig; body1 += "\"";
-  body1 += "}";
-
   int http1 = 0;
-  String resp1;
-  if (!httpJsonPost(codesUrl, body1, http1, resp1)) {
+  NetCodeResult result;
+  NetResponse resp1(netCodeEvent, &result);
+  const uint32_t postStart = millis();
+  if (!httpJsonPost(codesUrl, w.c_str(), w.length(), http1, resp1)) {
     Serial.println("[NET] POST /api/codes failed to start.");
     return false;
   }
 
-  Serial.printf("[NET] /api/codes -> %d\n", http1);
+  Serial.printf("[NET] /api/codes -> %d in %lu ms (%s connection)\n", http1, (unsigned long)(millis() - postStart),
+                netSession.lastReused ? "kept" : netSession.client.resumeOffered ? "new, resuming" : "new");
   if (http1 < 200 || http1 >= 300) {
-    Serial.println(resp1);
+    Serial.println(resp1.head);
     return false;
   }
 
-  String oneTimeCode;
-  if (!extractJsonStringField(resp1, "code", oneTimeCode)) {
+  if (!result.code[0]) {
     Serial.println("[NET] Could not parse code from /api/codes response.");
-    Serial.println(resp1);
+    Serial.println(resp1.head);
     return false;
   }
 
   // This is what you want to show to the user on the LCD
-  outCode = oneTimeCode;
+  outCode = result.code;
   return true;
-}
\ No newline at end of file
+}
+
+// -----------------------------
+// Offline score queue
+// -----------------------------
+// At game over the score goes into a journal on flash (ScoreJournal.h) and
+// a background task uploads it whenever the network allows, so no score
+// depends on Wi-Fi, NTP or the server being up at that moment. Pending
+// scores go out in batches of up to NET_BATCH_MAX to /api/codes/batch, each
+// record signed like a /api/codes request at upload time; against a server
+// without that endpoint (404) they go one per /api/codes request. After a
+// failure the task waits NET_BACKOFF_MIN_MS, doubling up to
+// NET_BACKOFF_MAX_MS; a new score retries at once, as its player is waiting
+// for the code.
+
+static const uint8_t  NET_BATCH_MAX      = 8;
+static const uint32_t NET_BACKOFF_MIN_MS = 5000;
+static const uint32_t NET_BACKOFF_MAX_MS = 300000;
+static const uint8_t  NET_CODE_CHARS     = 15;
+
+static ScoreJournal<fs::FS> scoreJournal(LittleFS, "/scores.log", "/scores.tmp");
+static SemaphoreHandle_t scoreJournalLock = NULL;
+static volatile bool netUploadKick = false;
+static bool netBatchSupported = true;
+// The last code the uploader received and the journal id it belongs to
+static uint32_t netCodeId = 0;
+static char netCode[NET_CODE_CHARS + 1] = "";
+
+static inline void netPublishCode(uint32_t id, const char* code) {
+  Serial.printf("[NET] Score %lu -> code %s\n", (unsigned long)id, code);
+  xSemaphoreTake(scoreJournalLock, portMAX_DELAY);
+  strncpy(netCode, code, NET_CODE_CHARS);
+  netCode[NET_CODE_CHARS] = 0;
+  netCodeId = id;
+  xSemaphoreGive(scoreJournalLock);
+}
+
+// Whole-request rejections that a retry won't fix. The scores are dropped,
+// as a failed direct submission would have lost them.
+static inline bool netRejected(int httpCode) {
+  return httpCode >= 400 && httpCode < 500 && httpCode != 404 && httpCode != 408 && httpCode != 429;
+}
+
+// Results of an upload, one per record: a /api/codes response has a
+// top-level code, a /api/codes/batch response one object per record in
+// "results".
+struct NetBatchResult {
+  const JournalScore* batch;
+  uint8_t count;
+  uint8_t depth;  // where code and error are: 1 single, 3 batched
+  uint8_t done = 0;
+  char code[JSON_VALUE_MAX + 1] = {0};
+  char error[JSON_VALUE_MAX + 1] = {0};
+};
+
+static inline void netFinishResult(NetBatchResult* r) {
+  if (r->done >= r->count) return;
+  uint32_t id = r->batch[r->done].id;
+  if (r->code[0]) netPublishCode(id, r->code);
+  else Serial.printf("[NET] Score %lu rejected: %s\n", (unsigned long)id, r->error[0] ? r->error : "no code");
+  r->done++;
+  r->code[0] = 0;
+  r->error[0] = 0;
+}
+
+static void netBatchEvent(void* ctx, JsonEvent event, uint8_t depth, const char* key, const char* value) {
+  NetBatchResult* r = (NetBatchResult*)ctx;
+  if (depth != r->depth) return;
+  if (event == JSON_OBJECT_END) netFinishResult(r);
+  else if (strcmp(key, "code") == 0) strncpy(r->code, value, JSON_VALUE_MAX);
+  else if (strcmp(key, "error") == 0) strncpy(r->error, value, JSON_VALUE_MAX);
+}
+
+// Sends the oldest pending scores. False on a failure worth retrying later.
+static inline bool netUploadPending() {
+  JournalScore batch[NET_BATCH_MAX];
+  xSemaphoreTake(scoreJournalLock, portMAX_DELAY);
+  uint8_t n = scoreJournal.peek(batch, netBatchSupported ? NET_BATCH_MAX : 1);
+  xSemaphoreGive(scoreJournalLock);
+  if (!n) return true;
+
+  if (!netLinkReady()) return false;
+  const int ts = netSigningTime();
+  if (!ts) return false;
+
+  const bool batched = netBatchSupported;
+  char body[16 + NET_BATCH_MAX * NET_RECORD_JSON_MAX];
+  JsonWriter w(body, sizeof(body));
+  if (batched) {
+    w.beginObject();
+    w.beginArray("codes");
+  }
+  for (uint8_t i = 0; i < n; ++i) {
+    if (!writeScoreJson(w, batch[i].score, ts, batch[i].nonce)) return false;
+  }
+  if (batched) {
+    w.endArray();
+    w.endObject();
+  }
+  if (!w.ok()) {
+    Serial.println("[NET] Request body too large.");
+    return false;
+  }
+
+  int httpCode = 0;
+  NetBatchResult result;
+  result.batch = batch;
+  result.count = n;
+  result.depth = batched ? 3 : 1;
+  NetResponse resp(netBatchEvent, &result);
+  if (!httpJsonPost(joinUrl(API_BASE, batched ? "/api/codes/batch" : "/api/codes"), w.c_str(), w.length(), httpCode,
+                    resp)) {
+    Serial.println("[NET] Score upload failed to start.");
+    return false;
+  }
+  Serial.printf("[NET] %s (%u scores) -> %d\n", batched ? "/api/codes/batch" : "/api/codes", n, httpCode);
+
+  if (batched && httpCode == 404) {
+    Serial.println("[NET] No batch endpoint; sending scores one at a time.");
+    netBatchSupported = false;
+    return true;
+  }
+
+  uint8_t done = result.done;
+  if (netRejected(httpCode)) {
+    Serial.printf("[NET] Dropping scores %lu..%lu.\n", (unsigned long)batch[0].id, (unsigned long)batch[n - 1].id);
+    Serial.println(resp.head);
+    done = n;
+  } else if (httpCode < 200 || httpCode >= 300) {
+    Serial.println(resp.head);
+    return false;
+  } else if (!batched && !done) {
+    // A single response is the object itself; it ends at depth 1
+    netFinishResult(&result);
+    done = 1;
+  }
+  if (!done) {
+    Serial.println("[NET] Could not parse results from /api/codes/batch response.");
+    Serial.println(resp.head);
+    return false;
+  }
+
+  xSemaphoreTake(scoreJournalLock, portMAX_DELAY);
+  scoreJournal.markDone(batch[done - 1].id);
+  xSemaphoreGive(scoreJournalLock);
+  return true;
+}
+
+static void netUploadTask(void*) {
+  uint32_t backoffMs = 0;
+  uint32_t retryAt = millis();
+  bool linkWasReady = false;
+  for (;;) {
+    // A new score, or the link coming (back) up, is worth an attempt now
+    const bool linkReady = netLinkReady();
+    if (netUploadKick || (linkReady && !linkWasReady)) {
+      netUploadKick = false;
+      retryAt = millis();
+    }
+    linkWasReady = linkReady;
+    xSemaphoreTake(scoreJournalLock, portMAX_DELAY);
+    uint32_t pending = scoreJournal.pending();
+    xSemaphoreGive(scoreJournalLock);
+    if (!pending || !linkReady || (int32_t)(millis() - retryAt) < 0) {
+      delay(100);
+      continue;
+    }
+
+    if (netUploadPending()) {
+      backoffMs = 0;
+      continue;
+    }
+    backoffMs = backoffMs ? backoffMs * 2 : NET_BACKOFF_MIN_MS;
+    if (backoffMs > NET_BACKOFF_MAX_MS) backoffMs = NET_BACKOFF_MAX_MS;
+    // Random half so boards that lost the network together don't retry in step
+    uint32_t waitMs = backoffMs / 2 + (uint32_t)esp_random() % (backoffMs / 2 + 1);
+    retryAt = millis() + waitMs;
+    Serial.printf("[NET] %lu scores queued; retrying in %lu s.\n", (unsigned long)pending,
+                  (unsigned long)(waitMs / 1000));
+  }
+}
+
+// Opens the journal and starts the uploader. Call once LittleFS is mounted;
+// without it scores are submitted directly (submitScoreToServer).
+static inline bool netQueueBegin() {
+  scoreJournalLock = xSemaphoreCreateMutex();
+  if (!scoreJournal.begin()) {
+    Serial.println("[NET] Score journal unavailable.");
+    return false;
+  }
+  if (scoreJournal.droppedBytes()) {
+    Serial.printf("[NET] Score journal: dropped %lu damaged bytes.\n", (unsigned long)scoreJournal.droppedBytes());
+  }
+  if (scoreJournal.pending()) {
+    Serial.printf("[NET] %lu scores waiting to upload.\n", (unsigned long)scoreJournal.pending());
+  }
+  xTaskCreatePinnedToCore(netUploadTask, "upload", 8192, NULL, 1, NULL, 1);
+  return true;
+}
+
+// Writes a score to the journal for upload. False if it couldn't be stored.
+static inline bool netQueueScore(uint32_t score, uint32_t& idOut) {
+  if (!scoreJournal.ready()) return false;
+  char nonce[JOURNAL_NONCE_CHARS + 1];
+  makeNonce(nonce, sizeof(nonce));
+  time_t now = time(nullptr);
+  uint32_t playedAt = now > NET_TIME_VALID_AFTER ? (uint32_t)now : 0;
+
+  xSemaphoreTake(scoreJournalLock, portMAX_DELAY);
+  bool ok = scoreJournal.append(score, playedAt, nonce, idOut);
+  xSemaphoreGive(scoreJournalLock);
+  if (ok) netUploadKick = true;
+  return ok;
+}
+
+// The code for journal score id, once the uploader has it.
+static inline bool netTakeCode(uint32_t id, String& codeOut) {
+  xSemaphoreTake(scoreJournalLock, portMAX_DELAY);
+  bool ok = netCodeId == id;
+  if (ok) codeOut = netCode;
+  xSemaphoreGive(scoreJournalLock);
+  return ok;
+}
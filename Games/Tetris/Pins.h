@@ -25,6 +25,8 @@ static const uint8_t MATRIX_ROWS = PREVIEW_ROWS + PLAY_H;
 
 // ===== Timing =====
 static const uint16_t DEBOUNCE_MS = 18;
+// Frame time when Tetris runs in the arcade image (Arcade.h)
+static const uint16_t FRAME_MS = 16;
 
 // Joystick repeat tuning (DAS/ARR-ish)
 static const uint16_t MOVE_REPEAT_START_MS = 160;
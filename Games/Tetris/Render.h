@@ -62,47 +62,6 @@ struct Renderer {
     lcdPanel->changeCharArray(out);
   }
 
-  // --------------------------
-  // NEW: HUD (Hold / divider / Next + score last 3 digits)
-  // digit 0: hold icon (colored)
-  // digit 1: divider (dim)
-  // digit 2: next icon (colored)
-  // digit 3-5: score (white)
-  // --------------------------
-
-  void setHostHud3MasksAndScore(const uint8_t masks3[3],
-                              const uint32_t cols3[3],
-                              uint16_t scoreLast3)
-{
-  if (!lcdPanel || !strip) return;
-
-  const uint32_t off = strip->Color(0, 0, 0);
-  const uint32_t scoreCol = strip->Color(220, 220, 220);
-
-  // Digits 0-2: raw masks + per-digit colors
-  for (uint8_t i = 0; i < 3; ++i) {
-    lcdPanel->setDigitOnColour(i, cols3[i]);
-    lcdPanel->setDigitOffColour(i, off);
-    lcdPanel->setDigitSegments(i, masks3[i]);
-  }
-
-  // Digits 3-5: score (numeric)
-  uint16_t last3 = (uint16_t)(scoreLast3 % 1000);
-  char c3 = (char)('0' + (last3 / 100) % 10);
-  char c4 = (char)('0' + (last3 / 10) % 10);
-  char c5 = (char)('0' + (last3 / 1) % 10);
-
-  for (uint8_t i = 3; i < 6; ++i) {
-    lcdPanel->setDigitOnColour(i, scoreCol);
-    lcdPanel->setDigitOffColour(i, off);
-  }
-
-  lcdPanel->setDigitChar(3, c3);
-  lcdPanel->setDigitChar(4, c4);
-  lcdPanel->setDigitChar(5, c5);
-}
-
-
 static inline uint8_t SEG_BY_ID(uint8_t segId) {
   // segId 1..7 -> bit 0..6
   if (segId < 1 || segId > 7) return 0;
@@ -266,6 +225,21 @@ static inline uint32_t scoreColorSmoothByScore(Adafruit_NeoPixel& strip, uint32_
     strip->show();
   }
 
+  // GRB pixels in PBFR order (column by column, odd columns bottom to top),
+  // as host frames and animation clips carry them
+  void drawGrbColumns(const uint8_t* grb) {
+    uint16_t idx = 0;
+    for (uint8_t x = 0; x < W; ++x) {
+      bool reverseCol = (x % 2 == 1);
+      for (uint8_t i = 0; i < MATRIX_ROWS; ++i) {
+        uint8_t row = reverseCol ? (uint8_t)(MATRIX_ROWS - 1 - i) : i;
+        uint32_t c = strip->Color(grb[idx + 1], grb[idx + 0], grb[idx + 2]);
+        pixelGrid->setGridCellColour((uint16_t)(MATRIX_ROWS - 1 - row), x, c);
+        idx += 3;
+      }
+    }
+  }
+
   // ===== Title text drawing (5x7 font, right-to-left scrolling) =====
   // Coordinates: (0,0) is top-left of play area (not preview), y in [0..PLAY_H-1]
   void drawChar5x7(int16_t x0, int16_t y0, const uint8_t glyph[7], uint32_t c) {
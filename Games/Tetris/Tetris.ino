@@ -1,24 +1,24 @@
 #include <Arduino.h>
 #include <Adafruit_NeoPixel.h>
 #include <PixelGridCore.h>
-#include "HostRuntime.h"
 #include "Pins.h"
 #include "Input.h"
 #include "Render.h"
 #include "Game.h"
 
 #include "NetSubmit.h" // WiFi + score submit
+#include <LittleFS.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
 // Hardware objects
 Adafruit_NeoPixel strip(PIXEL_BUFFER_SIZE, PIN_LED, NEO_GRB + NEO_KHZ800);
-Pixel_Grid* pixelGrid = nullptr;
-LCD_Panel* lcdPanel = nullptr;
+Cabinet cabinet;
 
 Renderer renderer;
 Input input;
 TetrisGame game;
+HostRuntime hostRuntime;
 
 enum AppState {
   STATE_TITLE_PIXELCATS,
@@ -38,6 +38,16 @@ static int16_t TETRIS_TITLE_TEXT_WIDTH = 0;
 int16_t titleX = W;
 uint32_t tTitle = 0;
 
+// Optional title clips on LittleFS (host/tools/pixelgrid_anim makes them).
+// Without them the hand-drawn scrolls are shown.
+static const char* TITLE_CLIP_PIXELCATS = "/title.pga";
+static const char* TITLE_CLIP_TETRIS = "/tetris.pga";
+static bool fsReady = false;
+static File titleClipFile;
+static AnimFileSource<File> titleClipSource;
+static AnimPlayer titleClip;
+static uint8_t titleClipGrb[W * MATRIX_ROWS * 3];
+
 // Async submission state
 static volatile bool submissionInProgress = false;
 static bool submissionStarted = false;
@@ -45,108 +55,56 @@ static bool submissionSuccess = false;
 static String submissionCode = "";
 static bool submissionHandled = false;
 static TaskHandle_t submitTaskHandle = NULL;
+static uint32_t submissionQueuedId = 0; // journal id when queued for upload
 static uint32_t submissionCompleteMs = 0; // millis when submission completed
 static const uint32_t SUBMISSION_SHOW_SCORE_MS = 5000; // show PC score for 5s before switching to code (if any)
 int16_t lastScore = 0;
 // submit latch: ensure we submit once per game over
 static bool submittedThisGame = false;
 
-static uint8_t lastHostPayload = 0;
-static unsigned long lastHostSendMs = 0;
-static const unsigned long HOST_SEND_MIN_MS = 15; // throttle to avoid flooding
-static uint8_t buildHostPayload(const Input &inp) {
-  uint8_t p = 0;
-  p |= (inp.btn1.stable ? (1u << 0) : 0);
-  p |= (inp.btn2.stable ? (1u << 1) : 0);
-  p |= (inp.btn3.stable ? (1u << 2) : 0);
-  p |= (inp.joyU.stable ? (1u << 3) : 0);
-  p |= (inp.joyD.stable ? (1u << 4) : 0);
-  p |= (inp.joyL.stable ? (1u << 5) : 0);
-  p |= (inp.joyR.stable ? (1u << 6) : 0);
-  p |= (inp.btn4.stable ? (1u << 7) : 0);
-  return p;
+static inline bool anyStartButtonPressed(const InputState& s) {
+  return s.anyButtonPressed;
 }
 
-static bool readBytesWithTimeout(uint8_t* buf, size_t len, unsigned long timeoutMs = 50) {
-  unsigned long start = millis();
-  size_t got = 0;
-  while (got < len && (millis() - start) < timeoutMs) {
-    if (Serial.available()) {
-      int b = Serial.read();
-      if (b >= 0) buf[got++] = (uint8_t)b;
-    } else {
-      delay(1);
-    }
-  }
-  return (got == len);
+static void stopTitleClip() {
+  titleClip.stop();
+  if (titleClipFile) titleClipFile.close();
 }
 
-// Handle a PBLC packet AFTER you've consumed the 'P','B','L','C' magic.
-// Packet format (PC side): 'P' 'B' 'L' 'C' + uint16_t length (little-endian) + payload bytes (UTF8)
-static void HandlePblcPacket() {
-  // read 2-byte length
-  uint8_t lenBytes[2];
-  if (!readBytesWithTimeout(lenBytes, 2, 50)) return;
-  uint16_t payloadLen = (uint16_t)lenBytes[0] | ((uint16_t)lenBytes[1] << 8);
-
-  // cap to safe buffer size
-  const size_t MAX_LCD = 32;
-  uint16_t toRead = payloadLen;
-  if (toRead > MAX_LCD) toRead = MAX_LCD;
-
-  char buf[MAX_LCD + 1];
-  size_t idx = 0;
-  unsigned long start = millis();
-  while (idx < toRead && (millis() - start) < 250) {
-    if (Serial.available()) {
-      int c = Serial.read();
-      if (c >= 0) buf[idx++] = (char)c;
-    } else {
-      delay(1);
-    }
-  }
-  buf[idx] = '\0';
-
-  // If payloadLen > toRead flush remaining bytes so parser stays in sync
-  if (payloadLen > toRead) {
-    uint16_t skip = payloadLen - toRead;
-    unsigned long flushStart = millis();
-    while (skip-- > 0 && (millis() - flushStart) < 200) {
-      if (Serial.available()) Serial.read(); else delay(1);
-    }
-  }
-
-  // Update your renderer / LCD. Use the same API you use elsewhere:
-  renderer.setDigitsText(buf);
+static void startTitleClip(const char* path) {
+  stopTitleClip();
+  if (!fsReady || !LittleFS.exists(path)) return;
+  titleClipFile = LittleFS.open(path, "r");
+  if (!titleClipFile) return;
+  titleClip.begin(titleClipSource.source(titleClipFile), titleClipGrb, (uint16_t)(W * MATRIX_ROWS));
 }
-static void sendHostInputIfChanged(const Input &inp) {
-  uint8_t payload = buildHostPayload(inp);
-  unsigned long now = millis();
-  if (payload != lastHostPayload && (now - lastHostSendMs) >= HOST_SEND_MIN_MS) {
-    Serial.write('b');       // marker expected by PC
-    Serial.write(payload);   // single payload byte
-    lastHostPayload = payload;
-    lastHostSendMs = now;
-  }
-}
-static inline bool anyStartButtonPressed(const InputState& s) {
-  return s.anyButtonPressed;
+
+// Draws the clip's current frame; false if there is none to show
+static bool drawTitleClip(uint32_t now) {
+  if (titleClip.status == ANIM_IDLE || titleClip.status == ANIM_ERROR) return false;
+  titleClip.update(now);
+  if (!titleClip.showing) return false;
+  renderer.drawGrbColumns(titleClipGrb);
+  return true;
 }
 
 static void enterTitle() {
   state = STATE_TITLE_PIXELCATS;
+  startTitleClip(TITLE_CLIP_PIXELCATS);
   titleX = W;
   tTitle = millis();
   input.resetRepeatTimers(millis());
 }
 static void enterTetris(){
   state = STATE_TITLE_TETRIS;
+  startTitleClip(TITLE_CLIP_TETRIS);
   titleX = W;
   tTitle = millis();
   input.resetRepeatTimers(millis());
 }
 static void enterPlaying() {
   state = STATE_PLAYING;
+  stopTitleClip();
   submittedThisGame = false;
   game.reset(renderer);
   input.resetRepeatTimers(millis());
@@ -165,6 +123,7 @@ static void enterGameOverHold() {
   submissionCode = "";
   submissionHandled = false;
   submitTaskHandle = NULL;
+  submissionQueuedId = 0;
 }
 
 // Background task to submit score without blocking the main loop
@@ -187,14 +146,7 @@ static void submitScoreBackgroundTask(void* pvParameters) {
 void initStandaloneMode() {
   randomSeed(analogRead(A0));
 
-  strip.begin();
-  strip.show();
-
-  if (!pixelGrid) pixelGrid = new Pixel_Grid(&strip, 0, MATRIX_ROWS, W);
-  if (!lcdPanel)  lcdPanel  = new LCD_Panel(&strip, 214, 6, strip.Color(255, 255, 255));
-
-  renderer.begin(&strip, pixelGrid, lcdPanel);
-  input.begin();
+  renderer.begin(cabinet.strip, cabinet.grid, cabinet.lcd);
 
   game.initColours(renderer);
   renderer.setScoreDigits(0);
@@ -225,7 +177,7 @@ void runStandaloneLoop() {
       titleX -= 1;
       if (titleX < -PIXELCATS_TITLE_TEXT_WIDTH) titleX = W;
     }
-    renderer.drawTitleScroll_PIXELCATS(titleX);
+    if (!drawTitleClip(now)) renderer.drawTitleScroll_PIXELCATS(titleX);
 
     if (renderer.lcdPanel && renderer.strip) {
       uint32_t pink = renderer.strip->Color(255, 105, 180);
@@ -261,7 +213,7 @@ void runStandaloneLoop() {
       if (titleX < -TETRIS_TITLE_TEXT_WIDTH) titleX = W;
     }
 
-    renderer.drawTitleScroll_TETRIS(titleX);
+    if (!drawTitleClip(now)) renderer.drawTitleScroll_TETRIS(titleX);
     if (lastScore > 0){
       if (renderer.lcdPanel && renderer.strip) {
         uint32_t pink = renderer.strip->Color(255, 105, 180);
@@ -330,10 +282,19 @@ void runStandaloneLoop() {
       submissionStarted = true;
       submissionInProgress = true;
       submissionHandled = false;
-      // allocate score on heap to pass into task
-      uint32_t* pscore = new uint32_t((uint32_t)game.score);
-      // create a background task to perform the HTTP submission
-      xTaskCreatePinnedToCore(submitScoreBackgroundTask, "submit", 8192, pscore, 1, &submitTaskHandle, 1);
+      // Queue the score for the uploader; without a journal, submit directly
+      if (!netQueueScore((uint32_t)game.score, submissionQueuedId)) {
+        submissionQueuedId = 0;
+        if (netLinkReady()) {
+          // allocate score on heap to pass into task
+          uint32_t* pscore = new uint32_t((uint32_t)game.score);
+          // create a background task to perform the HTTP submission
+          xTaskCreatePinnedToCore(submitScoreBackgroundTask, "submit", 8192, pscore, 1, &submitTaskHandle, 1);
+        } else {
+          // Offline with nowhere to keep the score: PC+score stays up
+          submissionInProgress = false;
+        }
+      }
 
       // Immediately show PC + score as interim LCD display while submission runs
       if (renderer.lcdPanel && renderer.strip) {
@@ -371,6 +332,13 @@ void runStandaloneLoop() {
       }
     }
     
+    // A queued score is done once the uploader has its code. Until then
+    // (offline, or the server refused it) the interim PC+score stays up.
+    if (submissionQueuedId && submissionInProgress && netTakeCode(submissionQueuedId, submissionCode)) {
+      submissionSuccess = true;
+      submissionInProgress = false;
+    }
+
     // If submission completed and not yet handled, apply a short delay so player sees PC+score
     if (submissionStarted && !submissionInProgress && !submissionHandled) {
       // record completion time and wait SUBMISSION_SHOW_SCORE_MS before swapping to code
@@ -416,105 +384,37 @@ void runStandaloneLoop() {
 void setup()
 {
   randomSeed(analogRead(A0));
-  Serial.begin(115200);
+  Serial.begin(HOST_DEFAULT_BAUD); // the host may negotiate a faster rate (PBBR)
   Serial.setTimeout(10);
 
-  strip.begin();
-  strip.show();
+  input.begin();
+  cabinet.begin(strip, input, W, MATRIX_ROWS);
+
+  netSignerBegin(); // HMAC key schedule for score signatures
+  netLinkBegin();   // join Wi-Fi now so the link is up by the first game over
 
-  pixelGrid = new Pixel_Grid(&strip, 0, MATRIX_ROWS, W);
-  lcdPanel  = new LCD_Panel(&strip, 214, 6, strip.Color(255, 255, 255));
+  fsReady = LittleFS.begin(false); // never format: no partition just means no clips
+  if (fsReady) netQueueBegin();    // scores survive offline spells and power cuts
 
-  resetHostParser();
+  hostRuntime.begin(cabinet.strip, cabinet.grid, cabinet.lcd, W, MATRIX_ROWS);
   initStandaloneMode();
 }
 
 // -----------------------------
 // Host/standalone runtime loop
 // -----------------------------
-// void loop()
-// {
-//   bool gotHostFrame = tryReadHostFrame();
-
-//   if (runtimeMode == MODE_HOST) {
-//       input.update();
-//       sendHostInputIfChanged(input);
-//       input.latch();
-//       if (millis() - lastHostFrameMs > HOST_TIMEOUT_MS) {
-//         resetHostParser();
-//         initStandaloneMode();
-
-//         return;
-//       }
-
-//     if (gotHostFrame || hostHasFrame) {
-//       renderHostFrame();
-//     } else {
-//       renderer.setDigitsText("HOST  ");
-//       renderer.show();
-//     }
-//     return;
-//   }
-
-//   runStandaloneLoop();
-// }
 void loop()
 {
-  bool gotHostFrame = false;
-  if (Serial.available() >= 4) { // 'P' + 3
-    gotHostFrame = tryReadHostFrame();
-  }
-  // If we were previously in host mode, enforce timeout even if parsing is currently failing.
-  if (runtimeMode == MODE_HOST) {
-    if (millis() - lastHostFrameMs > HOST_TIMEOUT_MS) {
-      resetHostParser();
+  netLinkPoll();
+  switch (hostRuntime.step(input)) {
+    case HOST_STEP_HOST:
+      return;
+    case HOST_STEP_TIMED_OUT:
       initStandaloneMode();
       return;
-    }
-  }
-
-  if (runtimeMode == MODE_HOST) {
-    input.update();
-    sendHostInputIfChanged(input);
-    input.latch();
-
-    if (gotHostFrame || hostHasFrame) {
-      renderHostFrame();
-    } else {
-      renderer.setDigitsText("HOST  ");
-      renderer.show();
-    }
-    return;
+    case HOST_STEP_GAME:
+      break;
   }
 
   runStandaloneLoop();
 }
-static void renderHostFrame() {
-  if (!hostHasFrame) return;
-
-  int idx = 0;
-
-  for (uint8_t x = 0; x < W; ++x) {
-    bool reverseCol = (x % 2 == 1);
-
-    for (uint8_t i = 0; i < MATRIX_ROWS; ++i) {
-      uint8_t row = reverseCol ? (uint8_t)(MATRIX_ROWS - 1 - i) : i;
-
-      // hostGrb is GRB
-      uint8_t g = hostGrb[idx + 0];
-      uint8_t r = hostGrb[idx + 1];
-      uint8_t b = hostGrb[idx + 2];
-
-      // Convert to NeoPixel packed color
-      uint32_t c = strip.Color(r, g, b);
-
-      uint16_t pixelRow = (uint16_t)(MATRIX_ROWS - 1 - row);
-      pixelGrid->setGridCellColour(pixelRow, x, c);
-
-      idx += 3;
-      if (idx + 2 >= (int)sizeof(hostGrb)) break;
-    }
-  }
-
-  renderer.show();
-}
\ No newline at end of file
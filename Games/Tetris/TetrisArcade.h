@@ -0,0 +1,61 @@
+// TetrisArcade.h
+#pragma once
+#include <Arduino.h>
+#include <PixelGridCore.h>
+#include "Pins.h"
+#include "Input.h"
+#include "Render.h"
+#include "Game.h"
+
+// Tetris as a Game for the arcade image (Games/Arcade): play, then the red
+// game-over screen until a button goes back to the menu. The title
+// screens, clips and score submission stay in Tetris.ino.
+class TetrisArcade : public Game {
+public:
+  const char* name() const override { return "TETRIS"; }
+  uint16_t frameMs() const override { return FRAME_MS; }
+
+  void begin(Cabinet& cabinet) override {
+    input_ = cabinet.input;
+    renderer_.begin(cabinet.strip, cabinet.grid, cabinet.lcd);
+    game_.initColours(renderer_);
+    Input_setRepeats(*input_);
+  }
+
+  void reset(uint32_t nowMs) override {
+    done_ = false;
+    game_.reset(renderer_);
+    input_->resetRepeat(nowMs);
+  }
+
+  void update(uint32_t nowMs) override {
+    InputState in = Input_sampleEdgesOnly(*input_);
+    if (game_.isGameOver()) {
+      done_ = in.anyButtonPressed;
+      return;
+    }
+    int8_t dx = Input_joystickRepeatDx(*input_, nowMs);
+    game_.update(in, dx, nowMs, renderer_);
+  }
+
+  void render() override {
+    if (game_.isGameOver()) {
+      renderer_.drawGameOverHold();
+      return;
+    }
+    game_.render(renderer_);
+  }
+
+  bool finished() const override { return done_; }
+
+  uint16_t serialize(uint8_t* out, uint16_t cap) const override { return gameSaveState(game_, out, cap); }
+  bool deserialize(const uint8_t* in, uint16_t len) override { return gameLoadState(game_, in, len); }
+
+  const TetrisGame& state() const { return game_; }
+
+private:
+  GameInput* input_ = nullptr;
+  Renderer renderer_;
+  TetrisGame game_;
+  bool done_ = false;
+};
@@ -0,0 +1,153 @@
+#include <Arduino.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+
+namespace {
+
+const auto bootTime = std::chrono::steady_clock::now();
+
+// Released buttons read HIGH (INPUT_PULLUP)
+std::atomic<uint8_t> pinLevels[64];
+// The same levels as one word per 32 pins, for gpioInputBank()
+std::atomic<uint32_t> pinBanks[2];
+struct PinInit {
+  PinInit() {
+    for (auto& p : pinLevels) p.store(HIGH);
+    for (auto& b : pinBanks) b.store(0xFFFFFFFFu);
+  }
+} pinInit;
+
+struct PinInterrupt {
+  std::atomic<voidFuncPtrArg> handler{nullptr};
+  std::atomic<void*> arg{nullptr};
+};
+PinInterrupt pinInterrupts[64];
+
+std::mt19937 rng;
+
+// How long a write may wait for a full pty/tty buffer before dropping
+const int WRITE_TIMEOUT_MS = 50;
+
+}  // namespace
+
+uint64_t emuNowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - bootTime).count());
+}
+
+uint32_t millis() { return static_cast<uint32_t>(emuNowNs() / 1000000u); }
+uint32_t micros() { return static_cast<uint32_t>(emuNowNs() / 1000u); }
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+void yield() { std::this_thread::yield(); }
+
+void pinMode(uint8_t, uint8_t) {}
+int digitalRead(uint8_t pin) { return pin < 64 ? pinLevels[pin].load() : HIGH; }
+uint32_t gpioInputBank(uint8_t bank) { return bank < 2 ? pinBanks[bank].load() : 0xFFFFFFFFu; }
+void digitalWrite(uint8_t, uint8_t) {}
+int analogRead(uint8_t) { return 0; }
+void attachInterruptArg(uint8_t pin, voidFuncPtrArg handler, void* arg, int) {
+  if (pin >= 64) return;
+  pinInterrupts[pin].arg.store(arg);
+  pinInterrupts[pin].handler.store(handler);
+}
+void detachInterrupt(uint8_t pin) {
+  if (pin < 64) pinInterrupts[pin].handler.store(nullptr);
+}
+void emuSetPin(uint8_t pin, int level) {
+  if (pin >= 64) return;
+  uint8_t v = level ? HIGH : LOW;
+  if (pinLevels[pin].exchange(v) == v) return;
+  uint32_t bit = 1u << (pin & 31);
+  if (v) pinBanks[pin >> 5].fetch_or(bit);
+  else pinBanks[pin >> 5].fetch_and(~bit);
+  if (voidFuncPtrArg h = pinInterrupts[pin].handler.load()) h(pinInterrupts[pin].arg.load());
+}
+
+void randomSeed(unsigned long seed) { rng.seed(static_cast<uint32_t>(seed)); }
+long random(long max) { return max > 0 ? static_cast<long>(rng() % static_cast<unsigned long>(max)) : 0; }
+long random(long min, long max) { return max > min ? min + random(max - min) : min; }
+uint32_t esp_random() { return rng(); }
+void configTime(long, int, const char*, const char*, const char*) {}
+
+void HardwareSerial::attach(int fd) {
+  fd_ = fd;
+  mem_ = nullptr;
+  memLeft_ = 0;
+}
+
+void HardwareSerial::attachMemory(const uint8_t* data, size_t len) {
+  fd_ = -1;
+  mem_ = data;
+  memLeft_ = len;
+}
+
+void HardwareSerial::detach() { attach(-1); }
+
+void HardwareSerial::noteRx(size_t n) {
+  lastRxNs_ = emuNowNs();
+  rxBytes_ += n;
+}
+
+int HardwareSerial::available() {
+  if (mem_) return static_cast<int>(memLeft_);
+  if (fd_ < 0) return 0;
+  int n = 0;
+  if (::ioctl(fd_, FIONREAD, &n) != 0) return 0;
+  return n;
+}
+
+size_t HardwareSerial::readBytes(char* out, size_t n) {
+  if (mem_) {
+    size_t take = n < memLeft_ ? n : memLeft_;
+    memcpy(out, mem_, take);
+    mem_ += take;
+    memLeft_ -= take;
+    if (take) noteRx(take);
+    return take;
+  }
+  if (fd_ < 0) return 0;
+  ssize_t got = ::read(fd_, out, n);
+  if (got <= 0) return 0;
+  noteRx(static_cast<size_t>(got));
+  return static_cast<size_t>(got);
+}
+
+int HardwareSerial::read() {
+  char c;
+  return readBytes(&c, 1) == 1 ? static_cast<uint8_t>(c) : -1;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t n) {
+  if (fd_ < 0) return n;
+  size_t done = 0;
+  while (done < n) {
+    ssize_t w = ::write(fd_, data + done, n - done);
+    if (w > 0) {
+      done += static_cast<size_t>(w);
+      continue;
+    }
+    pollfd p{fd_, POLLOUT, 0};
+    if (::poll(&p, 1, WRITE_TIMEOUT_MS) <= 0 || !(p.revents & POLLOUT)) break;
+  }
+  return done;
+}
+
+size_t HardwareSerial::printf(const char* fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n <= 0) return 0;
+  return write(reinterpret_cast<const uint8_t*>(buf), std::min(static_cast<size_t>(n), sizeof(buf) - 1));
+}
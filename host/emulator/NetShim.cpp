@@ -0,0 +1,264 @@
+#include <HTTPClient.h>
+#include <NetConfig.h>
+#include <WiFiClientSecure.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// ESP32 HTTPClient's default
+const int READ_TIMEOUT_MS = 5000;
+const size_t MAX_HEADER_BYTES = 8192;
+
+std::mutex apiBaseMutex;
+std::string apiBase;
+
+}  // namespace
+
+const char* emuApiBase() {
+  std::lock_guard<std::mutex> lock(apiBaseMutex);
+  if (apiBase.empty()) {
+    const char* env = std::getenv("PIXELGRID_EMU_API");
+    apiBase = env && *env ? env : "http://127.0.0.1:8080";
+  }
+  return apiBase.c_str();
+}
+
+void emuSetApiBase(const char* url) {
+  std::lock_guard<std::mutex> lock(apiBaseMutex);
+  apiBase = url;
+}
+
+int WiFiClientSecure::connect(const char* host, uint16_t port) {
+  stop();
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* res = nullptr;
+  if (::getaddrinfo(host, std::to_string(port).c_str(), &hints, &res) != 0 || !res) return 0;
+  int fd = ::socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  if (fd >= 0 && ::connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+    ::close(fd);
+    fd = -1;
+  }
+  ::freeaddrinfo(res);
+  if (fd < 0) return 0;
+  int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  fd_ = fd;
+  snprintf(host_, sizeof(host_), "%s", host);
+  port_ = port;
+  ssl_ = sslclient_context{};
+  if (plainStart_) return 1;
+  return startTLS();
+}
+
+int WiFiClientSecure::startTLS() {
+  static uint32_t nextSessionId = 1;
+  if (fd_ < 0) return 0;
+  plainStart_ = false;
+  mbedtls_ssl_context& ctx = ssl_.ssl_ctx;
+  ctx.current.id = ctx.offered.id ? ctx.offered.id : nextSessionId++;
+  return 1;
+}
+
+bool WiFiClientSecure::connected() {
+  if (fd_ < 0) return false;
+  pollfd p{fd_, POLLIN, 0};
+  if (::poll(&p, 1, 0) <= 0) return true;
+  // Readable with nothing to read: the peer closed it
+  char c;
+  ssize_t n = ::recv(fd_, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) return true;
+  stop();
+  return false;
+}
+
+void WiFiClientSecure::stop() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+}
+
+bool WiFiClientSecure::writeAll(const uint8_t* data, size_t n) {
+  size_t done = 0;
+  while (fd_ >= 0 && done < n) {
+    ssize_t w = ::send(fd_, data + done, n - done, MSG_NOSIGNAL);
+    if (w < 0 && errno == EINTR) continue;
+    if (w <= 0) return false;
+    done += static_cast<size_t>(w);
+  }
+  return done == n;
+}
+
+int WiFiClientSecure::read(uint8_t* out, size_t n, int timeoutMs) {
+  if (fd_ < 0) return -1;
+  pollfd p{fd_, POLLIN, 0};
+  int r = ::poll(&p, 1, timeoutMs);
+  if (r == 0) return 0;
+  if (r < 0) return errno == EINTR ? 0 : -1;
+  ssize_t got = ::recv(fd_, out, n, 0);
+  return got > 0 ? static_cast<int>(got) : -1;
+}
+
+bool HTTPClient::begin(WiFiClientSecure& client, const String& url) {
+  std::string u = url.c_str();
+  size_t scheme = u.find("://");
+  if (scheme == std::string::npos) return false;
+  std::string rest = u.substr(scheme + 3);
+  size_t slash = rest.find('/');
+  std::string hostPort = rest.substr(0, slash);
+  path_ = slash == std::string::npos ? "/" : rest.substr(slash);
+  size_t colon = hostPort.find(':');
+  host_ = hostPort.substr(0, colon);
+  port_ = colon == std::string::npos ? (u.compare(0, 5, "https") == 0 ? 443 : 80)
+                                     : static_cast<uint16_t>(std::strtoul(hostPort.c_str() + colon + 1, nullptr, 10));
+  if (host_.empty() || !port_) return false;
+
+  // A kept connection only serves the same server
+  if (client.connected() && (host_ != client.host() || port_ != client.port())) client.stop();
+  if (&client != client_) in_.clear();
+  client_ = &client;
+  headers_.clear();
+  bodyLeft_ = 0;
+  serverClose_ = false;
+  return true;
+}
+
+void HTTPClient::addHeader(const char* name, const char* value) {
+  headers_ += name;
+  headers_ += ": ";
+  headers_ += value;
+  headers_ += "\r\n";
+}
+
+int HTTPClient::POST(uint8_t* payload, size_t size) {
+  if (!client_) return HTTPC_ERROR_NOT_CONNECTED;
+  if (!client_->connected()) {
+    in_.clear();
+    if (!client_->connect(host_.c_str(), port_)) return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+
+  std::string req = "POST " + path_ + " HTTP/1.1\r\nHost: " + host_ + "\r\nUser-Agent: ESP32HTTPClient\r\n" +
+                    "Connection: " + (reuse_ ? "keep-alive" : "close") + "\r\n" + headers_ +
+                    "Content-Length: " + std::to_string(size) + "\r\n\r\n";
+  if (!client_->writeAll(reinterpret_cast<const uint8_t*>(req.data()), req.size())) {
+    return HTTPC_ERROR_SEND_HEADER_FAILED;
+  }
+  if (size && !client_->writeAll(payload, size)) return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+
+  int status = 0;
+  readHeaders(status);
+  return status;
+}
+
+// Fills in_ with one more read. False on timeout or a closed connection.
+bool HTTPClient::readMore() {
+  uint8_t buf[2048];
+  int n = client_->read(buf, sizeof(buf), READ_TIMEOUT_MS);
+  if (n <= 0) return false;
+  in_.append(reinterpret_cast<const char*>(buf), static_cast<size_t>(n));
+  return true;
+}
+
+bool HTTPClient::readHeaders(int& status) {
+  size_t end;
+  while ((end = in_.find("\r\n\r\n")) == std::string::npos) {
+    if (in_.size() > MAX_HEADER_BYTES) {
+      status = HTTPC_ERROR_CONNECTION_LOST;
+      return false;
+    }
+    uint8_t buf[2048];
+    int n = client_->read(buf, sizeof(buf), READ_TIMEOUT_MS);
+    if (n <= 0) {
+      // Nothing at all back means the request never reached a live server
+      status = n == 0 ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+      return false;
+    }
+    in_.append(reinterpret_cast<const char*>(buf), static_cast<size_t>(n));
+  }
+  std::string head = in_.substr(0, end);
+  in_.erase(0, end + 4);
+
+  // "HTTP/1.1 200 OK"
+  size_t sp = head.find(' ');
+  status = sp == std::string::npos ? 0 : std::atoi(head.c_str() + sp + 1);
+  if (status <= 0) {
+    status = HTTPC_ERROR_CONNECTION_LOST;
+    return false;
+  }
+  bodyLeft_ = 0;
+  serverClose_ = head.compare(0, 8, "HTTP/1.0") == 0;
+  for (size_t pos = head.find("\r\n"); pos != std::string::npos;) {
+    size_t next = head.find("\r\n", pos + 2);
+    std::string line = head.substr(pos + 2, next == std::string::npos ? std::string::npos : next - pos - 2);
+    pos = next;
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    std::string name = line.substr(0, colon);
+    for (char& c : name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    const char* value = line.c_str() + colon + 1;
+    while (*value == ' ') ++value;
+    if (name == "content-length") bodyLeft_ = std::strtoul(value, nullptr, 10);
+    else if (name == "connection") serverClose_ = strcasecmp(value, "close") == 0;
+  }
+  return true;
+}
+
+int HTTPClient::writeToStream(Stream* stream) {
+  if (!client_) return HTTPC_ERROR_NOT_CONNECTED;
+  int written = 0;
+  while (bodyLeft_) {
+    if (in_.empty() && !readMore()) {
+      serverClose_ = true;  // the rest of the body would be read as the next response
+      return written ? written : HTTPC_ERROR_READ_TIMEOUT;
+    }
+    size_t n = in_.size() < bodyLeft_ ? in_.size() : bodyLeft_;
+    if (stream) stream->write(reinterpret_cast<const uint8_t*>(in_.data()), n);
+    in_.erase(0, n);
+    bodyLeft_ -= n;
+    written += static_cast<int>(n);
+  }
+  return written;
+}
+
+String HTTPClient::getString() {
+  class StringSink : public Stream {
+   public:
+    size_t write(uint8_t b) override {
+      s += static_cast<char>(b);
+      return 1;
+    }
+    size_t write(const uint8_t* data, size_t n) override {
+      s.append(reinterpret_cast<const char*>(data), n);
+      return n;
+    }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    std::string s;
+  } sink;
+  writeToStream(&sink);
+  return String(sink.s);
+}
+
+void HTTPClient::end() {
+  if (client_ && (!reuse_ || serverClose_ || bodyLeft_)) {
+    client_->stop();
+    in_.clear();
+  }
+  bodyLeft_ = 0;
+}
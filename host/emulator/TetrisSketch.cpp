@@ -0,0 +1,2 @@
+// Builds the Tetris sketch unchanged.
+#include "Tetris.ino"
@@ -0,0 +1,628 @@
+// pixelgrid_emu: runs the Tetris firmware (Tetris.ino, Render.h and the
+// PixelGridcore HostRuntime) on Linux against the Arduino shim in host/emulator/shim. Serial
+// is a pty or tty, millis() the monotonic clock and the LED strip a capture
+// buffer, so host mode can be exercised and measured without a board.
+//
+//   pixelgrid_emu --pty [--seconds N]         # prints the pty to point a host at
+//   pixelgrid_emu --port PATH [--seconds N]   # e.g. the pty from pixelgrid_host --pty
+//   pixelgrid_emu --bench [--frames N]        # latency/throughput/timeout report
+//
+// --bench drives the firmware over a pty pair and exits non-zero if a check
+// fails, so CI can run it.
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include <Animation.h>
+#include <HostRuntime.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AnimEncoder.h"
+#include "DeviceStream.h"
+#include "FrameEncoder.h"
+#include "HostBaud.h"
+#include "HostFrame.h"
+#include "InputReport.h"
+#include "PacketWriter.h"
+#include "Pins.h"
+#include "SerialPort.h"
+
+// From the sketch
+void setup();
+void loop();
+void initStandaloneMode();
+extern Adafruit_NeoPixel strip;
+extern HostRuntime hostRuntime;
+
+namespace {
+
+volatile std::sig_atomic_t running = 1;
+
+void onSignal(int) { running = 0; }
+
+int usage(const char* argv0) {
+  std::fprintf(stderr,
+               "usage: %s (--pty | --port PATH) [--seconds N]\n"
+               "       %s --bench [--frames N]\n",
+               argv0, argv0);
+  return 2;
+}
+
+// Runs loop() on its own thread, like the firmware's main task
+class DeviceThread {
+ public:
+  void start() {
+    stop_ = false;
+    thread_ = std::thread([this] {
+      while (!stop_) {
+        loop();
+        std::this_thread::yield();
+      }
+    });
+  }
+  void stop() {
+    stop_ = true;
+    if (thread_.joinable()) thread_.join();
+  }
+  ~DeviceThread() { stop(); }
+
+ private:
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+// ---------------------------------------------------------------------------
+// Plain run: be a board on a pty or tty until interrupted
+// ---------------------------------------------------------------------------
+
+int runDevice(const std::string& portPath, bool usePty, uint32_t seconds) {
+  pixelgrid::SerialPort port;
+  if (usePty) {
+    std::string slave;
+    if (!port.openPty(slave)) {
+      std::fprintf(stderr, "pty: %s\n", port.lastError().c_str());
+      return 1;
+    }
+    std::printf("host side: %s\n", slave.c_str());
+    std::fflush(stdout);
+  } else if (!port.open(portPath, HOST_DEFAULT_BAUD)) {
+    std::fprintf(stderr, "%s\n", port.lastError().c_str());
+    return 1;
+  }
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  Serial.attach(port.fd());
+  setup();
+
+  const uint32_t start = millis();
+  uint32_t nextReport = start + 1000;
+  uint32_t lastShows = strip.showCount();
+  uint64_t lastRx = Serial.rxBytes();
+  while (running) {
+    loop();
+    std::this_thread::yield();
+
+    uint32_t now = millis();
+    if (seconds && now - start >= seconds * 1000u) break;
+    if ((int32_t)(now - nextReport) >= 0) {
+      std::printf("%s  shows %u/s  rx %llu B/s\n", hostRuntime.mode == MODE_HOST ? "host      " : "standalone",
+                  strip.showCount() - lastShows,
+                  static_cast<unsigned long long>(Serial.rxBytes() - lastRx));
+      std::fflush(stdout);
+      lastShows = strip.showCount();
+      lastRx = Serial.rxBytes();
+      nextReport += 1000;
+    }
+  }
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Bench
+// ---------------------------------------------------------------------------
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    std::printf("FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t i = static_cast<size_t>(p * static_cast<double>(v.size() - 1) + 0.5);
+  return v[i];
+}
+
+void reportLatency(const char* name, const std::vector<double>& us) {
+  std::printf("  %-26s p50 %7.1f us  p99 %7.1f us  max %7.1f us\n", name, percentile(us, 0.5),
+              percentile(us, 0.99), us.empty() ? 0.0 : *std::max_element(us.begin(), us.end()));
+}
+
+// Bench frames are a single colour: r/g carry a 16-bit id, b marks them as ours
+const uint8_t TAG_BLUE = 0xA5;
+
+pixelgrid::HostFrame taggedFrame(uint16_t id) {
+  pixelgrid::HostFrame f;
+  f.fill(static_cast<uint8_t>(id), static_cast<uint8_t>(id >> 8), TAG_BLUE);
+  return f;
+}
+
+// A Tetris-like board with a piece falling through it
+pixelgrid::HostFrame gameFrame(uint32_t tick) {
+  pixelgrid::HostFrame f;
+  f.fill(6, 6, 12);
+  for (uint8_t y = 15; y < pixelgrid::HostFrame::H; ++y) {
+    for (uint8_t x = 0; x < pixelgrid::HostFrame::W; ++x) {
+      if ((x + y) % 7) f.set(x, y, 0, 200, 200);
+    }
+  }
+  uint8_t py = static_cast<uint8_t>(tick % 14);
+  for (uint8_t i = 0; i < 4; ++i) f.set(static_cast<uint8_t>(3 + i), py, 220, 0, 220);
+  return f;
+}
+
+// What show() put on the strip, recorded from the device thread
+struct ShowCapture {
+  std::mutex m;
+  std::condition_variable cv;
+  uint16_t lastId = 0;
+  uint64_t showNs = 0;  // when the tagged frame was shown
+  uint64_t rxNs = 0;    // when its last byte was read from Serial
+
+  static void hook(const Adafruit_NeoPixel& s, void* ctx) {
+    ShowCapture* self = static_cast<ShowCapture*>(ctx);
+    const uint8_t* p = s.getPixels();  // pixel 0 is in the matrix
+    if (p[2] != TAG_BLUE) return;
+    uint16_t id = static_cast<uint16_t>(p[1] | (p[0] << 8));
+    std::lock_guard<std::mutex> lock(self->m);
+    if (id == self->lastId) return;
+    self->lastId = id;
+    self->showNs = emuNowNs();
+    self->rxNs = Serial.lastRxNs();
+    self->cv.notify_all();
+  }
+
+  bool waitFor(uint16_t id, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(m);
+    return cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&] { return lastId == id; });
+  }
+};
+
+void appendPacket(std::vector<uint8_t>& out, const std::vector<uint8_t>& pkt) {
+  out.insert(out.end(), pkt.begin(), pkt.end());
+}
+
+// Parser throughput: the firmware's own hostRuntime.poll() (and then loop())
+// fed from memory, so the numbers are CPU cost, not link speed.
+void benchParserThroughput(uint32_t frames) {
+  std::printf("parser throughput (%u frames from memory)\n", frames);
+
+  std::vector<uint8_t> plain, framed, delta;
+  pixelgrid::PacketWriter framedWriter(true);
+  pixelgrid::HostFrame prev;
+  for (uint32_t i = 0; i < frames; ++i) {
+    pixelgrid::HostFrame f = gameFrame(i);
+    appendPacket(plain, pixelgrid::buildPacket(HOST_PKT_FRAME, f.grb, sizeof(f.grb)));
+    appendPacket(framed, framedWriter.build(HOST_PKT_FRAME, f.grb, sizeof(f.grb)));
+    std::vector<uint8_t> enc = pixelgrid::encodeFrameBest(i ? prev.grb : nullptr, f.grb, pixelgrid::HostFrame::PIXELS);
+    appendPacket(delta, enc.empty() ? pixelgrid::buildPacket(HOST_PKT_FRAME, f.grb, sizeof(f.grb))
+                                    : pixelgrid::buildPacket(HOST_PKT_FRAME_DELTA, enc.data(), enc.size()));
+    prev = f;
+  }
+
+  struct Run {
+    const char* name;
+    const std::vector<uint8_t>* stream;
+    bool withLoop;
+  };
+  const Run runs[] = {
+      {"PBFR, HostRuntime::poll", &plain, false},
+      {"framed PBFR", &framed, false},
+      {"PBDF", &delta, false},
+      {"PBFR, loop() + show()", &plain, true},
+  };
+
+  for (const Run& r : runs) {
+    hostRuntime.reset();
+    Serial.attachMemory(r.stream->data(), r.stream->size());
+    uint32_t shows0 = strip.showCount();
+    uint32_t got = 0;
+
+    uint64_t t0 = emuNowNs();
+    // The parser stops after each frame, so small frames can still be
+    // buffered when Serial runs dry
+    bool more = true;
+    while (more) {
+      if (r.withLoop) {
+        loop();
+        more = Serial.available() > 0 || hostRuntime.displayDirty;
+      } else {
+        bool frame = hostRuntime.poll();
+        if (frame) ++got;
+        more = frame || Serial.available() > 0;
+      }
+    }
+    uint64_t ns = emuNowNs() - t0;
+    if (r.withLoop) got = strip.showCount() - shows0;
+
+    double secs = static_cast<double>(ns) / 1e9;
+    std::printf("  %-26s %8.0f frames/s  %7.1f MB/s  (%zu bytes)\n", r.name, got / secs,
+                static_cast<double>(r.stream->size()) / secs / 1e6, r.stream->size());
+    check(got == frames, r.withLoop ? "every frame is shown once" : "every frame is parsed");
+  }
+
+  Serial.detach();
+  hostRuntime.reset();
+  initStandaloneMode();
+}
+
+// A framed PBDF delta that is lost or fails its CRC must not leave later
+// deltas applied to the wrong reference: the firmware refuses them until
+// the next keyframe.
+void benchLostDelta() {
+  std::printf("lost deltas (framed PBDF from memory)\n");
+
+  pixelgrid::PacketWriter writer(true);
+  std::vector<uint8_t> stream;
+  pixelgrid::HostFrame f[7];
+  for (uint32_t i = 0; i < 7; ++i) f[i] = gameFrame(i);
+  auto key = [&](uint32_t i) { return writer.build(HOST_PKT_FRAME, f[i].grb, sizeof(f[i].grb)); };
+  auto delta = [&](uint32_t i) {
+    std::vector<uint8_t> enc = pixelgrid::encodeFrameBest(f[i - 1].grb, f[i].grb, pixelgrid::HostFrame::PIXELS);
+    check(!enc.empty() && frameEncodingIsDelta(enc[0]), "bench frames encode as deltas");
+    return writer.build(HOST_PKT_FRAME_DELTA, enc.data(), enc.size());
+  };
+
+  // Frame 1 never arrives; frame 3's CRC fails
+  appendPacket(stream, key(0));
+  delta(1);
+  appendPacket(stream, delta(2));
+  appendPacket(stream, key(3));
+  std::vector<uint8_t> bad = delta(4);
+  bad[bad.size() / 2] = static_cast<uint8_t>(bad[bad.size() / 2] == 1 ? 2 : 1);
+  appendPacket(stream, bad);
+  appendPacket(stream, delta(5));
+  appendPacket(stream, key(6));
+
+  hostRuntime.reset();
+  Serial.attachMemory(stream.data(), stream.size());
+  std::vector<bool> shown;
+  bool more = true;
+  while (more) {
+    bool frame = hostRuntime.poll();
+    if (frame) shown.push_back(std::memcmp(hostRuntime.grb, f[3].grb, sizeof(f[3].grb)) == 0);
+    more = frame || Serial.available() > 0;
+  }
+  const HostLinkStats& s = hostRuntime.stats();
+  std::printf("  %u of 6 frames shown, %u dropped, %u corrupt\n", static_cast<unsigned>(shown.size()),
+              s.dropped, s.corrupt);
+  check(shown.size() == 3, "deltas after a lost or corrupt frame are refused until a keyframe");
+  check(shown.size() > 1 && shown[1], "the keyframe after a lost delta is shown");
+  check(std::memcmp(hostRuntime.grb, f[6].grb, sizeof(f[6].grb)) == 0, "the last keyframe is shown");
+
+  Serial.detach();
+  hostRuntime.reset();
+  initStandaloneMode();
+}
+
+// End-to-end latency over a pty: host write done -> show(), and the
+// device-side part of it, last byte read from Serial -> show().
+void benchHostLatency(pixelgrid::SerialPort& host, ShowCapture& cap, uint32_t frames, bool framedPackets,
+                      uint16_t& nextId) {
+  std::printf("host-mode latency (%u %s frames over a pty)\n", frames, framedPackets ? "framed" : "plain");
+
+  pixelgrid::PacketWriter writer(framedPackets);
+  std::vector<double> endToEnd, device;
+  uint32_t shown = 0;
+  for (uint32_t i = 0; i < frames; ++i) {
+    uint16_t id = nextId++;
+    pixelgrid::HostFrame f = taggedFrame(id);
+    std::vector<uint8_t> pkt = writer.build(HOST_PKT_FRAME, f.grb, sizeof(f.grb));
+    if (!host.write(pkt.data(), pkt.size())) break;
+    uint64_t sentNs = emuNowNs();
+
+    if (cap.waitFor(id, 1000)) {
+      std::lock_guard<std::mutex> lock(cap.m);
+      ++shown;
+      endToEnd.push_back(static_cast<double>(cap.showNs - std::min(sentNs, cap.showNs)) / 1e3);
+      device.push_back(static_cast<double>(cap.showNs - cap.rxNs) / 1e3);
+    }
+    // Let the loop go idle again, as between frames at 60 fps
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+
+  reportLatency("host write -> show()", endToEnd);
+  reportLatency("last byte read -> show()", device);
+  check(shown == frames, "every frame sent over the pty is shown");
+}
+
+// A pressed button reaches the host as a 'b' input report while in host mode
+void benchInputReport(pixelgrid::SerialPort& host) {
+  pixelgrid::DeviceStreamParser rx;
+  uint8_t buf[256];
+  while (host.read(buf, sizeof(buf), 0) > 0) {
+  }
+
+  uint64_t t0 = emuNowNs();
+  emuSetPin(PIN_BTN1, LOW);
+  bool seen = false;
+  while (!seen && emuNowNs() - t0 < 500000000ull) {
+    size_t n = host.read(buf, sizeof(buf), 10);
+    rx.feed(buf, n);
+    uint8_t bits;
+    while (rx.popInput(bits)) seen = seen || (bits & 0x01);
+  }
+  double ms = static_cast<double>(emuNowNs() - t0) / 1e6;
+  emuSetPin(PIN_BTN1, HIGH);
+
+  // Wait for the release too, so the next bench starts from idle buttons
+  bool released = false;
+  t0 = emuNowNs();
+  while (seen && !released && emuNowNs() - t0 < 500000000ull) {
+    size_t n = host.read(buf, sizeof(buf), 10);
+    rx.feed(buf, n);
+    uint8_t bits;
+    while (rx.popInput(bits)) released = !(bits & 0x01);
+  }
+
+  std::printf("input report\n  button press -> 'b' report  %.1f ms (debounce %u ms)\n", ms, DEBOUNCE_MS);
+  check(seen, "a button press is reported to the host");
+  check(released, "the release is reported as well");
+}
+
+// Reads device output until done() or timeoutMs pass
+template <typename Done>
+bool readDeviceUntil(pixelgrid::SerialPort& host, pixelgrid::DeviceStreamParser& rx, int timeoutMs, Done done) {
+  uint8_t buf[256];
+  uint64_t end = emuNowNs() + static_cast<uint64_t>(timeoutMs) * 1000000ull;
+  while (emuNowNs() < end) {
+    rx.feed(buf, host.read(buf, sizeof(buf), 2));
+    if (done()) return true;
+  }
+  return false;
+}
+
+// PBIM switches the firmware to PBIN reports; PBPI/PBPO map its micros()
+// onto the host clock (here the same clock, so the mapping can be checked).
+// Two buttons pressed 5 ms apart must arrive as two edges with their own
+// timestamps, which 'b' bytes throttled to 15 ms cannot carry.
+void benchTimestampedInput(pixelgrid::SerialPort& host) {
+  pixelgrid::DeviceStreamParser rx;
+  pixelgrid::DeviceClock clock;
+  std::vector<pixelgrid::InputReport> reports;
+  std::vector<uint64_t> receivedUs;
+
+  auto pump = [&] {
+    pixelgrid::DevicePacket p;
+    while (rx.popPacket(p)) {
+      pixelgrid::InputReport r;
+      uint32_t token, deviceUs;
+      if (p.type == HOST_PKT_INPUT && pixelgrid::parseInputReport(p.payload.data(), p.payload.size(), r)) {
+        reports.push_back(r);
+        receivedUs.push_back(emuNowNs() / 1000);
+      } else if (p.type == HOST_PKT_PONG && pixelgrid::parsePong(p.payload.data(), p.payload.size(), token, deviceUs)) {
+        clock.addSample(static_cast<int64_t>(token), static_cast<int64_t>(emuNowNs() / 1000), deviceUs);
+      }
+    }
+  };
+
+  const uint8_t mode = HOST_INPUT_MODE_REPORTS;
+  std::vector<uint8_t> pkt = pixelgrid::buildPacket(HOST_PKT_INPUT_MODE, &mode, 1);
+  host.write(pkt.data(), pkt.size());
+
+  // The token is the send time; it only has to come back unchanged
+  for (int i = 0; i < 8; ++i) {
+    uint8_t ping[HOST_PING_BYTES];
+    hostWriteU32(ping, static_cast<uint32_t>(emuNowNs() / 1000));
+    pkt = pixelgrid::buildPacket(HOST_PKT_PING, ping, sizeof(ping));
+    size_t before = clock.valid() ? 1 : 0;
+    host.write(pkt.data(), pkt.size());
+    readDeviceUntil(host, rx, 100, [&] { pump(); return clock.valid() && (before == 0 || clock.lastRttUs() > 0); });
+  }
+  int64_t mapErrUs = clock.toHostUs(micros()) - static_cast<int64_t>(emuNowNs() / 1000);
+
+  uint64_t press1 = emuNowNs() / 1000;
+  emuSetPin(PIN_BTN1, LOW);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  uint64_t press2 = emuNowNs() / 1000;
+  emuSetPin(PIN_BTN2, LOW);
+
+  HostInputEvent e1{}, e2{};
+  bool have1 = false, have2 = false;
+  uint64_t rx2 = 0;
+  readDeviceUntil(host, rx, 500, [&] {
+    pump();
+    for (size_t i = 0; i < reports.size() && !have2; ++i) {
+      for (const HostInputEvent& e : reports[i].events) {
+        if (e.bits == 0x01 && !have1) {
+          e1 = e;
+          have1 = true;
+        }
+        if (e.bits == 0x03 && !have2) {
+          e2 = e;
+          have2 = true;
+          rx2 = receivedUs[i];
+        }
+      }
+    }
+    return have2;
+  });
+  emuSetPin(PIN_BTN1, HIGH);
+  emuSetPin(PIN_BTN2, HIGH);
+
+  std::printf("timestamped input (PBIN)\n  ping round trip            best %.1f us, mapping error %lld us\n",
+              clock.bestRttUs(), static_cast<long long>(mapErrUs));
+  check(clock.valid(), "the firmware answers PBPI");
+  check(mapErrUs > -1000 && mapErrUs < 1000, "PBPI/PBPO maps device time onto the host clock");
+  check(have1 && have2, "two presses 5 ms apart arrive as separate edges");
+  if (!have1 || !have2) return;
+
+  double gapMs = static_cast<int32_t>(e2.us - e1.us) / 1000.0;
+  double pressToEdgeMs = (clock.toHostUs(e2.us) - static_cast<int64_t>(press2)) / 1000.0;
+  double edgeToHostMs = (static_cast<int64_t>(rx2) - clock.toHostUs(e2.us)) / 1000.0;
+  std::printf("  edge spacing               %.1f ms (pressed %.1f ms apart)\n", gapMs, (press2 - press1) / 1000.0);
+  std::printf("  press -> edge timestamp    %.1f ms (debounce %u ms)\n", pressToEdgeMs, DEBOUNCE_MS);
+  std::printf("  edge -> report at host     %.1f ms\n", edgeToHostMs);
+  check(gapMs > 3.0 && gapMs < 8.0, "edge timestamps keep the 5 ms spacing");
+  check(pressToEdgeMs > -2.0 && pressToEdgeMs < 2.0, "edges are dated to the press, not the debounce");
+}
+
+// A clip streamed with PBAS/PBAD plays on the device's clock. Raw noise
+// frames make it many times the device's stream buffer, so the host has to
+// wait for PBAK credit; the last frame is tagged so its show() can be timed.
+void benchAnimationStream(pixelgrid::SerialPort& host, ShowCapture& cap, uint16_t& nextId) {
+  const uint16_t FRAMES = 30;
+  const uint16_t FRAME_MS = 30;
+  std::vector<pixelgrid::AnimFrame> frames(FRAMES);
+  uint32_t seed = 1;
+  for (uint16_t i = 0; i + 1 < FRAMES; ++i) {
+    for (uint8_t& b : frames[i].frame.grb) {
+      seed = seed * 1103515245u + 12345u;
+      b = static_cast<uint8_t>(seed >> 16);
+    }
+    frames[i].durationMs = FRAME_MS;
+  }
+  uint16_t lastId = nextId++;
+  frames[FRAMES - 1].frame = taggedFrame(lastId);
+  frames[FRAMES - 1].durationMs = FRAME_MS;
+  std::vector<uint8_t> clip = pixelgrid::encodeAnimation(frames, false);
+
+  pixelgrid::DeviceStreamParser rx;
+  pixelgrid::PacketWriter writer(false);
+  uint32_t shows0 = strip.showCount();
+  uint64_t t0 = emuNowNs();
+  pixelgrid::AnimStreamResult r = pixelgrid::streamAnimation(host, rx, writer, clip);
+  bool lastShown = cap.waitFor(lastId, 100);
+  uint32_t shows = strip.showCount() - shows0;
+  double lastMs = 0;
+  {
+    std::lock_guard<std::mutex> lock(cap.m);
+    lastMs = static_cast<double>(cap.showNs - t0) / 1e6;
+  }
+  double expectMs = (FRAMES - 1) * FRAME_MS;
+
+  std::printf("animation stream (%u frames of %u ms, %zu bytes, %u byte buffer)\n", FRAMES, FRAME_MS, clip.size(),
+              ANIM_STREAM_BYTES);
+  std::printf("  PBAS -> last frame shown    %.1f ms (clip timing %.0f ms)\n", lastMs, expectMs);
+  std::printf("  PBAK acks                   %u, played %.2f s\n", r.acks, r.seconds);
+  check(r.played, "a streamed clip plays to its end");
+  check(r.bytesSent == clip.size(), "the whole clip is sent");
+  check(lastShown && shows >= FRAMES, "every clip frame is shown");
+  check(lastMs >= expectMs - 5.0 && lastMs <= expectMs + 150.0, "clip frames keep their durations");
+}
+
+// Without frames the device drops back to standalone after HOST_TIMEOUT_MS.
+// PBSQ status queries keep coming meanwhile: link control is not host activity.
+void benchHostTimeout(pixelgrid::SerialPort& host, ShowCapture& cap, uint16_t& nextId) {
+  uint16_t id = nextId++;
+  pixelgrid::HostFrame f = taggedFrame(id);
+  std::vector<uint8_t> pkt = pixelgrid::buildPacket(HOST_PKT_FRAME, f.grb, sizeof(f.grb));
+  host.write(pkt.data(), pkt.size());
+  bool shown = cap.waitFor(id, 1000);
+  check(shown, "the last frame before the timeout is shown");
+
+  uint64_t lastFrameNs;
+  {
+    std::lock_guard<std::mutex> lock(cap.m);
+    lastFrameNs = cap.showNs;
+  }
+
+  std::vector<uint8_t> query = pixelgrid::buildPacket(HOST_PKT_STATUS_REQ, nullptr, 0);
+  uint64_t nextQuery = 0;
+  uint8_t drain[256];
+  const uint64_t limitNs = (HOST_TIMEOUT_MS + 1000ull) * 1000000ull;
+  while (hostRuntime.mode == MODE_HOST && emuNowNs() - lastFrameNs < limitNs) {
+    uint64_t now = emuNowNs();
+    if (now >= nextQuery) {
+      host.write(query.data(), query.size());
+      nextQuery = now + 250000000ull;
+    }
+    host.read(drain, sizeof(drain), 1);
+  }
+  double ms = static_cast<double>(emuNowNs() - lastFrameNs) / 1e6;
+
+  std::printf("host timeout\n  last frame -> standalone  %.1f ms (HOST_TIMEOUT_MS %u)\n", ms,
+              static_cast<unsigned>(HOST_TIMEOUT_MS));
+  check(hostRuntime.mode == MODE_STANDALONE, "the device leaves host mode when frames stop");
+  check(ms >= HOST_TIMEOUT_MS - 5.0 && ms <= HOST_TIMEOUT_MS + 100.0, "the timeout fires close to HOST_TIMEOUT_MS");
+}
+
+int runBench(uint32_t frames) {
+  setup();
+
+  benchParserThroughput(frames * 10);
+  benchLostDelta();
+
+  pixelgrid::SerialPort device, host;
+  std::string slave;
+  if (!device.openPty(slave) || !host.open(slave, HOST_DEFAULT_BAUD)) {
+    std::fprintf(stderr, "pty: %s%s\n", device.lastError().c_str(), host.lastError().c_str());
+    return 1;
+  }
+  Serial.attach(device.fd());
+  hostRuntime.reset();
+
+  ShowCapture cap;
+  Adafruit_NeoPixel::setShowHook(ShowCapture::hook, &cap);
+  DeviceThread dev;
+  dev.start();
+
+  uint16_t nextId = 1;
+  benchHostLatency(host, cap, frames, false, nextId);
+  benchHostLatency(host, cap, frames, true, nextId);
+  benchInputReport(host);
+  benchTimestampedInput(host);
+  benchAnimationStream(host, cap, nextId);
+  benchHostTimeout(host, cap, nextId);
+
+  dev.stop();
+  Adafruit_NeoPixel::setShowHook(nullptr, nullptr);
+  Serial.detach();
+
+  if (failures == 0) {
+    std::printf("All checks passed.\n");
+    return 0;
+  }
+  std::printf("%d check(s) failed.\n", failures);
+  return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string portPath;
+  bool usePty = false;
+  bool bench = false;
+  uint32_t seconds = 0;
+  uint32_t frames = 200;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--port" && hasValue) portPath = argv[++i];
+    else if (a == "--pty") usePty = true;
+    else if (a == "--bench") bench = true;
+    else if (a == "--seconds" && hasValue) seconds = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (a == "--frames" && hasValue) frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else return usage(argv[0]);
+  }
+
+  if (bench) return (usePty || !portPath.empty() || !frames) ? usage(argv[0]) : runBench(frames);
+  if (usePty == !portPath.empty()) return usage(argv[0]);
+  return runDevice(portPath, usePty, seconds);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+// LED strip backed by a GRB capture buffer. show() hands the buffer to the
+// emulator's hook instead of clocking it out to the LEDs.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+ public:
+  // Called from show() with the strip; the buffer is only valid during the call
+  using ShowHook = void (*)(const Adafruit_NeoPixel& strip, void* ctx);
+
+  Adafruit_NeoPixel(uint16_t n, int16_t pin = -1, uint16_t type = NEO_GRB + NEO_KHZ800)
+      : pixels_(static_cast<size_t>(n) * 3), pin_(pin), type_(type) {}
+
+  void begin() {}
+  void show() {
+    ++shows_;
+    if (hook_) hook_(*this, hookCtx_);
+  }
+  void clear() { std::fill(pixels_.begin(), pixels_.end(), 0); }
+  void setBrightness(uint8_t) {}
+
+  uint16_t numPixels() const { return static_cast<uint16_t>(pixels_.size() / 3); }
+  uint8_t* getPixels() { return pixels_.data(); }
+  const uint8_t* getPixels() const { return pixels_.data(); }
+  uint32_t showCount() const { return shows_; }
+
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+    if (n >= numPixels()) return;
+    uint8_t* p = &pixels_[static_cast<size_t>(n) * 3];
+    p[0] = g;
+    p[1] = r;
+    p[2] = b;
+  }
+  void setPixelColor(uint16_t n, uint32_t c) {
+    setPixelColor(n, static_cast<uint8_t>(c >> 16), static_cast<uint8_t>(c >> 8), static_cast<uint8_t>(c));
+  }
+  uint32_t getPixelColor(uint16_t n) const {
+    if (n >= numPixels()) return 0;
+    const uint8_t* p = &pixels_[static_cast<size_t>(n) * 3];
+    return Color(p[1], p[0], p[2]);
+  }
+
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | b;
+  }
+
+  // Same maths as the Adafruit library so title colours match the board
+  static uint32_t ColorHSV(uint16_t hue, uint8_t sat = 255, uint8_t val = 255) {
+    uint8_t r, g, b;
+    hue = static_cast<uint16_t>((hue * 1530L + 32768) / 65536);
+    if (hue < 510) {
+      b = 0;
+      if (hue < 255) { r = 255; g = static_cast<uint8_t>(hue); }
+      else { r = static_cast<uint8_t>(510 - hue); g = 255; }
+    } else if (hue < 1020) {
+      r = 0;
+      if (hue < 765) { g = 255; b = static_cast<uint8_t>(hue - 510); }
+      else { g = static_cast<uint8_t>(1020 - hue); b = 255; }
+    } else if (hue < 1530) {
+      g = 0;
+      if (hue < 1275) { r = static_cast<uint8_t>(hue - 1020); b = 255; }
+      else { r = 255; b = static_cast<uint8_t>(1530 - hue); }
+    } else {
+      r = 255; g = 0; b = 0;
+    }
+    uint32_t v1 = 1 + val;
+    uint16_t s1 = static_cast<uint16_t>(1 + sat);
+    uint8_t s2 = static_cast<uint8_t>(255 - sat);
+    return ((((((r * s1) >> 8) + s2) * v1) & 0xff00) << 8) |
+           (((((g * s1) >> 8) + s2) * v1) & 0xff00) |
+           (((((b * s1) >> 8) + s2) * v1) >> 8);
+  }
+  // The emulator shows linear values; gamma only matters on real LEDs
+  static uint32_t gamma32(uint32_t x) { return x; }
+
+  static void setShowHook(ShowHook hook, void* ctx) {
+    hook_ = hook;
+    hookCtx_ = ctx;
+  }
+
+ private:
+  std::vector<uint8_t> pixels_;
+  int16_t pin_;
+  uint16_t type_;
+  uint32_t shows_ = 0;
+
+  static inline ShowHook hook_ = nullptr;
+  static inline void* hookCtx_ = nullptr;
+};
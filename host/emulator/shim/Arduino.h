@@ -0,0 +1,194 @@
+#pragma once
+
+// Just enough of the Arduino core to build the Tetris sketch on Linux. Time
+// comes from the monotonic clock, Serial is a tty/pty file descriptor (or an
+// in-memory buffer for benchmarks) and pins are an array the emulator sets.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define A0 1
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+
+using std::max;
+using std::min;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+int analogRead(uint8_t pin);
+
+void randomSeed(unsigned long seed);
+long random(long max);
+long random(long min, long max);
+uint32_t esp_random();
+// The host clock is already set, so there is nothing to sync
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+typedef void (*voidFuncPtrArg)(void*);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+// The handler runs on the thread that calls emuSetPin(), standing in for
+// the interrupt; only CHANGE is supported.
+void attachInterruptArg(uint8_t pin, voidFuncPtrArg handler, void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+// The input register words, GPIO_IN_REG (bank 0, GPIO0-31) and
+// GPIO_IN1_REG (bank 1), built from the emulated pin levels
+uint32_t gpioInputBank(uint8_t bank);
+
+// Emulator control: drive an input pin (buttons are active LOW). A change
+// runs the pin's interrupt handler.
+void emuSetPin(uint8_t pin, int level);
+
+class String {
+ public:
+  String() = default;
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(unsigned int v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned int length() const { return static_cast<unsigned int>(s_.size()); }
+  void reserve(unsigned int n) { s_.reserve(n); }
+
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* o) { s_ += o; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+  char operator[](unsigned int i) const { return i < s_.size() ? s_[i] : 0; }
+
+  bool startsWith(const String& p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+  bool endsWith(const String& p) const {
+    return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+  }
+  int indexOf(char c, unsigned int from = 0) const { return found(s_.find(c, from)); }
+  int indexOf(const String& p, unsigned int from = 0) const { return found(s_.find(p.s_, from)); }
+  String substring(unsigned int from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from >= s_.size() || to <= from) return String();
+    return String(s_.substr(from, to - from));
+  }
+  void remove(unsigned int index) { if (index < s_.size()) s_.erase(index); }
+  void remove(unsigned int index, unsigned int count) { if (index < s_.size()) s_.erase(index, count); }
+  void replace(const String& from, const String& to) {
+    if (from.s_.empty()) return;
+    for (size_t i = s_.find(from.s_); i != std::string::npos; i = s_.find(from.s_, i + to.s_.size())) {
+      s_.replace(i, from.s_.size(), to.s_);
+    }
+  }
+
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  friend String operator+(const String& a, const char* b) { return String(a.s_ + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.s_); }
+
+ private:
+  static int found(size_t i) { return i == std::string::npos ? -1 : static_cast<int>(i); }
+
+  std::string s_;
+};
+
+// Only what sinks passed to HTTPClient::writeToStream() need
+class Stream {
+ public:
+  virtual ~Stream() = default;
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t* data, size_t n) {
+    size_t done = 0;
+    while (done < n && write(data[done])) ++done;
+    return done;
+  }
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() {}
+};
+
+// Serial over a file descriptor. Reads never block; writes wait briefly for
+// a full pty/tty buffer and then drop, like USB CDC with no host reading.
+class HardwareSerial {
+ public:
+  // Emulator side: where the bytes come from and go to
+  void attach(int fd);
+  // Serves reads from memory (writes are discarded) until the buffer is used up
+  void attachMemory(const uint8_t* data, size_t len);
+  void detach();
+
+  void begin(unsigned long baud) { baud_ = baud; }
+  void end() {}
+  void updateBaudRate(unsigned long baud) { baud_ = baud; }
+  void setTimeout(unsigned long ms) { timeoutMs_ = ms; }
+  unsigned long baudRate() const { return baud_; }
+
+  int available();
+  int read();
+  size_t readBytes(char* out, size_t n);
+  size_t readBytes(uint8_t* out, size_t n) { return readBytes(reinterpret_cast<char*>(out), n); }
+
+  size_t write(uint8_t b) { return write(&b, 1); }
+  size_t write(const uint8_t* data, size_t n);
+  size_t write(const char* s) { return write(reinterpret_cast<const uint8_t*>(s), strlen(s)); }
+  void flush() {}
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str()); }
+  size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+  size_t print(int v) { return print(String(v)); }
+  size_t print(unsigned int v) { return print(String(v)); }
+  size_t print(long v) { return print(String(v)); }
+  size_t print(unsigned long v) { return print(String(v)); }
+  template <typename T>
+  size_t println(const T& v) { return print(v) + println(); }
+  size_t println() { return write("\r\n"); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  // Monotonic time (ns) of the last read that returned data
+  uint64_t lastRxNs() const { return lastRxNs_; }
+  uint64_t rxBytes() const { return rxBytes_; }
+
+ private:
+  void noteRx(size_t n);
+
+  int fd_ = -1;
+  const uint8_t* mem_ = nullptr;
+  size_t memLeft_ = 0;
+  unsigned long baud_ = 0;
+  unsigned long timeoutMs_ = 1000;
+  uint64_t lastRxNs_ = 0;
+  uint64_t rxBytes_ = 0;
+};
+
+extern HardwareSerial Serial;
+
+// Monotonic clock in nanoseconds, the same one millis() uses
+uint64_t emuNowNs();
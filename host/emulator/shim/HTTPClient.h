@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+
+#include <string>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// HTTP/1.1 over the plain TCP WiFiClientSecure, with the parts of the ESP32
+// HTTPClient the sketch uses: POST with a Content-Length body, keep-alive
+// (setReuse), and the body read back through getString() or writeToStream().
+// https:// URLs are spoken as plain HTTP.
+class HTTPClient {
+ public:
+  bool begin(WiFiClientSecure& client, const String& url);
+  void setReuse(bool reuse) { reuse_ = reuse; }
+  void addHeader(const char* name, const char* value);
+  int POST(uint8_t* payload, size_t size);
+  String getString();
+  int writeToStream(Stream* stream);
+  void end();
+
+ private:
+  bool readHeaders(int& status);
+  bool readMore();
+
+  WiFiClientSecure* client_ = nullptr;
+  std::string host_;
+  uint16_t port_ = 80;
+  std::string path_;
+  std::string headers_;
+  std::string in_;            // read but not yet consumed
+  size_t bodyLeft_ = 0;
+  bool reuse_ = false;
+  bool serverClose_ = false;
+};
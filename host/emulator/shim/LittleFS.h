@@ -0,0 +1,86 @@
+#pragma once
+
+// LittleFS on a host directory. begin() mounts $PIXELGRID_EMU_FS and fails
+// when it isn't set, like a board without a data partition; "/title.pga"
+// then opens $PIXELGRID_EMU_FS/title.pga. Tests can mount a directory of
+// their own with begin(dir).
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace fs {
+
+class File {
+ public:
+  File() = default;
+  explicit File(std::FILE* f) {
+    if (f) f_.reset(f, std::fclose);
+  }
+
+  size_t read(uint8_t* buf, size_t n) { return f_ ? std::fread(buf, 1, n, f_.get()) : 0; }
+  int read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  bool seek(uint32_t pos) { return f_ && std::fseek(f_.get(), static_cast<long>(pos), SEEK_SET) == 0; }
+  size_t position() const { return f_ ? static_cast<size_t>(std::ftell(f_.get())) : 0; }
+  size_t size() const {
+    if (!f_) return 0;
+    long here = std::ftell(f_.get());
+    std::fseek(f_.get(), 0, SEEK_END);
+    long end = std::ftell(f_.get());
+    std::fseek(f_.get(), here, SEEK_SET);
+    return static_cast<size_t>(end);
+  }
+  size_t write(const uint8_t* buf, size_t n) { return f_ ? std::fwrite(buf, 1, n, f_.get()) : 0; }
+  size_t write(uint8_t c) { return write(&c, 1); }
+  void flush() {
+    if (f_) std::fflush(f_.get());
+  }
+  int available() const { return static_cast<int>(size() - position()); }
+  void close() { f_.reset(); }
+  explicit operator bool() const { return static_cast<bool>(f_); }
+
+ private:
+  std::shared_ptr<std::FILE> f_;
+};
+
+class FS {
+ public:
+  bool begin(bool formatOnFail = false) {
+    (void)formatOnFail;
+    const char* dir = std::getenv("PIXELGRID_EMU_FS");
+    return begin(std::string(dir ? dir : ""));
+  }
+  bool begin(const std::string& dir) {
+    root_ = dir;
+    return !root_.empty();
+  }
+  void end() { root_.clear(); }
+
+  File open(const char* path, const char* mode = "r") {
+    if (root_.empty()) return File();
+    std::string m = std::string(mode) + "b";
+    return File(std::fopen((root_ + path).c_str(), m.c_str()));
+  }
+  bool exists(const char* path) {
+    File f = open(path);
+    return static_cast<bool>(f);
+  }
+  bool remove(const char* path) { return !root_.empty() && std::remove((root_ + path).c_str()) == 0; }
+  bool rename(const char* from, const char* to) {
+    return !root_.empty() && std::rename((root_ + from).c_str(), (root_ + to).c_str()) == 0;
+  }
+
+ private:
+  std::string root_;
+};
+
+}  // namespace fs
+
+using fs::File;
+
+inline fs::FS LittleFS;
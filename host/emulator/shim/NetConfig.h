@@ -0,0 +1,16 @@
+#pragma once
+
+// Placeholder credentials. The emulator posts scores to emuApiBase(): the
+// PIXELGRID_EMU_API environment variable, or http://127.0.0.1:8080, where
+// host/pixelgrid_score_server listens by default.
+#define EDUROAM_SSID "emulator"
+#define EAP_IDENTITY "emulator"
+#define EAP_USERNAME "emulator"
+#define EAP_PASSWORD "emulator"
+#define API_BASE emuApiBase()
+#define GAME_CODE "EMU"
+#define GAME_SECRET "emulator"
+
+const char* emuApiBase();
+// Points score submission somewhere else (the net bench's own server)
+void emuSetApiBase(const char* url);
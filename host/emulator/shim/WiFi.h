@@ -0,0 +1,51 @@
+#pragma once
+
+// The emulator uses the host's network. Joining succeeds at once: begin()
+// reports an address through the onEvent() callback, and the host clock is
+// already set, so the firmware's link comes up on its first poll and score
+// submission goes straight to the HTTP request (NetShim.cpp), which fails
+// fast when no score server is listening.
+
+#include <Arduino.h>
+
+enum wl_status_t { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 };
+enum wifi_mode_t { WIFI_OFF = 0, WIFI_STA = 1 };
+enum arduino_event_id_t {
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+  ARDUINO_EVENT_MAX = 38
+};
+
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+
+class WiFiClass {
+ public:
+  wl_status_t status() const { return connected_ ? WL_CONNECTED : WL_DISCONNECTED; }
+  bool disconnect(bool = false, bool = false) {
+    if (connected_) {
+      connected_ = false;
+      emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    }
+    return true;
+  }
+  bool mode(wifi_mode_t) { return true; }
+  void begin(const char*) {
+    connected_ = true;
+    emit(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  }
+  String localIP() const { return String("127.0.0.1"); }
+  int onEvent(WiFiEventCb cb, arduino_event_id_t = ARDUINO_EVENT_MAX) {
+    cb_ = cb;
+    return 1;
+  }
+
+ private:
+  void emit(arduino_event_id_t event) {
+    if (cb_) cb_(event);
+  }
+
+  bool connected_ = false;
+  WiFiEventCb cb_ = nullptr;
+};
+
+inline WiFiClass WiFi;
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mbedtls/ssl.h>
+
+// What arduino-esp32 keeps per connection; only the mbedTLS context is used
+struct sslclient_context {
+  mbedtls_ssl_context ssl_ctx;
+};
+
+// Plain TCP: the emulator talks HTTP to a local server (see
+// host/src/ScoreServer.h), so there is no TLS and nothing to verify.
+class WiFiClientSecure {
+ public:
+  ~WiFiClientSecure() { stop(); }
+
+  void setInsecure() {}
+  int connect(const char* host, uint16_t port);
+  // connect() then stops before the handshake, which startTLS() does
+  void setPlainStart() { plainStart_ = true; }
+  int startTLS();
+  // Open, and the peer hasn't closed it
+  bool connected();
+  void stop();
+
+  // Writes everything or fails
+  bool writeAll(const uint8_t* data, size_t n);
+  // Waits up to timeoutMs for data; 0 on timeout, -1 once the peer closed
+  int read(uint8_t* out, size_t n, int timeoutMs);
+
+  const char* host() const { return host_; }
+  uint16_t port() const { return port_; }
+
+ protected:
+  sslclient_context* sslclient = &ssl_;
+
+ private:
+  sslclient_context ssl_{};
+  bool plainStart_ = false;
+  int fd_ = -1;
+  char host_[64] = {0};
+  uint16_t port_ = 0;
+};
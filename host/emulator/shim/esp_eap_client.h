@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int esp_err_t;
+typedef enum { ESP_EAP_TYPE_PEAP = 1 } esp_eap_method_t;
+
+static inline esp_err_t esp_eap_client_set_identity(const uint8_t*, int) { return 0; }
+static inline esp_err_t esp_eap_client_set_username(const uint8_t*, int) { return 0; }
+static inline esp_err_t esp_eap_client_set_password(const uint8_t*, int) { return 0; }
+static inline esp_err_t esp_eap_client_set_eap_methods(esp_eap_method_t) { return 0; }
+static inline void esp_eap_client_clear_ca_cert(void) {}
+static inline void esp_eap_client_clear_certificate_and_key(void) {}
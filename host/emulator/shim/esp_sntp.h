@@ -0,0 +1,8 @@
+#pragma once
+
+// The host clock is already set, so the firmware never waits for a sync and
+// the callback is never called.
+struct timeval;
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+static inline void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t) {}
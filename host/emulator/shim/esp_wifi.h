@@ -0,0 +1,5 @@
+#pragma once
+
+typedef int esp_err_t;
+
+static inline esp_err_t esp_wifi_sta_enterprise_enable(void) { return 0; }
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <mutex>
+
+#include "FreeRTOS.h"
+
+// Mutexes only; the sketch never gives up waiting for one.
+typedef std::mutex* SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::mutex; }
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t) {
+  m->lock();
+  return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t m) {
+  m->unlock();
+  return pdTRUE;
+}
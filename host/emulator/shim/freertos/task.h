@@ -0,0 +1,19 @@
+#pragma once
+
+#include <thread>
+
+#include "FreeRTOS.h"
+
+// Tasks are detached threads; vTaskDelete(NULL) at the end of a task body is
+// all the sketch uses, so returning from the function is enough.
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+static inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                                                 UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+  std::thread(fn, arg).detach();
+  if (handle) *handle = nullptr;
+  return pdPASS;
+}
+
+static inline void vTaskDelete(TaskHandle_t) {}
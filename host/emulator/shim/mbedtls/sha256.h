@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Portable stand-in for the SHA-256 half of mbedTLS 3.x, so DeviceSigner
+// signs in the emulator and the host tests the way it does on the board.
+// The whole state is one plain struct, so a clone is a copy.
+
+typedef struct mbedtls_sha256_context {
+  uint32_t state[8];
+  uint64_t total;
+  uint8_t used;
+  uint8_t buffer[64];
+} mbedtls_sha256_context;
+
+static inline uint32_t sha256Ror(uint32_t x, uint8_t n) { return (x >> n) | (x << (32 - n)); }
+
+static inline void mbedtls_sha256_compress(mbedtls_sha256_context* ctx, const uint8_t* p) {
+  static const uint32_t K[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+  uint32_t* st = ctx->state;
+
+  // 16-word rolling message schedule
+  uint32_t w[16];
+  for (uint8_t i = 0; i < 16; ++i) {
+    w[i] = ((uint32_t)p[4 * i] << 24) | ((uint32_t)p[4 * i + 1] << 16) | ((uint32_t)p[4 * i + 2] << 8) | p[4 * i + 3];
+  }
+  uint32_t a = st[0], b = st[1], c = st[2], d = st[3];
+  uint32_t e = st[4], f = st[5], g = st[6], h = st[7];
+  for (uint8_t i = 0; i < 64; ++i) {
+    if (i >= 16) {
+      uint32_t w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+      uint32_t s0 = sha256Ror(w15, 7) ^ sha256Ror(w15, 18) ^ (w15 >> 3);
+      uint32_t s1 = sha256Ror(w2, 17) ^ sha256Ror(w2, 19) ^ (w2 >> 10);
+      w[i & 15] += s0 + w[(i - 7) & 15] + s1;
+    }
+    uint32_t S1 = sha256Ror(e, 6) ^ sha256Ror(e, 11) ^ sha256Ror(e, 25);
+    uint32_t S0 = sha256Ror(a, 2) ^ sha256Ror(a, 13) ^ sha256Ror(a, 22);
+    uint32_t t1 = h + S1 + ((e & f) ^ (~e & g)) + K[i] + w[i & 15];
+    uint32_t t2 = S0 + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  st[0] += a; st[1] += b; st[2] += c; st[3] += d;
+  st[4] += e; st[5] += f; st[6] += g; st[7] += h;
+}
+
+static inline void mbedtls_sha256_init(mbedtls_sha256_context* ctx) { memset(ctx, 0, sizeof(*ctx)); }
+static inline void mbedtls_sha256_free(mbedtls_sha256_context* ctx) { memset(ctx, 0, sizeof(*ctx)); }
+
+static inline void mbedtls_sha256_clone(mbedtls_sha256_context* dst, const mbedtls_sha256_context* src) {
+  *dst = *src;
+}
+
+// SHA-224 isn't provided; is224 must be 0
+static inline int mbedtls_sha256_starts(mbedtls_sha256_context* ctx, int is224) {
+  static const uint32_t INIT[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  if (is224) return -1;
+  memcpy(ctx->state, INIT, sizeof(ctx->state));
+  ctx->total = 0;
+  ctx->used = 0;
+  return 0;
+}
+
+static inline int mbedtls_sha256_update(mbedtls_sha256_context* ctx, const unsigned char* input, size_t ilen) {
+  ctx->total += ilen;
+  if (ctx->used) {
+    size_t n = 64 - ctx->used;
+    if (n > ilen) n = ilen;
+    memcpy(ctx->buffer + ctx->used, input, n);
+    ctx->used = (uint8_t)(ctx->used + n);
+    input += n;
+    ilen -= n;
+    if (ctx->used < 64) return 0;
+    mbedtls_sha256_compress(ctx, ctx->buffer);
+    ctx->used = 0;
+  }
+  for (; ilen >= 64; input += 64, ilen -= 64) mbedtls_sha256_compress(ctx, input);
+  memcpy(ctx->buffer, input, ilen);
+  ctx->used = (uint8_t)ilen;
+  return 0;
+}
+
+static inline int mbedtls_sha256_finish(mbedtls_sha256_context* ctx, unsigned char output[32]) {
+  uint64_t bits = ctx->total * 8;
+  ctx->buffer[ctx->used++] = 0x80;
+  if (ctx->used > 64 - 8) {
+    memset(ctx->buffer + ctx->used, 0, 64 - ctx->used);
+    mbedtls_sha256_compress(ctx, ctx->buffer);
+    ctx->used = 0;
+  }
+  memset(ctx->buffer + ctx->used, 0, 64 - 8 - ctx->used);
+  for (uint8_t i = 0; i < 8; ++i) ctx->buffer[63 - i] = (uint8_t)(bits >> (8 * i));
+  mbedtls_sha256_compress(ctx, ctx->buffer);
+  for (uint8_t i = 0; i < 8; ++i) {
+    output[4 * i]     = (uint8_t)(ctx->state[i] >> 24);
+    output[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+    output[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+    output[4 * i + 3] = (uint8_t)ctx->state[i];
+  }
+  return 0;
+}
+
+static inline int mbedtls_sha256(const unsigned char* input, size_t ilen, unsigned char output[32], int is224) {
+  mbedtls_sha256_context ctx;
+  mbedtls_sha256_init(&ctx);
+  int ret = mbedtls_sha256_starts(&ctx, is224);
+  if (ret == 0) ret = mbedtls_sha256_update(&ctx, input, ilen);
+  if (ret == 0) ret = mbedtls_sha256_finish(&ctx, output);
+  mbedtls_sha256_free(&ctx);
+  return ret;
+}
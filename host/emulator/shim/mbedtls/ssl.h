@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+// The emulator's WiFiClientSecure is plain TCP, so a TLS session is just an
+// id: startTLS() issues one, or keeps the one offered through
+// mbedtls_ssl_set_session(), and mbedtls_ssl_get_session() hands it back.
+struct mbedtls_ssl_session {
+  uint32_t id;
+};
+
+struct mbedtls_ssl_context {
+  mbedtls_ssl_session offered;
+  mbedtls_ssl_session current;
+};
+
+#define MBEDTLS_ERR_SSL_BAD_INPUT_DATA -0x7100
+
+static inline void mbedtls_ssl_session_init(mbedtls_ssl_session* session) { session->id = 0; }
+static inline void mbedtls_ssl_session_free(mbedtls_ssl_session* session) { session->id = 0; }
+
+static inline int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session) {
+  ssl->offered = *session;
+  return 0;
+}
+
+static inline int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session) {
+  if (!ssl->current.id) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  *session = ssl->current;
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include "AnimEncoder.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Animation.h"
+#include "FrameEncoder.h"
+
+namespace pixelgrid {
+
+namespace {
+
+const uint16_t CLIP_PIXELS = HostFrame::W * HostFrame::H;
+
+void appendU16(std::vector<uint8_t>& out, uint16_t v) {
+  out.push_back(static_cast<uint8_t>(v));
+  out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+std::vector<uint8_t> framePayload(const HostFrame* prev, const HostFrame& frame) {
+  std::vector<uint8_t> payload = encodeFrameBest(prev ? prev->grb : nullptr, frame.grb, CLIP_PIXELS);
+  if (payload.empty()) {
+    payload.push_back(ANIM_ENC_RAW);
+    payload.insert(payload.end(), frame.grb, frame.grb + CLIP_PIXELS * 3);
+  }
+  return payload;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+}  // namespace
+
+HostFrame imageToFrame(const Image& image, uint8_t brightness) {
+  HostFrame f;
+  if (image.width == 0 || image.height == 0) return f;
+
+  for (uint8_t y = 0; y < HostFrame::H; ++y) {
+    uint32_t y0 = y * image.height / HostFrame::H;
+    uint32_t y1 = std::max(y0 + 1, (y + 1u) * image.height / HostFrame::H);
+    for (uint8_t x = 0; x < HostFrame::W; ++x) {
+      uint32_t x0 = x * image.width / HostFrame::W;
+      uint32_t x1 = std::max(x0 + 1, (x + 1u) * image.width / HostFrame::W);
+
+      uint64_t sum[3] = {0, 0, 0};
+      uint64_t count = 0;
+      for (uint32_t sy = y0; sy < y1 && sy < image.height; ++sy) {
+        for (uint32_t sx = x0; sx < x1 && sx < image.width; ++sx) {
+          const uint8_t* p = &image.rgba[(static_cast<size_t>(sy) * image.width + sx) * 4];
+          for (int c = 0; c < 3; ++c) sum[c] += p[c] * p[3] / 255u;
+          ++count;
+        }
+      }
+      uint8_t rgb[3];
+      for (int c = 0; c < 3; ++c) rgb[c] = static_cast<uint8_t>(sum[c] / count * brightness / 255u);
+      f.set(x, y, rgb[0], rgb[1], rgb[2]);
+    }
+  }
+  return f;
+}
+
+std::vector<uint8_t> encodeAnimation(const std::vector<AnimFrame>& frames, bool loop) {
+  // Merge repeats first so the header can carry the final frame count
+  std::vector<AnimFrame> merged;
+  for (const AnimFrame& f : frames) {
+    if (!merged.empty() && merged.back().frame == f.frame &&
+        merged.back().durationMs + static_cast<uint32_t>(f.durationMs) <= 0xFFFF) {
+      merged.back().durationMs = static_cast<uint16_t>(merged.back().durationMs + f.durationMs);
+    } else {
+      merged.push_back(f);
+    }
+  }
+
+  std::vector<uint8_t> body;
+  uint16_t maxPayload = 0;
+  const HostFrame* prev = nullptr;
+  for (const AnimFrame& f : merged) {
+    std::vector<uint8_t> payload = framePayload(prev, f.frame);
+    maxPayload = std::max(maxPayload, static_cast<uint16_t>(payload.size()));
+    appendU16(body, f.durationMs);
+    appendU16(body, static_cast<uint16_t>(payload.size()));
+    body.insert(body.end(), payload.begin(), payload.end());
+    prev = &f.frame;
+  }
+
+  std::vector<uint8_t> out = {'P', 'G', 'A', 'N', ANIM_VERSION, HostFrame::W, HostFrame::H,
+                              static_cast<uint8_t>(loop ? ANIM_FLAG_LOOP : 0)};
+  appendU16(out, static_cast<uint16_t>(merged.size()));
+  appendU16(out, maxPayload);
+  out.insert(out.end(), body.begin(), body.end());
+  return out;
+}
+
+bool parseAnimHeader(const uint8_t* data, size_t len, AnimInfo& out) {
+  if (len < ANIM_HEADER_BYTES || data[0] != 'P' || data[1] != 'G' || data[2] != 'A' || data[3] != 'N' ||
+      data[4] != ANIM_VERSION) {
+    return false;
+  }
+  out.width = data[5];
+  out.height = data[6];
+  out.flags = data[7];
+  out.frameCount = animReadU16(data + 8);
+  out.maxPayload = animReadU16(data + 10);
+  return true;
+}
+
+bool parseAnimAck(const uint8_t* payload, size_t len, uint32_t& consumed, uint16_t& bufferBytes, uint8_t& status) {
+  if (len != HOST_ANIM_ACK_BYTES) return false;
+  consumed = hostReadU32(payload);
+  bufferBytes = animReadU16(payload + 4);
+  status = payload[6];
+  return true;
+}
+
+AnimStreamResult streamAnimation(SerialPort& port, DeviceStreamParser& rx, PacketWriter& writer,
+                                 const std::vector<uint8_t>& clip, int timeoutMs) {
+  AnimStreamResult result;
+  auto t0 = std::chrono::steady_clock::now();
+  auto lastAck = t0;
+
+  std::vector<uint8_t> pkt = writer.build(HOST_PKT_ANIM_START, nullptr, 0);
+  if (!port.write(pkt.data(), pkt.size())) {
+    result.error = "write failed";
+    return result;
+  }
+
+  uint32_t consumed = 0;
+  uint16_t bufferBytes = 0;  // unknown until the first PBAK
+  uint8_t buf[256];
+  for (;;) {
+    while (bufferBytes && result.bytesSent < clip.size() && result.bytesSent - consumed < bufferBytes) {
+      size_t n = std::min({ANIM_DATA_PACKET_BYTES, clip.size() - result.bytesSent,
+                           static_cast<size_t>(bufferBytes - (result.bytesSent - consumed))});
+      pkt = writer.build(HOST_PKT_ANIM_DATA, clip.data() + result.bytesSent, n);
+      if (!port.write(pkt.data(), pkt.size())) {
+        result.error = "write failed";
+        return result;
+      }
+      result.bytesSent += static_cast<uint32_t>(n);
+    }
+
+    rx.feed(buf, port.read(buf, sizeof(buf), 10));
+    DevicePacket p;
+    while (rx.popPacket(p)) {
+      uint32_t c;
+      uint16_t size;
+      uint8_t status;
+      if (p.type != HOST_PKT_ANIM_ACK || !parseAnimAck(p.payload.data(), p.payload.size(), c, size, status)) continue;
+      consumed = c;
+      bufferBytes = size;
+      result.status = status;
+      result.acks++;
+      lastAck = std::chrono::steady_clock::now();
+    }
+
+    if (result.acks && result.status != ANIM_PLAYING) {
+      result.seconds = secondsSince(t0);
+      result.played = result.status == ANIM_DONE;
+      if (!result.played) result.error = result.status == ANIM_ERROR ? "device rejected the clip" : "clip was stopped";
+      return result;
+    }
+    if (secondsSince(lastAck) * 1000.0 > timeoutMs) {
+      result.seconds = secondsSince(t0);
+      result.error = "no answer from the device";
+      return result;
+    }
+  }
+}
+
+}  // namespace pixelgrid
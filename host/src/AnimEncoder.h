@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DeviceStream.h"
+#include "HostFrame.h"
+#include "ImageDecode.h"
+#include "PacketWriter.h"
+#include "SerialPort.h"
+
+// Host side of animation clips (libraries/PixelGridcore/src/Animation.h):
+// turning images into .pga files and streaming clips to a device.
+
+namespace pixelgrid {
+
+struct AnimFrame {
+  HostFrame frame;
+  uint16_t durationMs = 100;
+};
+
+// Scales an image onto the W x H board. Each cell is the average of the part
+// of the image it covers, with alpha composited over black, then scaled by
+// brightness / 255.
+HostFrame imageToFrame(const Image& image, uint8_t brightness = 255);
+
+// A clip of the board's W x H pixels. Each frame is stored in the smallest of
+// raw, RLE, palette and (after the first) XOR delta from the one before;
+// repeated frames are merged by adding up their durations.
+std::vector<uint8_t> encodeAnimation(const std::vector<AnimFrame>& frames, bool loop);
+
+struct AnimInfo {
+  uint8_t width = 0;
+  uint8_t height = 0;
+  uint8_t flags = 0;
+  uint16_t frameCount = 0;
+  uint16_t maxPayload = 0;
+};
+
+// Reads a clip header. False if data isn't a clip this version understands.
+bool parseAnimHeader(const uint8_t* data, size_t len, AnimInfo& out);
+
+// PBAK payload. False if it has the wrong length.
+bool parseAnimAck(const uint8_t* payload, size_t len, uint32_t& consumed, uint16_t& bufferBytes, uint8_t& status);
+
+struct AnimStreamResult {
+  bool played = false;  // the device played the clip to its end
+  uint8_t status = 0;   // last AnimStatus the device reported
+  uint32_t bytesSent = 0;
+  uint32_t acks = 0;
+  double seconds = 0;   // PBAS to the final PBAK
+  std::string error;
+};
+
+// PBAD payloads are at most this long
+const size_t ANIM_DATA_PACKET_BYTES = 512;
+
+// Streams a clip with PBAS/PBAD, never sending more than the device's buffer
+// has room for, and waits for it to finish playing. Fails if no PBAK arrives
+// for timeoutMs. Other packets that arrive meanwhile are discarded; input
+// reports stay queued in rx.
+AnimStreamResult streamAnimation(SerialPort& port, DeviceStreamParser& rx, PacketWriter& writer,
+                                 const std::vector<uint8_t>& clip, int timeoutMs = 1000);
+
+}  // namespace pixelgrid
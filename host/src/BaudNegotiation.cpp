@@ -0,0 +1,85 @@
+#include "BaudNegotiation.h"
+
+#include <chrono>
+
+#include "PacketWriter.h"
+
+namespace pixelgrid {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BaudAck {
+  uint32_t baud = 0;
+  uint8_t status = 0;
+};
+
+bool waitForAck(SerialPort& port, DeviceStreamParser& rx, Clock::time_point deadline, BaudAck& ack) {
+  uint8_t buf[256];
+  for (;;) {
+    DevicePacket p;
+    while (rx.popPacket(p)) {
+      if (p.type != HOST_PKT_BAUD_ACK || p.payload.size() != HOST_BAUD_ACK_BYTES) continue;
+      ack.baud = hostReadU32(p.payload.data());
+      ack.status = p.payload[4];
+      return true;
+    }
+
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    if (left <= 0) return false;
+    size_t n = port.read(buf, sizeof(buf), static_cast<int>(left));
+    rx.feed(buf, n);
+  }
+}
+
+bool sendPacket(SerialPort& port, uint16_t type, const uint8_t* payload, size_t len) {
+  std::vector<uint8_t> pkt = buildPacket(type, payload, len);
+  return port.write(pkt.data(), pkt.size());
+}
+
+}  // namespace
+
+const char* baudResultName(BaudResult r) {
+  switch (r) {
+    case BaudResult::Switched: return "switched";
+    case BaudResult::Rejected: return "rejected";
+    case BaudResult::NoAnswer: return "no answer";
+    case BaudResult::FellBack: return "fell back";
+  }
+  return "?";
+}
+
+BaudResult negotiateBaud(SerialPort& port, DeviceStreamParser& rx, uint32_t baud, int timeoutMs) {
+  const uint32_t oldBaud = port.baud();
+
+  uint8_t req[HOST_BAUD_REQ_BYTES];
+  hostWriteU32(req, baud);
+  if (!sendPacket(port, HOST_PKT_BAUD_REQ, req, sizeof(req))) return BaudResult::NoAnswer;
+
+  BaudAck ack;
+  if (!waitForAck(port, rx, Clock::now() + std::chrono::milliseconds(timeoutMs), ack)) {
+    return BaudResult::NoAnswer;
+  }
+  if (ack.status == HOST_BAUD_REJECTED || ack.baud != baud) return BaudResult::Rejected;
+
+  // The device switches as soon as the ack has left it
+  if (!port.setBaud(baud)) {
+    // Can't follow; the device times out back to oldBaud by itself
+    return BaudResult::FellBack;
+  }
+  // A PBBC after the device has confirmed is answered with its current
+  // rate, so a retry also recovers from a lost confirming PBBA
+  for (int i = 0; i < BAUD_CONFIRM_TRIES; ++i) {
+    if (sendPacket(port, HOST_PKT_BAUD_CONFIRM, nullptr, 0) &&
+        waitForAck(port, rx, Clock::now() + std::chrono::milliseconds(timeoutMs), ack) &&
+        ack.status == HOST_BAUD_CONFIRMED && ack.baud == baud) {
+      return BaudResult::Switched;
+    }
+  }
+
+  port.setBaud(oldBaud);
+  return BaudResult::FellBack;
+}
+
+}  // namespace pixelgrid
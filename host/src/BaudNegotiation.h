@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+#include "DeviceStream.h"
+#include "HostBaud.h"
+#include "SerialPort.h"
+
+// Host side of the PBBR/PBBA/PBBC handshake (libraries/PixelGridcore/src/HostBaud.h).
+// Packets other than PBBA that arrive while waiting are discarded; input
+// reports stay queued in the parser.
+
+namespace pixelgrid {
+
+enum class BaudResult {
+  Switched,  // both sides now run at the requested rate
+  Rejected,  // device doesn't support the rate; link unchanged
+  NoAnswer,  // no ack at the current rate; link unchanged
+  FellBack   // device switched but never confirmed; port restored to the old rate
+};
+
+// PBBC sent at the new rate before giving up: a lost PBBA costs a retry,
+// not the link
+const int BAUD_CONFIRM_TRIES = 3;
+
+const char* baudResultName(BaudResult r);
+
+// timeoutMs applies to each ack. Keep it at least HOST_BAUD_CONFIRM_MS so
+// that after FellBack a device that never saw a PBBC has given up on the
+// new rate as well.
+//
+// After FellBack the device may still be at the new rate: it took a PBBC
+// but none of its answers got through. It only drops back once the link
+// has been quiet for HOST_BAUD_IDLE_MS, and then to HOST_DEFAULT_BAUD. So a
+// caller must send nothing for HOST_BAUD_IDLE_MS before talking again, and
+// then talk at HOST_DEFAULT_BAUD if that isn't the old rate.
+BaudResult negotiateBaud(SerialPort& port, DeviceStreamParser& rx, uint32_t baud,
+                         int timeoutMs = static_cast<int>(HOST_BAUD_CONFIRM_MS));
+
+}  // namespace pixelgrid
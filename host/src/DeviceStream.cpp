@@ -0,0 +1,89 @@
+#include "DeviceStream.h"
+
+namespace pixelgrid {
+
+void DeviceStreamParser::feed(const uint8_t* data, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    uint8_t b = data[i];
+    switch (state_) {
+      case State::Idle:
+        if (b == 'b') state_ = State::InputByte;
+        else if (b == 'P') state_ = State::WaitB;
+        else ++skipped_;
+        break;
+
+      case State::InputByte:
+        inputs_.push_back(b);
+        state_ = State::Idle;
+        break;
+
+      case State::WaitB:
+        if (b == 'B') {
+          headerGot_ = 0;
+          state_ = State::Header;
+        } else if (b == 'b') {
+          ++skipped_;
+          state_ = State::InputByte;
+        } else if (b != 'P') {
+          skipped_ += 2;
+          state_ = State::Idle;
+        } else {
+          ++skipped_;
+        }
+        break;
+
+      case State::Header:
+        header_[headerGot_++] = b;
+        if (headerGot_ < 4) break;
+        current_.type = static_cast<uint16_t>((header_[0] << 8) | header_[1]);
+        need_ = static_cast<size_t>(header_[2] | (header_[3] << 8));
+        current_.payload.clear();
+        if (need_ == 0) {
+          packets_.push_back(current_);
+          state_ = State::Idle;
+        } else {
+          current_.payload.reserve(need_);
+          state_ = State::Payload;
+        }
+        break;
+
+      case State::Payload: {
+        size_t take = n - i;
+        if (take > need_) take = need_;
+        current_.payload.insert(current_.payload.end(), data + i, data + i + take);
+        need_ -= take;
+        i += take - 1;
+        if (need_ == 0) {
+          packets_.push_back(std::move(current_));
+          current_ = DevicePacket();
+          state_ = State::Idle;
+        }
+        break;
+      }
+    }
+  }
+}
+
+bool DeviceStreamParser::popInput(uint8_t& bits) {
+  if (inputs_.empty()) return false;
+  bits = inputs_.front();
+  inputs_.pop_front();
+  return true;
+}
+
+bool DeviceStreamParser::popPacket(DevicePacket& out) {
+  if (packets_.empty()) return false;
+  out = std::move(packets_.front());
+  packets_.pop_front();
+  return true;
+}
+
+void DeviceStreamParser::clear() {
+  state_ = State::Idle;
+  headerGot_ = 0;
+  need_ = 0;
+  inputs_.clear();
+  packets_.clear();
+}
+
+}  // namespace pixelgrid
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Splits what the device sends back into input reports and packets:
+//   'b' <bits>        packed input byte (see docs/API Documentation.md 3.1)
+//   'P' 'B' t0 t1 len payload
+// Anything else is counted and skipped.
+
+namespace pixelgrid {
+
+struct DevicePacket {
+  uint16_t type = 0;
+  std::vector<uint8_t> payload;
+};
+
+class DeviceStreamParser {
+ public:
+  void feed(const uint8_t* data, size_t n);
+
+  bool popInput(uint8_t& bits);
+  bool popPacket(DevicePacket& out);
+
+  size_t pendingInputs() const { return inputs_.size(); }
+  uint32_t skippedBytes() const { return skipped_; }
+
+  void clear();
+
+ private:
+  enum class State { Idle, InputByte, WaitB, Header, Payload };
+
+  State state_ = State::Idle;
+  uint8_t header_[4] = {};
+  size_t headerGot_ = 0;
+  DevicePacket current_;
+  size_t need_ = 0;
+  uint32_t skipped_ = 0;
+
+  std::deque<uint8_t> inputs_;
+  std::deque<DevicePacket> packets_;
+};
+
+}  // namespace pixelgrid
@@ -0,0 +1,111 @@
+#include "FrameEncoder.h"
+
+#include <cstring>
+
+#include "FrameCodec.h"
+
+namespace pixelgrid {
+
+namespace {
+
+bool samePixel(const uint8_t* a, const uint8_t* b) {
+  return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+}  // namespace
+
+std::vector<uint8_t> encodeFrameRle(const uint8_t* frame, size_t pixels) {
+  std::vector<uint8_t> out;
+  out.push_back(FRAME_ENC_RLE);
+
+  size_t px = 0;
+  while (px < pixels) {
+    const uint8_t* c = frame + px * 3;
+    size_t run = 1;
+    while (px + run < pixels && run < 255 && samePixel(c, frame + (px + run) * 3)) ++run;
+
+    out.push_back(static_cast<uint8_t>(run));
+    out.insert(out.end(), c, c + 3);
+    px += run;
+  }
+  return out;
+}
+
+std::vector<uint8_t> encodeFrameXorDelta(const uint8_t* prev, const uint8_t* frame, size_t pixels) {
+  std::vector<uint8_t> out;
+  out.push_back(FRAME_ENC_XOR_DELTA);
+
+  size_t px = 0;
+  while (px < pixels) {
+    size_t skip = 0;
+    while (px < pixels && skip < 255 && samePixel(prev + px * 3, frame + px * 3)) {
+      ++skip;
+      ++px;
+    }
+
+    size_t litStart = px;
+    size_t lit = 0;
+    while (px < pixels && lit < 255 && !samePixel(prev + px * 3, frame + px * 3)) {
+      ++lit;
+      ++px;
+    }
+
+    // Unchanged tail needs no run at all
+    if (lit == 0 && px == pixels) break;
+
+    out.push_back(static_cast<uint8_t>(skip));
+    out.push_back(static_cast<uint8_t>(lit));
+    for (size_t k = litStart * 3; k < (litStart + lit) * 3; ++k) {
+      out.push_back(static_cast<uint8_t>(prev[k] ^ frame[k]));
+    }
+  }
+  return out;
+}
+
+bool encodeFramePalette4(const uint8_t* frame, size_t pixels, std::vector<uint8_t>& out) {
+  uint8_t palette[FRAME_PALETTE_MAX * 3];
+  uint8_t n = 0;
+  std::vector<uint8_t> indices(pixels);
+
+  for (size_t px = 0; px < pixels; ++px) {
+    const uint8_t* c = frame + px * 3;
+    uint8_t idx = 0;
+    while (idx < n && !samePixel(palette + idx * 3, c)) ++idx;
+    if (idx == n) {
+      if (n == FRAME_PALETTE_MAX) return false;
+      std::memcpy(palette + n * 3, c, 3);
+      ++n;
+    }
+    indices[px] = idx;
+  }
+
+  out.clear();
+  out.push_back(FRAME_ENC_PALETTE4);
+  out.push_back(n);
+  out.insert(out.end(), palette, palette + n * 3);
+  for (size_t px = 0; px < pixels; px += 2) {
+    uint8_t hi = indices[px];
+    uint8_t lo = (px + 1 < pixels) ? indices[px + 1] : 0;
+    out.push_back(static_cast<uint8_t>((hi << 4) | lo));
+  }
+  return true;
+}
+
+std::vector<uint8_t> encodeFrameBest(const uint8_t* prev, const uint8_t* frame, size_t pixels) {
+  std::vector<uint8_t> best = encodeFrameRle(frame, pixels);
+
+  std::vector<uint8_t> candidate;
+  if (encodeFramePalette4(frame, pixels, candidate) && candidate.size() < best.size()) {
+    best.swap(candidate);
+  }
+
+  if (prev) {
+    candidate = encodeFrameXorDelta(prev, frame, pixels);
+    if (candidate.size() < best.size()) best.swap(candidate);
+  }
+
+  if (best.size() >= pixels * 3) best.clear();
+  return best;
+}
+
+}  // namespace pixelgrid
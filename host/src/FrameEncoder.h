@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Reference encoder for PBDF compressed frames. Decoding lives in
+// libraries/PixelGridcore/src/FrameCodec.h; every function here returns a
+// complete PBDF payload (encoding byte + body) that decodeFrame() accepts.
+// Frames are GRB, 3 bytes per pixel, in PBFR order.
+
+namespace pixelgrid {
+
+std::vector<uint8_t> encodeFrameRle(const uint8_t* frame, size_t pixels);
+
+std::vector<uint8_t> encodeFrameXorDelta(const uint8_t* prev, const uint8_t* frame, size_t pixels);
+
+// Fails (returns false) if the frame uses more than 16 distinct colours.
+bool encodeFramePalette4(const uint8_t* frame, size_t pixels, std::vector<uint8_t>& out);
+
+// Smallest of the encodings above. prev may be null when the device has no
+// reference frame (first frame, after a PBFS or a reset). Returns an empty
+// vector when a raw PBFR would be as small or smaller.
+std::vector<uint8_t> encodeFrameBest(const uint8_t* prev, const uint8_t* frame, size_t pixels);
+
+}  // namespace pixelgrid
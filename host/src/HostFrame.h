@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+#include "HostProtocol.h"
+
+// One PBFR frame: 256 GRB pixels. The board shows the first W * H of them,
+// column by column, with odd columns running bottom to top (the same
+// serpentine order as the LED wiring).
+
+namespace pixelgrid {
+
+struct HostFrame {
+  static const uint8_t W = 10;
+  static const uint8_t H = 20;
+  static const uint16_t PIXELS = HOST_FRAME_BYTES / 3;
+
+  uint8_t grb[HOST_FRAME_BYTES] = {};
+
+  // x = 0 is the left column, y = 0 the top row
+  static uint16_t index(uint8_t x, uint8_t y) {
+    uint8_t i = (x & 1) ? static_cast<uint8_t>(H - 1 - y) : y;
+    return static_cast<uint16_t>(x * H + i);
+  }
+
+  void set(uint8_t x, uint8_t y, uint8_t r, uint8_t g, uint8_t b) {
+    if (x >= W || y >= H) return;
+    uint8_t* p = grb + index(x, y) * 3;
+    p[0] = g;
+    p[1] = r;
+    p[2] = b;
+  }
+
+  void fill(uint8_t r, uint8_t g, uint8_t b) {
+    for (uint16_t i = 0; i < PIXELS; ++i) {
+      grb[i * 3 + 0] = g;
+      grb[i * 3 + 1] = r;
+      grb[i * 3 + 2] = b;
+    }
+  }
+
+  void clear() { std::memset(grb, 0, sizeof(grb)); }
+
+  bool operator==(const HostFrame& o) const { return std::memcmp(grb, o.grb, sizeof(grb)) == 0; }
+  bool operator!=(const HostFrame& o) const { return !(*this == o); }
+};
+
+// PB7S payload: three HUD digits and the last three score digits
+struct HostHud {
+  uint8_t masks[3] = {};
+  uint8_t rgb[3][3] = {};
+  uint16_t score = 0;
+
+  void payload(uint8_t out[15]) const {
+    for (int i = 0; i < 3; ++i) {
+      out[i] = masks[i];
+      out[3 + i * 3 + 0] = rgb[i][0];
+      out[3 + i * 3 + 1] = rgb[i][1];
+      out[3 + i * 3 + 2] = rgb[i][2];
+    }
+    out[12] = static_cast<uint8_t>(score / 100 % 10);
+    out[13] = static_cast<uint8_t>(score / 10 % 10);
+    out[14] = static_cast<uint8_t>(score % 10);
+  }
+};
+
+}  // namespace pixelgrid
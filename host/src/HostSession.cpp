@@ -0,0 +1,288 @@
+#include "HostSession.h"
+
+#include <algorithm>
+
+#include "FrameCodec.h"
+#include "FrameEncoder.h"
+
+namespace pixelgrid {
+
+namespace {
+
+const double RATE_SMOOTHING = 0.25; // weight of a new bandwidth sample
+const size_t MAX_PINGS_OUT = 8;     // unanswered pings remembered
+
+double toMs(std::chrono::steady_clock::duration d) {
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+}  // namespace
+
+int64_t hostNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+HostSession::HostSession(SerialPort& port, const HostSessionConfig& config)
+    : port_(port), config_(config), writer_(config.framed) {
+  stats_.linkBytesPerSec = port.baud() / 10.0;
+  Clock::time_point now = Clock::now();
+  lastConfirmAt_ = now;
+  nextFrameAt_ = now;
+  lastFrameAt_ = now;
+  nextPingAt_ = now;
+}
+
+void HostSession::submitFrame(const HostFrame& frame) {
+  stats_.framesSubmitted++;
+  if (frameDirty_) stats_.framesMerged++;
+  pending_ = frame;
+  frameDirty_ = true;
+}
+
+void HostSession::setLcdText(const std::string& text) {
+  lcd_ = text;
+  lcdDirty_ = true;
+}
+
+void HostSession::setHud(const HostHud& hud) {
+  hud_ = hud;
+  hudDirty_ = true;
+}
+
+void HostSession::service(int waitMs) {
+  readDevice(waitMs);
+
+  Clock::time_point now = Clock::now();
+  expireConfirmations(now);
+
+  if (config_.inputReports && !inputModeSent_) {
+    const uint8_t mode = HOST_INPUT_MODE_REPORTS;
+    send(HOST_PKT_INPUT_MODE, &mode, 1);
+    inputModeSent_ = true;
+  }
+  if (config_.pingEveryMs && now >= nextPingAt_) sendPing(now);
+
+  // LCD and HUD are a few bytes; they go out with the next frame slot, or on
+  // their own when the application isn't sending frames.
+  if ((lcdDirty_ || hudDirty_) && (frameDirty_ ? frameAllowed(now) : now >= nextFrameAt_)) {
+    if (lcdDirty_) {
+      send(HOST_PKT_LCD_TEXT, reinterpret_cast<const uint8_t*>(lcd_.data()), lcd_.size());
+      lcdDirty_ = false;
+    }
+    if (hudDirty_) {
+      uint8_t p[15];
+      hud_.payload(p);
+      send(HOST_PKT_HUD_7SEG, p, sizeof(p));
+      hudDirty_ = false;
+    }
+  }
+
+  if (!frameDirty_ && haveLastSent_ && toMs(now - lastFrameAt_) >= config_.keepAliveMs) {
+    // Keep host mode alive; unchanged frames compress to a few bytes
+    pending_ = lastSent_;
+    frameDirty_ = true;
+  }
+
+  if (frameDirty_ && frameAllowed(now)) sendFrame(now);
+}
+
+void HostSession::readDevice(int waitMs) {
+  uint8_t buf[512];
+  size_t n = port_.read(buf, sizeof(buf), waitMs);
+  while (n > 0) {
+    rx_.feed(buf, n);
+    n = port_.read(buf, sizeof(buf), 0);
+  }
+
+  DevicePacket p;
+  Clock::time_point now = Clock::now();
+  int64_t nowUs = hostNowUs();
+  uint8_t bits;
+  while (rx_.popInput(bits)) {
+    InputEdge e;
+    e.bits = bits;
+    e.hostUs = e.receivedUs = nowUs;
+    edges_.push_back(e);
+    lastBits_ = bits;
+  }
+  while (rx_.popPacket(p)) {
+    if (p.type == HOST_PKT_STATUS) onStatus(p, now);
+    else if (p.type == HOST_PKT_INPUT) onInputReport(p, nowUs);
+    else if (p.type == HOST_PKT_PONG) onPong(p, nowUs);
+  }
+}
+
+void HostSession::onInputReport(const DevicePacket& p, int64_t nowUs) {
+  InputReport r;
+  if (!parseInputReport(p.payload.data(), p.payload.size(), r)) return;
+  stats_.inputEdgesLost += r.lost;
+
+  InputEdge e;
+  e.timestamped = true;
+  e.receivedUs = nowUs;
+  for (const HostInputEvent& ev : r.events) {
+    e.bits = ev.bits;
+    e.deviceUs = ev.us;
+    e.hostUs = clock_.valid() ? clock_.toHostUs(ev.us) : nowUs;
+    edges_.push_back(e);
+    stats_.inputEdges++;
+  }
+  // A report without edges is the state when reports were switched on
+  if (r.events.empty() && r.bits != lastBits_) {
+    e.bits = r.bits;
+    e.deviceUs = r.deviceUs;
+    e.hostUs = clock_.valid() ? clock_.toHostUs(r.deviceUs) : nowUs;
+    edges_.push_back(e);
+  }
+  lastBits_ = r.bits;
+}
+
+void HostSession::onPong(const DevicePacket& p, int64_t nowUs) {
+  uint32_t token, deviceUs;
+  if (!parsePong(p.payload.data(), p.payload.size(), token, deviceUs)) return;
+  for (auto it = pings_.begin(); it != pings_.end(); ++it) {
+    if (it->token != token) continue;
+    clock_.addSample(it->sentUs, nowUs, deviceUs);
+    stats_.pingRttMs = (nowUs - it->sentUs) / 1000.0;
+    pings_.erase(pings_.begin(), it + 1); // older ones are lost
+    return;
+  }
+}
+
+void HostSession::sendPing(Clock::time_point now) {
+  uint8_t payload[HOST_PING_BYTES];
+  uint32_t token = nextPingToken_++;
+  hostWriteU32(payload, token);
+  send(HOST_PKT_PING, payload, sizeof(payload));
+  pings_.push_back({token, hostNowUs()});
+  if (pings_.size() > MAX_PINGS_OUT) pings_.pop_front();
+  nextPingAt_ = now + std::chrono::milliseconds(config_.pingEveryMs);
+}
+
+bool HostSession::popInput(uint8_t& bits) {
+  InputEdge e;
+  if (!popInputEdge(e)) return false;
+  bits = e.bits;
+  return true;
+}
+
+bool HostSession::popInputEdge(InputEdge& out) {
+  if (edges_.empty()) return false;
+  out = edges_.front();
+  edges_.pop_front();
+  return true;
+}
+
+void HostSession::onStatus(const DevicePacket& p, Clock::time_point now) {
+  StatusReply reply;
+  if (!parseStatusReply(p.payload.data(), p.payload.size(), reply)) return;
+  stats_.deviceConfirms = true;
+
+  // A framed packet the device lost or rejected may have been a frame
+  const HostLinkStats& link = reply.stats;
+  if (link.corrupt != stats_.deviceLink.corrupt || link.dropped != stats_.deviceLink.dropped) forceKeyframe();
+  stats_.deviceLink = link;
+
+  if (reply.hasToken) {
+    size_t i = 0;
+    while (i < inFlight_.size() && inFlight_[i].token != reply.token) ++i;
+    if (i == inFlight_.size()) {
+      // Its frame already timed out: the reply says nothing about the link now
+      stats_.lateConfirms++;
+      return;
+    }
+    // Replies for the frames before it never came
+    for (; i > 0; --i) {
+      inFlight_.pop_front();
+      stats_.framesUnconfirmed++;
+      forceKeyframe();
+    }
+  }
+  if (inFlight_.empty()) return;
+
+  InFlight done = inFlight_.front();
+  inFlight_.pop_front();
+  stats_.framesConfirmed++;
+  stats_.lastRttMs = toMs(now - done.sentAt);
+
+  // Only replies to back-to-back frames measure the link; otherwise the gap
+  // is just the application being idle.
+  if (done.sentAt < lastConfirmAt_) {
+    double secs = std::chrono::duration<double>(now - lastConfirmAt_).count();
+    if (secs > 0) {
+      double sample = done.bytes / secs;
+      stats_.linkBytesPerSec += RATE_SMOOTHING * (sample - stats_.linkBytesPerSec);
+    }
+  }
+  lastConfirmAt_ = now;
+}
+
+void HostSession::expireConfirmations(Clock::time_point now) {
+  while (!inFlight_.empty() && toMs(now - inFlight_.front().sentAt) >= config_.confirmTimeoutMs) {
+    inFlight_.pop_front();
+    stats_.framesUnconfirmed++;
+    // Without confirmations at all there is nothing to go on
+    if (stats_.deviceConfirms) forceKeyframe();
+  }
+}
+
+void HostSession::forceKeyframe() {
+  if (keyframeDue_ || !haveLastSent_) return;
+  keyframeDue_ = true;
+  stats_.keyframesForced++;
+}
+
+bool HostSession::frameAllowed(Clock::time_point now) const {
+  if (now < nextFrameAt_) return false;
+  // Confirmations come back at the rate the link and device actually manage,
+  // so the in-flight window alone paces to the measured bandwidth. Without
+  // them, wait until the estimated link time of the last frame has passed.
+  if (stats_.deviceConfirms) return inFlight_.size() < config_.maxInFlight;
+  double linkSecs = lastFrameBytes_ / std::max(stats_.linkBytesPerSec, 1.0);
+  return now >= lastFrameAt_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(linkSecs));
+}
+
+void HostSession::sendFrame(Clock::time_point now) {
+  std::vector<uint8_t> encoded;
+  if (config_.compress) {
+    bool keyframe = !haveLastSent_ || keyframeDue_ || sinceKeyframe_ >= config_.keyframeEvery;
+    encoded = encodeFrameBest(keyframe ? nullptr : lastSent_.grb, pending_.grb, HostFrame::PIXELS);
+    if (keyframe) sinceKeyframe_ = 0;
+  }
+  if (!encoded.empty()) {
+    send(HOST_PKT_FRAME_DELTA, encoded.data(), encoded.size());
+    if (frameEncodingIsDelta(encoded[0])) sinceKeyframe_++;
+  } else {
+    send(HOST_PKT_FRAME, pending_.grb, sizeof(pending_.grb));
+    sinceKeyframe_ = 0;
+  }
+  uint8_t token[HOST_STATUS_TOKEN_BYTES];
+  uint32_t tokenValue = nextStatusToken_++;
+  hostWriteU32(token, tokenValue);
+  send(HOST_PKT_STATUS_REQ, token, sizeof(token));
+
+  size_t bytes = pendingBytes_;
+  pendingBytes_ = 0;
+  inFlight_.push_back({now, bytes, tokenValue});
+
+  if (sinceKeyframe_ == 0) keyframeDue_ = false;
+  lastSent_ = pending_;
+  haveLastSent_ = true;
+  frameDirty_ = false;
+  lastFrameAt_ = now;
+  lastFrameBytes_ = bytes;
+  stats_.framesSent++;
+
+  double fpsSecs = config_.maxFps ? 1.0 / config_.maxFps : 0.0;
+  nextFrameAt_ = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(fpsSecs));
+}
+
+void HostSession::send(uint16_t type, const uint8_t* payload, size_t len) {
+  std::vector<uint8_t> pkt = writer_.build(type, payload, len);
+  if (!port_.write(pkt.data(), pkt.size())) return;
+  stats_.bytesSent += pkt.size();
+  pendingBytes_ += pkt.size();
+}
+
+}  // namespace pixelgrid
@@ -0,0 +1,166 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "DeviceStream.h"
+#include "HostFrame.h"
+#include "InputReport.h"
+#include "PacketWriter.h"
+#include "SerialPort.h"
+
+// Drives a board in host mode. The application submits frames, LCD text and
+// HUD state whenever it likes; service() decides what actually goes out.
+//
+// Nothing is ever queued: each of frame / LCD / HUD has one pending slot and
+// a newer submit replaces an unsent one (counted as merged). A frame is only
+// sent while fewer than maxInFlight frames are unconfirmed, and no faster
+// than the measured link bandwidth allows, so a slow link or a busy device
+// costs frames, not latency.
+//
+// Confirmation: every frame is followed by a PBSQ with a token, and the PBST
+// reply echoes it. A reply for a frame whose confirmation already timed out
+// is ignored, and one that skips earlier frames means their replies were
+// lost. (Firmware that predates tokens is matched oldest first.) The spacing
+// of replies while the link is kept busy is the measured bandwidth
+// (linkBytesPerSec). Firmware that doesn't answer PBSQ is paced on time
+// alone, at the last measured or the nominal rate (baud / 10).
+//
+// Deltas are XORed against the last frame sent, which the device only holds
+// if that frame arrived. A confirmation that times out, or a PBST whose
+// corrupt or dropped count went up, makes the next frame a keyframe.
+//
+// Input: the session asks for PBIN reports (PBIM), which carry every edge
+// with the device time it was seen, and pings the device (PBPI) to map that
+// time onto the host clock. Firmware without them keeps sending 'b' bytes;
+// both end up in the same queue.
+
+namespace pixelgrid {
+
+struct HostSessionConfig {
+  bool framed = false;            // COBS + CRC framing
+  bool compress = true;           // PBDF when smaller than PBFR
+  uint32_t keyframeEvery = 60;    // frames between deltas and a full keyframe
+  uint32_t maxFps = 60;
+  uint8_t maxInFlight = 2;        // frames sent but not yet confirmed
+  uint32_t confirmTimeoutMs = 1000;
+  uint32_t keepAliveMs = 1000;    // resend the last frame when idle (HOST_TIMEOUT_MS is 2500)
+  bool inputReports = true;       // ask for timestamped PBIN input reports
+  uint32_t pingEveryMs = 1000;    // PBPI clock/latency probes, 0 = never
+};
+
+struct HostSessionStats {
+  uint64_t framesSubmitted = 0;
+  uint64_t framesSent = 0;
+  uint64_t framesMerged = 0;      // replaced before they could be sent
+  uint64_t framesConfirmed = 0;
+  uint64_t framesUnconfirmed = 0; // confirmation timed out or never came
+  uint64_t lateConfirms = 0;      // PBST for a frame that had already timed out
+  uint64_t bytesSent = 0;
+  double linkBytesPerSec = 0;     // current estimate
+  double lastRttMs = 0;           // frame write to its PBST
+  bool deviceConfirms = false;    // device has answered a PBSQ
+  uint64_t inputEdges = 0;        // edges received in PBIN reports
+  uint64_t inputEdgesLost = 0;    // edges the device had to drop
+  double pingRttMs = 0;           // last PBPI/PBPO round trip
+  uint64_t keyframesForced = 0;   // after a lost confirmation or a device-side drop
+  HostLinkStats deviceLink;       // the device's counters from the last PBST
+};
+
+struct InputEdge {
+  uint8_t bits = 0;           // packed input byte after the edge
+  bool timestamped = false;   // from a PBIN report rather than a 'b' byte
+  uint32_t deviceUs = 0;      // device micros() when the edge was seen
+  int64_t hostUs = 0;         // the same moment on the host clock (hostNowUs), once pings
+                              // have come back; otherwise when it was received
+  int64_t receivedUs = 0;     // when the report reached the host
+};
+
+// Host clock used for InputEdge times: steady_clock in microseconds
+int64_t hostNowUs();
+
+class HostSession {
+ public:
+  explicit HostSession(SerialPort& port, const HostSessionConfig& config = HostSessionConfig());
+
+  void submitFrame(const HostFrame& frame);
+  void setLcdText(const std::string& text);
+  void setHud(const HostHud& hud);
+
+  // Reads device output (waiting up to waitMs for it) and sends what pacing
+  // allows. Call it often; it never blocks longer than waitMs plus one write.
+  void service(int waitMs = 0);
+
+  // Input changes in arrival order, with or without timing
+  bool popInput(uint8_t& bits);
+  bool popInputEdge(InputEdge& out);
+  DeviceStreamParser& rx() { return rx_; }
+  const DeviceClock& deviceClock() const { return clock_; }
+
+  // Frames sent but not yet confirmed
+  size_t inFlight() const { return inFlight_.size(); }
+  bool framePending() const { return frameDirty_; }
+  const HostSessionStats& stats() const { return stats_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct InFlight {
+    Clock::time_point sentAt;
+    size_t bytes;
+    uint32_t token; // sent in its PBSQ
+  };
+
+  void readDevice(int waitMs);
+  void onStatus(const DevicePacket& p, Clock::time_point now);
+  void forceKeyframe();
+  void onInputReport(const DevicePacket& p, int64_t nowUs);
+  void onPong(const DevicePacket& p, int64_t nowUs);
+  void sendPing(Clock::time_point now);
+  void expireConfirmations(Clock::time_point now);
+  bool frameAllowed(Clock::time_point now) const;
+  void sendFrame(Clock::time_point now);
+  void send(uint16_t type, const uint8_t* payload, size_t len);
+
+  SerialPort& port_;
+  HostSessionConfig config_;
+  PacketWriter writer_;
+  DeviceStreamParser rx_;
+  HostSessionStats stats_;
+
+  HostFrame pending_;
+  bool frameDirty_ = false;
+  std::string lcd_;
+  bool lcdDirty_ = false;
+  HostHud hud_;
+  bool hudDirty_ = false;
+
+  HostFrame lastSent_;
+  bool haveLastSent_ = false;
+  uint32_t sinceKeyframe_ = 0;
+  bool keyframeDue_ = false;
+
+  std::deque<InFlight> inFlight_;
+  uint32_t nextStatusToken_ = 0;
+  Clock::time_point lastConfirmAt_;
+  Clock::time_point nextFrameAt_;
+  Clock::time_point lastFrameAt_;
+  size_t lastFrameBytes_ = 0;
+  size_t pendingBytes_ = 0; // bytes written since the last frame went out
+
+  std::deque<InputEdge> edges_;
+  uint8_t lastBits_ = 0;
+  bool inputModeSent_ = false;
+  DeviceClock clock_;
+  struct Ping {
+    uint32_t token;
+    int64_t sentUs;
+  };
+  std::deque<Ping> pings_;
+  uint32_t nextPingToken_ = 1;
+  Clock::time_point nextPingAt_;
+};
+
+}  // namespace pixelgrid
@@ -0,0 +1,664 @@
+#include "ImageDecode.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace pixelgrid {
+
+namespace {
+
+// Refuse images that would need absurd amounts of memory
+const uint64_t MAX_PIXELS = 16u * 1024u * 1024u;
+
+uint32_t readBe32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+uint16_t readLe16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+// ---- inflate (RFC 1951), after zlib's puff.c ----
+
+// LSB-first bit reader; ok() turns false once a read runs past the end
+class BitReader {
+ public:
+  BitReader(const uint8_t* p, size_t n) : p_(p), n_(n) {}
+
+  uint32_t bits(int need) {
+    uint32_t val = buf_;
+    while (cnt_ < need) {
+      if (pos_ >= n_) {
+        ok_ = false;
+        return 0;
+      }
+      val |= static_cast<uint32_t>(p_[pos_++]) << cnt_;
+      cnt_ += 8;
+    }
+    buf_ = val >> need;
+    cnt_ -= need;
+    return val & ((1u << need) - 1);
+  }
+
+  // Drops the rest of the current byte
+  void align() {
+    buf_ = 0;
+    cnt_ = 0;
+  }
+
+  bool ok() const { return ok_; }
+  size_t pos() const { return pos_; }
+  void skip(size_t n) { pos_ += n; }
+  const uint8_t* data() const { return p_; }
+  size_t size() const { return n_; }
+
+ private:
+  const uint8_t* p_;
+  size_t n_;
+  size_t pos_ = 0;
+  uint32_t buf_ = 0;
+  int cnt_ = 0;
+  bool ok_ = true;
+};
+
+const int MAX_BITS = 15;
+
+struct Huffman {
+  uint16_t count[MAX_BITS + 1];
+  uint16_t symbol[288];
+};
+
+// Canonical code from code lengths. Returns 0 for a complete code, > 0 for
+// an incomplete one and < 0 for an over-subscribed one.
+int buildHuffman(Huffman& h, const uint8_t* length, int n) {
+  std::memset(h.count, 0, sizeof(h.count));
+  for (int s = 0; s < n; ++s) h.count[length[s]]++;
+  if (h.count[0] == n) return 0;
+
+  int left = 1;
+  for (int len = 1; len <= MAX_BITS; ++len) {
+    left <<= 1;
+    left -= h.count[len];
+    if (left < 0) return left;
+  }
+
+  uint16_t offs[MAX_BITS + 1];
+  offs[1] = 0;
+  for (int len = 1; len < MAX_BITS; ++len) offs[len + 1] = static_cast<uint16_t>(offs[len] + h.count[len]);
+  for (int s = 0; s < n; ++s) {
+    if (length[s]) h.symbol[offs[length[s]]++] = static_cast<uint16_t>(s);
+  }
+  return left;
+}
+
+int decodeSymbol(BitReader& br, const Huffman& h) {
+  int code = 0, first = 0, index = 0;
+  for (int len = 1; len <= MAX_BITS; ++len) {
+    code |= static_cast<int>(br.bits(1));
+    int count = h.count[len];
+    if (code - count < first) return h.symbol[index + (code - first)];
+    index += count;
+    first += count;
+    first <<= 1;
+    code <<= 1;
+  }
+  return -1;
+}
+
+const uint16_t LEN_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                               31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t LEN_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t DIST_BASE[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+bool inflateCodes(BitReader& br, const Huffman& lencode, const Huffman& distcode, std::vector<uint8_t>& out) {
+  for (;;) {
+    int sym = decodeSymbol(br, lencode);
+    if (sym < 0 || !br.ok()) return false;
+    if (sym < 256) {
+      out.push_back(static_cast<uint8_t>(sym));
+      continue;
+    }
+    if (sym == 256) return true;
+
+    sym -= 257;
+    if (sym >= 29) return false;
+    size_t len = LEN_BASE[sym] + br.bits(LEN_EXTRA[sym]);
+    int ds = decodeSymbol(br, distcode);
+    if (ds < 0 || ds >= 30) return false;
+    size_t dist = DIST_BASE[ds] + br.bits(DIST_EXTRA[ds]);
+    if (!br.ok() || dist > out.size()) return false;
+    size_t from = out.size() - dist;
+    for (size_t i = 0; i < len; ++i) out.push_back(out[from + i]);
+  }
+}
+
+bool inflateStored(BitReader& br, std::vector<uint8_t>& out) {
+  br.align();
+  size_t at = br.pos();
+  if (at + 4 > br.size()) return false;
+  const uint8_t* p = br.data() + at;
+  uint16_t len = readLe16(p);
+  if (static_cast<uint16_t>(~len) != readLe16(p + 2)) return false;
+  if (at + 4 + len > br.size()) return false;
+  out.insert(out.end(), p + 4, p + 4 + len);
+  br.skip(4 + len);
+  return true;
+}
+
+bool inflateFixed(BitReader& br, std::vector<uint8_t>& out) {
+  static Huffman lencode, distcode;
+  static bool built = false;
+  if (!built) {
+    uint8_t lengths[288];
+    int s = 0;
+    for (; s < 144; ++s) lengths[s] = 8;
+    for (; s < 256; ++s) lengths[s] = 9;
+    for (; s < 280; ++s) lengths[s] = 7;
+    for (; s < 288; ++s) lengths[s] = 8;
+    buildHuffman(lencode, lengths, 288);
+    for (s = 0; s < 30; ++s) lengths[s] = 5;
+    buildHuffman(distcode, lengths, 30);
+    built = true;
+  }
+  return inflateCodes(br, lencode, distcode, out);
+}
+
+bool inflateDynamic(BitReader& br, std::vector<uint8_t>& out) {
+  static const uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+  int nlen = static_cast<int>(br.bits(5)) + 257;
+  int ndist = static_cast<int>(br.bits(5)) + 1;
+  int ncode = static_cast<int>(br.bits(4)) + 4;
+  if (!br.ok() || nlen > 286 || ndist > 30) return false;
+
+  uint8_t lengths[320] = {};
+  for (int i = 0; i < ncode; ++i) lengths[ORDER[i]] = static_cast<uint8_t>(br.bits(3));
+  Huffman lencode, distcode;
+  if (buildHuffman(lencode, lengths, 19) != 0) return false;
+
+  int index = 0;
+  while (index < nlen + ndist) {
+    int sym = decodeSymbol(br, lencode);
+    if (sym < 0 || !br.ok()) return false;
+    if (sym < 16) {
+      lengths[index++] = static_cast<uint8_t>(sym);
+      continue;
+    }
+    uint8_t len = 0;
+    int repeat;
+    if (sym == 16) {
+      if (index == 0) return false;
+      len = lengths[index - 1];
+      repeat = 3 + static_cast<int>(br.bits(2));
+    } else if (sym == 17) {
+      repeat = 3 + static_cast<int>(br.bits(3));
+    } else {
+      repeat = 11 + static_cast<int>(br.bits(7));
+    }
+    if (index + repeat > nlen + ndist) return false;
+    while (repeat--) lengths[index++] = len;
+  }
+  if (lengths[256] == 0) return false;
+
+  // Incomplete codes are only allowed for a single length
+  int err = buildHuffman(lencode, lengths, nlen);
+  if (err < 0 || (err > 0 && nlen - lencode.count[0] != 1)) return false;
+  err = buildHuffman(distcode, lengths + nlen, ndist);
+  if (err < 0 || (err > 0 && ndist - distcode.count[0] != 1)) return false;
+
+  return inflateCodes(br, lencode, distcode, out);
+}
+
+uint32_t adler32(const std::vector<uint8_t>& data) {
+  uint32_t a = 1, b = 0;
+  for (uint8_t c : data) {
+    a = (a + c) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+// ---- PNG ----
+
+uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+  int p = a + b - c;
+  int pa = p > a ? p - a : a - p;
+  int pb = p > b ? p - b : b - p;
+  int pc = p > c ? p - c : c - p;
+  if (pa <= pb && pa <= pc) return a;
+  return pb <= pc ? b : c;
+}
+
+bool unfilterPng(std::vector<uint8_t>& raw, uint32_t height, size_t stride, size_t bpp) {
+  std::vector<uint8_t> zero(stride, 0);
+  for (uint32_t y = 0; y < height; ++y) {
+    uint8_t* line = &raw[y * (stride + 1)];
+    uint8_t filter = line[0];
+    uint8_t* cur = line + 1;
+    const uint8_t* up = y ? &raw[(y - 1) * (stride + 1) + 1] : zero.data();
+    for (size_t i = 0; i < stride; ++i) {
+      uint8_t a = i >= bpp ? cur[i - bpp] : 0;
+      uint8_t c = i >= bpp ? up[i - bpp] : 0;
+      switch (filter) {
+        case 0: break;
+        case 1: cur[i] = static_cast<uint8_t>(cur[i] + a); break;
+        case 2: cur[i] = static_cast<uint8_t>(cur[i] + up[i]); break;
+        case 3: cur[i] = static_cast<uint8_t>(cur[i] + ((a + up[i]) >> 1)); break;
+        case 4: cur[i] = static_cast<uint8_t>(cur[i] + paeth(a, up[i], c)); break;
+        default: return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Sample c of pixel x at the image's own bit depth
+uint16_t pngSample(const uint8_t* row, uint32_t x, int c, int channels, int depth) {
+  size_t index = static_cast<size_t>(x) * channels + c;
+  if (depth == 16) return static_cast<uint16_t>((row[index * 2] << 8) | row[index * 2 + 1]);
+  if (depth == 8) return row[index];
+  size_t bit = index * depth;
+  int shift = 8 - depth - static_cast<int>(bit % 8);
+  return static_cast<uint16_t>((row[bit / 8] >> shift) & ((1 << depth) - 1));
+}
+
+uint8_t to8(uint16_t v, int depth) {
+  if (depth == 16) return static_cast<uint8_t>(v >> 8);
+  return static_cast<uint8_t>(v * 255 / ((1 << depth) - 1));
+}
+
+// ---- GIF ----
+
+// Concatenates data sub-blocks starting at pos; pos ends past the terminator
+bool readSubBlocks(const uint8_t* data, size_t len, size_t& pos, std::vector<uint8_t>* out) {
+  for (;;) {
+    if (pos >= len) return false;
+    uint8_t n = data[pos++];
+    if (n == 0) return true;
+    if (pos + n > len) return false;
+    if (out) out->insert(out->end(), data + pos, data + pos + n);
+    pos += n;
+  }
+}
+
+bool lzwDecode(const std::vector<uint8_t>& in, int minCodeSize, size_t pixels, std::vector<uint8_t>& out) {
+  if (minCodeSize < 2 || minCodeSize > 8) return false;
+  const int clear = 1 << minCodeSize;
+  const int eoi = clear + 1;
+
+  static uint16_t prefix[4096];
+  static uint8_t suffix[4096];
+  static uint8_t stack[4097];
+
+  int codeSize = minCodeSize + 1;
+  int next = clear + 2;
+  int prev = -1;
+  uint8_t firstByte = 0;
+
+  BitReader br(in.data(), in.size());
+  out.clear();
+  while (out.size() < pixels) {
+    int code = static_cast<int>(br.bits(codeSize));
+    if (!br.ok()) break;
+    if (code == clear) {
+      codeSize = minCodeSize + 1;
+      next = clear + 2;
+      prev = -1;
+      continue;
+    }
+    if (code == eoi) break;
+    if (prev < 0) {
+      if (code >= clear) return false;
+      out.push_back(static_cast<uint8_t>(code));
+      prev = code;
+      firstByte = static_cast<uint8_t>(code);
+      continue;
+    }
+
+    int in_code = code;
+    int sp = 0;
+    if (code == next) {
+      stack[sp++] = firstByte;
+      code = prev;
+    } else if (code > next) {
+      return false;
+    }
+    while (code >= clear) {
+      stack[sp++] = suffix[code];
+      code = prefix[code];
+    }
+    firstByte = static_cast<uint8_t>(code);
+    stack[sp++] = firstByte;
+
+    if (next < 4096) {
+      prefix[next] = static_cast<uint16_t>(prev);
+      suffix[next] = firstByte;
+      ++next;
+      if (next == (1 << codeSize) && codeSize < 12) ++codeSize;
+    }
+    prev = in_code;
+    while (sp > 0) out.push_back(stack[--sp]);
+  }
+  // Truncated streams are common; missing pixels take index 0
+  out.resize(pixels, 0);
+  return true;
+}
+
+}  // namespace
+
+bool zlibInflate(const uint8_t* data, size_t len, std::vector<uint8_t>& out) {
+  out.clear();
+  if (len < 6) return false;
+  uint8_t cmf = data[0], flg = data[1];
+  if ((cmf & 0x0F) != 8 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) return false;
+
+  BitReader br(data + 2, len - 2);
+  bool last = false;
+  while (!last) {
+    last = br.bits(1) != 0;
+    uint32_t type = br.bits(2);
+    if (!br.ok()) return false;
+    bool ok = type == 0 ? inflateStored(br, out) : type == 1 ? inflateFixed(br, out)
+            : type == 2 ? inflateDynamic(br, out) : false;
+    if (!ok) return false;
+  }
+
+  br.align();
+  size_t at = 2 + br.pos();
+  return at + 4 <= len && readBe32(data + at) == adler32(out);
+}
+
+bool decodePng(const uint8_t* data, size_t len, Image& out, std::string& error) {
+  static const uint8_t SIGNATURE[8] = {137, 'P', 'N', 'G', 13, 10, 26, 10};
+  if (len < 8 || std::memcmp(data, SIGNATURE, 8) != 0) {
+    error = "not a PNG file";
+    return false;
+  }
+
+  uint32_t width = 0, height = 0;
+  int depth = 0, colorType = -1, interlace = 0;
+  std::vector<uint8_t> idat, palette, trns;
+  bool haveHeader = false;
+
+  size_t pos = 8;
+  while (pos + 12 <= len) {
+    uint32_t n = readBe32(data + pos);
+    const uint8_t* type = data + pos + 4;
+    const uint8_t* body = data + pos + 8;
+    if (n > len - pos - 12) {
+      error = "truncated PNG chunk";
+      return false;
+    }
+    if (std::memcmp(type, "IHDR", 4) == 0 && n >= 13) {
+      width = readBe32(body);
+      height = readBe32(body + 4);
+      depth = body[8];
+      colorType = body[9];
+      interlace = body[12];
+      haveHeader = true;
+    } else if (std::memcmp(type, "PLTE", 4) == 0) {
+      palette.assign(body, body + n);
+    } else if (std::memcmp(type, "tRNS", 4) == 0) {
+      trns.assign(body, body + n);
+    } else if (std::memcmp(type, "IDAT", 4) == 0) {
+      idat.insert(idat.end(), body, body + n);
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      break;
+    }
+    pos += 12 + n;
+  }
+
+  if (!haveHeader || width == 0 || height == 0) {
+    error = "PNG has no image header";
+    return false;
+  }
+  if (static_cast<uint64_t>(width) * height > MAX_PIXELS) {
+    error = "PNG is too large";
+    return false;
+  }
+  if (interlace != 0) {
+    error = "interlaced PNGs are not supported";
+    return false;
+  }
+
+  int channels;
+  switch (colorType) {
+    case 0: channels = 1; break;
+    case 2: channels = 3; break;
+    case 3: channels = 1; break;
+    case 4: channels = 2; break;
+    case 6: channels = 4; break;
+    default: error = "unknown PNG colour type"; return false;
+  }
+  bool depthOk = depth == 8 || depth == 16 || ((colorType == 0 || colorType == 3) && (depth == 1 || depth == 2 || depth == 4));
+  if (!depthOk || (colorType == 3 && (depth == 16 || palette.empty()))) {
+    error = "unsupported PNG bit depth";
+    return false;
+  }
+
+  size_t bitsPerPixel = static_cast<size_t>(channels) * depth;
+  size_t stride = (width * bitsPerPixel + 7) / 8;
+  size_t bpp = bitsPerPixel >= 8 ? bitsPerPixel / 8 : 1;
+
+  std::vector<uint8_t> raw;
+  if (!zlibInflate(idat.data(), idat.size(), raw)) {
+    error = "corrupt PNG image data";
+    return false;
+  }
+  if (raw.size() < height * (stride + 1) || !unfilterPng(raw, height, stride, bpp)) {
+    error = "corrupt PNG scanlines";
+    return false;
+  }
+
+  out.width = width;
+  out.height = height;
+  out.rgba.assign(static_cast<size_t>(width) * height * 4, 0);
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint8_t* row = &raw[y * (stride + 1) + 1];
+    for (uint32_t x = 0; x < width; ++x) {
+      uint8_t* px = &out.rgba[(static_cast<size_t>(y) * width + x) * 4];
+      uint16_t s0 = pngSample(row, x, 0, channels, depth);
+      switch (colorType) {
+        case 0:
+          px[0] = px[1] = px[2] = to8(s0, depth);
+          px[3] = trns.size() >= 2 && s0 == ((trns[0] << 8) | trns[1]) ? 0 : 255;
+          break;
+        case 3:
+          if (s0 * 3u + 2 < palette.size()) {
+            px[0] = palette[s0 * 3];
+            px[1] = palette[s0 * 3 + 1];
+            px[2] = palette[s0 * 3 + 2];
+          }
+          px[3] = s0 < trns.size() ? trns[s0] : 255;
+          break;
+        case 4:
+          px[0] = px[1] = px[2] = to8(s0, depth);
+          px[3] = to8(pngSample(row, x, 1, channels, depth), depth);
+          break;
+        default: {
+          uint16_t s1 = pngSample(row, x, 1, channels, depth);
+          uint16_t s2 = pngSample(row, x, 2, channels, depth);
+          px[0] = to8(s0, depth);
+          px[1] = to8(s1, depth);
+          px[2] = to8(s2, depth);
+          if (colorType == 6) {
+            px[3] = to8(pngSample(row, x, 3, channels, depth), depth);
+          } else {
+            bool key = trns.size() >= 6 && s0 == ((trns[0] << 8) | trns[1]) &&
+                       s1 == ((trns[2] << 8) | trns[3]) && s2 == ((trns[4] << 8) | trns[5]);
+            px[3] = key ? 0 : 255;
+          }
+          break;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool decodeGif(const uint8_t* data, size_t len, std::vector<ImageFrame>& out, std::string& error) {
+  out.clear();
+  if (len < 13 || (std::memcmp(data, "GIF87a", 6) != 0 && std::memcmp(data, "GIF89a", 6) != 0)) {
+    error = "not a GIF file";
+    return false;
+  }
+  uint32_t width = readLe16(data + 6);
+  uint32_t height = readLe16(data + 8);
+  uint8_t flags = data[10];
+  if (width == 0 || height == 0) {
+    error = "GIF has an empty canvas";
+    return false;
+  }
+
+  size_t pos = 13;
+  std::vector<uint8_t> globalTable;
+  if (flags & 0x80) {
+    size_t n = 3u * (2u << (flags & 7));
+    if (pos + n > len) {
+      error = "truncated GIF colour table";
+      return false;
+    }
+    globalTable.assign(data + pos, data + pos + n);
+    pos += n;
+  }
+
+  // Transparent black where no frame has drawn yet
+  std::vector<uint8_t> canvas(static_cast<size_t>(width) * height * 4, 0);
+  int disposal = 0, transparent = -1;
+  uint32_t delayMs = 0;
+
+  while (pos < len) {
+    uint8_t block = data[pos++];
+    if (block == 0x3B) break;
+
+    if (block == 0x21) {
+      if (pos >= len) break;
+      uint8_t label = data[pos++];
+      std::vector<uint8_t> ext;
+      if (!readSubBlocks(data, len, pos, &ext)) {
+        error = "truncated GIF extension";
+        return false;
+      }
+      if (label == 0xF9 && ext.size() >= 4) {
+        disposal = (ext[0] >> 2) & 7;
+        transparent = (ext[0] & 1) ? ext[3] : -1;
+        delayMs = readLe16(&ext[1]) * 10u;
+      }
+      continue;
+    }
+
+    if (block != 0x2C) {
+      error = "unknown GIF block";
+      return false;
+    }
+    if (pos + 10 > len) {
+      error = "truncated GIF image";
+      return false;
+    }
+    uint32_t left = readLe16(data + pos);
+    uint32_t top = readLe16(data + pos + 2);
+    uint32_t w = readLe16(data + pos + 4);
+    uint32_t h = readLe16(data + pos + 6);
+    uint8_t imageFlags = data[pos + 8];
+    pos += 9;
+
+    std::vector<uint8_t> table = globalTable;
+    if (imageFlags & 0x80) {
+      size_t n = 3u * (2u << (imageFlags & 7));
+      if (pos + n > len) {
+        error = "truncated GIF colour table";
+        return false;
+      }
+      table.assign(data + pos, data + pos + n);
+      pos += n;
+    }
+    if (pos >= len) {
+      error = "truncated GIF image";
+      return false;
+    }
+    int minCodeSize = data[pos++];
+    std::vector<uint8_t> lzw, indices;
+    if (!readSubBlocks(data, len, pos, &lzw) || !lzwDecode(lzw, minCodeSize, static_cast<size_t>(w) * h, indices)) {
+      error = "corrupt GIF image data";
+      return false;
+    }
+
+    // Interlaced rows come in four passes
+    std::vector<uint32_t> rowOf(h);
+    if (imageFlags & 0x40) {
+      static const uint32_t START[4] = {0, 4, 2, 1};
+      static const uint32_t STEP[4] = {8, 8, 4, 2};
+      uint32_t r = 0;
+      for (int pass = 0; pass < 4; ++pass) {
+        for (uint32_t y = START[pass]; y < h; y += STEP[pass]) rowOf[r++] = y;
+      }
+    } else {
+      for (uint32_t y = 0; y < h; ++y) rowOf[y] = y;
+    }
+
+    std::vector<uint8_t> before;
+    if (disposal == 3) before = canvas;
+
+    for (uint32_t r = 0; r < h; ++r) {
+      uint32_t cy = top + rowOf[r];
+      if (cy >= height) continue;
+      for (uint32_t x = 0; x < w; ++x) {
+        uint32_t cx = left + x;
+        uint8_t idx = indices[static_cast<size_t>(r) * w + x];
+        if (cx >= width || idx == transparent || idx * 3u + 2 >= table.size()) continue;
+        uint8_t* px = &canvas[(static_cast<size_t>(cy) * width + cx) * 4];
+        px[0] = table[idx * 3];
+        px[1] = table[idx * 3 + 1];
+        px[2] = table[idx * 3 + 2];
+        px[3] = 255;
+      }
+    }
+
+    ImageFrame frame;
+    frame.image.width = width;
+    frame.image.height = height;
+    frame.image.rgba = canvas;
+    frame.delayMs = delayMs ? delayMs : 100;
+    out.push_back(std::move(frame));
+
+    if (disposal == 2) {
+      for (uint32_t y = top; y < top + h && y < height; ++y) {
+        for (uint32_t x = left; x < left + w && x < width; ++x) {
+          std::memset(&canvas[(static_cast<size_t>(y) * width + x) * 4], 0, 4);
+        }
+      }
+    } else if (disposal == 3) {
+      canvas.swap(before);
+    }
+    disposal = 0;
+    transparent = -1;
+    delayMs = 0;
+  }
+
+  if (out.empty()) {
+    error = "GIF has no frames";
+    return false;
+  }
+  return true;
+}
+
+bool loadImageFile(const std::string& path, std::vector<ImageFrame>& out, std::string& error) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    error = "cannot open " + path;
+    return false;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  if (data.size() >= 6 && std::memcmp(data.data(), "GIF", 3) == 0) {
+    return decodeGif(data.data(), data.size(), out, error);
+  }
+  ImageFrame frame;
+  if (!decodePng(data.data(), data.size(), frame.image, error)) return false;
+  out.assign(1, std::move(frame));
+  return true;
+}
+
+}  // namespace pixelgrid
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal PNG and GIF readers for turning artwork into animation clips.
+// No external libraries: PNG needs its own inflate, GIF its own LZW.
+
+namespace pixelgrid {
+
+// 8-bit RGBA, rows from the top, left to right
+struct Image {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::vector<uint8_t> rgba;
+};
+
+struct ImageFrame {
+  Image image;
+  uint32_t delayMs = 0;  // GIF frame delay; 0 for still images
+};
+
+// Non-interlaced PNG in any colour type at any bit depth. 16-bit samples are
+// cut to 8 bits; tRNS transparency is honoured.
+bool decodePng(const uint8_t* data, size_t len, Image& out, std::string& error);
+
+// Every GIF frame composed onto the full canvas (disposal and transparency
+// applied), with its delay. A delay of 0 becomes 100 ms, as browsers do.
+bool decodeGif(const uint8_t* data, size_t len, std::vector<ImageFrame>& out, std::string& error);
+
+// Reads a PNG or GIF file, picking the decoder from its signature. A PNG is
+// a single frame.
+bool loadImageFile(const std::string& path, std::vector<ImageFrame>& out, std::string& error);
+
+// zlib stream (RFC 1950/1951) decoder, used for PNG. Exposed for tests.
+bool zlibInflate(const uint8_t* data, size_t len, std::vector<uint8_t>& out);
+
+}  // namespace pixelgrid
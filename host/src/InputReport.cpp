@@ -0,0 +1,48 @@
+#include "InputReport.h"
+
+#include <algorithm>
+
+namespace pixelgrid {
+
+bool parseInputReport(const uint8_t* payload, size_t len, InputReport& out) {
+  if (len < HOST_INPUT_HEADER_BYTES) return false;
+  uint8_t count = payload[5];
+  if (len != HOST_INPUT_HEADER_BYTES + static_cast<size_t>(count) * HOST_INPUT_EVENT_BYTES) return false;
+
+  out.deviceUs = hostReadU32(payload);
+  out.bits = payload[4];
+  out.lost = payload[6];
+  out.events.clear();
+  const uint8_t* p = payload + HOST_INPUT_HEADER_BYTES;
+  for (uint8_t i = 0; i < count; ++i, p += HOST_INPUT_EVENT_BYTES) {
+    out.events.push_back({hostReadU32(p), p[4]});
+  }
+  return true;
+}
+
+bool parsePong(const uint8_t* payload, size_t len, uint32_t& token, uint32_t& deviceUs) {
+  if (len != HOST_PONG_BYTES) return false;
+  token = hostReadU32(payload);
+  deviceUs = hostReadU32(payload + 4);
+  return true;
+}
+
+void DeviceClock::addSample(int64_t hostSendUs, int64_t hostRecvUs, uint32_t deviceUs) {
+  if (hostRecvUs < hostSendUs) return;
+  samples_.push_back({hostSendUs + (hostRecvUs - hostSendUs) / 2, deviceUs, hostRecvUs - hostSendUs});
+  if (samples_.size() > WINDOW) samples_.pop_front();
+}
+
+const DeviceClock::Sample& DeviceClock::best() const {
+  return *std::min_element(samples_.begin(), samples_.end(),
+                           [](const Sample& a, const Sample& b) { return a.rttUs < b.rttUs; });
+}
+
+int64_t DeviceClock::toHostUs(uint32_t deviceUs) const {
+  if (!valid()) return 0;
+  const Sample& s = best();
+  // Signed 32-bit difference, so a wrap between the two readings is harmless
+  return s.hostMidUs + static_cast<int32_t>(deviceUs - s.deviceUs);
+}
+
+}  // namespace pixelgrid
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "HostInput.h"
+
+// Host side of PBIN input reports and PBPI/PBPO latency probes (see
+// HostInput.h). DeviceClock turns ping round trips into a mapping from the
+// device's micros() to host time, so input edges can be placed on the host's
+// clock and their age measured.
+
+namespace pixelgrid {
+
+struct InputReport {
+  uint32_t deviceUs = 0;             // device time the report was sent
+  uint8_t bits = 0;                  // state after the last event
+  uint8_t lost = 0;                  // edges dropped on the device
+  std::vector<HostInputEvent> events;
+};
+
+// Returns false if the payload is truncated or its count doesn't match.
+bool parseInputReport(const uint8_t* payload, size_t len, InputReport& out);
+
+// PBPO payload: the PBPI token and the device's micros() when it was parsed
+bool parsePong(const uint8_t* payload, size_t len, uint32_t& token, uint32_t& deviceUs);
+
+// Offset estimate from ping round trips. Each sample assumes the device
+// stamped the pong halfway through the round trip; the sample with the
+// shortest round trip among the last few is trusted most (as in NTP).
+class DeviceClock {
+ public:
+  static const size_t WINDOW = 8;
+
+  // hostSendUs/hostRecvUs: when the PBPI went out and the PBPO came back
+  void addSample(int64_t hostSendUs, int64_t hostRecvUs, uint32_t deviceUs);
+
+  bool valid() const { return !samples_.empty(); }
+  // Round trip of the latest sample and of the one the mapping uses
+  double lastRttUs() const { return valid() ? static_cast<double>(samples_.back().rttUs) : 0.0; }
+  double bestRttUs() const { return valid() ? static_cast<double>(best().rttUs) : 0.0; }
+
+  // Device micros() -> host microseconds. Good for timestamps within ~35
+  // minutes of the last sample (micros() wraps after ~71).
+  int64_t toHostUs(uint32_t deviceUs) const;
+
+ private:
+  struct Sample {
+    int64_t hostMidUs;
+    uint32_t deviceUs;
+    int64_t rttUs;
+  };
+  const Sample& best() const;
+
+  std::deque<Sample> samples_;
+};
+
+}  // namespace pixelgrid
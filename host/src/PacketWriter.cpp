@@ -0,0 +1,61 @@
+#include "PacketWriter.h"
+
+#include <algorithm>
+
+namespace pixelgrid {
+
+std::vector<uint8_t> buildPacket(uint16_t type, const uint8_t* payload, size_t len) {
+  std::vector<uint8_t> out(HOST_HEADER_BYTES + len);
+  hostPacketHeader(out.data(), type, static_cast<uint16_t>(len));
+  if (len) std::copy(payload, payload + len, out.begin() + HOST_HEADER_BYTES);
+  return out;
+}
+
+std::vector<uint8_t> buildFramedPacket(uint8_t seq, uint16_t type, const uint8_t* payload, size_t len) {
+  std::vector<uint8_t> raw;
+  raw.reserve(len + 7);
+  raw.push_back(seq);
+  raw.push_back(static_cast<uint8_t>(type >> 8));
+  raw.push_back(static_cast<uint8_t>(type & 0xFF));
+  raw.push_back(static_cast<uint8_t>(len & 0xFF));
+  raw.push_back(static_cast<uint8_t>(len >> 8));
+  raw.insert(raw.end(), payload, payload + len);
+  uint16_t crc = hostCrc16(raw.data(), raw.size());
+  raw.push_back(static_cast<uint8_t>(crc & 0xFF));
+  raw.push_back(static_cast<uint8_t>(crc >> 8));
+
+  std::vector<uint8_t> out(raw.size() + raw.size() / 254 + 3);
+  out[0] = 0x00;
+  size_t n = hostCobsEncode(raw.data(), raw.size(), out.data() + 1);
+  out[n + 1] = 0x00;
+  out.resize(n + 2);
+  return out;
+}
+
+std::vector<uint8_t> PacketWriter::build(uint16_t type, const uint8_t* payload, size_t len) {
+  if (!framed_) return buildPacket(type, payload, len);
+  return buildFramedPacket(seq_++, type, payload, len);
+}
+
+bool parseStatusPayload(const uint8_t* payload, size_t len, HostLinkStats& out) {
+  if (len != HOST_STATUS_BYTES && len != HOST_STATUS_BYTES + HOST_STATUS_TOKEN_BYTES) return false;
+  uint32_t v[6];
+  for (int i = 0; i < 6; ++i) v[i] = hostReadU32(payload + i * 4);
+  out.packets = v[0];
+  out.framed = v[1];
+  out.corrupt = v[2];
+  out.dropped = v[3];
+  out.outOfOrder = v[4];
+  out.resyncBytes = v[5];
+  return true;
+}
+
+bool parseStatusReply(const uint8_t* payload, size_t len, StatusReply& out) {
+  if (len != HOST_STATUS_BYTES && len != HOST_STATUS_BYTES + HOST_STATUS_TOKEN_BYTES) return false;
+  parseStatusPayload(payload, HOST_STATUS_BYTES, out.stats);
+  out.hasToken = len > HOST_STATUS_BYTES;
+  out.token = out.hasToken ? hostReadU32(payload + HOST_STATUS_BYTES) : 0;
+  return true;
+}
+
+}  // namespace pixelgrid
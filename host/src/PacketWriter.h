@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "HostProtocol.h"
+
+// Builds host packets in either wire form (see HostProtocol.h). Framed
+// packets carry a CRC-16 and a sequence number so the device can count
+// corrupt, dropped and out-of-order packets; query them with PBSQ.
+
+namespace pixelgrid {
+
+// 'P' 'B' t0 t1 len payload
+std::vector<uint8_t> buildPacket(uint16_t type, const uint8_t* payload, size_t len);
+
+// 0x00 COBS(seq t0 t1 len payload crc) 0x00
+std::vector<uint8_t> buildFramedPacket(uint8_t seq, uint16_t type, const uint8_t* payload, size_t len);
+
+// Hands out consecutive sequence numbers for framed packets
+class PacketWriter {
+ public:
+  explicit PacketWriter(bool framed = false) : framed_(framed) {}
+
+  bool framed() const { return framed_; }
+  void setFramed(bool framed) { framed_ = framed; }
+
+  std::vector<uint8_t> build(uint16_t type, const uint8_t* payload, size_t len);
+  std::vector<uint8_t> build(uint16_t type, const std::vector<uint8_t>& payload) {
+    return build(type, payload.data(), payload.size());
+  }
+
+ private:
+  bool framed_;
+  uint8_t seq_ = 0;
+};
+
+// Parses a PBST payload, with or without the PBSQ token. Returns false if
+// it has the wrong length.
+bool parseStatusPayload(const uint8_t* payload, size_t len, HostLinkStats& out);
+
+struct StatusReply {
+  HostLinkStats stats;
+  bool hasToken = false; // firmware that predates PBSQ tokens sends none
+  uint32_t token = 0;
+};
+
+bool parseStatusReply(const uint8_t* payload, size_t len, StatusReply& out);
+
+}  // namespace pixelgrid
@@ -0,0 +1,483 @@
+#include "ScoreServer.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "DeviceSigner.h"
+#include "NetJson.h"
+
+namespace pixelgrid {
+
+namespace {
+
+const size_t MAX_HEADER_BYTES = 8192;
+const size_t MAX_BODY_BYTES = 64 * 1024;
+const size_t MAX_BATCH_RECORDS = 64;
+const int POLL_MS = 100;  // how often blocked threads look at running_
+
+// Just enough JSON for score records: objects, arrays, strings, and numbers
+// and literals kept as their text.
+struct JsonNode {
+  enum Kind { NONE, STRING, LITERAL, OBJECT, ARRAY } kind = NONE;
+  std::string text;
+  std::vector<std::pair<std::string, JsonNode>> members;
+  std::vector<JsonNode> items;
+
+  const JsonNode* member(const std::string& key) const {
+    for (const auto& m : members) {
+      if (m.first == key) return &m.second;
+    }
+    return nullptr;
+  }
+};
+
+class JsonParser {
+ public:
+  explicit JsonParser(const std::string& s) : s_(s) {}
+
+  bool parse(JsonNode& out) {
+    if (!value(out, 0)) return false;
+    skipSpace();
+    return i_ == s_.size();
+  }
+
+ private:
+  void skipSpace() {
+    while (i_ < s_.size() && (s_[i_] == ' ' || s_[i_] == '\t' || s_[i_] == '\r' || s_[i_] == '\n')) ++i_;
+  }
+
+  bool value(JsonNode& out, int depth) {
+    if (depth > 16) return false;
+    skipSpace();
+    if (i_ >= s_.size()) return false;
+    char c = s_[i_];
+    if (c == '{') {
+      out.kind = JsonNode::OBJECT;
+      ++i_;
+      skipSpace();
+      if (i_ < s_.size() && s_[i_] == '}') return ++i_, true;
+      for (;;) {
+        std::string key;
+        skipSpace();
+        if (!string(key)) return false;
+        skipSpace();
+        if (i_ >= s_.size() || s_[i_++] != ':') return false;
+        out.members.emplace_back(key, JsonNode());
+        if (!value(out.members.back().second, depth + 1)) return false;
+        skipSpace();
+        if (i_ >= s_.size()) return false;
+        if (s_[i_] == '}') return ++i_, true;
+        if (s_[i_++] != ',') return false;
+      }
+    }
+    if (c == '[') {
+      out.kind = JsonNode::ARRAY;
+      ++i_;
+      skipSpace();
+      if (i_ < s_.size() && s_[i_] == ']') return ++i_, true;
+      for (;;) {
+        out.items.emplace_back();
+        if (!value(out.items.back(), depth + 1)) return false;
+        skipSpace();
+        if (i_ >= s_.size()) return false;
+        if (s_[i_] == ']') return ++i_, true;
+        if (s_[i_++] != ',') return false;
+      }
+    }
+    if (c == '"') {
+      out.kind = JsonNode::STRING;
+      return string(out.text);
+    }
+    out.kind = JsonNode::LITERAL;
+    while (i_ < s_.size() && (std::isalnum(static_cast<unsigned char>(s_[i_])) || s_[i_] == '-' || s_[i_] == '+' ||
+                              s_[i_] == '.')) {
+      out.text += s_[i_++];
+    }
+    return !out.text.empty();
+  }
+
+  bool string(std::string& out) {
+    if (i_ >= s_.size() || s_[i_] != '"') return false;
+    ++i_;
+    while (i_ < s_.size()) {
+      char c = s_[i_++];
+      if (c == '"') return true;
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (i_ >= s_.size()) return false;
+      char e = s_[i_++];
+      switch (e) {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'u': {
+          if (i_ + 4 > s_.size()) return false;
+          unsigned long code = std::strtoul(s_.substr(i_, 4).c_str(), nullptr, 16);
+          i_ += 4;
+          out += code < 0x80 ? static_cast<char>(code) : '?';
+          break;
+        }
+        default: out += e; break;
+      }
+    }
+    return false;
+  }
+
+  const std::string& s_;
+  size_t i_ = 0;
+};
+
+std::string quote(const std::string& s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') out += '\\';
+    if (static_cast<unsigned char>(c) < 0x20) {
+      char esc[8];
+      std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+      out += esc;
+      continue;
+    }
+    out += c;
+  }
+  return out + "\"";
+}
+
+std::string errorBody(const std::string& error) { return "{\"error\":" + quote(error) + "}"; }
+
+bool parseInt(const std::string& text, long lo, long hi, long& out) {
+  if (text.empty()) return false;
+  char* end = nullptr;
+  errno = 0;
+  long long v = std::strtoll(text.c_str(), &end, 10);
+  if (errno || *end || v < lo || v > hi) return false;
+  out = static_cast<long>(v);
+  return true;
+}
+
+const char* reason(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    default: return "Error";
+  }
+}
+
+std::string lower(std::string s) {
+  for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  return s;
+}
+
+// Waits until fd is readable. False on timeout (idleMs, 0 = forever) or stop.
+bool waitReadable(int fd, const std::atomic<bool>& running, uint32_t idleMs) {
+  uint32_t waited = 0;
+  while (running) {
+    int slice = idleMs && idleMs - waited < static_cast<uint32_t>(POLL_MS) ? static_cast<int>(idleMs - waited) : POLL_MS;
+    pollfd p{fd, POLLIN, 0};
+    int r = ::poll(&p, 1, slice);
+    if (r > 0) return true;
+    if (r < 0 && errno != EINTR) return false;
+    waited += static_cast<uint32_t>(slice);
+    if (idleMs && waited >= idleMs) return false;
+  }
+  return false;
+}
+
+bool writeAll(int fd, const std::string& data) {
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = ::send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) continue;
+      return false;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+}  // namespace
+
+ScoreServer::ScoreServer(const ScoreServerConfig& config) : config_(config) {}
+
+ScoreServer::~ScoreServer() { stop(); }
+
+bool ScoreServer::fail(const std::string& what) {
+  error_ = what + ": " + std::strerror(errno);
+  if (listenFd_ >= 0) ::close(listenFd_);
+  listenFd_ = -1;
+  return false;
+}
+
+bool ScoreServer::start(uint16_t port) {
+  stop();
+  listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd_ < 0) return fail("socket");
+  int one = 1;
+  ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) return fail("bind");
+  if (::listen(listenFd_, 64) != 0) return fail("listen");
+  socklen_t len = sizeof(addr);
+  if (::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) return fail("getsockname");
+  port_ = ntohs(addr.sin_port);
+  running_ = true;
+  acceptThread_ = std::thread(&ScoreServer::acceptLoop, this);
+  return true;
+}
+
+void ScoreServer::stop() {
+  if (!running_.exchange(false)) return;
+  if (acceptThread_.joinable()) acceptThread_.join();
+  ::close(listenFd_);
+  listenFd_ = -1;
+  std::lock_guard<std::mutex> lock(connMutex_);
+  for (std::thread& t : connThreads_) t.join();
+  connThreads_.clear();
+}
+
+std::string ScoreServer::baseUrl() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+ScoreServerStats ScoreServer::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void ScoreServer::acceptLoop() {
+  while (waitReadable(listenFd_, running_, 0)) {
+    int fd = ::accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) continue;
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stats_.connections++;
+    }
+    std::lock_guard<std::mutex> lock(connMutex_);
+    connThreads_.emplace_back(&ScoreServer::serve, this, fd);
+  }
+}
+
+void ScoreServer::serve(int fd) {
+  std::string in;
+  uint32_t served = 0;
+  char buf[4096];
+  for (;;) {
+    // Headers
+    size_t headerEnd;
+    while ((headerEnd = in.find("\r\n\r\n")) == std::string::npos) {
+      if (in.size() > MAX_HEADER_BYTES || !waitReadable(fd, running_, config_.idleCloseMs)) {
+        ::close(fd);
+        return;
+      }
+      ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+      if (n <= 0) {
+        ::close(fd);
+        return;
+      }
+      in.append(buf, static_cast<size_t>(n));
+    }
+
+    std::string head = in.substr(0, headerEnd);
+    in.erase(0, headerEnd + 4);
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    size_t sp1 = requestLine.find(' ');
+    size_t sp2 = requestLine.find(' ', sp1 + 1);
+    std::string method = requestLine.substr(0, sp1);
+    std::string path = sp1 == std::string::npos ? "" : requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+    bool keepAlive = requestLine.find("HTTP/1.1") != std::string::npos;
+    size_t contentLength = 0;
+    for (size_t pos = lineEnd; pos != std::string::npos && pos < head.size();) {
+      size_t next = head.find("\r\n", pos + 2);
+      std::string line = head.substr(pos + 2, next == std::string::npos ? std::string::npos : next - pos - 2);
+      pos = next;
+      size_t colon = line.find(':');
+      if (colon == std::string::npos) continue;
+      std::string name = lower(line.substr(0, colon));
+      std::string value = line.substr(colon + 1);
+      while (!value.empty() && value[0] == ' ') value.erase(0, 1);
+      if (name == "content-length") contentLength = std::strtoul(value.c_str(), nullptr, 10);
+      else if (name == "connection") keepAlive = lower(value) != "close";
+    }
+
+    ScoreResponse resp;
+    if (contentLength > MAX_BODY_BYTES) {
+      resp = {413, errorBody("body too large")};
+      keepAlive = false;
+    } else {
+      while (in.size() < contentLength) {
+        if (!waitReadable(fd, running_, config_.idleCloseMs ? config_.idleCloseMs : 5000)) {
+          ::close(fd);
+          return;
+        }
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+          ::close(fd);
+          return;
+        }
+        in.append(buf, static_cast<size_t>(n));
+      }
+      std::string body = in.substr(0, contentLength);
+      in.erase(0, contentLength);
+      resp = handle(method, path, body);
+    }
+
+    served++;
+    if (config_.maxRequestsPerConnection && served >= config_.maxRequestsPerConnection) keepAlive = false;
+    char header[192];
+    std::snprintf(header, sizeof(header),
+                  "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\nConnection: %s\r\n\r\n",
+                  resp.status, reason(resp.status), resp.body.size(), keepAlive ? "keep-alive" : "close");
+    if (!writeAll(fd, header + resp.body) || !keepAlive) {
+      ::close(fd);
+      return;
+    }
+  }
+}
+
+std::string ScoreServer::checkRecord(const std::map<std::string, std::string>& fields, std::string& error,
+                                     int& status) {
+  status = 400;
+  auto get = [&](const char* key) -> const std::string* {
+    auto it = fields.find(key);
+    return it == fields.end() ? nullptr : &it->second;
+  };
+  const std::string* scoreText = get("score");
+  const std::string* gameCode = get("game_code");
+  const std::string* tsText = get("ts");
+  const std::string* nonce = get("nonce");
+  const std::string* sig = get("sig");
+  long score = 0, ts = 0;
+  if (!scoreText || !parseInt(*scoreText, 0, INT32_MAX, score)) {
+    error = "bad score";
+    return "";
+  }
+  if (!tsText || !parseInt(*tsText, 0, INT32_MAX, ts)) {
+    error = "bad ts";
+    return "";
+  }
+  if (!nonce || nonce->empty() || nonce->size() > 64) {
+    error = "bad nonce";
+    return "";
+  }
+  if (!gameCode || *gameCode != config_.gameCode) {
+    error = "unknown game";
+    return "";
+  }
+  int64_t now = static_cast<int64_t>(std::time(nullptr)) + config_.clockOffsetS;
+  int64_t skew = now - ts;
+  if (skew > static_cast<int64_t>(config_.windowS) || -skew > static_cast<int64_t>(config_.windowS)) {
+    error = "timestamp outside window";
+    return "";
+  }
+
+  char msg[256];
+  size_t len = canonicalDeviceMessage(msg, sizeof(msg), gameCode->c_str(), static_cast<int>(score),
+                                      static_cast<int>(ts), nonce->c_str());
+  uint8_t mac[SHA256_BYTES];
+  DeviceSigner signer;
+  signer.begin(config_.secret.c_str());
+  char expected[64];
+  if (!len || !signer.sign(reinterpret_cast<const uint8_t*>(msg), len, mac) ||
+      !base64UrlEncode(mac, sizeof(mac), expected, sizeof(expected)) || !sig || *sig != expected) {
+    status = 401;
+    error = "bad signature";
+    return "";
+  }
+
+  status = 200;
+  auto known = codes_.find(*nonce);
+  if (known != codes_.end()) {
+    stats_.replays++;
+    return known->second;
+  }
+  // Six digits from the MAC, so codes look random but tests can repeat them
+  uint32_t v = (static_cast<uint32_t>(mac[0]) << 24) | (static_cast<uint32_t>(mac[1]) << 16) |
+               (static_cast<uint32_t>(mac[2]) << 8) | mac[3];
+  char code[8];
+  std::snprintf(code, sizeof(code), "%06u", static_cast<unsigned>(v % 1000000u));
+  codes_[*nonce] = code;
+  return code;
+}
+
+ScoreResponse ScoreServer::handle(const std::string& method, const std::string& path, const std::string& body) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.requests++;
+  const bool single = path == "/api/codes";
+  const bool batch = path == "/api/codes/batch" && config_.batch;
+  if (!single && !batch) return {404, errorBody("not found")};
+  if (method != "POST") return {405, errorBody("method not allowed")};
+
+  JsonNode root;
+  if (!JsonParser(body).parse(root) || root.kind != JsonNode::OBJECT) return {400, errorBody("bad json")};
+
+  auto fieldsOf = [](const JsonNode& obj) {
+    std::map<std::string, std::string> fields;
+    for (const auto& m : obj.members) {
+      if (m.second.kind == JsonNode::STRING || m.second.kind == JsonNode::LITERAL) fields[m.first] = m.second.text;
+    }
+    return fields;
+  };
+
+  if (single) {
+    std::string error;
+    int status = 0;
+    std::string code = checkRecord(fieldsOf(root), error, status);
+    if (code.empty()) {
+      stats_.rejected++;
+      return {status, errorBody(error)};
+    }
+    stats_.accepted++;
+    return {200, "{\"code\":" + quote(code) + "}"};
+  }
+
+  const JsonNode* codes = root.member("codes");
+  if (!codes || codes->kind != JsonNode::ARRAY || codes->items.empty() || codes->items.size() > MAX_BATCH_RECORDS) {
+    return {400, errorBody("codes must be an array of 1 to " + std::to_string(MAX_BATCH_RECORDS) + " records")};
+  }
+  std::string out = "{\"results\":[";
+  for (size_t i = 0; i < codes->items.size(); ++i) {
+    const JsonNode& rec = codes->items[i];
+    std::map<std::string, std::string> fields;
+    if (rec.kind == JsonNode::OBJECT) fields = fieldsOf(rec);
+    std::string error;
+    int status = 0;
+    std::string code = rec.kind == JsonNode::OBJECT ? checkRecord(fields, error, status) : "";
+    if (rec.kind != JsonNode::OBJECT) error = "not an object";
+    if (i) out += ",";
+    out += "{\"nonce\":" + quote(fields["nonce"]) + ",";
+    if (code.empty()) {
+      stats_.rejected++;
+      out += "\"error\":" + quote(error) + "}";
+    } else {
+      stats_.accepted++;
+      out += "\"code\":" + quote(code) + "}";
+    }
+  }
+  return {200, out + "]}"};
+}
+
+}  // namespace pixelgrid
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Stand-in for the score backend (docs/API Documentation.md section 2): an
+// HTTP/1.1 server on loopback that answers POST /api/codes and
+// POST /api/codes/batch the way the real one does, so the firmware's submit
+// path can be run and timed without the network.
+//
+// A record is accepted when its game_code matches, ts is within windowS of
+// the server clock, and sig is the base64url HMAC-SHA256 of
+// canonicalDeviceMessage() (DeviceSigner.h) under the shared secret. Each
+// accepted nonce gets a six-digit code; a nonce seen before gets its code
+// again, as a server answering a resent batch should.
+//
+// Connections are kept alive. One thread accepts and one thread serves each
+// connection.
+
+namespace pixelgrid {
+
+struct ScoreServerConfig {
+  std::string secret = "emulator";   // GAME_SECRET
+  std::string gameCode = "EMU";      // GAME_CODE
+  uint32_t windowS = 120;            // allowed |server time - ts|
+  int64_t clockOffsetS = 0;          // added to the server clock, to test skew
+  bool batch = true;                 // false: /api/codes/batch is a 404
+  uint32_t maxRequestsPerConnection = 0;  // then Connection: close; 0 = no limit
+  uint32_t idleCloseMs = 0;          // drop a silent connection after this; 0 = never
+};
+
+struct ScoreServerStats {
+  uint64_t connections = 0;
+  uint64_t requests = 0;
+  uint64_t accepted = 0;   // records given a code, replays included
+  uint64_t replays = 0;    // records whose nonce already had a code
+  uint64_t rejected = 0;   // records refused (signature, time, game, fields)
+};
+
+struct ScoreResponse {
+  int status = 0;
+  std::string body;
+};
+
+class ScoreServer {
+ public:
+  explicit ScoreServer(const ScoreServerConfig& config = ScoreServerConfig());
+  ~ScoreServer();
+  ScoreServer(const ScoreServer&) = delete;
+  ScoreServer& operator=(const ScoreServer&) = delete;
+
+  // Listens on 127.0.0.1; port 0 picks a free one (see port()).
+  bool start(uint16_t port = 0);
+  void stop();
+
+  uint16_t port() const { return port_; }
+  // "http://127.0.0.1:<port>", the API_BASE to give the firmware
+  std::string baseUrl() const;
+  ScoreServerStats stats() const;
+  const std::string& lastError() const { return error_; }
+
+  // One request without the socket, for tests
+  ScoreResponse handle(const std::string& method, const std::string& path, const std::string& body);
+
+ private:
+  void acceptLoop();
+  void serve(int fd);
+  // Returns the code, or "" with error set
+  std::string checkRecord(const std::map<std::string, std::string>& fields, std::string& error, int& status);
+  bool fail(const std::string& what);
+
+  ScoreServerConfig config_;
+  int listenFd_ = -1;
+  uint16_t port_ = 0;
+  std::string error_;
+  std::atomic<bool> running_{false};
+  std::thread acceptThread_;
+  std::vector<std::thread> connThreads_;
+  std::mutex connMutex_;
+
+  mutable std::mutex mutex_;  // codes_ and stats_
+  std::map<std::string, std::string> codes_;  // nonce -> code
+  ScoreServerStats stats_;
+};
+
+}  // namespace pixelgrid
@@ -0,0 +1,153 @@
+#include "SerialPort.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace pixelgrid {
+
+namespace {
+
+bool toSpeed(uint32_t baud, speed_t& out) {
+  switch (baud) {
+    case 9600: out = B9600; return true;
+    case 19200: out = B19200; return true;
+    case 38400: out = B38400; return true;
+    case 57600: out = B57600; return true;
+    case 115200: out = B115200; return true;
+    case 230400: out = B230400; return true;
+#ifdef B460800
+    case 460800: out = B460800; return true;
+#endif
+#ifdef B921600
+    case 921600: out = B921600; return true;
+#endif
+#ifdef B1500000
+    case 1500000: out = B1500000; return true;
+#endif
+#ifdef B2000000
+    case 2000000: out = B2000000; return true;
+#endif
+    default: return false;
+  }
+}
+
+}  // namespace
+
+SerialPort::~SerialPort() { close(); }
+
+bool SerialPort::fail(const std::string& what) {
+  error_ = what + ": " + std::strerror(errno);
+  return false;
+}
+
+bool SerialPort::open(const std::string& path, uint32_t baud) {
+  close();
+  fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd_ < 0) return fail("open " + path);
+  if (!configure(baud)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool SerialPort::openPty(std::string& slavePath) {
+  close();
+  fd_ = ::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd_ < 0) return fail("posix_openpt");
+  if (::grantpt(fd_) != 0 || ::unlockpt(fd_) != 0) {
+    fail("grantpt/unlockpt");
+    close();
+    return false;
+  }
+  const char* name = ::ptsname(fd_);
+  if (!name) {
+    fail("ptsname");
+    close();
+    return false;
+  }
+  slavePath = name;
+  if (!configure(115200)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void SerialPort::close() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+  baud_ = 0;
+}
+
+bool SerialPort::configure(uint32_t baud) {
+  speed_t speed;
+  if (!toSpeed(baud, speed)) {
+    error_ = "unsupported baud rate " + std::to_string(baud);
+    return false;
+  }
+
+  termios tio;
+  if (::tcgetattr(fd_, &tio) != 0) return fail("tcgetattr");
+  ::cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cflag &= ~CRTSCTS;
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  ::cfsetispeed(&tio, speed);
+  ::cfsetospeed(&tio, speed);
+  if (::tcsetattr(fd_, TCSANOW, &tio) != 0) return fail("tcsetattr");
+
+  baud_ = baud;
+  return true;
+}
+
+bool SerialPort::setBaud(uint32_t baud) {
+  if (fd_ < 0) {
+    error_ = "port not open";
+    return false;
+  }
+  ::tcdrain(fd_);
+  return configure(baud);
+}
+
+bool SerialPort::write(const uint8_t* data, size_t n, int timeoutMs) {
+  while (n > 0) {
+    ssize_t w = ::write(fd_, data, n);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN) return fail("write");
+      pollfd p{fd_, POLLOUT, 0};
+      if (::poll(&p, 1, timeoutMs) <= 0) {
+        error_ = "write timed out (nothing is reading the other end)";
+        return false;
+      }
+      if (!(p.revents & POLLOUT)) {
+        // e.g. a pty whose other end isn't open
+        error_ = "write failed: other end closed";
+        return false;
+      }
+      continue;
+    }
+    data += w;
+    n -= static_cast<size_t>(w);
+  }
+  return true;
+}
+
+size_t SerialPort::read(uint8_t* out, size_t n, int timeoutMs) {
+  if (fd_ < 0) return 0;
+  pollfd p{fd_, POLLIN, 0};
+  int r = ::poll(&p, 1, timeoutMs);
+  if (r <= 0 || !(p.revents & POLLIN)) return 0;
+  ssize_t got = ::read(fd_, out, n);
+  return got > 0 ? static_cast<size_t>(got) : 0;
+}
+
+}  // namespace pixelgrid
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Raw (8N1, no flow control) POSIX serial port. Works on USB-CDC/UART device
+// nodes and on pseudo-terminals, which is how the tests and the device
+// emulator stand in for a board. Failures return false; lastError() says why.
+
+namespace pixelgrid {
+
+class SerialPort {
+ public:
+  SerialPort() = default;
+  ~SerialPort();
+  SerialPort(const SerialPort&) = delete;
+  SerialPort& operator=(const SerialPort&) = delete;
+
+  bool open(const std::string& path, uint32_t baud);
+  // Opens the master side of a new pty; slavePath is the device to hand to
+  // the other end.
+  bool openPty(std::string& slavePath);
+  void close();
+
+  bool isOpen() const { return fd_ >= 0; }
+  int fd() const { return fd_; }
+  uint32_t baud() const { return baud_; }
+  const std::string& lastError() const { return error_; }
+
+  // Waits for queued output to drain, then changes the line rate.
+  bool setBaud(uint32_t baud);
+
+  // Writes everything, waiting up to timeoutMs whenever the output buffer is
+  // full. Returns false on error or timeout; the rest of the data is dropped.
+  bool write(const uint8_t* data, size_t n, int timeoutMs = 1000);
+  // Waits up to timeoutMs for input, then returns whatever is buffered (at
+  // most n bytes, 0 on timeout).
+  size_t read(uint8_t* out, size_t n, int timeoutMs);
+
+ private:
+  bool configure(uint32_t baud);
+  bool fail(const std::string& what);
+
+  int fd_ = -1;
+  uint32_t baud_ = 0;
+  std::string error_;
+};
+
+}  // namespace pixelgrid
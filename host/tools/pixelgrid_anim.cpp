@@ -0,0 +1,140 @@
+// pixelgrid_anim: turns PNG sequences and GIFs into .pga animation clips,
+// and plays clips on a board (or the device emulator) over serial.
+//
+//   pixelgrid_anim -o clip.pga [options] frame000.png frame001.png ...
+//   pixelgrid_anim -o clip.pga [options] intro.gif
+//   pixelgrid_anim --play clip.pga --port /dev/ttyACM0 [--baud N] [--framed]
+//
+// Options:
+//   --delay MS       duration of each PNG frame (default 100); GIFs keep their own
+//   --loop           the clip starts over at its end (when played from LittleFS)
+//   --brightness N   scale colours by N / 255 (default 255)
+//
+// Images are scaled to the 10x20 board, so draw them at that aspect ratio.
+// Copy a clip to the board's LittleFS as /title.pga or /tetris.pga to replace
+// the scrolling titles.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "AnimEncoder.h"
+#include "Animation.h"
+
+namespace {
+
+int usage(const char* argv0) {
+  std::fprintf(stderr,
+               "usage: %s -o OUT.pga [--delay MS] [--loop] [--brightness N] IMAGE...\n"
+               "       %s --play CLIP.pga --port PATH [--baud N] [--framed]\n",
+               argv0, argv0);
+  return 2;
+}
+
+const char* statusName(uint8_t status) {
+  switch (status) {
+    case ANIM_IDLE: return "stopped";
+    case ANIM_PLAYING: return "playing";
+    case ANIM_DONE: return "done";
+    case ANIM_ERROR: return "error";
+    default: return "?";
+  }
+}
+
+int encode(const std::string& outPath, const std::vector<std::string>& inputs, uint16_t delayMs, bool loop,
+           uint8_t brightness) {
+  std::vector<pixelgrid::AnimFrame> frames;
+  for (const std::string& path : inputs) {
+    std::vector<pixelgrid::ImageFrame> images;
+    std::string error;
+    if (!pixelgrid::loadImageFile(path, images, error)) {
+      std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+      return 1;
+    }
+    for (const pixelgrid::ImageFrame& img : images) {
+      pixelgrid::AnimFrame f;
+      f.frame = pixelgrid::imageToFrame(img.image, brightness);
+      uint32_t ms = img.delayMs ? img.delayMs : delayMs;
+      f.durationMs = static_cast<uint16_t>(ms > 0xFFFF ? 0xFFFF : ms);
+      frames.push_back(f);
+    }
+  }
+
+  std::vector<uint8_t> clip = pixelgrid::encodeAnimation(frames, loop);
+  std::ofstream out(outPath, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(clip.data()), static_cast<std::streamsize>(clip.size()));
+  if (!out) {
+    std::fprintf(stderr, "cannot write %s\n", outPath.c_str());
+    return 1;
+  }
+
+  pixelgrid::AnimInfo info;
+  pixelgrid::parseAnimHeader(clip.data(), clip.size(), info);
+  uint32_t totalMs = 0;
+  for (const pixelgrid::AnimFrame& f : frames) totalMs += f.durationMs;
+  std::printf("%s: %u images -> %u frames, %.1f s, %zu bytes (%.0f per frame, largest %u)\n", outPath.c_str(),
+              static_cast<unsigned>(frames.size()), info.frameCount, totalMs / 1000.0, clip.size(),
+              static_cast<double>(clip.size() - ANIM_HEADER_BYTES) / info.frameCount, info.maxPayload);
+  return 0;
+}
+
+int play(const std::string& clipPath, const std::string& portPath, uint32_t baud, bool framed) {
+  std::ifstream in(clipPath, std::ios::binary);
+  std::vector<uint8_t> clip((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  pixelgrid::AnimInfo info;
+  if (!pixelgrid::parseAnimHeader(clip.data(), clip.size(), info)) {
+    std::fprintf(stderr, "%s: not an animation clip\n", clipPath.c_str());
+    return 1;
+  }
+
+  pixelgrid::SerialPort port;
+  if (!port.open(portPath, baud)) {
+    std::fprintf(stderr, "%s\n", port.lastError().c_str());
+    return 1;
+  }
+  pixelgrid::DeviceStreamParser rx;
+  pixelgrid::PacketWriter writer(framed);
+  pixelgrid::AnimStreamResult r = pixelgrid::streamAnimation(port, rx, writer, clip);
+
+  std::printf("%u frames, %u bytes in %.2f s, %u acks: %s%s%s\n", info.frameCount, r.bytesSent, r.seconds, r.acks,
+              statusName(r.status), r.error.empty() ? "" : ", ", r.error.c_str());
+  return r.played ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string outPath, playPath, portPath;
+  std::vector<std::string> inputs;
+  uint32_t baud = 115200;
+  uint16_t delayMs = 100;
+  uint8_t brightness = 255;
+  bool loop = false;
+  bool framed = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "-o" && hasValue) outPath = argv[++i];
+    else if (a == "--play" && hasValue) playPath = argv[++i];
+    else if (a == "--port" && hasValue) portPath = argv[++i];
+    else if (a == "--baud" && hasValue) baud = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (a == "--framed") framed = true;
+    else if (a == "--delay" && hasValue) delayMs = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (a == "--brightness" && hasValue) brightness = static_cast<uint8_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (a == "--loop") loop = true;
+    else if (!a.empty() && a[0] != '-') inputs.push_back(a);
+    else return usage(argv[0]);
+  }
+
+  if (!playPath.empty() && !portPath.empty() && outPath.empty() && inputs.empty()) {
+    return play(playPath, portPath, baud, framed);
+  }
+  if (!outPath.empty() && !inputs.empty() && playPath.empty()) {
+    return encode(outPath, inputs, delayMs, loop, brightness);
+  }
+  return usage(argv[0]);
+}
@@ -0,0 +1,239 @@
+// pixelgrid_breakoutsim: plays Breakout headless with a paddle AI, many
+// games in a row, to tune the game with numbers instead of play sessions.
+//
+//   pixelgrid_breakoutsim [--games N] [--seed S] [--speedup-every K]
+//                         [--drop-ms MS] [--max-minutes M] [--move-ms MS]
+//
+// Each game runs BreakoutGame (Games/Breakout/Game.cpp) frame by frame at
+// FRAME_MS of game time, as the sketch does. The AI follows the lowest
+// falling ball and moves at most one cell per --move-ms (the joystick
+// repeat rate by default), aiming a random side of the paddle at the
+// ball. It reports frames per second of wall time and the spread of
+// scores, game lengths and how games ended.
+//
+// It also checks every frame that the balls stay in the field and never
+// move into a brick. Exits non-zero if a check fails, so CI can run it.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Game.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    std::printf("FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+struct Options {
+  uint32_t games = 1000;
+  uint32_t seed = 1;
+  uint16_t speedupEvery = BALL_SPEEDUP_EVERY;
+  uint16_t dropMs = BRICK_DROP_MS;
+  uint32_t maxMinutes = 30;
+  uint16_t moveMs = MOVE_REPEAT_MS;
+};
+
+enum Ending { END_BALL_LOST, END_BRICKS_DOWN, END_TIME_CAP, END_COUNT };
+const char* const ENDING_NAMES[END_COUNT] = { "ball lost", "bricks reached the paddle", "time cap" };
+
+struct Result {
+  uint32_t score;
+  uint32_t frames;
+  uint16_t bricks;
+  Ending ending;
+};
+
+struct Paddle {
+  uint32_t rng;
+  int8_t aim = 0;  // paddle cell under the ball, from the paddle's left end
+  bool wasRising = true;
+  uint32_t nextMoveFrame = 0;
+
+  uint32_t next(uint32_t n) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng % n;
+  }
+
+  int8_t move(const BreakoutGame& g, uint32_t frame, uint32_t moveFrames) {
+    if (g.balls.count == 0) return 0;
+    // The lowest ball on its way down, else the lowest ball
+    uint8_t target = 0;
+    bool falling = g.balls.vy[0] > 0;
+    for (uint8_t i = 1; i < g.balls.count; ++i) {
+      bool f = g.balls.vy[i] > 0;
+      if ((f && !falling) || (f == falling && g.balls.y[i] > g.balls.y[target])) {
+        target = i;
+        falling = f;
+      }
+    }
+    // A new aim each time the ball comes back down
+    if (falling && wasRising) aim = (int8_t)next(g.paddleW);
+    wasRising = !falling;
+
+    if (frame < nextMoveFrame) return 0;
+    int8_t want = (int8_t)((g.balls.x[target] >> BALL_FRAC_BITS) - aim);
+    if (want == g.paddleX) return 0;
+    nextMoveFrame = frame + moveFrames;
+    return want < g.paddleX ? -1 : 1;
+  }
+};
+
+// Ball positions before a frame, to catch one that moved into a brick
+struct Before {
+  uint8_t count;
+  int16_t x[BALL_MAX];
+  int16_t y[BALL_MAX];
+};
+
+void checkFrame(const BreakoutGame& g, const Before& before, bool dropped) {
+  for (uint8_t i = 0; i < g.balls.count; ++i) {
+    int16_t cx = (int16_t)(g.balls.x[i] >> BALL_FRAC_BITS);
+    int16_t cy = (int16_t)(g.balls.y[i] >> BALL_FRAC_BITS);
+    if (g.balls.x[i] < 0 || cx >= (int16_t)W || g.balls.y[i] < 0) {
+      check(false, "balls stay inside the walls and below the top");
+      return;
+    }
+    // Indices only hold still while no ball was lost this frame
+    if (dropped || before.count != g.balls.count) continue;
+    bool moved = cx != (before.x[i] >> BALL_FRAC_BITS) || cy != (before.y[i] >> BALL_FRAC_BITS);
+    if (moved && g.brickAt((int8_t)cx, (int8_t)cy)) {
+      check(false, "a ball never moves into a brick");
+      return;
+    }
+  }
+}
+
+Result playGame(uint32_t seed, const Options& o) {
+  BreakoutGame g;
+  g.seed(seed);
+  g.speedupEvery = o.speedupEvery;
+  g.brickDropMs = o.dropMs;
+  g.reset(0);
+  g.serveBall();
+
+  Paddle ai;
+  ai.rng = seed * 2654435761u + 1;
+  uint32_t moveFrames = (o.moveMs + FRAME_MS - 1) / FRAME_MS;
+  uint32_t maxFrames = o.maxMinutes * 60000u / FRAME_MS;
+
+  uint32_t frame = 0;
+  Before before;
+  for (; frame < maxFrames && !g.gameOver; ++frame) {
+    int8_t dx = ai.move(g, frame, moveFrames);
+    if (dx) g.movePaddle(dx);
+
+    before.count = g.balls.count;
+    for (uint8_t i = 0; i < g.balls.count; ++i) {
+      before.x[i] = g.balls.x[i];
+      before.y[i] = g.balls.y[i];
+    }
+    uint32_t drops = g.tBrickDrop;
+    g.update(frame * FRAME_MS);
+    checkFrame(g, before, g.tBrickDrop != drops);
+  }
+
+  check(g.score == 10u * g.bricksHit, "score is ten per brick");
+  Ending ending = END_TIME_CAP;
+  if (g.gameOver) ending = g.balls.count == 0 ? END_BALL_LOST : END_BRICKS_DOWN;
+  return { g.score, frame, g.bricksHit, ending };
+}
+
+template <typename T>
+T percentile(const std::vector<T>& sorted, uint32_t pct) {
+  return sorted[(sorted.size() - 1) * pct / 100];
+}
+
+int usage(const char* argv0) {
+  std::fprintf(stderr,
+               "usage: %s [--games N] [--seed S] [--speedup-every K] [--drop-ms MS]\n"
+               "          [--max-minutes M] [--move-ms MS]\n",
+               argv0);
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (i + 1 >= argc) return usage(argv[0]);
+    unsigned long v = std::strtoul(argv[++i], nullptr, 10);
+    if (a == "--games") o.games = (uint32_t)v;
+    else if (a == "--seed") o.seed = (uint32_t)v;
+    else if (a == "--speedup-every") o.speedupEvery = (uint16_t)v;
+    else if (a == "--drop-ms") o.dropMs = (uint16_t)v;
+    else if (a == "--max-minutes") o.maxMinutes = (uint32_t)v;
+    else if (a == "--move-ms") o.moveMs = (uint16_t)v;
+    else return usage(argv[0]);
+  }
+  if (!o.games || !o.dropMs || !o.maxMinutes) return usage(argv[0]);
+
+  std::vector<Result> results;
+  results.reserve(o.games);
+  uint64_t frames = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < o.games; ++n) {
+    results.push_back(playGame(o.seed + n, o));
+    frames += results.back().frames;
+  }
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  std::vector<uint32_t> scores;
+  std::vector<double> minutes;
+  uint32_t endings[END_COUNT] = {};
+  double scoreSum = 0;
+  for (const Result& r : results) {
+    scores.push_back(r.score);
+    minutes.push_back(r.frames * FRAME_MS / 60000.0);
+    endings[r.ending]++;
+    scoreSum += r.score;
+  }
+  std::sort(scores.begin(), scores.end());
+  std::sort(minutes.begin(), minutes.end());
+
+  std::printf("breakout: %u games from seed %u, speed-up every %u bricks, drop every %u ms\n",
+              o.games, o.seed, o.speedupEvery, o.dropMs);
+  std::printf("  %-14s %llu frames in %.2f s, %.2f M steps/s\n", "simulated",
+              (unsigned long long)frames, s, s > 0 ? frames / s / 1e6 : 0.0);
+  std::printf("  %-14s min %u  p10 %u  median %u  p90 %u  max %u  mean %.1f\n", "score",
+              scores.front(), percentile(scores, 10), percentile(scores, 50), percentile(scores, 90),
+              scores.back(), scoreSum / o.games);
+  std::printf("  %-14s p10 %.2f  median %.2f  p90 %.2f  max %.2f minutes\n", "game length",
+              percentile(minutes, 10), percentile(minutes, 50), percentile(minutes, 90), minutes.back());
+  for (uint8_t e = 0; e < END_COUNT; ++e) {
+    std::printf("  %-14s %5.1f%%  %s\n", e ? "" : "ended by", 100.0 * endings[e] / o.games, ENDING_NAMES[e]);
+  }
+
+  // Score histogram, ten buckets up to the highest score
+  const uint8_t BUCKETS = 10;
+  uint32_t width = scores.back() / BUCKETS + 10;
+  uint32_t counts[BUCKETS] = {};
+  for (uint32_t sc : scores) counts[std::min<uint32_t>(sc / width, BUCKETS - 1)]++;
+  uint32_t most = *std::max_element(counts, counts + BUCKETS);
+  std::printf("  score spread\n");
+  for (uint8_t b = 0; b < BUCKETS; ++b) {
+    std::printf("  %6u-%-6u %5u ", b * width, (b + 1) * width - 1, counts[b]);
+    for (uint32_t k = 0; k < (most ? counts[b] * 40 / most : 0); ++k) std::putchar('#');
+    std::putchar('\n');
+  }
+
+  if (failures == 0) {
+    std::printf("All checks passed.\n");
+    return 0;
+  }
+  std::printf("%d check(s) failed.\n", failures);
+  return 1;
+}
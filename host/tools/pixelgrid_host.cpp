@@ -0,0 +1,164 @@
+// pixelgrid_host: drives a PixelGrid board (or the device emulator) in host
+// mode with a demo animation and prints the input it reports.
+//
+//   pixelgrid_host --port /dev/ttyACM0 [options]
+//   pixelgrid_host --pty [options]        # prints the pty to point the emulator at
+//
+// Options:
+//   --baud N        rate to open the port at (default 115200)
+//   --negotiate N   switch the link to N baud after opening (PBBR)
+//   --framed        send COBS/CRC framed packets
+//   --raw           never compress frames (always PBFR)
+//   --fps N         frame rate cap (default 60)
+//   --seconds N     run time, 0 = until interrupted (default 0)
+//   --text TEXT     LCD text (default "HOST")
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "BaudNegotiation.h"
+#include "HostSession.h"
+#include "SerialPort.h"
+
+namespace {
+
+volatile std::sig_atomic_t running = 1;
+
+void onSignal(int) { running = 0; }
+
+int usage(const char* argv0) {
+  std::fprintf(stderr,
+               "usage: %s (--port PATH | --pty) [--baud N] [--negotiate N] [--framed] [--raw]\n"
+               "          [--fps N] [--seconds N] [--text TEXT]\n",
+               argv0);
+  return 2;
+}
+
+// A falling diagonal rainbow with a block bouncing across it
+void renderDemo(pixelgrid::HostFrame& f, uint32_t tick) {
+  using F = pixelgrid::HostFrame;
+  for (uint8_t y = 0; y < F::H; ++y) {
+    for (uint8_t x = 0; x < F::W; ++x) {
+      uint8_t phase = static_cast<uint8_t>((x + y) * 12 - tick * 3);
+      uint8_t r = phase < 85 ? static_cast<uint8_t>(85 - phase) : phase < 170 ? 0 : static_cast<uint8_t>(phase - 170);
+      uint8_t g = phase < 85 ? static_cast<uint8_t>(phase) : phase < 170 ? static_cast<uint8_t>(170 - phase) : 0;
+      uint8_t b = phase < 85 ? 0 : phase < 170 ? static_cast<uint8_t>(phase - 85) : static_cast<uint8_t>(255 - phase);
+      f.set(x, y, r / 4, g / 4, b / 4);
+    }
+  }
+
+  uint32_t span = (F::W - 2) * 2;
+  uint32_t pos = (tick / 4) % span;
+  uint8_t bx = static_cast<uint8_t>(pos < span / 2 ? pos : span - pos);
+  uint8_t by = static_cast<uint8_t>((tick / 2) % (F::H - 1));
+  for (uint8_t dy = 0; dy < 2; ++dy) {
+    for (uint8_t dx = 0; dx < 2; ++dx) f.set(static_cast<uint8_t>(bx + dx), static_cast<uint8_t>(by + dy), 255, 255, 255);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string portPath;
+  bool usePty = false;
+  uint32_t baud = 115200;
+  uint32_t negotiate = 0;
+  uint32_t seconds = 0;
+  std::string text = "HOST";
+  pixelgrid::HostSessionConfig cfg;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--port" && hasValue) portPath = argv[++i];
+    else if (a == "--pty") usePty = true;
+    else if (a == "--baud" && hasValue) baud = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (a == "--negotiate" && hasValue) negotiate = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (a == "--framed") cfg.framed = true;
+    else if (a == "--raw") cfg.compress = false;
+    else if (a == "--fps" && hasValue) cfg.maxFps = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (a == "--seconds" && hasValue) seconds = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (a == "--text" && hasValue) text = argv[++i];
+    else return usage(argv[0]);
+  }
+  if (usePty == !portPath.empty()) return usage(argv[0]);
+
+  pixelgrid::SerialPort port;
+  if (usePty) {
+    std::string slave;
+    if (!port.openPty(slave)) {
+      std::fprintf(stderr, "pty: %s\n", port.lastError().c_str());
+      return 1;
+    }
+    std::printf("device side: %s\n", slave.c_str());
+    std::fflush(stdout);
+  } else if (!port.open(portPath, baud)) {
+    std::fprintf(stderr, "%s\n", port.lastError().c_str());
+    return 1;
+  }
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  pixelgrid::HostSession session(port, cfg);
+  if (negotiate) {
+    pixelgrid::BaudResult r = pixelgrid::negotiateBaud(port, session.rx(), negotiate);
+    std::printf("baud %u: %s\n", negotiate, pixelgrid::baudResultName(r));
+    if (r == pixelgrid::BaudResult::FellBack) {
+      // The device may still be at the new rate until the link goes quiet
+      std::this_thread::sleep_for(std::chrono::milliseconds(HOST_BAUD_IDLE_MS));
+      port.setBaud(HOST_DEFAULT_BAUD);
+    }
+  }
+  session.setLcdText(text);
+
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+  const auto tickLen = std::chrono::microseconds(1000000 / (cfg.maxFps ? cfg.maxFps : 60));
+  Clock::time_point nextTick = start;
+  Clock::time_point nextReport = start + std::chrono::seconds(1);
+  pixelgrid::HostFrame frame;
+  uint32_t tick = 0;
+
+  while (running) {
+    Clock::time_point now = Clock::now();
+    if (seconds && now - start >= std::chrono::seconds(seconds)) break;
+
+    if (now >= nextTick) {
+      renderDemo(frame, tick++);
+      session.submitFrame(frame);
+      nextTick += tickLen;
+      if (nextTick < now) nextTick = now + tickLen;
+    }
+
+    session.service(1);
+
+    uint8_t bits;
+    while (session.popInput(bits)) std::printf("input 0x%02X\n", bits);
+
+    if (now >= nextReport) {
+      const pixelgrid::HostSessionStats& st = session.stats();
+      std::printf("sent %llu merged %llu  link %.0f B/s  rtt %.1f ms%s\n",
+                  static_cast<unsigned long long>(st.framesSent),
+                  static_cast<unsigned long long>(st.framesMerged),
+                  st.linkBytesPerSec, st.lastRttMs,
+                  st.deviceConfirms ? "" : "  (no confirmations, time paced)");
+      std::fflush(stdout);
+      nextReport += std::chrono::seconds(1);
+    }
+  }
+
+  const pixelgrid::HostSessionStats& st = session.stats();
+  std::printf("frames: submitted %llu sent %llu merged %llu confirmed %llu, %llu bytes\n",
+              static_cast<unsigned long long>(st.framesSubmitted),
+              static_cast<unsigned long long>(st.framesSent),
+              static_cast<unsigned long long>(st.framesMerged),
+              static_cast<unsigned long long>(st.framesConfirmed),
+              static_cast<unsigned long long>(st.bytesSent));
+  return 0;
+}
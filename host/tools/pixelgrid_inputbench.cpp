@@ -0,0 +1,167 @@
+// pixelgrid_inputbench: times the two ways of reading and debouncing the
+// eight input lines, on the emulator's pin shim.
+//
+//   pixelgrid_inputbench [--passes N]
+//
+// "per pin" is the old loop: eight digitalRead() calls and a timed debounce
+// per button. "port" is InputPort plus VerticalCounter: one register word
+// and eight lanes debounced with a few bitwise operations. "edges" is
+// InputDebouncer fed a bouncing press and release per line, the path the
+// Tetris input takes. On the host digitalRead() is only an atomic load, so
+// the per-pin cost here is a floor; on the ESP32 each call also looks up the
+// pin's port.
+//
+// It also checks that the edge path settles every scripted press and
+// release within the debounce time and never passes on a bounce. Exits
+// non-zero if a check fails, so CI can run it.
+
+#include <Arduino.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <InputPort.h>
+
+namespace {
+
+const uint16_t DEBOUNCE_MS = 18;
+const uint8_t LINES = 8;
+const uint8_t PINS[LINES] = { 3, 4, 10, 6, 9, 7, 8, 12 };
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    std::printf("FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// The per-button debounce the loop used to run on every pass
+struct PolledBtn {
+  uint8_t pin = 0;
+  bool stable = false;
+  bool lastRaw = false;
+  uint32_t lastChange = 0;
+
+  void update(uint32_t now) {
+    bool raw = digitalRead(pin) == LOW;
+    if (raw != lastRaw) {
+      lastRaw = raw;
+      lastChange = now;
+    }
+    if (now - lastChange >= DEBOUNCE_MS && stable != raw) stable = raw;
+  }
+};
+
+// Some lines pressed on a pass, so both paths see changing input
+void togglePins(uint32_t pass) {
+  if ((pass & 255) == 0) emuSetPin(PINS[(pass >> 8) % LINES], (pass >> 11) & 1 ? HIGH : LOW);
+}
+
+void benchPerPin(uint32_t passes) {
+  PolledBtn btns[LINES];
+  for (uint8_t i = 0; i < LINES; ++i) btns[i].pin = PINS[i];
+  uint8_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t pass = 0; pass < passes; ++pass) {
+    togglePins(pass);
+    for (uint8_t i = 0; i < LINES; ++i) {
+      btns[i].update(pass / 64);
+      sink ^= btns[i].stable ? (uint8_t)(1u << i) : 0;
+    }
+  }
+  double s = secondsSince(t0);
+  std::printf("  %-24s %7.1f ns/pass  (%02x)\n", "per pin, digitalRead", s * 1e9 / passes, sink);
+}
+
+void benchPort(uint32_t passes) {
+  InputPort port;
+  port.begin(PINS, LINES);
+  VerticalCounter vc;
+  uint8_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t pass = 0; pass < passes; ++pass) {
+    togglePins(pass);
+    vc.clock(port.read());
+    sink ^= vc.state;
+  }
+  double s = secondsSince(t0);
+  std::printf("  %-24s %7.1f ns/pass  (%02x)\n", "port, vertical counter", s * 1e9 / passes, sink);
+  for (uint8_t i = 0; i < LINES; ++i) emuSetPin(PINS[i], HIGH);
+}
+
+// Every line: a press that bounces three times, then a bouncing release
+void benchEdges(uint32_t rounds) {
+  const uint32_t debounceUs = DEBOUNCE_MS * 1000u;
+  InputDebouncer d;
+  d.begin(0, 0, debounceUs);
+  uint32_t t = 0;
+  uint8_t levels = 0;
+  uint32_t edges = 0;
+  bool settled = true;
+  bool noBounce = true;
+  bool dated = true;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < rounds; ++r) {
+    uint8_t line = (uint8_t)(r % LINES);
+    uint8_t bit = (uint8_t)(1u << line);
+    bool press = !(levels & bit);
+    uint32_t start = t + 50000;
+    // 1 ms apart: on, off, on, off, on for a press
+    for (uint8_t b = 0; b < 5; ++b) {
+      levels ^= bit;
+      d.edge(levels, start + b * 1000u);
+      ++edges;
+    }
+    uint32_t last = start + 4000;
+    uint8_t stable = d.settle(last + 1000);
+    noBounce = noBounce && ((stable & bit) != 0) != press;
+    stable = d.settle(last + debounceUs);
+    settled = settled && ((stable & bit) != 0) == press;
+    dated = dated && d.changedUs(line) == start;
+    t = last + debounceUs;
+  }
+  double s = secondsSince(t0);
+  std::printf("  %-24s %7.1f ns/edge\n", "edges, InputDebouncer", s * 1e9 / edges);
+
+  check(settled, "each press and release is stable by the debounce time after its last bounce");
+  check(noBounce, "a line still bouncing keeps its old level");
+  check(dated, "each change is dated to the first edge of its burst");
+}
+
+int usage(const char* argv0) {
+  std::fprintf(stderr, "usage: %s [--passes N]\n", argv0);
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t passes = 2000000;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--passes" && i + 1 < argc) passes = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else return usage(argv[0]);
+  }
+  if (!passes) return usage(argv[0]);
+
+  std::printf("input read + debounce, 8 lines\n");
+  benchPerPin(passes);
+  benchPort(passes);
+  benchEdges(passes / 16 + 1);
+
+  if (failures == 0) {
+    std::printf("All checks passed.\n");
+    return 0;
+  }
+  std::printf("%d check(s) failed.\n", failures);
+  return 1;
+}
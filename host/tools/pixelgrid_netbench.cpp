@@ -0,0 +1,256 @@
+// pixelgrid_netbench: runs the firmware's score submission path
+// (Games/Tetris/NetSubmit.h) on Linux against a local ScoreServer, through
+// the emulator's socket-backed WiFiClientSecure/HTTPClient shim, and reports
+// submissions per second and per-request latency.
+//
+//   pixelgrid_netbench [--count N] [--verbose]
+//
+// Besides timing, it checks what the server made of each request: direct
+// submissions share one connection, reconnect when the server closes it,
+// batches drain the journal, and a wrong secret, a skewed clock or a server
+// without /api/codes/batch are handled. Exits non-zero if a check fails, so
+// CI can run it.
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include "NetSubmit.h"
+#include "ScoreServer.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  if (!ok) {
+    std::printf("FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t i = static_cast<size_t>(p * static_cast<double>(v.size() - 1) + 0.5);
+  return v[i];
+}
+
+void reportLatency(const char* name, const std::vector<double>& us, double seconds) {
+  std::printf("  %-26s p50 %7.1f us  p99 %7.1f us  max %7.1f us", name, percentile(us, 0.5), percentile(us, 0.99),
+              us.empty() ? 0.0 : *std::max_element(us.begin(), us.end()));
+  // Runs with pauses between requests have no meaningful rate
+  if (seconds > 0) std::printf("  %7.0f req/s", static_cast<double>(us.size()) / seconds);
+  std::printf("\n");
+}
+
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+bool isCode(const String& code) {
+  if (code.length() != 6) return false;
+  for (size_t i = 0; i < code.length(); ++i) {
+    if (code[i] < '0' || code[i] > '9') return false;
+  }
+  return true;
+}
+
+// A server of its own for one run, with the firmware pointed at it
+struct BenchServer {
+  explicit BenchServer(const pixelgrid::ScoreServerConfig& config) : server(config) {
+    if (!server.start()) {
+      std::fprintf(stderr, "score server: %s\n", server.lastError().c_str());
+      std::exit(1);
+    }
+    emuSetApiBase(server.baseUrl().c_str());
+    netSession.close();
+    netSession.client.forgetSession();
+    netSession.handshakes = 0;
+    netSession.reuses = 0;
+    netSession.resumeOffers = 0;
+    netBatchSupported = true;
+  }
+
+  pixelgrid::ScoreServer server;
+};
+
+// Direct submissions (submitScoreToServer), one after another
+std::vector<double> submitMany(uint32_t count, uint32_t pauseMs, uint32_t& codes) {
+  std::vector<double> us;
+  codes = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (pauseMs) std::this_thread::sleep_for(std::chrono::milliseconds(pauseMs));
+    String code;
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = submitScoreToServer(1000 + i, code);
+    us.push_back(secondsSince(t0) * 1e6);
+    if (ok && isCode(code)) codes++;
+  }
+  return us;
+}
+
+void benchKeptConnection(uint32_t count) {
+  BenchServer b{pixelgrid::ScoreServerConfig()};
+  uint32_t codes = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<double> us = submitMany(count, 0, codes);
+  reportLatency("submit, kept connection", us, secondsSince(t0));
+
+  pixelgrid::ScoreServerStats s = b.server.stats();
+  check(codes == count, "every direct submission gets a six-digit code");
+  check(s.accepted == count && s.rejected == 0, "the server accepts every signed record");
+  check(s.connections == 1, "direct submissions share one connection");
+  check(netSession.handshakes == 1 && netSession.reuses == count - 1, "the session counts one new connection");
+}
+
+void benchServerCloses(uint32_t count) {
+  pixelgrid::ScoreServerConfig config;
+  config.maxRequestsPerConnection = 5;
+  BenchServer b{config};
+  uint32_t codes = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<double> us = submitMany(count, 0, codes);
+  reportLatency("submit, close every 5", us, secondsSince(t0));
+
+  pixelgrid::ScoreServerStats s = b.server.stats();
+  check(codes == count, "submissions succeed when the server closes every 5 requests");
+  check(s.connections == (count + 4) / 5, "a connection the server closed is replaced");
+  check(netSession.resumeOffers == s.connections - 1, "a replacement connection offers the last TLS session");
+}
+
+void benchIdleClose() {
+  const uint32_t count = 10;
+  pixelgrid::ScoreServerConfig config;
+  config.idleCloseMs = 50;
+  BenchServer b{config};
+  uint32_t codes = 0;
+  std::vector<double> us = submitMany(count, 100, codes);
+  reportLatency("submit, server idle close", us, 0);
+
+  check(codes == count, "submissions succeed after the server dropped an idle connection");
+  check(b.server.stats().connections == count, "each submission after an idle close reconnects");
+  check(netSession.resumeOffers == count - 1, "each reconnect offers the last TLS session");
+}
+
+// Queued scores drained through /api/codes/batch, or one at a time without it
+void benchJournal(uint32_t count, bool batch) {
+  char dir[] = "/tmp/pixelgrid_netbench.XXXXXX";
+  if (!mkdtemp(dir)) {
+    std::perror("mkdtemp");
+    std::exit(1);
+  }
+  LittleFS.begin(std::string(dir));
+  check(scoreJournal.begin(), "the score journal opens");
+
+  pixelgrid::ScoreServerConfig config;
+  config.batch = batch;
+  BenchServer b{config};
+
+  uint32_t lastId = 0;
+  for (uint32_t i = 0; i < count; ++i) check(netQueueScore(2000 + i, lastId), "a score is queued");
+
+  std::vector<double> us;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t attempts = 0; scoreJournal.pending() && attempts < count * 2 + 2; ++attempts) {
+    auto r0 = std::chrono::steady_clock::now();
+    check(netUploadPending(), "an upload succeeds");
+    us.push_back(secondsSince(r0) * 1e6);
+  }
+  double seconds = secondsSince(t0);
+  reportLatency(batch ? "upload, batched request" : "upload, 404 then singles", us, seconds);
+  std::printf("  %-26s %7.0f scores/s\n", "", count / seconds);
+
+  pixelgrid::ScoreServerStats s = b.server.stats();
+  String code;
+  check(scoreJournal.pending() == 0, "the journal drains");
+  check(s.accepted == count && s.rejected == 0, "the server accepts every queued score");
+  check(netTakeCode(lastId, code) && isCode(code), "the last queued score's code is published");
+  if (batch) {
+    check(s.requests == (count + NET_BATCH_MAX - 1) / NET_BATCH_MAX, "queued scores go NET_BATCH_MAX per request");
+  } else {
+    check(!netBatchSupported, "a 404 from /api/codes/batch switches to single requests");
+    check(s.requests == count + 1, "without the batch endpoint each score is its own request");
+  }
+
+  if (DIR* d = opendir(dir)) {
+    while (dirent* e = readdir(d)) {
+      if (e->d_name[0] != '.') unlink((std::string(dir) + "/" + e->d_name).c_str());
+    }
+    closedir(d);
+  }
+  rmdir(dir);
+}
+
+void checkRejections() {
+  {
+    pixelgrid::ScoreServerConfig config;
+    config.secret = "not the device secret";
+    BenchServer b{config};
+    String code;
+    check(!submitScoreToServer(1, code) && code.length() == 0, "a wrong secret is not given a code");
+    check(b.server.stats().rejected == 1, "the server rejects a bad signature");
+  }
+  {
+    pixelgrid::ScoreServerConfig config;
+    config.clockOffsetS = 200;
+    BenchServer b{config};
+    String code;
+    check(!submitScoreToServer(1, code), "a clock 200 s behind the server is rejected");
+  }
+  {
+    pixelgrid::ScoreServerConfig config;
+    config.clockOffsetS = -100;
+    BenchServer b{config};
+    String code;
+    check(submitScoreToServer(1, code) && isCode(code), "a clock 100 s ahead of the server is accepted");
+  }
+}
+
+int usage(const char* argv0) {
+  std::fprintf(stderr, "usage: %s [--count N] [--verbose]\n", argv0);
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t count = 200;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--count" && i + 1 < argc) count = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    else if (a == "--verbose") Serial.attach(STDOUT_FILENO);  // the firmware's [NET] log
+    else return usage(argv[0]);
+  }
+  if (!count) return usage(argv[0]);
+
+  netSignerBegin();
+  netLinkBegin();
+  netLinkPoll();
+  netLinkPoll();
+  check(netLinkReady(), "the link comes up");
+  scoreJournalLock = xSemaphoreCreateMutex();
+
+  benchKeptConnection(count);
+  benchServerCloses(count);
+  benchIdleClose();
+  benchJournal(count, true);
+  benchJournal(count / 4 + 1, false);
+  checkRejections();
+
+  if (failures == 0) {
+    std::printf("All checks passed.\n");
+    return 0;
+  }
+  std::printf("%d check(s) failed.\n", failures);
+  return 1;
+}
@@ -0,0 +1,70 @@
+// pixelgrid_score_server: the local stand-in for the score backend
+// (ScoreServer.h), for running the emulator's submit path by hand.
+//
+//   pixelgrid_score_server [--port N] [--secret S] [--game CODE] [--no-batch]
+//
+// The defaults match the emulator's NetConfig.h, so pixelgrid_emu posts to
+// it without PIXELGRID_EMU_API set. Runs until Ctrl-C.
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "ScoreServer.h"
+
+namespace {
+
+volatile std::sig_atomic_t running = 1;
+
+void onSignal(int) { running = 0; }
+
+int usage(const char* argv0) {
+  std::fprintf(stderr, "usage: %s [--port N] [--secret S] [--game CODE] [--no-batch]\n", argv0);
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  pixelgrid::ScoreServerConfig config;
+  unsigned long port = 8080;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--port" && hasValue) port = std::strtoul(argv[++i], nullptr, 10);
+    else if (a == "--secret" && hasValue) config.secret = argv[++i];
+    else if (a == "--game" && hasValue) config.gameCode = argv[++i];
+    else if (a == "--no-batch") config.batch = false;
+    else return usage(argv[0]);
+  }
+  if (port > 65535) return usage(argv[0]);
+
+  pixelgrid::ScoreServer server(config);
+  if (!server.start(static_cast<uint16_t>(port))) {
+    std::fprintf(stderr, "%s\n", server.lastError().c_str());
+    return 1;
+  }
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  std::printf("Listening on %s (game %s)\n", server.baseUrl().c_str(), config.gameCode.c_str());
+  std::fflush(stdout);
+
+  pixelgrid::ScoreServerStats last;
+  while (running) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    pixelgrid::ScoreServerStats s = server.stats();
+    if (s.requests != last.requests) {
+      std::printf("requests %llu  accepted %llu  replays %llu  rejected %llu  connections %llu\n",
+                  static_cast<unsigned long long>(s.requests), static_cast<unsigned long long>(s.accepted),
+                  static_cast<unsigned long long>(s.replays), static_cast<unsigned long long>(s.rejected),
+                  static_cast<unsigned long long>(s.connections));
+      std::fflush(stdout);
+      last = s;
+    }
+  }
+  server.stop();
+  return 0;
+}
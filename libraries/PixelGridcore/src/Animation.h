@@ -0,0 +1,367 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "FrameCodec.h"
+#include "HostProtocol.h"
+
+// Animation clips (.pga files)
+//   header  "PGAN", u8 version, u8 width, u8 height, u8 flags,
+//           u16 frame count, u16 largest frame payload
+//   frames  u16 duration ms, u16 length, payload[length]
+// Integers are little-endian. A frame payload is an encoding byte and a
+// body: ANIM_ENC_RAW is width * height GRB pixels, any other value is a
+// PBDF payload (FrameCodec.h). Pixels are in PBFR order (column by column,
+// odd columns bottom to top). The first frame must not be an XOR delta;
+// looping clips start again from the header.
+//
+// AnimPlayer pulls a clip through an AnimSource one frame at a time, so it
+// needs one frame payload of RAM (ANIM_PAYLOAD_MAX) plus the caller's frame
+// buffer however long the clip is. Sources may return fewer bytes than asked
+// for, as a serial stream that hasn't caught up does; the player resumes
+// where it stopped on the next update() and counts the frames that were late.
+//
+// Host stream (see HostRuntime.h):
+//   host   -> PBAS  empty: stop any clip and start a new one
+//   host   -> PBAD  the next bytes of the clip, split anywhere
+//   device -> PBAK  u32 clip bytes the player has consumed, u16 stream
+//                   buffer size, u8 AnimStatus
+// The device answers PBAS and PBAD with a PBAK, and sends another whenever
+// the player has consumed ANIM_ACK_EVERY bytes since the last one, at least
+// every ANIM_ACK_MS while the clip plays, and once when it ends. Hosts must
+// keep (bytes sent - bytes consumed) <= buffer size; a PBAD that doesn't fit
+// ends the clip with ANIM_ERR_OVERRUN. Streams can't rewind, so a looping
+// clip sent this way plays once.
+
+static const uint8_t  ANIM_VERSION            = 1;
+static const uint16_t ANIM_HEADER_BYTES       = 12;
+static const uint16_t ANIM_FRAME_HEADER_BYTES = 4;
+static const uint8_t  ANIM_ENC_RAW            = 0;
+static const uint8_t  ANIM_FLAG_LOOP          = 0x01;
+// A raw frame as large as a host frame, plus its encoding byte
+static const uint16_t ANIM_PAYLOAD_MAX = HOST_FRAME_BYTES + 1;
+
+static const uint16_t ANIM_STREAM_BYTES = 1024;
+static const uint16_t ANIM_ACK_EVERY    = ANIM_STREAM_BYTES / 4;
+static const uint16_t ANIM_ACK_MS       = 250;
+static const uint16_t HOST_ANIM_ACK_BYTES = 7;
+
+enum AnimStatus : uint8_t {
+  ANIM_IDLE    = 0,
+  ANIM_PLAYING = 1,
+  ANIM_DONE    = 2, // a clip without ANIM_FLAG_LOOP ended; the last frame stays up
+  ANIM_ERROR   = 3
+};
+
+enum AnimError : uint8_t {
+  ANIM_ERR_NONE      = 0,
+  ANIM_ERR_HEADER    = 1, // bad magic or version, no frames
+  ANIM_ERR_SIZE      = 2, // clip width * height doesn't match the frame buffer
+  ANIM_ERR_TOO_LARGE = 3, // a frame payload doesn't fit ANIM_PAYLOAD_MAX
+  ANIM_ERR_FRAME     = 4, // a frame failed to decode
+  ANIM_ERR_OVERRUN   = 5  // the host sent more than the stream buffer holds
+};
+
+static inline uint16_t animReadU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline void animWriteU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+struct AnimSource {
+  void* ctx = nullptr;
+  // Copies up to n bytes into dst and returns how many; 0 means none yet
+  // (streams) or the end of the data.
+  uint16_t (*read)(void* ctx, uint8_t* dst, uint16_t n) = nullptr;
+  // Back to the first byte of the clip. Null for sources that can't.
+  bool (*rewind)(void* ctx) = nullptr;
+};
+
+// A clip already in memory (flash or RAM)
+struct AnimMemorySource {
+  const uint8_t* data = nullptr;
+  uint32_t len = 0;
+  uint32_t pos = 0;
+
+  void begin(const uint8_t* d, uint32_t n) {
+    data = d;
+    len = n;
+    pos = 0;
+  }
+
+  AnimSource source() {
+    AnimSource s;
+    s.ctx = this;
+    s.read = read;
+    s.rewind = rewind;
+    return s;
+  }
+
+  static uint16_t read(void* ctx, uint8_t* dst, uint16_t n) {
+    AnimMemorySource* m = (AnimMemorySource*)ctx;
+    uint32_t left = m->len - m->pos;
+    uint16_t take = left < n ? (uint16_t)left : n;
+    memcpy(dst, m->data + m->pos, take);
+    m->pos += take;
+    return take;
+  }
+
+  static bool rewind(void* ctx) {
+    ((AnimMemorySource*)ctx)->pos = 0;
+    return true;
+  }
+};
+
+// A clip in a file: anything with read(uint8_t*, size_t) and seek(pos),
+// such as an Arduino LittleFS or SD File. The file must stay open while
+// the clip plays.
+template <typename FileT>
+struct AnimFileSource {
+  FileT* file = nullptr;
+
+  AnimSource source(FileT& f) {
+    file = &f;
+    AnimSource s;
+    s.ctx = this;
+    s.read = read;
+    s.rewind = rewind;
+    return s;
+  }
+
+  static uint16_t read(void* ctx, uint8_t* dst, uint16_t n) {
+    int got = (int)((AnimFileSource*)ctx)->file->read(dst, n);
+    return got > 0 ? (uint16_t)got : 0;
+  }
+
+  static bool rewind(void* ctx) {
+    return ((AnimFileSource*)ctx)->file->seek(0);
+  }
+};
+
+// Bytes from PBAD packets waiting for the player
+struct AnimStreamRing {
+  uint8_t buf[ANIM_STREAM_BYTES];
+  uint16_t head = 0;      // next read
+  uint16_t count = 0;
+  uint32_t consumed = 0;  // bytes handed to the player since reset()
+
+  void reset() {
+    head = count = 0;
+    consumed = 0;
+  }
+
+  uint16_t space() const { return (uint16_t)(ANIM_STREAM_BYTES - count); }
+
+  // All or nothing: false (and nothing stored) if the bytes don't fit
+  bool push(const uint8_t* p, uint16_t n) {
+    if (n > space()) return false;
+    for (uint16_t i = 0; i < n; ++i) buf[(head + count + i) % ANIM_STREAM_BYTES] = p[i];
+    count = (uint16_t)(count + n);
+    return true;
+  }
+
+  AnimSource source() {
+    AnimSource s;
+    s.ctx = this;
+    s.read = read;
+    return s;
+  }
+
+  static uint16_t read(void* ctx, uint8_t* dst, uint16_t n) {
+    AnimStreamRing* r = (AnimStreamRing*)ctx;
+    uint16_t take = r->count < n ? r->count : n;
+    for (uint16_t i = 0; i < take; ++i) dst[i] = r->buf[(r->head + i) % ANIM_STREAM_BYTES];
+    r->head = (uint16_t)((r->head + take) % ANIM_STREAM_BYTES);
+    r->count = (uint16_t)(r->count - take);
+    r->consumed += take;
+    return take;
+  }
+};
+
+// PBAK payload
+static inline void hostAnimAckPayload(uint32_t consumed, uint8_t status, uint8_t out[HOST_ANIM_ACK_BYTES]) {
+  hostWriteU32(out, consumed);
+  animWriteU16(out + 4, ANIM_STREAM_BYTES);
+  out[6] = status;
+}
+
+struct AnimPlayer {
+  enum Step : uint8_t { STEP_HEADER, STEP_FRAME_HEADER, STEP_PAYLOAD };
+
+  AnimSource src;
+  uint8_t* frame = nullptr;
+  uint16_t pixels = 0;
+
+  // Clip header, frame header or frame payload being read
+  uint8_t buf[ANIM_PAYLOAD_MAX];
+  uint16_t need = 0;
+  uint16_t got = 0;
+  Step step = STEP_HEADER;
+
+  AnimStatus status = ANIM_IDLE;
+  AnimError error = ANIM_ERR_NONE;
+
+  uint8_t width = 0;
+  uint8_t height = 0;
+  uint8_t flags = 0;
+  uint16_t frameCount = 0;
+  uint16_t frameIndex = 0;     // frames decoded since the header
+  uint16_t nextDurationMs = 0; // of the frame being read
+
+  bool showing = false;  // frame holds a decoded frame
+  bool stalled = false;  // the next frame was due but its bytes weren't there
+  uint16_t durationMs = 0;
+  uint32_t shownAtMs = 0;
+
+  uint32_t framesShown = 0;
+  uint32_t framesLate = 0;  // shown late because the source ran dry
+
+  // frame must hold framePixels * 3 bytes; the clip's width * height must
+  // match. The first frame is shown on the first update().
+  void begin(const AnimSource& source, uint8_t* frameBuf, uint16_t framePixels) {
+    src = source;
+    frame = frameBuf;
+    pixels = framePixels;
+    startHeader();
+    status = ANIM_PLAYING;
+    error = ANIM_ERR_NONE;
+    showing = false;
+    stalled = false;
+    framesShown = framesLate = 0;
+  }
+
+  void stop() { status = ANIM_IDLE; }
+
+  void fail(AnimError e) {
+    status = ANIM_ERROR;
+    error = e;
+  }
+
+  bool playing() const { return status == ANIM_PLAYING; }
+
+  // True when frame holds a new frame to show now
+  bool update(uint32_t nowMs) {
+    if (status != ANIM_PLAYING) return false;
+    uint32_t dueMs = shownAtMs + durationMs;
+    if (showing && (int32_t)(nowMs - dueMs) < 0) return false;
+
+    if (!readFrame()) {
+      if (status == ANIM_PLAYING) stalled = true;
+      return false;
+    }
+
+    // Keep the clip's cadence unless a whole frame was missed
+    if (!showing || stalled || nowMs - dueMs >= nextDurationMs) {
+      if (showing && stalled) framesLate++;
+      shownAtMs = nowMs;
+    } else {
+      shownAtMs = dueMs;
+    }
+    durationMs = nextDurationMs;
+    showing = true;
+    stalled = false;
+    framesShown++;
+    return true;
+  }
+
+  void startHeader() {
+    step = STEP_HEADER;
+    need = ANIM_HEADER_BYTES;
+    got = 0;
+  }
+
+  void expect(Step s, uint16_t n) {
+    step = s;
+    need = n;
+    got = 0;
+  }
+
+  bool fill() {
+    while (got < need) {
+      uint16_t n = src.read(src.ctx, buf + got, (uint16_t)(need - got));
+      if (n == 0) return false;
+      got = (uint16_t)(got + n);
+    }
+    return true;
+  }
+
+  bool parseHeader() {
+    if (buf[0] != 'P' || buf[1] != 'G' || buf[2] != 'A' || buf[3] != 'N' || buf[4] != ANIM_VERSION) {
+      fail(ANIM_ERR_HEADER);
+      return false;
+    }
+    width = buf[5];
+    height = buf[6];
+    flags = buf[7];
+    frameCount = animReadU16(buf + 8);
+    if (frameCount == 0) {
+      fail(ANIM_ERR_HEADER);
+      return false;
+    }
+    if ((uint16_t)(width * height) != pixels) {
+      fail(ANIM_ERR_SIZE);
+      return false;
+    }
+    if (animReadU16(buf + 10) > ANIM_PAYLOAD_MAX) {
+      fail(ANIM_ERR_TOO_LARGE);
+      return false;
+    }
+    frameIndex = 0;
+    return true;
+  }
+
+  bool decodePayload(uint16_t len) {
+    if (buf[0] == ANIM_ENC_RAW) {
+      if (len != 1 + pixels * 3) return false;
+      memcpy(frame, buf + 1, (size_t)pixels * 3);
+      return true;
+    }
+    if (frameEncodingIsDelta(buf[0]) && frameIndex == 0) return false;
+    return decodeFrame(buf, len, frame, pixels);
+  }
+
+  // Reads up to the end of the next frame and decodes it. False if the
+  // source ran dry (call again later) or the clip ended or failed.
+  bool readFrame() {
+    for (;;) {
+      if (step == STEP_FRAME_HEADER && got == 0 && frameIndex == frameCount) {
+        if (!(flags & ANIM_FLAG_LOOP) || !src.rewind || !src.rewind(src.ctx)) {
+          status = ANIM_DONE;
+          return false;
+        }
+        startHeader();
+      }
+      if (!fill()) return false;
+
+      switch (step) {
+        case STEP_HEADER:
+          if (!parseHeader()) return false;
+          expect(STEP_FRAME_HEADER, ANIM_FRAME_HEADER_BYTES);
+          break;
+
+        case STEP_FRAME_HEADER: {
+          nextDurationMs = animReadU16(buf);
+          uint16_t len = animReadU16(buf + 2);
+          if (len == 0 || len > ANIM_PAYLOAD_MAX) {
+            fail(len ? ANIM_ERR_TOO_LARGE : ANIM_ERR_FRAME);
+            return false;
+          }
+          expect(STEP_PAYLOAD, len);
+          break;
+        }
+
+        case STEP_PAYLOAD:
+          if (!decodePayload(got)) {
+            fail(ANIM_ERR_FRAME);
+            return false;
+          }
+          frameIndex++;
+          expect(STEP_FRAME_HEADER, ANIM_FRAME_HEADER_BYTES);
+          return true;
+      }
+    }
+  }
+};
@@ -0,0 +1,280 @@
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "GameInput.h"
+#include "LCD_Panel.h"
+#include "Pixel_Grid.h"
+
+// Several games in one firmware image.
+//
+//   Cabinet       the LEDs, LCD and buttons, made once by the sketch and
+//                 shared by every game
+//   Game          what a game implements to run on a Cabinet
+//   GameRegistry  the games linked into the image; each registers itself
+//                 with PIXELGRID_REGISTER_GAME from its own .cpp
+//   Arcade        the game-selection menu, then the chosen game on a fixed
+//                 frame clock, and back to the menu when it has finished
+//
+// The cabinet's input lines are in the bit order of the host input byte
+// (HostRuntime.h): BTN1, BTN2, BTN3, JOY_UP, JOY_DOWN, JOY_LEFT, JOY_RIGHT,
+// BTN4.
+
+static const uint8_t CABINET_LINE_JOY_LEFT = 5;
+static const uint8_t CABINET_LINE_JOY_RIGHT = 6;
+static const uint8_t CABINET_BUTTONS = 0x87; // BTN1..BTN4
+
+// The six LCD digits follow the grid on the strip
+static const uint16_t CABINET_LCD_START = 214;
+static const uint8_t CABINET_LCD_DIGITS = 6;
+
+struct Cabinet {
+  Adafruit_NeoPixel* strip = nullptr;
+  Pixel_Grid* grid = nullptr;
+  LCD_Panel* lcd = nullptr;
+  GameInput* input = nullptr;
+  uint8_t columns = 0;
+  uint8_t rows = 0;
+
+  // Starts the strip and makes the grid (the first columns x rows LEDs)
+  // and the LCD. The sketch has already begun the input with its pins.
+  void begin(Adafruit_NeoPixel& s, GameInput& in, uint8_t gridColumns, uint8_t gridRows) {
+    strip = &s;
+    input = &in;
+    columns = gridColumns;
+    rows = gridRows;
+
+    s.begin();
+    s.show();
+    if (!grid) grid = new Pixel_Grid(&s, 0, rows, columns);
+    if (!lcd) lcd = new LCD_Panel(&s, CABINET_LCD_START, CABINET_LCD_DIGITS, s.Color(255, 255, 255));
+  }
+
+  void show() {
+    lcd->render();
+    grid->render();
+    strip->show();
+  }
+};
+
+// A game on the cabinet. The Arcade calls begin() when the game takes the
+// cabinet over (from the menu, or after host mode), reset() for a new
+// game, then update() and render() once per frameMs() with the input
+// already updated for the frame.
+class Game {
+public:
+  // For logs and hosts; the menu shows games by number
+  virtual const char* name() const = 0;
+  virtual uint16_t frameMs() const = 0;
+
+  // Set up the display (colours, LCD) and input repeats; keeps the game's state
+  virtual void begin(Cabinet& cabinet) = 0;
+  virtual void reset(uint32_t nowMs) = 0;
+  virtual void update(uint32_t nowMs) = 0;
+  virtual void render() = 0;
+  // The player is done (game over, then a button): back to the menu
+  virtual bool finished() const = 0;
+
+  // The game's state as bytes: the length written, or 0 when cap is too
+  // small. A same-build snapshot only; deserialize() takes back what
+  // serialize() wrote in the same firmware, not a stored or host format.
+  virtual uint16_t serialize(uint8_t* out, uint16_t cap) const = 0;
+  virtual bool deserialize(const uint8_t* in, uint16_t len) = 0;
+
+protected:
+  ~Game() {}
+};
+
+// Snapshot helpers for games whose state is one trivially copyable object:
+// a u16 size, then its raw bytes. The bytes carry this build's layout,
+// padding and pointers, so a snapshot is only for the same firmware; the
+// size check refuses most snapshots from another build, not all of them.
+template <typename T>
+uint16_t gameSaveState(const T& state, uint8_t* out, uint16_t cap) {
+  static_assert(std::is_trivially_copyable<T>::value, "game state must be trivially copyable");
+  const uint16_t size = (uint16_t)sizeof(T);
+  if (cap < size + 2) return 0;
+  out[0] = (uint8_t)(size & 0xFF);
+  out[1] = (uint8_t)(size >> 8);
+  memcpy(out + 2, &state, size);
+  return (uint16_t)(size + 2);
+}
+
+template <typename T>
+bool gameLoadState(T& state, const uint8_t* in, uint16_t len) {
+  static_assert(std::is_trivially_copyable<T>::value, "game state must be trivially copyable");
+  const uint16_t size = (uint16_t)sizeof(T);
+  if (len != size + 2 || (uint16_t)(in[0] | (in[1] << 8)) != size) return false;
+  memcpy(&state, in + 2, size);
+  return true;
+}
+
+static const uint8_t ARCADE_MAX_GAMES = 8;
+
+// Filled before setup() by the games' static registrars, in name order so
+// the menu doesn't depend on link order
+struct GameRegistry {
+  static bool add(Game* game) {
+    uint8_t& n = countRef();
+    if (n == ARCADE_MAX_GAMES) return false;
+    Game** games = slots();
+    uint8_t i = n++;
+    while (i > 0 && strcmp(games[i - 1]->name(), game->name()) > 0) {
+      games[i] = games[i - 1];
+      --i;
+    }
+    games[i] = game;
+    return true;
+  }
+
+  static uint8_t count() { return countRef(); }
+  static Game* at(uint8_t i) { return i < countRef() ? slots()[i] : nullptr; }
+
+private:
+  static Game** slots() {
+    static Game* games[ARCADE_MAX_GAMES];
+    return games;
+  }
+  static uint8_t& countRef() {
+    static uint8_t n = 0;
+    return n;
+  }
+};
+
+// At namespace scope in the game's .cpp, after its Game object
+#define PIXELGRID_REGISTER_GAME(game) \
+  static const bool game##Registered_ = GameRegistry::add(&(game))
+
+// Fixed-rate frames: due() is true once per period, on the first pass at
+// or after the frame time, and the next frame time keeps the cadence. A
+// pass a whole period late starts the cadence again from itself instead
+// of running the missed frames back to back.
+struct FrameClock {
+  uint32_t next = 0;
+  bool running = false;
+
+  void restart() { running = false; }
+
+  bool due(uint32_t nowMs, uint16_t periodMs) {
+    if (running && (int32_t)(nowMs - next) < 0) return false;
+    next = running ? next + periodMs : nowMs + periodMs;
+    if ((int32_t)(nowMs - next) >= 0) next = nowMs + periodMs;
+    running = true;
+    return true;
+  }
+};
+
+static const uint16_t ARCADE_MENU_FRAME_MS = 16;
+
+enum ArcadeState : uint8_t { ARCADE_MENU, ARCADE_PLAYING };
+
+class Arcade {
+public:
+  ArcadeState state = ARCADE_MENU;
+  uint8_t selected = 0; // registry index, in the menu and while playing
+
+  void begin(Cabinet& cabinet, uint32_t nowMs) {
+    cabinet_ = &cabinet;
+    selected = 0;
+    enterMenu(nowMs);
+  }
+
+  Game* current() const { return GameRegistry::at(selected); }
+
+  // Call every loop() pass; runs a frame of the menu or the game when one
+  // is due
+  void loop(uint32_t nowMs) {
+    Game* game = current();
+    if (!game) return;
+    uint16_t period = state == ARCADE_PLAYING ? game->frameMs() : ARCADE_MENU_FRAME_MS;
+    if (!clock_.due(nowMs, period)) return;
+
+    GameInput& in = *cabinet_->input;
+    in.update();
+    if (state == ARCADE_MENU) {
+      menuFrame(nowMs);
+    } else {
+      game->update(nowMs);
+      if (game->finished()) {
+        enterMenu(nowMs);
+      } else {
+        game->render();
+      }
+    }
+    in.latch();
+  }
+
+  // Something else had the display (host mode): put ours back
+  void resume(uint32_t nowMs) {
+    Game* game = current();
+    if (!game) return;
+    if (state == ARCADE_MENU) {
+      showMenu(nowMs);
+      return;
+    }
+    game->begin(*cabinet_);
+    game->render();
+    clock_.restart();
+  }
+
+  void start(uint32_t nowMs) {
+    Game* game = current();
+    if (!game) return;
+    state = ARCADE_PLAYING;
+    game->begin(*cabinet_);
+    game->reset(nowMs);
+    game->render();
+    clock_.restart();
+  }
+
+private:
+  Cabinet* cabinet_ = nullptr;
+  FrameClock clock_;
+
+  void enterMenu(uint32_t nowMs) {
+    state = ARCADE_MENU;
+    clock_.restart();
+    showMenu(nowMs);
+  }
+
+  // Joystick left/right picks a game, any button starts it
+  void menuFrame(uint32_t nowMs) {
+    uint8_t n = GameRegistry::count();
+    uint8_t p = cabinet_->input->pressed();
+    if (p & CABINET_BUTTONS) {
+      start(nowMs);
+      return;
+    }
+    int8_t step = 0;
+    if (p & (1u << CABINET_LINE_JOY_LEFT)) step = -1;
+    else if (p & (1u << CABINET_LINE_JOY_RIGHT)) step = 1;
+    if (!step) return;
+    selected = (uint8_t)((selected + n + step) % n);
+    showMenu(nowMs);
+  }
+
+  // The selected game's opening frame as a preview, and its number on the LCD
+  void showMenu(uint32_t nowMs) {
+    Game* game = current();
+    if (!game) return;
+    game->begin(*cabinet_);
+    game->reset(nowMs);
+    game->render();
+
+    const uint32_t white = cabinet_->strip->Color(255, 255, 255);
+    const uint32_t off = cabinet_->strip->Color(0, 0, 0);
+    char digits[CABINET_LCD_DIGITS];
+    memset(digits, ' ', sizeof(digits));
+    digits[CABINET_LCD_DIGITS - 1] = (char)('1' + selected);
+    for (uint8_t d = 0; d < CABINET_LCD_DIGITS; ++d) {
+      cabinet_->lcd->setDigitOnColour(d, white);
+      cabinet_->lcd->setDigitOffColour(d, off);
+    }
+    cabinet_->lcd->changeCharArray(digits);
+    cabinet_->lcd->render();
+    cabinet_->strip->show();
+  }
+};
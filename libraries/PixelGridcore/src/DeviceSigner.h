@@ -0,0 +1,96 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <mbedtls/sha256.h>
+
+// HMAC-SHA256 device signatures (RFC 2104) with the key schedule done once.
+//
+// HMAC(K, m) = H((K ^ opad) || H((K ^ ipad) || m)). Both pad blocks depend
+// only on the key, so DeviceSigner::begin() hashes them once and keeps the
+// two mbedTLS SHA-256 states after that first block. sign() clones them and
+// hashes only the message and the 32-byte inner digest: three compressions
+// for a canonical score message instead of five, and no key handling per
+// record. The emulator and the host tests get the same calls from the
+// portable mbedtls/sha256.h in host/emulator/shim.
+
+static const uint8_t SHA256_BYTES       = 32;
+static const uint8_t SHA256_BLOCK_BYTES = 64;
+
+class DeviceSigner {
+public:
+  DeviceSigner() {
+    mbedtls_sha256_init(&inner_);
+    mbedtls_sha256_init(&outer_);
+  }
+
+  ~DeviceSigner() {
+    mbedtls_sha256_free(&inner_);
+    mbedtls_sha256_free(&outer_);
+  }
+
+  DeviceSigner(const DeviceSigner&) = delete;
+  DeviceSigner& operator=(const DeviceSigner&) = delete;
+
+  // Keys longer than a block are hashed first, as RFC 2104 says.
+  bool begin(const uint8_t* key, size_t len) {
+    ready_ = false;
+    uint8_t k[SHA256_BLOCK_BYTES] = {0};
+    if (len > SHA256_BLOCK_BYTES) {
+      if (mbedtls_sha256(key, len, k, 0) != 0) return false;
+    } else {
+      memcpy(k, key, len);
+    }
+
+    uint8_t ipad[SHA256_BLOCK_BYTES];
+    uint8_t opad[SHA256_BLOCK_BYTES];
+    for (uint8_t i = 0; i < SHA256_BLOCK_BYTES; ++i) {
+      ipad[i] = k[i] ^ 0x36;
+      opad[i] = k[i] ^ 0x5c;
+    }
+    ready_ = mbedtls_sha256_starts(&inner_, 0) == 0 && mbedtls_sha256_update(&inner_, ipad, sizeof(ipad)) == 0 &&
+             mbedtls_sha256_starts(&outer_, 0) == 0 && mbedtls_sha256_update(&outer_, opad, sizeof(opad)) == 0;
+    memset(k, 0, sizeof(k));
+    memset(ipad, 0, sizeof(ipad));
+    memset(opad, 0, sizeof(opad));
+    return ready_;
+  }
+
+  bool begin(const char* secret) { return begin((const uint8_t*)secret, strlen(secret)); }
+
+  bool ready() const { return ready_; }
+
+  bool sign(const uint8_t* msg, size_t len, uint8_t mac[SHA256_BYTES]) const {
+    if (!ready_) return false;
+    uint8_t digest[SHA256_BYTES];
+    mbedtls_sha256_context s;
+    mbedtls_sha256_init(&s);
+    mbedtls_sha256_clone(&s, &inner_);
+    bool ok = mbedtls_sha256_update(&s, msg, len) == 0 && mbedtls_sha256_finish(&s, digest) == 0;
+    mbedtls_sha256_free(&s);
+    if (ok) {
+      mbedtls_sha256_init(&s);
+      mbedtls_sha256_clone(&s, &outer_);
+      ok = mbedtls_sha256_update(&s, digest, sizeof(digest)) == 0 && mbedtls_sha256_finish(&s, mac) == 0;
+      mbedtls_sha256_free(&s);
+    }
+    memset(digest, 0, sizeof(digest));
+    return ok;
+  }
+
+private:
+  mbedtls_sha256_context inner_;  // after (K ^ ipad)
+  mbedtls_sha256_context outer_;  // after (K ^ opad)
+  bool ready_ = false;
+};
+
+// The message a score signature covers. MUST match the score server's
+// canonical_device_message() (server.py); the mock server in
+// host/src/ScoreServer.cpp uses this one. Writes it to out and returns its
+// length, or 0 if it doesn't fit.
+static inline size_t canonicalDeviceMessage(char* out, size_t cap, const char* game_code, int score, int ts,
+                                            const char* nonce) {
+  int n = snprintf(out, cap, "game_code=%s&score=%d&ts=%d&nonce=%s", game_code, score, ts, nonce);
+  return n > 0 && (size_t)n < cap ? (size_t)n : 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+// Compressed GRB frames (host PBDF packets)
+// Payload: [encoding u8] + body. Frames are GRB, 3 bytes per pixel, in the
+// same order as PBFR. Every decoder bounds-checks its input and returns
+// false on malformed data without writing past the frame.
+//
+// FRAME_ENC_RLE       runs of [count 1..255][G][R][B]
+// FRAME_ENC_XOR_DELTA runs of [skip 0..255][lit 0..255] + lit * 3 bytes,
+//                     each literal byte XORed onto the previous frame
+// FRAME_ENC_PALETTE4  [n 1..16] + n * 3 GRB palette + ceil(pixels / 2)
+//                     bytes of 4-bit indices, high nibble first
+
+enum FrameEncoding : uint8_t {
+  FRAME_ENC_RLE       = 1,
+  FRAME_ENC_XOR_DELTA = 2,
+  FRAME_ENC_PALETTE4  = 3
+};
+
+static const uint8_t FRAME_PALETTE_MAX = 16;
+
+static inline bool decodeFrameRle(const uint8_t* in, uint16_t len, uint8_t* frame, uint16_t pixels) {
+  uint16_t px = 0;
+  uint16_t i = 0;
+  while (i + 4 <= len) {
+    uint8_t count = in[i];
+    if (count == 0 || px + count > pixels) return false;
+    uint8_t* out = frame + (uint32_t)px * 3;
+    for (uint8_t k = 0; k < count; ++k) {
+      out[0] = in[i + 1];
+      out[1] = in[i + 2];
+      out[2] = in[i + 3];
+      out += 3;
+    }
+    px = (uint16_t)(px + count);
+    i = (uint16_t)(i + 4);
+  }
+  return i == len && px == pixels;
+}
+
+static inline bool decodeFrameXorDelta(const uint8_t* in, uint16_t len, uint8_t* frame, uint16_t pixels) {
+  uint16_t px = 0;
+  uint16_t i = 0;
+  while (i + 2 <= len) {
+    uint8_t skip = in[i];
+    uint8_t lit = in[i + 1];
+    i = (uint16_t)(i + 2);
+
+    px = (uint16_t)(px + skip);
+    if (px + lit > pixels) return false;
+    uint16_t bytes = (uint16_t)(lit * 3);
+    if (i + bytes > len) return false;
+
+    uint8_t* out = frame + (uint32_t)px * 3;
+    for (uint16_t k = 0; k < bytes; ++k) out[k] ^= in[i + k];
+    px = (uint16_t)(px + lit);
+    i = (uint16_t)(i + bytes);
+  }
+  return i == len && px <= pixels;
+}
+
+static inline bool decodeFramePalette4(const uint8_t* in, uint16_t len, uint8_t* frame, uint16_t pixels) {
+  if (len < 1) return false;
+  uint8_t n = in[0];
+  if (n == 0 || n > FRAME_PALETTE_MAX) return false;
+
+  const uint8_t* palette = in + 1;
+  const uint8_t* idx = palette + n * 3;
+  uint16_t need = (uint16_t)(1 + n * 3 + (pixels + 1) / 2);
+  if (len != need) return false;
+
+  for (uint16_t px = 0; px < pixels; ++px) {
+    uint8_t b = idx[px >> 1];
+    uint8_t c = (px & 1) ? (uint8_t)(b & 0x0F) : (uint8_t)(b >> 4);
+    if (c >= n) return false;
+    memcpy(frame + (uint32_t)px * 3, palette + c * 3, 3);
+  }
+  return true;
+}
+
+// Decode a PBDF payload into frame (pixels * 3 bytes). For XOR deltas frame
+// must already hold the previous frame.
+static inline bool decodeFrame(const uint8_t* payload, uint16_t len, uint8_t* frame, uint16_t pixels) {
+  if (len < 1) return false;
+  const uint8_t* body = payload + 1;
+  uint16_t bodyLen = (uint16_t)(len - 1);
+
+  switch (payload[0]) {
+    case FRAME_ENC_RLE:       return decodeFrameRle(body, bodyLen, frame, pixels);
+    case FRAME_ENC_XOR_DELTA: return decodeFrameXorDelta(body, bodyLen, frame, pixels);
+    case FRAME_ENC_PALETTE4:  return decodeFramePalette4(body, bodyLen, frame, pixels);
+    default:                  return false;
+  }
+}
+
+// True if the encoding needs the previous frame as its reference
+static inline bool frameEncodingIsDelta(uint8_t encoding) {
+  return encoding == FRAME_ENC_XOR_DELTA;
+}
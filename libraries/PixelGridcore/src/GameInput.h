@@ -0,0 +1,173 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "InputCapture.h"
+#include "InputPort.h"
+
+// The buttons and joystick as every game reads them.
+//
+// Up to eight INPUT_PULLUP lines, each a bit: pin changes come in through
+// the capture interrupts (InputCapture.h), are debounced as one mask
+// (InputDebouncer, InputPort.h) and show up here as held/pressed/released
+// masks. held() is the state this pass, prevHeld() the state at the last
+// latch(); call latch() once per loop after the edges have been used.
+//
+// Each change is dated to the first edge of its bounce burst (changedUs(),
+// changedMs()), and the changes of a pass are queued oldest first
+// (popEvent()) with the held mask after each, which is what host mode
+// reports.
+//
+// repeat() is the DAS/ARR rule for held directions, set per line with
+// setRepeat(): one step on the press, one after dasMs, then one every
+// arrMs, counted from the press time rather than the pass that saw it. It
+// returns every step that fell due since the last call, so the repeat rate
+// isn't capped by the loop rate. With an arrMs of 0 it returns
+// INPUT_REPEAT_ALL (as far as the game allows) once DAS is up.
+
+// repeat() with an ARR of 0: move as far as possible
+static const uint8_t INPUT_REPEAT_ALL = 0xFF;
+
+struct InputEvent {
+  uint32_t us;   // micros() of the change
+  uint8_t held;  // every line's state after it
+};
+
+class GameInput {
+public:
+  // Line i is pins[i]. Attaches the interrupts; call once.
+  void begin(const uint8_t* pins, uint8_t count, uint16_t debounceMs) {
+    capture_.begin(pins, count);
+    uint32_t nowUs = micros();
+    uint32_t now = millis();
+    held_ = prevHeld_ = 0;
+    debounce_.begin(0, nowUs, debounceMs * 1000UL);
+    // A line held at boot produces no interrupt; take its level now
+    debounce_.edge(capture_.levels(), nowUs);
+    for (uint8_t i = 0; i < INPUT_PORT_MAX_LINES; ++i) changedMs_[i] = now;
+    eventCount_ = eventHead_ = 0;
+    resetRepeat(now);
+  }
+
+  // DAS then ARR for a held line; dasMs 0 steps on the press only, arrMs 0
+  // repeats without limit once DAS is up
+  void setRepeat(uint8_t line, uint16_t dasMs, uint16_t arrMs) {
+    dasMs_[line] = dasMs;
+    arrMs_[line] = arrMs;
+  }
+
+  void update() { update(millis(), micros()); }
+
+  // Applies the edges captured since the last call, then debounces
+  void update(uint32_t nowMs, uint32_t nowUs) {
+    InputEdge e;
+    while (capture_.pop(e)) debounce_.edge(e.levels, e.us);
+    if (capture_.takeDropped()) debounce_.edge(capture_.levels(), nowUs);
+
+    uint8_t moved = debounce_.settle(nowUs) ^ held_;
+    if (!moved) return;
+    for (uint8_t i = 0, m = moved; m; ++i, m >>= 1) {
+      if (m & 1) changedMs_[i] = nowMs - (nowUs - debounce_.changedUs(i)) / 1000;
+    }
+    queueEvents(moved);
+    held_ ^= moved;
+  }
+
+  // A pin edge as if the capture interrupt had seen it, for replays and tests
+  void edge(uint8_t levels, uint32_t us) { debounce_.edge(levels, us); }
+
+  void latch() {
+    prevHeld_ = held_;
+    eventCount_ = eventHead_ = 0;
+  }
+
+  uint8_t held() const     { return held_; }
+  uint8_t prevHeld() const { return prevHeld_; }
+  uint8_t pressed() const  { return held_ & ~prevHeld_; }
+  uint8_t released() const { return prevHeld_ & ~held_; }
+  uint8_t changed() const  { return held_ ^ prevHeld_; }
+
+  uint32_t changedUs(uint8_t line) const { return debounce_.changedUs(line); }
+  uint32_t changedMs(uint8_t line) const { return changedMs_[line]; }
+
+  // This pass's changes, oldest first
+  bool popEvent(InputEvent& e) {
+    if (eventHead_ == eventCount_) return false;
+    e = events_[eventHead_++];
+    return true;
+  }
+
+  // Steps the held line owes this pass: 0, a count, or INPUT_REPEAT_ALL
+  uint8_t repeat(uint8_t line, uint32_t now) {
+    uint8_t bit = (uint8_t)(1u << line);
+    if (!(held_ & bit)) {
+      if (released() & bit) repeating_ &= (uint8_t)~bit;
+      return 0;
+    }
+
+    uint32_t steps = 0;
+    uint32_t& t = repeatT_[line];
+    if (pressed() & bit) {
+      t = changedMs_[line];
+      repeating_ &= (uint8_t)~bit;
+      steps = 1;
+    }
+    if (!dasMs_[line]) return (uint8_t)steps;
+    if (!(repeating_ & bit)) {
+      if (now - t < dasMs_[line]) return (uint8_t)steps;
+      t += dasMs_[line];
+      repeating_ |= bit;
+      steps++;
+    }
+
+    uint16_t arrMs = arrMs_[line];
+    if (!arrMs) {
+      t = now;
+      return INPUT_REPEAT_ALL;
+    }
+    uint32_t due = (now - t) / arrMs;
+    t += due * arrMs;
+    steps += due;
+    return steps < INPUT_REPEAT_ALL ? (uint8_t)steps : (uint8_t)(INPUT_REPEAT_ALL - 1);
+  }
+
+  void resetRepeat(uint32_t now) {
+    for (uint8_t i = 0; i < INPUT_PORT_MAX_LINES; ++i) repeatT_[i] = now;
+    repeating_ = 0;
+  }
+
+  InputCapture& capture() { return capture_; }
+  const InputDebouncer& debouncer() const { return debounce_; }
+
+private:
+  void queueEvents(uint8_t moved) {
+    uint8_t bits = held_;
+    while (moved && eventCount_ < INPUT_PORT_MAX_LINES) {
+      uint8_t first = 0xFF;
+      for (uint8_t i = 0; i < INPUT_PORT_MAX_LINES; ++i) {
+        if (!(moved & (1u << i))) continue;
+        if (first == 0xFF || (int32_t)(changedUs(i) - changedUs(first)) < 0) first = i;
+      }
+      bits ^= (uint8_t)(1u << first);
+      moved &= (uint8_t)~(1u << first);
+      events_[eventCount_].us = changedUs(first);
+      events_[eventCount_].held = bits;
+      ++eventCount_;
+    }
+  }
+
+  InputCapture capture_;
+  InputDebouncer debounce_;
+  uint8_t held_ = 0;
+  uint8_t prevHeld_ = 0;
+  uint32_t changedMs_[INPUT_PORT_MAX_LINES] = {};
+
+  InputEvent events_[INPUT_PORT_MAX_LINES];
+  uint8_t eventCount_ = 0;
+  uint8_t eventHead_ = 0;
+
+  uint16_t dasMs_[INPUT_PORT_MAX_LINES] = {};
+  uint16_t arrMs_[INPUT_PORT_MAX_LINES] = {};
+  uint32_t repeatT_[INPUT_PORT_MAX_LINES] = {};
+  uint8_t repeating_ = 0;
+};
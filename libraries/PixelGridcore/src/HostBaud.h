@@ -0,0 +1,100 @@
+#pragma once
+#include <stdint.h>
+
+#include "HostProtocol.h"
+
+// Host link baud negotiation
+//   host   -> PBBR  u32 baud                  (at the current rate)
+//   device -> PBBA  u32 baud + u8 status      (at the current rate), then switches
+//   host switches and sends PBBC              (at the new rate)
+//   device -> PBBA  baud + HOST_BAUD_CONFIRMED
+// If the PBBC doesn't arrive within HOST_BAUD_CONFIRM_MS the device goes back
+// to the rate it had; a host that gets no confirmation does the same. A link
+// left idle at a non-default rate drops back to HOST_DEFAULT_BAUD so a newly
+// started host can always connect at the default.
+//
+// A PBBC sent without a pending switch is answered with the current rate, so
+// hosts can use it to probe the link.
+
+static const uint32_t HOST_DEFAULT_BAUD    = 115200;
+static const uint32_t HOST_BAUD_CONFIRM_MS = 500;
+static const uint32_t HOST_BAUD_IDLE_MS    = 5000;
+
+static const uint16_t HOST_BAUD_REQ_BYTES = 4;
+static const uint16_t HOST_BAUD_ACK_BYTES = 5;
+
+enum HostBaudStatus : uint8_t {
+  HOST_BAUD_SWITCHING = 0, // switch now, then send PBBC
+  HOST_BAUD_CONFIRMED = 1, // link is running at this rate
+  HOST_BAUD_REJECTED  = 2  // rate not supported, link unchanged
+};
+
+static const uint32_t HOST_BAUD_RATES[] = { 115200, 230400, 460800, 921600, 1500000, 2000000 };
+
+static inline bool hostBaudSupported(uint32_t baud) {
+  for (uint32_t r : HOST_BAUD_RATES) {
+    if (r == baud) return true;
+  }
+  return false;
+}
+
+static inline void hostBaudAckPayload(uint32_t baud, uint8_t status, uint8_t out[HOST_BAUD_ACK_BYTES]) {
+  hostWriteU32(out, baud);
+  out[4] = status;
+}
+
+// Device side of the handshake. The caller owns the port: it sends the ack
+// each call fills in, then applies any rate returned.
+struct HostBaudSwitch {
+  uint32_t current = HOST_DEFAULT_BAUD;
+  uint32_t fallback = HOST_DEFAULT_BAUD;
+  bool confirming = false;
+  uint32_t switchedMs = 0;
+  uint32_t lastRxMs = 0;
+
+  void reset(uint32_t nowMs) {
+    current = fallback = HOST_DEFAULT_BAUD;
+    confirming = false;
+    lastRxMs = nowMs;
+  }
+
+  // Any packet received keeps a non-default rate alive
+  void noteActivity(uint32_t nowMs) { lastRxMs = nowMs; }
+
+  // PBBR. Returns the rate to switch to once the ack has gone out, or 0.
+  uint32_t request(uint32_t baud, uint32_t nowMs, uint8_t ack[HOST_BAUD_ACK_BYTES]) {
+    if (!hostBaudSupported(baud)) {
+      hostBaudAckPayload(current, HOST_BAUD_REJECTED, ack);
+      return 0;
+    }
+    hostBaudAckPayload(baud, HOST_BAUD_SWITCHING, ack);
+    // The request got through, so the current rate is known to work
+    fallback = current;
+    current = baud;
+    confirming = true;
+    switchedMs = nowMs;
+    return baud;
+  }
+
+  // PBBC
+  void confirm(uint8_t ack[HOST_BAUD_ACK_BYTES]) {
+    confirming = false;
+    hostBaudAckPayload(current, HOST_BAUD_CONFIRMED, ack);
+  }
+
+  // Returns the rate to fall back to, or 0 to stay
+  uint32_t poll(uint32_t nowMs) {
+    if (confirming) {
+      if (nowMs - switchedMs < HOST_BAUD_CONFIRM_MS) return 0;
+      confirming = false;
+      lastRxMs = nowMs;
+      current = fallback;
+      return current;
+    }
+    if (current != HOST_DEFAULT_BAUD && nowMs - lastRxMs >= HOST_BAUD_IDLE_MS) {
+      current = fallback = HOST_DEFAULT_BAUD;
+      return current;
+    }
+    return 0;
+  }
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <stdint.h>
+
+#include "HostProtocol.h"
+
+// Input reports and latency probes
+//   host   -> PBIM  u8 mode: 0 = 'b' <bits> bytes (default), 1 = PBIN reports
+//   device -> PBIN  u32 nowUs, u8 bits, u8 count, u8 lost, count x (u32 us, u8 bits)
+//   host   -> PBPI  u32 token
+//   device -> PBPO  u32 token + u32 device micros() when the PBPI was parsed
+//
+// Every change of the packed input byte is queued with the micros() it was
+// seen at, and PBIN carries all of them, so edges closer together than the
+// report spacing are neither merged nor lost. nowUs is the device time the
+// report was sent; `lost` counts edges dropped because the queue was full.
+// Timestamps are the device's micros() and wrap every ~71 minutes; hosts map
+// them onto their own clock using PBPI/PBPO round trips.
+//
+// None of these switch the device into host mode. A host mode timeout puts
+// the device back to 'b' bytes.
+
+static const uint8_t HOST_INPUT_MODE_BYTES   = 0;
+static const uint8_t HOST_INPUT_MODE_REPORTS = 1;
+
+static const uint8_t  HOST_INPUT_MAX_EVENTS   = 16;
+static const uint16_t HOST_INPUT_HEADER_BYTES = 7;
+static const uint16_t HOST_INPUT_EVENT_BYTES  = 5;
+static const uint16_t HOST_INPUT_REPORT_MAX_BYTES =
+    HOST_INPUT_HEADER_BYTES + HOST_INPUT_MAX_EVENTS * HOST_INPUT_EVENT_BYTES;
+// Reports are at least this far apart; the first edge after a quiet spell
+// goes out at once.
+static const uint32_t HOST_INPUT_REPORT_MIN_US = 4000;
+
+static const uint16_t HOST_PING_BYTES = 4;
+static const uint16_t HOST_PONG_BYTES = 8;
+
+static inline void hostPongPayload(const uint8_t ping[HOST_PING_BYTES], uint32_t nowUs, uint8_t out[HOST_PONG_BYTES]) {
+  memcpy(out, ping, HOST_PING_BYTES);
+  hostWriteU32(out + 4, nowUs);
+}
+
+struct HostInputEvent {
+  uint32_t us;
+  uint8_t bits;
+};
+
+// Device side: queues edges and builds PBIN payloads. Call note() with the
+// packed input byte every loop, then send take() whenever due() says so.
+struct HostInputQueue {
+  HostInputEvent events[HOST_INPUT_MAX_EVENTS];
+  uint8_t head = 0;
+  uint8_t count = 0;
+  uint8_t bits = 0;
+  uint8_t lost = 0;
+  bool primed = false;   // bits holds a sampled state
+  bool snapshot = false; // send the current state even without edges
+  uint32_t lastReportUs = 0;
+
+  // Forgets queued edges; the next note() is reported as the starting state
+  void reset() {
+    head = count = lost = 0;
+    primed = false;
+    snapshot = false;
+  }
+
+  void note(uint8_t b, uint32_t nowUs) {
+    if (!primed) {
+      bits = b;
+      primed = true;
+      snapshot = true;
+      lastReportUs = nowUs - HOST_INPUT_REPORT_MIN_US;
+      return;
+    }
+    if (b == bits) return;
+    bits = b;
+    if (count == HOST_INPUT_MAX_EVENTS) {
+      // Keep the newest edges; each carries the full state
+      head = (uint8_t)((head + 1) % HOST_INPUT_MAX_EVENTS);
+      count--;
+      if (lost < 255) lost++;
+    }
+    events[(head + count) % HOST_INPUT_MAX_EVENTS] = { nowUs, b };
+    count++;
+  }
+
+  bool due(uint32_t nowUs) const {
+    return (count > 0 || snapshot) && (nowUs - lastReportUs >= HOST_INPUT_REPORT_MIN_US);
+  }
+
+  // Fills a PBIN payload (HOST_INPUT_REPORT_MAX_BYTES at most), empties the queue
+  uint16_t take(uint32_t nowUs, uint8_t* out) {
+    hostWriteU32(out, nowUs);
+    out[4] = bits;
+    out[5] = count;
+    out[6] = lost;
+    uint8_t* p = out + HOST_INPUT_HEADER_BYTES;
+    for (uint8_t i = 0; i < count; ++i) {
+      const HostInputEvent& e = events[(head + i) % HOST_INPUT_MAX_EVENTS];
+      hostWriteU32(p, e.us);
+      p[4] = e.bits;
+      p += HOST_INPUT_EVENT_BYTES;
+    }
+    uint16_t len = (uint16_t)(p - out);
+    head = count = lost = 0;
+    snapshot = false;
+    lastReportUs = nowUs;
+    return len;
+  }
+};
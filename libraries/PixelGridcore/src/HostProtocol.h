@@ -0,0 +1,460 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Host serial protocol
+// Every packet is 'P' 'B' <t0> <t1> + uint16_t length (little-endian) + payload.
+//
+// Packets may instead be sent framed, for links where corruption has to be
+// detected:
+//   0x00 + COBS( seq, t0, t1, len lo, len hi, payload, crc lo, crc hi ) + 0x00
+// crc is CRC-16/CCITT-FALSE over seq..payload, and seq counts up by one per
+// framed packet. COBS output never contains 0x00, so a zero always marks a
+// frame boundary. Plain and framed packets may be mixed on one stream.
+//
+// HostParser is a byte-driven state machine over a small ring buffer. poll()
+// moves whatever the stream reports as available into the ring and parses as
+// far as those bytes go; it never waits for the rest of a packet, so a slow or
+// stalled host cannot hold up input sampling or rendering.
+
+static constexpr uint16_t hostPacketType(char t0, char t1) {
+  return (uint16_t)(((uint16_t)(uint8_t)t0 << 8) | (uint8_t)t1);
+}
+
+static const uint16_t HOST_PKT_FRAME    = hostPacketType('F', 'R'); // PBFR: GRB LED frame
+static const uint16_t HOST_PKT_LCD_TEXT = hostPacketType('L', 'C'); // PBLC: LCD text
+static const uint16_t HOST_PKT_HUD_7SEG = hostPacketType('7', 'S'); // PB7S: HUD masks + score
+// PBFS: GRB frame the host already laid out in strip (serpentine wire) order.
+// The device may stream it straight into the LED driver buffer.
+static const uint16_t HOST_PKT_FRAME_STRIP = hostPacketType('F', 'S');
+// PBDF: compressed frame (RLE / XOR delta / 4-bit palette, see FrameCodec.h)
+static const uint16_t HOST_PKT_FRAME_DELTA = hostPacketType('D', 'F');
+// PBSQ (host -> device, empty or a u32 token): request link statistics
+// PBST (device -> host): HostLinkStats as six little-endian uint32_t, then
+//                        the PBSQ's token if it had one
+static const uint16_t HOST_PKT_STATUS_REQ = hostPacketType('S', 'Q');
+static const uint16_t HOST_PKT_STATUS     = hostPacketType('S', 'T');
+// Baud negotiation, see HostBaud.h
+static const uint16_t HOST_PKT_BAUD_REQ     = hostPacketType('B', 'R'); // PBBR: host asks for a rate
+static const uint16_t HOST_PKT_BAUD_ACK     = hostPacketType('B', 'A'); // PBBA: device answers
+static const uint16_t HOST_PKT_BAUD_CONFIRM = hostPacketType('B', 'C'); // PBBC: host, at the new rate
+// Input reports and latency probes, see HostInput.h
+static const uint16_t HOST_PKT_INPUT_MODE = hostPacketType('I', 'M'); // PBIM: host picks the report format
+static const uint16_t HOST_PKT_INPUT      = hostPacketType('I', 'N'); // PBIN: timestamped input edges
+static const uint16_t HOST_PKT_PING       = hostPacketType('P', 'I'); // PBPI: host probe
+static const uint16_t HOST_PKT_PONG       = hostPacketType('P', 'O'); // PBPO: device answer
+// Streamed animation clips, see Animation.h
+static const uint16_t HOST_PKT_ANIM_START = hostPacketType('A', 'S'); // PBAS: host starts a clip
+static const uint16_t HOST_PKT_ANIM_DATA  = hostPacketType('A', 'D'); // PBAD: clip bytes
+static const uint16_t HOST_PKT_ANIM_ACK   = hostPacketType('A', 'K'); // PBAK: device progress
+
+static const uint16_t HOST_FRAME_BYTES  = 256 * 3;
+static const uint16_t HOST_RING_SIZE    = 256; // must be a power of two
+static const uint16_t HOST_SCRATCH_SIZE = 64;  // payloads without a direct target
+static const uint16_t HOST_HEADER_BYTES = 6;   // 'P' 'B' t0 t1 len lo len hi
+static const uint16_t HOST_STATUS_BYTES = 6 * 4;
+static const uint16_t HOST_STATUS_TOKEN_BYTES = 4;
+
+// Framed packets older than the last accepted one are dropped, unless this
+// many arrive in a row: then the host has restarted its counter.
+static const uint8_t HOST_SEQ_RESYNC_AFTER = 3;
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+static inline uint16_t hostCrc16Update(uint16_t crc, uint8_t b) {
+  crc ^= (uint16_t)((uint16_t)b << 8);
+  for (uint8_t i = 0; i < 8; ++i) {
+    crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+static inline uint16_t hostCrc16(const uint8_t* data, size_t n, uint16_t crc = 0xFFFF) {
+  for (size_t i = 0; i < n; ++i) crc = hostCrc16Update(crc, data[i]);
+  return crc;
+}
+
+// COBS-encode n bytes into out, which needs room for n + n / 254 + 1 bytes.
+// Returns the encoded length; the 0x00 delimiters are not written.
+static inline size_t hostCobsEncode(const uint8_t* in, size_t n, uint8_t* out) {
+  size_t codeAt = 0;
+  size_t o = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < n; ++i) {
+    if (in[i] != 0) {
+      out[o++] = in[i];
+      if (++code != 0xFF) continue;
+    }
+    out[codeAt] = code;
+    codeAt = o++;
+    code = 1;
+  }
+  out[codeAt] = code;
+  return o;
+}
+
+// Plain packet header: 'P' 'B' t0 t1 len lo len hi
+static inline void hostPacketHeader(uint8_t out[HOST_HEADER_BYTES], uint16_t type, uint16_t len) {
+  out[0] = 'P';
+  out[1] = 'B';
+  out[2] = (uint8_t)(type >> 8);
+  out[3] = (uint8_t)(type & 0xFF);
+  out[4] = (uint8_t)(len & 0xFF);
+  out[5] = (uint8_t)(len >> 8);
+}
+
+struct HostLinkStats {
+  uint32_t packets = 0;     // accepted, plain and framed
+  uint32_t framed = 0;      // accepted framed packets
+  uint32_t corrupt = 0;     // framed packets failing the COBS/length/CRC checks
+  uint32_t dropped = 0;     // framed packets missing from the sequence
+  uint32_t outOfOrder = 0;  // framed packets older than the last accepted one
+  uint32_t resyncBytes = 0; // bytes skipped looking for a packet start
+};
+
+static inline uint32_t hostReadU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void hostWriteU32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+// PBST payload, in HostLinkStats field order
+static inline void hostStatsPayload(const HostLinkStats& s, uint8_t out[HOST_STATUS_BYTES]) {
+  const uint32_t v[6] = { s.packets, s.framed, s.corrupt, s.dropped, s.outOfOrder, s.resyncBytes };
+  for (uint8_t i = 0; i < 6; ++i) hostWriteU32(out + i * 4, v[i]);
+}
+
+struct HostParserCallbacks {
+  void* ctx = nullptr;
+
+  // Asked once per plain packet, as soon as the header is complete. Return a
+  // buffer (and its capacity in cap) to stream the payload straight into, or
+  // nullptr to collect it in the parser's scratch buffer instead. Framed
+  // packets are always collected in the parser: their payload can't be used
+  // until the CRC at the end has been checked.
+  uint8_t* (*payloadTarget)(void* ctx, uint16_t type, uint16_t len, uint16_t& cap) = nullptr;
+
+  // Called once the whole payload has arrived. len is the number of bytes
+  // stored; anything beyond the buffer capacity was discarded.
+  void (*onPacket)(void* ctx, uint16_t type, const uint8_t* payload, uint16_t len) = nullptr;
+};
+
+struct HostParser {
+  enum State : uint8_t {
+    WAIT_P, WAIT_B, TYPE_0, TYPE_1, LEN_LO, LEN_HI, PAYLOAD,
+    FRAMED_CODE, FRAMED_DATA, FRAMED_SKIP
+  };
+
+  HostParserCallbacks cb;
+  HostLinkStats stats;
+
+  uint8_t ring[HOST_RING_SIZE];
+  uint16_t head = 0; // next write
+  uint16_t tail = 0; // next read
+
+  State state = WAIT_P;
+  uint16_t type = 0;
+  uint16_t len = 0;
+  uint16_t got = 0;
+
+  uint8_t* dst = nullptr;
+  uint16_t dstCap = 0;
+  bool dstDirect = false;
+  uint8_t scratch[HOST_SCRATCH_SIZE];
+
+  // Framed packet being decoded
+  uint8_t cobsLeft = 0;        // data bytes left in the current COBS block
+  bool cobsZeroNext = false;   // the block ends in an implicit 0x00
+  uint16_t fPos = 0;           // decoded bytes so far
+  uint8_t fSeq = 0;
+  uint16_t fCrc = 0xFFFF;
+  uint16_t fCrcRx = 0;
+  uint8_t framed[HOST_FRAME_BYTES];
+
+  bool haveSeq = false;
+  uint8_t nextSeq = 0;
+  uint8_t staleRun = 0;
+  bool lastFramed = false;  // the last accepted packet was framed
+  bool zeroIsData = false;  // plain resync: a 0x00 is not a frame start
+
+  void begin(const HostParserCallbacks& callbacks) {
+    cb = callbacks;
+    reset();
+  }
+
+  void reset() {
+    head = tail = 0;
+    state = WAIT_P;
+    type = len = got = 0;
+    dst = nullptr;
+    dstCap = 0;
+    dstDirect = false;
+    haveSeq = false;
+    staleRun = 0;
+    lastFramed = false;
+    zeroIsData = false;
+  }
+
+  uint16_t ringUsed() const { return (uint16_t)((head - tail) & (HOST_RING_SIZE - 1)); }
+  uint16_t ringFree() const { return (uint16_t)(HOST_RING_SIZE - 1 - ringUsed()); }
+
+  // Append raw bytes to the ring. Returns how many were accepted.
+  uint16_t push(const uint8_t* data, uint16_t n) {
+    uint16_t room = ringFree();
+    if (n > room) n = room;
+    for (uint16_t i = 0; i < n; ++i) {
+      ring[head] = data[i];
+      head = (uint16_t)((head + 1) & (HOST_RING_SIZE - 1));
+    }
+    return n;
+  }
+
+  // Drain what the stream already has buffered into the ring, then parse it.
+  // Works with anything exposing available()/readBytes() (HardwareSerial,
+  // USB CDC, host test fakes). Returns the number of packets dispatched.
+  template <typename StreamT>
+  uint16_t poll(StreamT& s) {
+    uint16_t dispatched = 0;
+
+    // Bytes held back after a direct-target packet go first
+    if (process(dispatched)) return dispatched;
+
+    int avail = s.available();
+    while (avail > 0) {
+      if (head == tail) head = tail = 0; // empty: restart at 0 for the longest span
+      uint16_t span = contiguousFree();
+      if (span == 0) break;
+      if ((int)span > avail) span = (uint16_t)avail;
+
+      size_t n = s.readBytes(reinterpret_cast<char*>(&ring[head]), span);
+      if (n == 0) break;
+      head = (uint16_t)((head + n) & (HOST_RING_SIZE - 1));
+      avail -= (int)n;
+
+      if (process(dispatched)) break;
+    }
+    return dispatched;
+  }
+
+  // Parse buffered bytes. Pauses right after a packet that was streamed into
+  // a direct target, or a framed packet, so the caller can use that buffer
+  // before the next packet starts overwriting it; returns true in that case.
+  bool process(uint16_t& dispatched) {
+    while (tail != head) {
+      if (state == PAYLOAD) {
+        // Bulk-copy the contiguous run of payload bytes
+        uint16_t run = (head > tail) ? (uint16_t)(head - tail) : (uint16_t)(HOST_RING_SIZE - tail);
+        uint16_t need = (uint16_t)(len - got);
+        if (run > need) run = need;
+
+        if (got < dstCap) {
+          uint16_t keep = (uint16_t)(dstCap - got);
+          if (keep > run) keep = run;
+          memcpy(dst + got, &ring[tail], keep);
+        }
+        got = (uint16_t)(got + run);
+        tail = (uint16_t)((tail + run) & (HOST_RING_SIZE - 1));
+
+        if (got == len && finishPacket(dispatched)) return true;
+        continue;
+      }
+
+      uint8_t b = ring[tail];
+      tail = (uint16_t)((tail + 1) & (HOST_RING_SIZE - 1));
+      if (step(b, dispatched)) return true;
+    }
+    return false;
+  }
+
+  uint16_t contiguousFree() const {
+    if (head >= tail) return (uint16_t)(HOST_RING_SIZE - head - (tail == 0 ? 1 : 0));
+    return (uint16_t)(tail - head - 1);
+  }
+
+  // Feed one header byte. Returns true if a direct-target or framed packet
+  // completed.
+  bool step(uint8_t b, uint16_t& dispatched) {
+    switch (state) {
+      case WAIT_P:
+        if (b == 'P') { state = WAIT_B; zeroIsData = false; }
+        else if (b == 0x00 && !zeroIsData) beginFramed();
+        else stats.resyncBytes++;
+        break;
+      case WAIT_B:
+        if (b == 'B') state = TYPE_0;
+        else if (b == 0x00 && !zeroIsData) { stats.resyncBytes++; beginFramed(); }
+        else if (b != 'P') { state = WAIT_P; stats.resyncBytes += 2; }
+        else stats.resyncBytes++;
+        break;
+      case TYPE_0:
+        type = (uint16_t)((uint16_t)b << 8);
+        state = TYPE_1;
+        break;
+      case TYPE_1:
+        type = (uint16_t)(type | b);
+        state = LEN_LO;
+        break;
+      case LEN_LO:
+        len = b;
+        state = LEN_HI;
+        break;
+      case LEN_HI:
+        len = (uint16_t)(len | ((uint16_t)b << 8));
+        beginPayload();
+        if (len == 0) return finishPacket(dispatched);
+        break;
+      case PAYLOAD:
+        break;
+      case FRAMED_CODE:
+      case FRAMED_DATA:
+        return stepFramed(b, dispatched);
+      case FRAMED_SKIP:
+        if (b == 0x00) beginFramed();
+        else stats.resyncBytes++;
+        break;
+    }
+    return false;
+  }
+
+  void beginPayload() {
+    got = 0;
+    dstCap = 0;
+    dst = nullptr;
+    if (cb.payloadTarget) dst = cb.payloadTarget(cb.ctx, type, len, dstCap);
+    dstDirect = (dst != nullptr);
+    if (!dst) {
+      dst = scratch;
+      dstCap = sizeof(scratch);
+    }
+    state = PAYLOAD;
+  }
+
+  bool finishPacket(uint16_t& dispatched) {
+    uint16_t stored = (len < dstCap) ? len : dstCap;
+    lastFramed = false;
+    stats.packets++;
+    dispatched++;
+    state = WAIT_P;
+    if (cb.onPacket) cb.onPacket(cb.ctx, type, dst, stored);
+    return dstDirect;
+  }
+
+  // ---- Framed packets ----
+
+  void beginFramed() {
+    state = FRAMED_CODE;
+    cobsLeft = 0;
+    cobsZeroNext = false;
+    fPos = 0;
+    fCrc = 0xFFFF;
+    fCrcRx = 0;
+  }
+
+  // A framed packet that failed its checks. On a framed stream the next 0x00
+  // starts the next packet (atZero: this one already does). Otherwise it was
+  // most likely a stray zero on a plain stream, and the zero length bytes in
+  // plain headers would keep opening bogus frames, so look for a 'P' instead.
+  void rejectFramed(bool atZero) {
+    stats.corrupt++;
+    if (!lastFramed) {
+      state = WAIT_P;
+      zeroIsData = true;
+    } else if (atZero) {
+      beginFramed();
+    } else {
+      state = FRAMED_SKIP;
+    }
+  }
+
+  bool stepFramed(uint8_t b, uint16_t& dispatched) {
+    if (b == 0x00) {
+      // Back-to-back zeros are idle delimiters
+      if (fPos == 0 && cobsLeft == 0 && !cobsZeroNext) return false;
+      return endFramed(dispatched);
+    }
+
+    if (state == FRAMED_CODE) {
+      if (cobsZeroNext && !framedByte(0)) return false;
+      cobsLeft = (uint8_t)(b - 1);
+      cobsZeroNext = (b != 0xFF);
+      if (cobsLeft > 0) state = FRAMED_DATA;
+      return false;
+    }
+
+    if (!framedByte(b)) return false;
+    if (--cobsLeft == 0) state = FRAMED_CODE;
+    return false;
+  }
+
+  // One decoded byte of: seq, t0, t1, len lo, len hi, payload..., crc lo, crc hi
+  bool framedByte(uint8_t b) {
+    uint16_t pos = fPos++;
+    if (pos < 5) {
+      fCrc = hostCrc16Update(fCrc, b);
+      switch (pos) {
+        case 0: fSeq = b; break;
+        case 1: type = (uint16_t)((uint16_t)b << 8); break;
+        case 2: type = (uint16_t)(type | b); break;
+        case 3: len = b; break;
+        case 4:
+          len = (uint16_t)(len | ((uint16_t)b << 8));
+          if (len > sizeof(framed)) { rejectFramed(false); return false; }
+          break;
+      }
+      return true;
+    }
+
+    uint16_t p = (uint16_t)(pos - 5);
+    if (p < len) {
+      fCrc = hostCrc16Update(fCrc, b);
+      framed[p] = b;
+    } else if (p == len) {
+      fCrcRx = b;
+    } else if (p == len + 1) {
+      fCrcRx = (uint16_t)(fCrcRx | ((uint16_t)b << 8));
+    } else {
+      rejectFramed(false); // more bytes than the header promised
+      return false;
+    }
+    return true;
+  }
+
+  // Closing 0x00 of a framed packet. The final COBS block's implicit zero is
+  // the delimiter itself, so it is not decoded.
+  bool endFramed(uint16_t& dispatched) {
+    bool complete = state == FRAMED_CODE && fPos >= 5 && fPos == (uint16_t)(len + 7);
+    if (!complete || fCrc != fCrcRx) {
+      rejectFramed(true);
+      return false;
+    }
+    state = WAIT_P;
+
+    if (haveSeq && fSeq != nextSeq) {
+      uint8_t ahead = (uint8_t)(fSeq - nextSeq);
+      if (ahead >= 128) {
+        // Behind what we already accepted: a late or duplicated packet
+        if (++staleRun < HOST_SEQ_RESYNC_AFTER) {
+          stats.outOfOrder++;
+          return false;
+        }
+      } else {
+        stats.dropped += ahead;
+      }
+    }
+    haveSeq = true;
+    nextSeq = (uint8_t)(fSeq + 1);
+    staleRun = 0;
+
+    lastFramed = true;
+    stats.packets++;
+    stats.framed++;
+    dispatched++;
+    if (cb.onPacket) cb.onPacket(cb.ctx, type, framed, len);
+    return true;
+  }
+};
@@ -0,0 +1,526 @@
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Animation.h"
+#include "FrameCodec.h"
+#include "GameInput.h"
+#include "HostBaud.h"
+#include "HostInput.h"
+#include "HostProtocol.h"
+#include "LCD_Panel.h"
+#include "Pixel_Grid.h"
+
+// Host mode for any game on the cabinet: a PC drives the LEDs and the LCD
+// over Serial (HostProtocol.h) and gets the buttons back, and the game runs
+// whenever no host is talking to it.
+//
+// The sketch owns one HostRuntime, calls begin() once its strip, grid and
+// LCD exist, and step() at the top of every loop() pass, before its own
+// frame timing:
+//
+//   HOST_STEP_GAME       no host: run the game this pass
+//   HOST_STEP_HOST       the host owns the display; step() has already read
+//                        the input, reported it and redrawn, so the sketch
+//                        skips its game
+//   HOST_STEP_TIMED_OUT  no host activity for HOST_TIMEOUT_MS: the runtime
+//                        is back to its defaults, and the sketch puts its own
+//                        display back before running the game again
+//
+// step() only parses what Serial already holds, so with no host attached it
+// costs one Serial.available(). The LEDs are pushed only when a packet
+// changed something; show() is the most expensive call in the loop.
+//
+// The game's input lines must be in the bit order of the host input byte
+// (BTN1, BTN2, BTN3, JOY_UP, JOY_DOWN, JOY_LEFT, JOY_RIGHT, BTN4), so the
+// debounced mask is the byte that is sent.
+
+static const uint32_t HOST_TIMEOUT_MS = 2500;
+
+// Legacy 'b' bytes carry only the current state, so changes within
+// HOST_SEND_MIN_MS of the last one wait (and may merge).
+static const uint32_t HOST_SEND_MIN_MS = 15; // throttle to avoid flooding
+
+enum RuntimeMode : uint8_t { MODE_STANDALONE = 0, MODE_HOST = 1 };
+
+enum HostStep : uint8_t { HOST_STEP_GAME, HOST_STEP_HOST, HOST_STEP_TIMED_OUT };
+
+class HostRuntime {
+public:
+  RuntimeMode mode = MODE_STANDALONE;
+  uint32_t lastFrameMs = 0;
+
+  // Host framebuffer: GRB bytes in PBFR order (column by column, odd
+  // columns bottom to top)
+  uint8_t grb[HOST_FRAME_BYTES];
+  bool hasFrame = false;
+  // True when the latest frame was a PBFS copied straight into the strip buffer
+  bool frameInStrip = false;
+  // Set when a host packet changed what should be on the LEDs/LCD
+  bool displayDirty = false;
+
+  // The grid is columns x rows cells from the start of the strip
+  void begin(Adafruit_NeoPixel* strip, Pixel_Grid* grid, LCD_Panel* lcd, uint8_t columns, uint8_t rows) {
+    strip_ = strip;
+    grid_ = grid;
+    lcd_ = lcd;
+    columns_ = columns;
+    rows_ = rows;
+    reset();
+  }
+
+  // Back to standalone at the default baud rate, with nothing buffered
+  void reset() {
+    // A host that went away may have left the link at a high rate
+    if (baud_.current != HOST_DEFAULT_BAUD) setBaud(HOST_DEFAULT_BAUD);
+    baud_.reset(millis());
+    pendingBaud_ = 0;
+    inputMode_ = HOST_INPUT_MODE_BYTES;
+    input_.reset();
+    anim_.stop();
+
+    while (Serial.available() > 0) (void)Serial.read();
+
+    HostParserCallbacks cb;
+    cb.ctx = this;
+    cb.payloadTarget = payloadTargetThunk;
+    cb.onPacket = onPacketThunk;
+    parser_.begin(cb);
+    parserReady_ = true;
+
+    hasFrame = false;
+    frameInStrip = false;
+    grbValid_ = false;
+    seenCorrupt_ = parser_.stats.corrupt;
+    seenDropped_ = parser_.stats.dropped;
+    displayDirty = false;
+    mode = MODE_STANDALONE;
+    lastFrameMs = 0;
+  }
+
+  // One pass of loop(); see the top of this file
+  HostStep step(GameInput& in) {
+    bool gotFrame = poll();
+    // Enforce the timeout even if parsing is currently failing
+    if (mode == MODE_HOST && millis() - lastFrameMs > HOST_TIMEOUT_MS) {
+      reset();
+      return HOST_STEP_TIMED_OUT;
+    }
+    if (mode != MODE_HOST) return HOST_STEP_GAME;
+
+    in.update();
+    reportInput(in);
+    in.latch();
+
+    if (gotFrame || displayDirty) {
+      displayDirty = false;
+      show();
+    }
+    return HOST_STEP_HOST;
+  }
+
+  // Non-blocking: parses whatever Serial already holds. True if a full frame arrived.
+  bool poll() {
+    if (!parserReady_) reset();
+
+    // Unconfirmed switch or idle link: back to the previous/default rate
+    uint32_t fallbackBaud = baud_.poll(millis());
+    if (fallbackBaud) setBaud(fallbackBaud);
+
+    frameArrived_ = false;
+    parser_.poll(Serial);
+    // A PBBR switch waits until the parser is done with what it read
+    if (pendingBaud_) {
+      setBaud(pendingBaud_);
+      pendingBaud_ = 0;
+    }
+
+    // A playing clip counts as host activity, so host mode lasts to its end
+    if (anim_.playing()) {
+      uint32_t now = millis();
+      if (anim_.update(now)) {
+        hasFrame = true;
+        frameInStrip = false;
+        frameArrived_ = true;
+      }
+      lastFrameMs = now;
+      if (!anim_.playing() || animRing_.consumed - animAckedAt_ >= ANIM_ACK_EVERY ||
+          now - animAckedMs_ >= ANIM_ACK_MS) {
+        sendAnimAck();
+      }
+    }
+    return frameArrived_;
+  }
+
+  // Reports each button that changed this pass as its own edge, oldest
+  // first, at the time it was pressed or released, then sends anything due
+  void reportInput(GameInput& in) {
+    InputEvent e;
+    while (in.popEvent(e)) reportInput(e.held, e.us);
+    reportInput(in.held(), micros());
+  }
+
+  // The packed input byte and the micros() it changed at. Sends 'b' bytes
+  // on change, or PBIN reports with timestamped edges once the host asks
+  // (PBIM).
+  void reportInput(uint8_t bits, uint32_t changedUs) {
+    if (inputMode_ == HOST_INPUT_MODE_REPORTS) {
+      uint32_t nowUs = micros();
+      input_.note(bits, changedUs);
+      if (input_.due(nowUs)) {
+        uint8_t report[HOST_INPUT_REPORT_MAX_BYTES];
+        uint16_t len = input_.take(nowUs, report);
+        sendPacket(HOST_PKT_INPUT, report, len);
+      }
+      return;
+    }
+
+    uint32_t now = millis();
+    if (bits != lastSentBits_ && (now - lastSentMs_) >= HOST_SEND_MIN_MS) {
+      Serial.write('b');  // marker expected by PC
+      Serial.write(bits); // single payload byte
+      lastSentBits_ = bits;
+      lastSentMs_ = now;
+    }
+  }
+
+  // Puts the latest host frame on the LEDs, or "HOST" on the LCD until
+  // the first one arrives
+  void show() {
+    if (!strip_ || !grid_ || !lcd_) return;
+    if (!hasFrame) {
+      setLcdText("HOST  ");
+      lcd_->render();
+      grid_->render();
+      strip_->show();
+      return;
+    }
+
+    // PBFS frames are already in the LED buffer in wire order; a grid
+    // render would overwrite them with the stale grid buffer
+    if (!frameInStrip) {
+      drawGrb();
+      grid_->render();
+    }
+    lcd_->render();
+    strip_->show();
+  }
+
+  const HostLinkStats& stats() const { return parser_.stats; }
+
+private:
+  Adafruit_NeoPixel* strip_ = nullptr;
+  Pixel_Grid* grid_ = nullptr;
+  LCD_Panel* lcd_ = nullptr;
+  uint8_t columns_ = 0;
+  uint8_t rows_ = 0;
+
+  // PBDF and PBFS payloads land here, and are decoded into grb or copied
+  // into the strip once complete. An encoded frame is never larger than a
+  // raw one (the host sends PBFR instead), so one frame's bytes are enough.
+  uint8_t deltaBuf_[HOST_FRAME_BYTES];
+  // grb holds a complete frame that XOR deltas can be applied to
+  bool grbValid_ = false;
+  // The parser's corrupt and dropped counts when grb was last checked
+  uint32_t seenCorrupt_ = 0;
+  uint32_t seenDropped_ = 0;
+
+  HostParser parser_;
+  HostBaudSwitch baud_;
+  uint32_t pendingBaud_ = 0; // accepted by PBBR, applied after parsing
+  HostInputQueue input_;
+  uint8_t inputMode_ = HOST_INPUT_MODE_BYTES;
+  // Clips streamed with PBAS/PBAD play into grb at the device's own pace
+  AnimStreamRing animRing_;
+  AnimPlayer anim_;
+  uint32_t animAckedAt_ = 0; // animRing_.consumed at the last PBAK
+  uint32_t animAckedMs_ = 0;
+  bool parserReady_ = false;
+  bool frameArrived_ = false;
+
+  uint8_t lastSentBits_ = 0;
+  uint32_t lastSentMs_ = 0;
+
+  static const uint8_t LCD_DIGITS = 6;
+
+  static uint8_t* payloadTargetThunk(void* ctx, uint16_t type, uint16_t len, uint16_t& cap) {
+    return static_cast<HostRuntime*>(ctx)->payloadTarget(type, len, cap);
+  }
+  static void onPacketThunk(void* ctx, uint16_t type, const uint8_t* payload, uint16_t len) {
+    static_cast<HostRuntime*>(ctx)->onPacket(type, payload, len);
+  }
+
+  uint16_t stripMatrixBytes() const { return (uint16_t)(grid_->numPixels() * 3); }
+
+  // PBFR payloads stream straight into grb; everything else is small and
+  // goes through the parser's scratch buffer. Framed packets arrive in the
+  // parser's own buffer once their CRC checks out and are copied from there.
+  //
+  // PBFS payloads are copied into the strip's own GRB buffer: the host has
+  // already laid the bytes out in wire order, so there is nothing to remap.
+  // They are staged first, as a packet can span several polls and the game
+  // may still draw into and show() the strip in between. Only the matrix
+  // part is copied (bytes past it would land on the LCD digits), so hosts
+  // may send just the grid's pixels. The strip never has setBrightness()
+  // applied, so raw bytes are correct.
+  uint8_t* payloadTarget(uint16_t type, uint16_t len, uint16_t& cap) {
+    if (type == HOST_PKT_FRAME && len == sizeof(grb)) {
+      grbValid_ = false; // until the whole frame has arrived
+      cap = sizeof(grb);
+      return grb;
+    }
+    if ((type == HOST_PKT_FRAME_DELTA || type == HOST_PKT_FRAME_STRIP || type == HOST_PKT_ANIM_DATA) &&
+        len <= sizeof(deltaBuf_)) {
+      // grb is the delta reference, so a PBFR must not be half-written
+      // into it while this packet streams in; PBDF gets its own buffer.
+      // PBAD is copied on into the clip stream as soon as it is complete.
+      cap = sizeof(deltaBuf_);
+      return deltaBuf_;
+    }
+    return nullptr;
+  }
+
+  void onPacket(uint16_t type, const uint8_t* payload, uint16_t len) {
+    baud_.noteActivity(millis());
+
+    // A framed packet was lost or failed its CRC since the last one. It may
+    // have been a frame, so grb is no reference for deltas until a keyframe.
+    if (parser_.stats.corrupt != seenCorrupt_ || parser_.stats.dropped != seenDropped_) {
+      seenCorrupt_ = parser_.stats.corrupt;
+      seenDropped_ = parser_.stats.dropped;
+      grbValid_ = false;
+    }
+
+    // Frames from the host take the display back from a streamed clip
+    if (type == HOST_PKT_FRAME || type == HOST_PKT_FRAME_DELTA || type == HOST_PKT_FRAME_STRIP) anim_.stop();
+
+    switch (type) {
+      case HOST_PKT_FRAME:
+        // Wrong-length frames were collected in scratch; ignore them.
+        if (payload != grb) {
+          if (len != sizeof(grb) || payload == parser_.scratch) return;
+          memcpy(grb, payload, len); // framed packet
+        }
+        grbValid_ = true;
+        noteFrame(false);
+        break;
+
+      case HOST_PKT_FRAME_DELTA:
+        // Oversized PBDF ends up in scratch; deltas need a reference frame.
+        if (payload == parser_.scratch || len == 0) return;
+        if (frameEncodingIsDelta(payload[0]) && !grbValid_) return;
+
+        // A failed decode may have partly overwritten grb; wait for a keyframe.
+        grbValid_ = decodeFrame(payload, len, grb, HOST_FRAME_BYTES / 3);
+        if (!grbValid_) return;
+        noteFrame(false);
+        break;
+
+      case HOST_PKT_FRAME_STRIP: {
+        // Oversized PBFS ends up in scratch
+        if (!strip_ || !grid_ || payload == parser_.scratch) return;
+        uint16_t cap = stripMatrixBytes();
+        memcpy(strip_->getPixels(), payload, len < cap ? len : cap);
+        // grb no longer matches the screen; host deltas need a new keyframe
+        grbValid_ = false;
+        noteFrame(true);
+        break;
+      }
+
+      case HOST_PKT_ANIM_START:
+        startAnim();
+        break;
+
+      case HOST_PKT_ANIM_DATA:
+        if (payload == parser_.scratch) return;
+        if (anim_.playing() && !animRing_.push(payload, len)) anim_.fail(ANIM_ERR_OVERRUN);
+        sendAnimAck();
+        break;
+
+      case HOST_PKT_LCD_TEXT:
+        handleLcdText(payload, len);
+        break;
+
+      case HOST_PKT_HUD_7SEG:
+        // Only process HUD packets once we're already in host mode.
+        if (mode != MODE_HOST) return;
+        handleHud7Seg(payload, len);
+        break;
+
+      // Link control and diagnostics don't take over the display
+      case HOST_PKT_STATUS_REQ:
+        sendStatus(payload, len);
+        return;
+
+      case HOST_PKT_BAUD_REQ:
+        handleBaudRequest(payload, len);
+        return;
+
+      case HOST_PKT_INPUT_MODE:
+        if (len != 1) return;
+        inputMode_ = payload[0] == HOST_INPUT_MODE_REPORTS ? HOST_INPUT_MODE_REPORTS : HOST_INPUT_MODE_BYTES;
+        input_.reset();
+        return;
+
+      case HOST_PKT_PING: {
+        if (len != HOST_PING_BYTES) return;
+        uint8_t pong[HOST_PONG_BYTES];
+        hostPongPayload(payload, micros(), pong);
+        sendPacket(HOST_PKT_PONG, pong, sizeof(pong));
+        return;
+      }
+
+      case HOST_PKT_BAUD_CONFIRM: {
+        uint8_t ack[HOST_BAUD_ACK_BYTES];
+        baud_.confirm(ack);
+        sendPacket(HOST_PKT_BAUD_ACK, ack, sizeof(ack));
+        return;
+      }
+
+      default:
+        // unknown packet: the parser already skipped its payload
+        return;
+    }
+
+    mode = MODE_HOST;
+    lastFrameMs = millis();
+    displayDirty = true;
+  }
+
+  void noteFrame(bool inStrip) {
+    hasFrame = true;
+    frameInStrip = inStrip;
+    frameArrived_ = true;
+  }
+
+  void drawGrb() {
+    uint16_t idx = 0;
+    for (uint8_t x = 0; x < columns_; ++x) {
+      bool reverseCol = (x % 2 == 1);
+      for (uint8_t i = 0; i < rows_; ++i) {
+        uint8_t row = reverseCol ? (uint8_t)(rows_ - 1 - i) : i;
+        uint32_t c = strip_->Color(grb[idx + 1], grb[idx + 0], grb[idx + 2]);
+        grid_->setGridCellColour((uint16_t)(rows_ - 1 - row), x, c);
+        idx += 3;
+      }
+    }
+  }
+
+  // Exactly LCD_DIGITS characters: the last ones of a longer text, a
+  // shorter one right-aligned
+  void setLcdText(const char* s) {
+    if (!lcd_) return;
+    char out[LCD_DIGITS];
+    memset(out, ' ', sizeof(out));
+    size_t n = strlen(s);
+    if (n >= LCD_DIGITS) {
+      memcpy(out, s + n - LCD_DIGITS, LCD_DIGITS);
+    } else {
+      memcpy(out + (LCD_DIGITS - n), s, n);
+    }
+    lcd_->changeCharArray(out);
+  }
+
+  // PBLC payload: UTF-8 text for the LCD (capped to the scratch buffer)
+  void handleLcdText(const uint8_t* p, uint16_t len) {
+    const size_t MAX_LCD = 32;
+    uint16_t n = len > MAX_LCD ? MAX_LCD : len;
+
+    char buf[MAX_LCD + 1];
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+
+    setLcdText(buf);
+  }
+
+  // PB7S payload layout:
+  // [0..2] masks for digits 0..2
+  // [3..11] colors for digits 0..2 as RGB triplets
+  // [12..14] score digits (hundreds,tens,ones) as values 0..9
+  // Digits 0-2 show the masks in their colours, digits 3-5 the score.
+  void handleHud7Seg(const uint8_t* p, uint16_t len) {
+    const uint16_t EXPECT = 15;
+    if (len != EXPECT || !lcd_ || !strip_) return;
+
+    const uint32_t off = strip_->Color(0, 0, 0);
+    const uint32_t scoreCol = strip_->Color(220, 220, 220);
+
+    for (uint8_t i = 0; i < 3; ++i) {
+      const uint8_t* rgb = p + 3 + i * 3;
+      lcd_->setDigitOnColour(i, strip_->Color(rgb[0], rgb[1], rgb[2]));
+      lcd_->setDigitOffColour(i, off);
+      lcd_->setDigitSegments(i, p[i]);
+    }
+    for (uint8_t i = 3; i < 6; ++i) {
+      lcd_->setDigitOnColour(i, scoreCol);
+      lcd_->setDigitOffColour(i, off);
+      lcd_->setDigitChar(i, (char)('0' + p[12 + i - 3] % 10));
+    }
+  }
+
+  void sendPacket(uint16_t type, const uint8_t* payload, uint16_t len) {
+    uint8_t header[HOST_HEADER_BYTES];
+    hostPacketHeader(header, type, len);
+    Serial.write(header, sizeof(header));
+    Serial.write(payload, len);
+  }
+
+  static void setBaud(uint32_t baud) {
+    Serial.flush(); // the ack must leave at the old rate
+#if defined(ARDUINO_USB_CDC_ON_BOOT) && ARDUINO_USB_CDC_ON_BOOT
+    // USB CDC has no line rate to change; the host's setting is what counts
+    (void)baud;
+#elif defined(ARDUINO_ARCH_ESP32)
+    Serial.updateBaudRate(baud);
+#else
+    Serial.end();
+    Serial.begin(baud);
+#endif
+  }
+
+  // PBBR payload: u32 requested rate. This runs inside parser_.poll(),
+  // which still holds a byte count read at the old rate, so the switch
+  // itself is left to poll().
+  void handleBaudRequest(const uint8_t* p, uint16_t len) {
+    uint8_t ack[HOST_BAUD_ACK_BYTES];
+    uint32_t newBaud = 0;
+    if (len == HOST_BAUD_REQ_BYTES) {
+      newBaud = baud_.request(hostReadU32(p), millis(), ack);
+    } else {
+      hostBaudAckPayload(baud_.current, HOST_BAUD_REJECTED, ack);
+    }
+    sendPacket(HOST_PKT_BAUD_ACK, ack, sizeof(ack));
+    if (newBaud) pendingBaud_ = newBaud;
+  }
+
+  // PBST reply to PBSQ, always sent as a plain packet; the PBSQ's token,
+  // if it had one, is echoed so the host can tell which request it answers
+  void sendStatus(const uint8_t* token, uint16_t len) {
+    uint8_t status[HOST_STATUS_BYTES + HOST_STATUS_TOKEN_BYTES];
+    hostStatsPayload(parser_.stats, status);
+    uint16_t n = HOST_STATUS_BYTES;
+    if (len == HOST_STATUS_TOKEN_BYTES) {
+      memcpy(status + n, token, len);
+      n += len;
+    }
+    sendPacket(HOST_PKT_STATUS, status, n);
+  }
+
+  void sendAnimAck() {
+    uint8_t ack[HOST_ANIM_ACK_BYTES];
+    hostAnimAckPayload(animRing_.consumed, anim_.status, ack);
+    sendPacket(HOST_PKT_ANIM_ACK, ack, sizeof(ack));
+    animAckedAt_ = animRing_.consumed;
+    animAckedMs_ = millis();
+  }
+
+  void startAnim() {
+    animRing_.reset();
+    anim_.begin(animRing_.source(), grb, (uint16_t)(columns_ * rows_));
+    // The clip's frames replace grb; host deltas need a new keyframe after it
+    grbValid_ = false;
+    sendAnimAck();
+  }
+};
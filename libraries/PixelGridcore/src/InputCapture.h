@@ -0,0 +1,123 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "InputPort.h"
+
+// Button edges captured by pin-change interrupts.
+//
+// Each input line is an INPUT_PULLUP pin (pressed reads LOW) with a CHANGE
+// interrupt. The handler reads micros() and every line at once (InputPort)
+// and pushes an InputEdge into a single-producer/single-consumer ring; the game loop pops them, so a
+// press keeps the time it happened however long the last frame took to
+// render, and nothing is read while no button moves.
+//
+// The ring takes no lock: the interrupt only writes head_, the loop only
+// writes tail_, and each index is published with release/acquire ordering
+// so the slot it covers is complete when the other side sees it (the
+// interrupt may run on the other core). A full ring drops the new edge and
+// counts it; the loop then reads the lines once to catch up (takeDropped()).
+
+static const uint8_t INPUT_CAPTURE_MAX_LINES = INPUT_PORT_MAX_LINES;
+static const uint8_t INPUT_EDGE_RING_SIZE    = 64;  // a power of two
+
+struct InputEdge {
+  uint32_t us;     // micros() when the interrupt ran
+  uint8_t line;    // index into the pins given to begin()
+  uint8_t down;    // 1 = the pin read LOW (pressed)
+  uint8_t levels;  // every line as read then, bit i = line i pressed
+};
+
+template <uint8_t N>
+class InputEdgeRing {
+  static_assert(N && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+  // Producer only. False (and counted) when the ring is full.
+  bool push(const InputEdge& e) {
+    uint8_t head = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+    uint8_t tail = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+    if ((uint8_t)(head - tail) == N) {
+      __atomic_store_n(&dropped_, dropped_ + 1, __ATOMIC_RELAXED);
+      return false;
+    }
+    slots_[head & (N - 1)] = e;
+    __atomic_store_n(&head_, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+    return true;
+  }
+
+  // Consumer only
+  bool pop(InputEdge& e) {
+    uint8_t tail = __atomic_load_n(&tail_, __ATOMIC_RELAXED);
+    uint8_t head = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+    if (head == tail) return false;
+    e = slots_[tail & (N - 1)];
+    __atomic_store_n(&tail_, (uint8_t)(tail + 1), __ATOMIC_RELEASE);
+    return true;
+  }
+
+  // Edges dropped since the ring was made; only the producer writes it
+  uint32_t dropped() const { return __atomic_load_n(&dropped_, __ATOMIC_RELAXED); }
+
+private:
+  InputEdge slots_[N];
+  // Free-running; N divides 256, so the difference is the fill level
+  uint8_t head_ = 0;
+  uint8_t tail_ = 0;
+  uint32_t dropped_ = 0;
+};
+
+class InputCapture {
+public:
+  // Pins pulled up, line i is pins[i]. Attaches the interrupts; call once.
+  void begin(const uint8_t* pins, uint8_t count) {
+    count_ = count < INPUT_CAPTURE_MAX_LINES ? count : INPUT_CAPTURE_MAX_LINES;
+    port_.begin(pins, count_);
+    for (uint8_t i = 0; i < count_; ++i) {
+      lines_[i].owner = this;
+      lines_[i].line = i;
+      lines_[i].pin = pins[i];
+      pinMode(pins[i], INPUT_PULLUP);
+      attachInterruptArg(digitalPinToInterrupt(pins[i]), onChange, &lines_[i], CHANGE);
+    }
+  }
+
+  bool pop(InputEdge& e) { return ring_.pop(e); }
+
+  // Edges lost to a full ring since the last call. Non-zero means the
+  // order of events is broken; read every line with levels() to recover.
+  uint32_t takeDropped() {
+    uint32_t d = ring_.dropped();
+    uint32_t n = d - seenDropped_;
+    seenDropped_ = d;
+    return n;
+  }
+
+  uint8_t count() const { return count_; }
+  uint8_t pin(uint8_t line) const { return lines_[line].pin; }
+  uint8_t levels() const { return port_.read(); }
+  bool down(uint8_t line) const { return (levels() >> line) & 1; }
+
+private:
+  struct Line {
+    InputCapture* owner;
+    uint8_t line;
+    uint8_t pin;
+  };
+
+  static void IRAM_ATTR onChange(void* arg) {
+    Line* l = (Line*)arg;
+    InputEdge e;
+    e.us = micros();
+    e.line = l->line;
+    e.levels = l->owner->port_.read();
+    e.down = (e.levels >> l->line) & 1;
+    l->owner->ring_.push(e);
+  }
+
+  InputEdgeRing<INPUT_EDGE_RING_SIZE> ring_;
+  InputPort port_;
+  Line lines_[INPUT_CAPTURE_MAX_LINES];
+  uint8_t count_ = 0;
+  uint32_t seenDropped_ = 0;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+
+// Every input line in one read, and debounced side by side.
+//
+// InputPort reads the GPIO input registers once per bank in use (GPIO0-31,
+// then GPIO32 and up) and gathers the lines into a mask, bit i = line i
+// pressed (pins are INPUT_PULLUP, so pressed reads LOW). No pin-to-port
+// lookup is done per read; begin() works out each line's bank and bit.
+//
+// VerticalCounter debounces eight lines at once: each bit position holds a
+// two-bit counter, kept as two bit planes, of consecutive samples that
+// differ from the stable level. Four in a row flip the level; any sample
+// that agrees clears the counter.
+//
+// InputDebouncer clocks that counter on a fixed sample grid from the
+// captured edges (InputCapture.h), not from loop passes: a sample is the
+// line levels at a grid tick, so the debounce time doesn't grow when a frame
+// takes longer. It also dates each change to the first edge of its bounce
+// burst, as Btn did.
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <soc/gpio_reg.h>
+// The host shims provide the same function over the emulated pins
+static inline uint32_t IRAM_ATTR gpioInputBank(uint8_t bank) {
+  return bank ? REG_READ(GPIO_IN1_REG) : REG_READ(GPIO_IN_REG);
+}
+#endif
+
+static const uint8_t INPUT_PORT_MAX_LINES = 8;
+// Samples that must agree before a line changes level
+static const uint8_t INPUT_DEBOUNCE_SAMPLES = 4;
+
+class InputPort {
+public:
+  // Line i is pins[i]; at most INPUT_PORT_MAX_LINES
+  void begin(const uint8_t* pins, uint8_t count) {
+    count_ = count < INPUT_PORT_MAX_LINES ? count : INPUT_PORT_MAX_LINES;
+    usesBank1_ = false;
+    for (uint8_t i = 0; i < count_; ++i) {
+      bank_[i] = pins[i] >> 5;
+      shift_[i] = pins[i] & 31;
+      if (bank_[i]) usesBank1_ = true;
+    }
+  }
+
+  // Pressed lines, bit i = line i
+  uint8_t IRAM_ATTR read() const {
+    uint32_t in[2];
+    in[0] = gpioInputBank(0);
+    in[1] = usesBank1_ ? gpioInputBank(1) : 0;
+    uint8_t high = 0;
+    for (uint8_t i = 0; i < count_; ++i) high |= (uint8_t)(((in[bank_[i]] >> shift_[i]) & 1u) << i);
+    return (uint8_t)(~high & lineMask());
+  }
+
+  uint8_t count() const { return count_; }
+  uint8_t lineMask() const { return (uint8_t)((1u << count_) - 1); }
+
+private:
+  uint8_t bank_[INPUT_PORT_MAX_LINES] = {};
+  uint8_t shift_[INPUT_PORT_MAX_LINES] = {};
+  uint8_t count_ = 0;
+  bool usesBank1_ = false;
+};
+
+struct VerticalCounter {
+  uint8_t state = 0;  // stable levels
+  uint8_t c0 = 0;     // counter, low bit plane
+  uint8_t c1 = 0;     // counter, high bit plane
+
+  void reset(uint8_t levels) {
+    state = levels;
+    c0 = c1 = 0;
+  }
+
+  // One sample of every line; returns the lines whose stable level flipped
+  uint8_t clock(uint8_t sample) {
+    uint8_t delta = sample ^ state;
+    c1 = (uint8_t)((c1 ^ c0) & delta);
+    c0 = (uint8_t)(~c0 & delta);
+    // Counted 3 -> 0: the fourth differing sample in a row
+    uint8_t flip = (uint8_t)(delta & ~(c0 | c1));
+    state ^= flip;
+    return flip;
+  }
+};
+
+class InputDebouncer {
+public:
+  // levels: the lines' state now, taken as already stable. The debounce
+  // time is INPUT_DEBOUNCE_SAMPLES sample periods.
+  void begin(uint8_t levels, uint32_t nowUs, uint32_t debounceUs) {
+    periodUs_ = debounceUs / INPUT_DEBOUNCE_SAMPLES;
+    if (!periodUs_) periodUs_ = 1;
+    counter_.reset(levels);
+    raw_ = levels;
+    nextSampleUs_ = nowUs + periodUs_;
+    for (uint8_t i = 0; i < INPUT_PORT_MAX_LINES; ++i) {
+      lastEdgeUs_[i] = nowUs - debounceUs;
+      burstUs_[i] = nowUs;
+      changedUs_[i] = nowUs;
+    }
+  }
+
+  // A captured edge: levels is every line's state right after it. Edges
+  // must come in the order they happened.
+  void edge(uint8_t levels, uint32_t us) {
+    clockTo(us);
+    uint8_t moved = levels ^ raw_;
+    for (uint8_t i = 0; moved; ++i, moved >>= 1) {
+      if (!(moved & 1)) continue;
+      // A burst starts at the first edge after a debounce time of quiet
+      if ((int32_t)(us - lastEdgeUs_[i]) >= (int32_t)(periodUs_ * INPUT_DEBOUNCE_SAMPLES)) burstUs_[i] = us;
+      lastEdgeUs_[i] = us;
+    }
+    raw_ = levels;
+  }
+
+  // Runs the samples due up to nowUs; returns the stable levels
+  uint8_t settle(uint32_t nowUs) {
+    clockTo(nowUs);
+    return counter_.state;
+  }
+
+  uint8_t stable() const { return counter_.state; }
+  uint8_t raw() const { return raw_; }
+  // micros() of the first edge of the burst that last changed the line
+  uint32_t changedUs(uint8_t line) const { return changedUs_[line]; }
+
+private:
+  void clockTo(uint32_t us) {
+    uint8_t n = 0;
+    while ((int32_t)(us - nextSampleUs_) >= 0) {
+      // Past this many equal samples the counters can't move
+      if (n == INPUT_DEBOUNCE_SAMPLES) {
+        nextSampleUs_ += ((us - nextSampleUs_) / periodUs_ + 1) * periodUs_;
+        break;
+      }
+      uint8_t flip = counter_.clock(raw_);
+      for (uint8_t i = 0; flip; ++i, flip >>= 1) {
+        if (flip & 1) changedUs_[i] = burstUs_[i];
+      }
+      nextSampleUs_ += periodUs_;
+      ++n;
+    }
+  }
+
+  VerticalCounter counter_;
+  uint8_t raw_ = 0;
+  uint32_t periodUs_ = 1;
+  uint32_t nextSampleUs_ = 0;
+  uint32_t lastEdgeUs_[INPUT_PORT_MAX_LINES] = {};
+  uint32_t burstUs_[INPUT_PORT_MAX_LINES] = {};
+  uint32_t changedUs_[INPUT_PORT_MAX_LINES] = {};
+};
@@ -0,0 +1,343 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// JSON and base64url for the score server (Games/Tetris/NetSubmit.h), on
+// caller-provided fixed buffers so a submission never touches the heap.
+//
+// JsonWriter appends to a char buffer and remembers whether it ran out of
+// room instead of failing each call; check ok() once at the end.
+//
+// JsonScanner reads a response a chunk at a time as it arrives, with no
+// copy of the body. It keeps the name of the member being read and the
+// string being read in small buffers (longer ones are cut short) and calls
+// back for each string value and each closed object. Numbers, booleans and
+// null are skipped. It doesn't validate: input it can't follow sets error()
+// and the rest is ignored.
+
+static const uint8_t JSON_MAX_DEPTH = 16;
+static const uint8_t JSON_KEY_MAX   = 15;
+static const uint8_t JSON_VALUE_MAX = 31;
+
+// base64url (RFC 4648 section 5) without padding
+static inline size_t base64UrlLength(size_t len) {
+  return (len * 4 + 2) / 3;
+}
+
+// Writes base64UrlLength(len) characters and a NUL to out. Returns the
+// length, or 0 if out (cap bytes) is too small.
+static inline size_t base64UrlEncode(const uint8_t* data, size_t len, char* out, size_t cap) {
+  static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  size_t n = base64UrlLength(len);
+  if (cap < n + 1) return 0;
+  char* o = out;
+  size_t i = 0;
+  for (; i + 3 <= len; i += 3) {
+    uint32_t v = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+    *o++ = ALPHABET[(v >> 18) & 63];
+    *o++ = ALPHABET[(v >> 12) & 63];
+    *o++ = ALPHABET[(v >> 6) & 63];
+    *o++ = ALPHABET[v & 63];
+  }
+  if (i < len) {
+    uint32_t v = (uint32_t)data[i] << 16;
+    if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+    *o++ = ALPHABET[(v >> 18) & 63];
+    *o++ = ALPHABET[(v >> 12) & 63];
+    if (i + 1 < len) *o++ = ALPHABET[(v >> 6) & 63];
+  }
+  *o = 0;
+  return n;
+}
+
+class JsonWriter {
+public:
+  JsonWriter(char* buf, size_t cap) : buf_(buf), cap_(cap) {
+    if (cap_) buf_[0] = 0;
+    else overflow_ = true;
+  }
+
+  void beginObject(const char* key = nullptr) { open(key, '{'); }
+  void endObject() { close('}'); }
+  void beginArray(const char* key = nullptr) { open(key, '['); }
+  void endArray() { close(']'); }
+
+  void field(const char* key, const char* value) {
+    member(key);
+    string(value);
+  }
+
+  void field(const char* key, long value) {
+    member(key);
+    char digits[12];
+    uint8_t n = 0;
+    unsigned long v = value < 0 ? 0ul - (unsigned long)value : (unsigned long)value;
+    do {
+      digits[n++] = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+    if (value < 0) put('-');
+    while (n) put(digits[--n]);
+  }
+
+  // Encodes data straight into the output, with no intermediate string
+  void fieldBase64Url(const char* key, const uint8_t* data, size_t len) {
+    member(key);
+    put('"');
+    if (overflow_) return;
+    size_t n = base64UrlEncode(data, len, buf_ + len_, cap_ - len_);
+    if (!n) {
+      overflow_ = true;
+      return;
+    }
+    len_ += n;
+    put('"');
+  }
+
+  bool ok() const { return !overflow_ && depth_ == 0; }
+  size_t length() const { return len_; }
+  const char* c_str() const { return buf_; }
+
+private:
+  void put(char c) {
+    // Keep room for the NUL
+    if (overflow_ || len_ + 1 >= cap_) {
+      overflow_ = true;
+      return;
+    }
+    buf_[len_++] = c;
+    buf_[len_] = 0;
+  }
+
+  void string(const char* s) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    put('"');
+    for (; *s; ++s) {
+      uint8_t c = (uint8_t)*s;
+      if (c == '"' || c == '\\') {
+        put('\\');
+        put((char)c);
+      } else if (c < 0x20) {
+        put('\\');
+        put('u');
+        put('0');
+        put('0');
+        put(HEX_DIGITS[c >> 4]);
+        put(HEX_DIGITS[c & 15]);
+      } else {
+        put((char)c);
+      }
+    }
+    put('"');
+  }
+
+  // Comma before every value but the first in its container, then the name
+  void member(const char* key) {
+    if (depth_) {
+      uint16_t bit = (uint16_t)(1u << (depth_ - 1));
+      if (notFirst_ & bit) put(',');
+      notFirst_ |= bit;
+    }
+    if (key) {
+      string(key);
+      put(':');
+    }
+  }
+
+  void open(const char* key, char c) {
+    member(key);
+    put(c);
+    if (depth_ >= JSON_MAX_DEPTH) {
+      overflow_ = true;
+      return;
+    }
+    depth_++;
+    notFirst_ &= (uint16_t)~(1u << (depth_ - 1));
+  }
+
+  void close(char c) {
+    if (!depth_) {
+      overflow_ = true;
+      return;
+    }
+    depth_--;
+    put(c);
+  }
+
+  char* buf_;
+  size_t cap_;
+  size_t len_ = 0;
+  bool overflow_ = false;
+  uint8_t depth_ = 0;
+  uint16_t notFirst_ = 0;  // bit d-1: depth d already holds a value
+};
+
+enum JsonEvent : uint8_t {
+  JSON_STRING,     // value is a string; key is the member it belongs to
+  JSON_OBJECT_END  // an object at depth closed; key and value are empty
+};
+
+class JsonScanner {
+public:
+  // depth counts enclosing containers: a top-level member is at 1, a member
+  // of an object in a top-level array at 3. key is the name of the last
+  // member read at that level, "" for array elements.
+  typedef void (*Callback)(void* ctx, JsonEvent event, uint8_t depth, const char* key, const char* value);
+
+  void begin(Callback cb, void* ctx) {
+    cb_ = cb;
+    ctx_ = ctx;
+    state_ = S_VALUE;
+    depth_ = 0;
+    arrays_ = 0;
+    expectKey_ = false;
+    key_[0] = 0;
+    len_ = 0;
+    error_ = false;
+    truncated_ = false;
+  }
+
+  void feed(const uint8_t* data, size_t n) {
+    for (size_t i = 0; i < n && !error_; ++i) feed((char)data[i]);
+  }
+
+  void feed(char c) {
+    switch (state_) {
+      case S_STRING:
+        if (c == '"') endString();
+        else if (c == '\\') state_ = S_ESCAPE;
+        else addChar(c);
+        return;
+      case S_ESCAPE:
+        state_ = S_STRING;
+        switch (c) {
+          case 'n': addChar('\n'); return;
+          case 't': addChar('\t'); return;
+          case 'r': addChar('\r'); return;
+          case 'b': addChar('\b'); return;
+          case 'f': addChar('\f'); return;
+          case 'u': state_ = S_UNICODE; hexLeft_ = 4; code_ = 0; return;
+          default: addChar(c); return;
+        }
+      case S_UNICODE: {
+        int h = hexValue(c);
+        if (h < 0) {
+          error_ = true;
+          return;
+        }
+        code_ = (uint16_t)((code_ << 4) | h);
+        if (--hexLeft_ == 0) {
+          // Codes and errors are ASCII; anything else is only kept as a marker
+          addChar(code_ < 0x80 ? (char)code_ : '?');
+          state_ = S_STRING;
+        }
+        return;
+      }
+      case S_LITERAL:
+        if (c == ',' || c == '}' || c == ']' || isSpace(c)) {
+          state_ = S_VALUE;
+          break;  // and handle c as structure
+        }
+        return;
+      case S_VALUE:
+        break;
+    }
+
+    if (isSpace(c)) return;
+    switch (c) {
+      case '{':
+      case '[':
+        if (depth_ >= JSON_MAX_DEPTH) {
+          error_ = true;
+          return;
+        }
+        if (c == '[') arrays_ |= (uint16_t)(1u << depth_);
+        else arrays_ &= (uint16_t)~(1u << depth_);
+        depth_++;
+        expectKey_ = c == '{';
+        key_[0] = 0;
+        return;
+      case '}':
+      case ']':
+        if (!depth_ || inArray() != (c == ']')) {
+          error_ = true;
+          return;
+        }
+        if (c == '}' && cb_) cb_(ctx_, JSON_OBJECT_END, depth_, "", "");
+        depth_--;
+        expectKey_ = false;
+        key_[0] = 0;
+        return;
+      case ',':
+        expectKey_ = depth_ && !inArray();
+        if (inArray()) key_[0] = 0;
+        return;
+      case ':':
+        expectKey_ = false;
+        return;
+      case '"':
+        state_ = S_STRING;
+        readingKey_ = expectKey_;
+        len_ = 0;
+        (readingKey_ ? key_ : value_)[0] = 0;
+        return;
+      default:
+        state_ = S_LITERAL;
+        return;
+    }
+  }
+
+  bool error() const { return error_; }
+  // Strings longer than JSON_VALUE_MAX were cut short
+  bool truncated() const { return truncated_; }
+
+private:
+  enum State : uint8_t { S_VALUE, S_STRING, S_ESCAPE, S_UNICODE, S_LITERAL };
+
+  static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+  static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  }
+
+  bool inArray() const { return depth_ && (arrays_ & (1u << (depth_ - 1))); }
+
+  void addChar(char c) {
+    uint8_t cap = readingKey_ ? JSON_KEY_MAX : JSON_VALUE_MAX;
+    if (len_ >= cap) {
+      truncated_ = true;
+      return;
+    }
+    char* dst = readingKey_ ? key_ : value_;
+    dst[len_++] = c;
+    dst[len_] = 0;
+  }
+
+  void endString() {
+    state_ = S_VALUE;
+    if (readingKey_) {
+      expectKey_ = false;
+      return;
+    }
+    if (cb_) cb_(ctx_, JSON_STRING, depth_, key_, value_);
+  }
+
+  Callback cb_ = nullptr;
+  void* ctx_ = nullptr;
+  State state_ = S_VALUE;
+  uint8_t depth_ = 0;
+  uint16_t arrays_ = 0;  // bit d: the container at depth d + 1 is an array
+  bool expectKey_ = false;
+  bool readingKey_ = false;
+  bool error_ = false;
+  bool truncated_ = false;
+  uint8_t len_ = 0;
+  uint8_t hexLeft_ = 0;
+  uint16_t code_ = 0;
+  char key_[JSON_KEY_MAX + 1] = {0};
+  char value_[JSON_VALUE_MAX + 1] = {0};
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <stdint.h>
+
+// Network link state machine: joins Wi-Fi at boot, syncs the clock, and keeps
+// both up, so a finished game only has to post its score.
+//
+//   LINK_JOINING  driver.join() called; waiting for an address
+//   LINK_SYNCING  connected; waiting for the clock to be set
+//   LINK_READY    connected with a valid clock
+//   LINK_WAIT     a join timed out or the link dropped; joining again at
+//                 retryAtMs, with the wait doubling from NET_LINK_RETRY_MIN_MS
+//
+// Nothing here blocks. The Wi-Fi and SNTP stacks report progress through
+// onConnected(), onDisconnected() and onTimeSynced(), which only set flags
+// and are safe to call from their own tasks; poll() reads the flags, acts on
+// timeouts and calls the driver, and is meant to run every pass of loop().
+// ready() may be read from any task.
+//
+// DriverT provides:
+//   void join()             start a connection (mode, credentials, begin)
+//   void leave()            drop the connection
+//   void startTimeSync()    start SNTP
+//   bool timeValid()        the clock is already set (RTC kept over reset)
+
+static const uint32_t NET_LINK_JOIN_TIMEOUT_MS = 45000;
+static const uint32_t NET_LINK_SYNC_TIMEOUT_MS = 15000;
+static const uint32_t NET_LINK_RETRY_MIN_MS    = 1000;
+static const uint32_t NET_LINK_RETRY_MAX_MS    = 60000;
+
+enum NetLinkState : uint8_t { LINK_OFF, LINK_JOINING, LINK_SYNCING, LINK_READY, LINK_WAIT };
+
+template <typename DriverT>
+class NetLink {
+public:
+  explicit NetLink(DriverT& driver) : driver_(driver) {}
+
+  void begin(uint32_t nowMs) {
+    retryMs_ = NET_LINK_RETRY_MIN_MS;
+    startJoin(nowMs);
+  }
+
+  // Wi-Fi and SNTP event hooks
+  void onConnected() { up_ = true; }
+  void onDisconnected() {
+    up_ = false;
+    drops_++;
+  }
+  void onTimeSynced() { synced_ = true; }
+
+  void poll(uint32_t nowMs) {
+    uint32_t drops = drops_;
+    bool dropped = drops != seenDrops_;
+    seenDrops_ = drops;
+
+    switch (state_) {
+      case LINK_OFF:
+        return;
+      case LINK_JOINING:
+        // A failed attempt also reports a disconnect; the stack keeps trying
+        // until the join timeout.
+        if (up_) {
+          retryMs_ = NET_LINK_RETRY_MIN_MS;
+          startSync(nowMs);
+        } else if (nowMs - sinceMs_ >= NET_LINK_JOIN_TIMEOUT_MS) {
+          wait(nowMs);
+        }
+        return;
+      case LINK_SYNCING:
+        if (dropped || !up_) {
+          wait(nowMs);
+        } else if (synced_ || driver_.timeValid()) {
+          state_ = LINK_READY;
+          readyCount_++;
+        } else if (nowMs - sinceMs_ >= NET_LINK_SYNC_TIMEOUT_MS) {
+          // NTP may be blocked for a while; the connection itself is fine
+          startSync(nowMs);
+        }
+        return;
+      case LINK_READY:
+        if (dropped || !up_) wait(nowMs);
+        return;
+      case LINK_WAIT:
+        if (nowMs - sinceMs_ >= waitMs_) startJoin(nowMs);
+        return;
+    }
+  }
+
+  bool ready() const { return state_ == LINK_READY; }
+  NetLinkState state() const { return state_; }
+  uint32_t joins() const { return joins_; }
+  uint32_t syncs() const { return syncs_; }
+  // Times the link became ready
+  uint32_t readyCount() const { return readyCount_; }
+
+private:
+  void startJoin(uint32_t nowMs) {
+    up_ = false;
+    seenDrops_ = drops_;
+    driver_.join();
+    joins_++;
+    state_ = LINK_JOINING;
+    sinceMs_ = nowMs;
+  }
+
+  void startSync(uint32_t nowMs) {
+    state_ = LINK_SYNCING;
+    sinceMs_ = nowMs;
+    if (driver_.timeValid()) return;
+    synced_ = false;
+    driver_.startTimeSync();
+    syncs_++;
+  }
+
+  void wait(uint32_t nowMs) {
+    driver_.leave();
+    up_ = false;
+    state_ = LINK_WAIT;
+    sinceMs_ = nowMs;
+    waitMs_ = retryMs_;
+    retryMs_ = retryMs_ * 2 > NET_LINK_RETRY_MAX_MS ? NET_LINK_RETRY_MAX_MS : retryMs_ * 2;
+  }
+
+  DriverT& driver_;
+  volatile NetLinkState state_ = LINK_OFF;
+  volatile bool up_ = false;
+  volatile bool synced_ = false;
+  volatile uint32_t drops_ = 0;
+  uint32_t seenDrops_ = 0;
+  uint32_t sinceMs_ = 0;
+  uint32_t waitMs_ = 0;
+  uint32_t retryMs_ = NET_LINK_RETRY_MIN_MS;
+  uint32_t joins_ = 0;
+  uint32_t syncs_ = 0;
+  uint32_t readyCount_ = 0;
+};
@@ -1,6 +1,15 @@
 #pragma once
 
-#include "Button.h"
+#include "Animation.h"
+#include "Arcade.h"
+#include "FrameCodec.h"
+#include "GameInput.h"
+#include "HostBaud.h"
+#include "HostInput.h"
+#include "HostProtocol.h"
+#include "HostRuntime.h"
+#include "InputCapture.h"
+#include "InputPort.h"
 #include "LCD_Digit.h"
 #include "LCD_Panel.h"
 #include "Pixel_Grid.h"
@@ -0,0 +1,239 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "HostProtocol.h"
+
+// Append-only score journal on flash. A score is written here at game over
+// and stays until the server has it, through Wi-Fi outages and power cycles.
+//   record  u8 type, u8 length, payload[length], u16 CRC of type..payload
+//   'S'     u32 id, u32 score, u32 played at (unix seconds, 0 if unknown),
+//           JOURNAL_NONCE_CHARS nonce characters
+//   'D'     u32 id: every score up to and including id is done
+// Integers are little-endian and the CRC is hostCrc16() (HostProtocol.h).
+// Ids count up from 1 and scores are uploaded in id order, so a single 'D'
+// record retires a whole batch.
+//
+// begin() reads the file up to the first record that is cut short or fails
+// its CRC, as a write interrupted by a power cut leaves it, and rewrites the
+// file without that tail. Rewrites (also once every score is done and the
+// file has grown past JOURNAL_COMPACT_BYTES) go to a second file that is
+// then renamed over the first, so a power cut mid-rewrite leaves one intact
+// copy.
+//
+// FsT is fs::FS (LittleFS) on the board; the emulator's LittleFS shim keeps
+// the files in a host directory. Not thread-safe: tasks sharing a journal
+// hold a lock around every call.
+
+static const uint8_t  JOURNAL_SCORE           = 'S';
+static const uint8_t  JOURNAL_DONE            = 'D';
+static const uint8_t  JOURNAL_NONCE_CHARS     = 16;
+static const uint8_t  JOURNAL_SCORE_BYTES     = 12 + JOURNAL_NONCE_CHARS;
+static const uint8_t  JOURNAL_DONE_BYTES      = 4;
+static const uint8_t  JOURNAL_RECORD_MAX      = 2 + JOURNAL_SCORE_BYTES + 2;
+static const uint32_t JOURNAL_COMPACT_BYTES   = 4096;
+
+struct JournalScore {
+  uint32_t id = 0;
+  uint32_t score = 0;
+  uint32_t playedAt = 0;
+  char nonce[JOURNAL_NONCE_CHARS + 1] = {0};
+};
+
+static inline uint32_t journalReadU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void journalWriteU32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+template <typename FsT>
+class ScoreJournal {
+public:
+  ScoreJournal(FsT& fs, const char* path, const char* tmpPath) : fs_(fs), path_(path), tmpPath_(tmpPath) {}
+
+  // Reads the journal, repairing it if needed. False if it can't be written.
+  bool begin() {
+    // A rewrite was cut short. Until the rename, the old file is complete.
+    if (fs_.exists(tmpPath_)) {
+      if (fs_.exists(path_)) fs_.remove(tmpPath_);
+      else fs_.rename(tmpPath_, path_);
+    }
+    scan();
+    ready_ = true;
+    if (validBytes_ < fileBytes_) {
+      droppedBytes_ = fileBytes_ - validBytes_;
+      ready_ = rewrite();
+    }
+    return ready_;
+  }
+
+  bool ready() const { return ready_; }
+  uint32_t pending() const { return nextId_ - 1 - doneThrough_; }
+  uint32_t nextId() const { return nextId_; }
+  uint32_t fileBytes() const { return fileBytes_; }
+  // Bytes of damaged tail thrown away by begin()
+  uint32_t droppedBytes() const { return droppedBytes_; }
+
+  // nonce is JOURNAL_NONCE_CHARS characters; longer ones are cut.
+  bool append(uint32_t score, uint32_t playedAt, const char* nonce, uint32_t& idOut) {
+    if (!ready_) return false;
+    uint8_t p[JOURNAL_SCORE_BYTES];
+    journalWriteU32(p, nextId_);
+    journalWriteU32(p + 4, score);
+    journalWriteU32(p + 8, playedAt);
+    memset(p + 12, 0, JOURNAL_NONCE_CHARS);
+    size_t n = strlen(nonce);
+    memcpy(p + 12, nonce, n < JOURNAL_NONCE_CHARS ? n : JOURNAL_NONCE_CHARS);
+    if (!appendRecord(JOURNAL_SCORE, p, sizeof(p))) return false;
+    idOut = nextId_++;
+    return true;
+  }
+
+  // The oldest max scores not yet done, in id order. Returns how many.
+  uint8_t peek(JournalScore* out, uint8_t max) {
+    if (!ready_ || !max || !pending()) return 0;
+    auto f = fs_.open(path_, "r");
+    if (!f) return 0;
+    uint8_t count = 0;
+    uint8_t type, len;
+    uint8_t payload[JOURNAL_SCORE_BYTES];
+    while (count < max && readRecord(f, type, payload, len)) {
+      if (type != JOURNAL_SCORE || journalReadU32(payload) <= doneThrough_) continue;
+      JournalScore& s = out[count++];
+      s.id = journalReadU32(payload);
+      s.score = journalReadU32(payload + 4);
+      s.playedAt = journalReadU32(payload + 8);
+      memcpy(s.nonce, payload + 12, JOURNAL_NONCE_CHARS);
+      s.nonce[JOURNAL_NONCE_CHARS] = 0;
+    }
+    f.close();
+    return count;
+  }
+
+  // Retires every score up to and including id.
+  bool markDone(uint32_t id) {
+    if (!ready_ || id <= doneThrough_ || id >= nextId_) return false;
+    uint8_t p[JOURNAL_DONE_BYTES];
+    journalWriteU32(p, id);
+    if (!appendRecord(JOURNAL_DONE, p, sizeof(p))) return false;
+    doneThrough_ = id;
+    if (!pending() && fileBytes_ > JOURNAL_COMPACT_BYTES) rewrite();
+    return true;
+  }
+
+private:
+  static uint8_t payloadBytes(uint8_t type) {
+    if (type == JOURNAL_SCORE) return JOURNAL_SCORE_BYTES;
+    if (type == JOURNAL_DONE) return JOURNAL_DONE_BYTES;
+    return 0;
+  }
+
+  static uint16_t encode(uint8_t* rec, uint8_t type, const uint8_t* payload, uint8_t len) {
+    rec[0] = type;
+    rec[1] = len;
+    memcpy(rec + 2, payload, len);
+    uint16_t crc = hostCrc16(rec, 2u + len);
+    rec[2 + len] = (uint8_t)crc;
+    rec[3 + len] = (uint8_t)(crc >> 8);
+    return (uint16_t)(len + 4);
+  }
+
+  // False at the end of the file or at the first damaged record.
+  template <typename FileT>
+  static bool readRecord(FileT& f, uint8_t& type, uint8_t* payload, uint8_t& len) {
+    uint8_t rec[JOURNAL_RECORD_MAX];
+    if (f.read(rec, 2) != 2) return false;
+    type = rec[0];
+    len = rec[1];
+    if (!len || len != payloadBytes(type)) return false;
+    if (f.read(rec + 2, len + 2u) != len + 2u) return false;
+    uint16_t crc = (uint16_t)(rec[2 + len] | (rec[3 + len] << 8));
+    if (hostCrc16(rec, 2u + len) != crc) return false;
+    memcpy(payload, rec + 2, len);
+    return true;
+  }
+
+  void scan() {
+    nextId_ = 1;
+    doneThrough_ = 0;
+    fileBytes_ = 0;
+    validBytes_ = 0;
+    auto f = fs_.open(path_, "r");
+    if (!f) return;
+    fileBytes_ = (uint32_t)f.size();
+    uint8_t type, len;
+    uint8_t payload[JOURNAL_SCORE_BYTES];
+    while (readRecord(f, type, payload, len)) {
+      uint32_t id = journalReadU32(payload);
+      if (type == JOURNAL_SCORE) nextId_ = id + 1;
+      else doneThrough_ = id;
+      // A 'D' record carries the last id after a rewrite with nothing pending
+      if (nextId_ <= doneThrough_) nextId_ = doneThrough_ + 1;
+      validBytes_ += len + 4u;
+    }
+    f.close();
+  }
+
+  bool appendRecord(uint8_t type, const uint8_t* payload, uint8_t len) {
+    uint8_t rec[JOURNAL_RECORD_MAX];
+    uint16_t n = encode(rec, type, payload, len);
+    auto f = fs_.open(path_, "a");
+    if (!f) return false;
+    bool ok = f.write(rec, n) == n;
+    f.close();
+    if (ok) {
+      fileBytes_ += n;
+      validBytes_ = fileBytes_;
+      return true;
+    }
+    // Part of the record may have reached the file; later appends must not
+    // land behind it, where begin() would never read them.
+    ready_ = rewrite();
+    return false;
+  }
+
+  // Writes the 'D' record and the pending scores to tmpPath_, then renames
+  // it over path_.
+  bool rewrite() {
+    auto out = fs_.open(tmpPath_, "w");
+    if (!out) return false;
+    uint8_t rec[JOURNAL_RECORD_MAX];
+    uint8_t p[JOURNAL_SCORE_BYTES];
+    journalWriteU32(p, pending() ? doneThrough_ : nextId_ - 1);
+    uint16_t n = encode(rec, JOURNAL_DONE, p, JOURNAL_DONE_BYTES);
+    bool ok = out.write(rec, n) == n;
+    uint32_t written = n;
+
+    auto in = fs_.open(path_, "r");
+    uint8_t type, len;
+    while (ok && in && readRecord(in, type, p, len)) {
+      if (type != JOURNAL_SCORE || journalReadU32(p) <= doneThrough_) continue;
+      n = encode(rec, type, p, len);
+      ok = out.write(rec, n) == n;
+      written += n;
+    }
+    if (in) in.close();
+    out.close();
+    if (!ok || !fs_.rename(tmpPath_, path_)) {
+      fs_.remove(tmpPath_);
+      return false;
+    }
+    fileBytes_ = validBytes_ = written;
+    return true;
+  }
+
+  FsT& fs_;
+  const char* path_;
+  const char* tmpPath_;
+  bool ready_ = false;
+  uint32_t nextId_ = 1;
+  uint32_t doneThrough_ = 0;
+  uint32_t fileBytes_ = 0;
+  uint32_t validBytes_ = 0;
+  uint32_t droppedBytes_ = 0;
+};
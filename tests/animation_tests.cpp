@@ -0,0 +1,327 @@
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AnimEncoder.h"
+#include "Animation.h"
+#include "FrameEncoder.h"
+#include "ImageDecode.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+using pixelgrid::AnimFrame;
+using pixelgrid::HostFrame;
+
+const uint16_t PIXELS = HostFrame::W * HostFrame::H;
+
+// Generated with Python's zlib: a 10x20 RGB gradient (r = x * 25, g = y * 12,
+// b = (x + y) * 8) with row filters 0..4 in turn, compressed with dynamic
+// Huffman codes; a 5x3 2-bit palette image (index (x + y) % 4, tRNS 255/128)
+// with fixed codes; and a 4x3 two-frame GIF whose second frame is a 2x2 patch
+// at (1,1) with transparent index 0.
+const uint8_t PNG_RGB_10X20[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x14, 0x08, 0x02, 0x00, 0x00, 0x00, 0x3B, 0x8C, 0x3B,
+    0x01, 0x00, 0x00, 0x00, 0xBA, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0xA5, 0xCE, 0xA1, 0x0E, 0x82,
+    0x60, 0x14, 0xC5, 0xF1, 0x83, 0x3A, 0x47, 0xD0, 0x8D, 0x08, 0xCD, 0x60, 0x20, 0x32, 0x82, 0x23,
+    0xDC, 0x40, 0x64, 0xC3, 0x40, 0x30, 0x10, 0x09, 0x04, 0x22, 0x33, 0xDD, 0xC2, 0x46, 0x30, 0x10,
+    0x49, 0x8C, 0x68, 0xB4, 0x61, 0xB8, 0xC1, 0x48, 0xFC, 0x5E, 0x83, 0x37, 0x11, 0x1F, 0x00, 0x82,
+    0xDF, 0xF6, 0x6F, 0xE7, 0x84, 0x1F, 0x00, 0x38, 0x30, 0x7D, 0x58, 0x31, 0xEC, 0x1C, 0xA7, 0x0A,
+    0x6E, 0x07, 0x6F, 0x40, 0xA0, 0x10, 0x4E, 0x88, 0x0C, 0x1C, 0xCC, 0x79, 0x5E, 0x6A, 0x33, 0xCF,
+    0x2B, 0x6D, 0x61, 0x5B, 0xC7, 0xBD, 0xB9, 0xD4, 0xEE, 0xF7, 0xC2, 0x4A, 0xE4, 0x3A, 0xE4, 0xF9,
+    0x14, 0xC4, 0x14, 0xE6, 0x14, 0x55, 0x94, 0x74, 0x94, 0x0E, 0x94, 0x29, 0x2A, 0x26, 0x2A, 0x0D,
+    0x44, 0x9E, 0x0E, 0xED, 0x72, 0xD6, 0xA1, 0x71, 0xE2, 0x70, 0xEA, 0x73, 0x16, 0x73, 0x91, 0x73,
+    0x59, 0x31, 0x77, 0x5C, 0x0F, 0xDC, 0x28, 0x6E, 0x27, 0xEE, 0x0D, 0x3C, 0x52, 0x1D, 0xDA, 0x2D,
+    0xD0, 0xA1, 0x09, 0x3B, 0x52, 0xFB, 0xD2, 0xC4, 0xD2, 0xE6, 0xD2, 0x57, 0xF2, 0xEC, 0xE4, 0x35,
+    0xC8, 0x5B, 0xC9, 0x67, 0x92, 0xD1, 0xC0, 0x58, 0xEB, 0xD0, 0xEE, 0xD7, 0xFF, 0x69, 0x5F, 0x13,
+    0x9B, 0x40, 0x41, 0x20, 0xE1, 0xF5, 0x71, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE,
+    0x42, 0x60, 0x82,
+};
+const uint8_t PNG_PALETTE_2BIT[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x03, 0x02, 0x03, 0x00, 0x00, 0x00, 0x26, 0x58, 0x2D,
+    0x6B, 0x00, 0x00, 0x00, 0x0C, 0x50, 0x4C, 0x54, 0x45, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00,
+    0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFB, 0x00, 0x60, 0xF6, 0x00, 0x00, 0x00, 0x02, 0x74, 0x52, 0x4E,
+    0x53, 0xFF, 0x80, 0x08, 0x0F, 0xB3, 0x6A, 0x00, 0x00, 0x00, 0x11, 0x49, 0x44, 0x41, 0x54, 0x78,
+    0x01, 0x63, 0x90, 0x66, 0x60, 0xCC, 0xB9, 0xC2, 0xE4, 0xEA, 0x00, 0x00, 0x07, 0x23, 0x01, 0xE4,
+    0x9B, 0x35, 0x6B, 0x58, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+const uint8_t GIF_TWO_FRAMES[] = {
+    0x47, 0x49, 0x46, 0x38, 0x39, 0x61, 0x04, 0x00, 0x03, 0x00, 0x81, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x21, 0xF9, 0x04, 0x04, 0x14, 0x00, 0x00,
+    0x00, 0x2C, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x03, 0x00, 0x00, 0x02, 0x05, 0x4C, 0x24, 0x86,
+    0xC3, 0x53, 0x00, 0x21, 0xF9, 0x04, 0x01, 0x00, 0x00, 0x00, 0x00, 0x2C, 0x01, 0x00, 0x01, 0x00,
+    0x02, 0x00, 0x02, 0x00, 0x00, 0x02, 0x03, 0xC4, 0x04, 0x05, 0x00, 0x3B,
+};
+
+// A block of colour sliding down a dark board
+HostFrame movingFrame(uint8_t step) {
+  HostFrame f;
+  f.fill(6, 6, 12);
+  for (uint8_t x = 2; x < 6; ++x) f.set(x, static_cast<uint8_t>(step % HostFrame::H), 220, static_cast<uint8_t>(step * 9), 0);
+  return f;
+}
+
+HostFrame noiseFrame(uint32_t seed) {
+  HostFrame f;
+  for (uint16_t i = 0; i < PIXELS * 3; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    f.grb[i] = static_cast<uint8_t>(seed >> 16);
+  }
+  return f;
+}
+
+bool sameCells(const uint8_t* grb, const HostFrame& f) { return std::memcmp(grb, f.grb, PIXELS * 3) == 0; }
+
+AnimFrame animFrame(const HostFrame& f, uint16_t ms) {
+  AnimFrame a;
+  a.frame = f;
+  a.durationMs = ms;
+  return a;
+}
+
+void testClipPlaysEveryFrameOnTime() {
+  // Keyframe, deltas, a repeat (merged) and incompressible noise (raw)
+  std::vector<AnimFrame> frames = {animFrame(movingFrame(0), 100), animFrame(movingFrame(1), 50),
+                                   animFrame(movingFrame(1), 30),  animFrame(noiseFrame(7), 40),
+                                   animFrame(movingFrame(2), 60)};
+  std::vector<uint8_t> clip = pixelgrid::encodeAnimation(frames, false);
+
+  pixelgrid::AnimInfo info;
+  ASSERT_TRUE(pixelgrid::parseAnimHeader(clip.data(), clip.size(), info));
+  ASSERT_EQ_U32(info.frameCount, 4);
+  ASSERT_EQ_U32(info.width * info.height, PIXELS);
+  ASSERT_EQ_U32(info.maxPayload, 1 + PIXELS * 3);  // the noise frame is raw
+
+  AnimMemorySource mem;
+  mem.begin(clip.data(), static_cast<uint32_t>(clip.size()));
+  static uint8_t frame[PIXELS * 3];
+  static AnimPlayer player;
+  player.begin(mem.source(), frame, PIXELS);
+
+  const HostFrame expect[4] = {movingFrame(0), movingFrame(1), noiseFrame(7), movingFrame(2)};
+  const uint32_t at[4] = {1000, 1100, 1180, 1220};
+  for (int i = 0; i < 4; ++i) {
+    if (i > 0) ASSERT_TRUE(!player.update(at[i] - 1));
+    ASSERT_TRUE(player.update(at[i]));
+    ASSERT_TRUE(sameCells(frame, expect[i]));
+  }
+  ASSERT_TRUE(!player.update(1279));
+  ASSERT_TRUE(!player.update(1280));
+  ASSERT_EQ_U32(player.status, ANIM_DONE);
+  ASSERT_EQ_U32(player.framesShown, 4);
+  ASSERT_EQ_U32(player.framesLate, 0);
+  ASSERT_TRUE(sameCells(frame, expect[3]));  // the last frame stays up
+}
+
+void testStreamedClipUsesFixedBuffer() {
+  // 600 frames: far more than the stream buffer or the player could hold
+  std::vector<AnimFrame> frames;
+  for (uint16_t i = 0; i < 600; ++i) frames.push_back(animFrame(movingFrame(static_cast<uint8_t>(i)), 20));
+  std::vector<uint8_t> clip = pixelgrid::encodeAnimation(frames, true);
+  ASSERT_TRUE(clip.size() > 4 * ANIM_STREAM_BYTES);
+  ASSERT_TRUE(sizeof(AnimPlayer) < ANIM_PAYLOAD_MAX + 128);
+
+  static AnimStreamRing ring;
+  static AnimPlayer player;
+  static uint8_t frame[PIXELS * 3];
+  ring.reset();
+  player.begin(ring.source(), frame, PIXELS);
+
+  // Feed 37-byte pieces, only as far as the ring has room; for 1.5 s the
+  // feed stops, long enough for the player to use up the ring
+  size_t sent = 0;
+  uint32_t now = 0;
+  uint32_t shown = 0;
+  bool allMatch = true;
+  while (shown < 600 && now < 100000) {
+    bool pause = now >= 2000 && now < 3500;
+    while (!pause && sent < clip.size()) {
+      size_t n = std::min<size_t>(37, clip.size() - sent);
+      if (!ring.push(clip.data() + sent, static_cast<uint16_t>(n))) break;
+      sent += n;
+    }
+    if (player.update(now)) {
+      allMatch = allMatch && sameCells(frame, movingFrame(static_cast<uint8_t>(shown)));
+      ++shown;
+    }
+    ++now;
+  }
+  ASSERT_EQ_U32(shown, 600);
+  ASSERT_TRUE(allMatch);
+  ASSERT_EQ_U32(ring.consumed, static_cast<uint32_t>(clip.size()));
+  ASSERT_TRUE(player.framesLate > 0);
+
+  // A stream can't rewind, so even a looping clip ends
+  ASSERT_TRUE(!player.update(now + 100));
+  ASSERT_EQ_U32(player.status, ANIM_DONE);
+}
+
+void testLoopingClipStartsOver() {
+  std::vector<AnimFrame> frames = {animFrame(movingFrame(3), 10), animFrame(movingFrame(4), 10)};
+  std::vector<uint8_t> clip = pixelgrid::encodeAnimation(frames, true);
+
+  AnimMemorySource mem;
+  mem.begin(clip.data(), static_cast<uint32_t>(clip.size()));
+  static AnimPlayer player;
+  static uint8_t frame[PIXELS * 3];
+  player.begin(mem.source(), frame, PIXELS);
+
+  for (uint32_t pass = 0; pass < 3; ++pass) {
+    ASSERT_TRUE(player.update(pass * 20));
+    ASSERT_TRUE(sameCells(frame, movingFrame(3)));
+    ASSERT_TRUE(player.update(pass * 20 + 10));
+    ASSERT_TRUE(sameCells(frame, movingFrame(4)));
+  }
+  ASSERT_EQ_U32(player.status, ANIM_PLAYING);
+}
+
+AnimError playError(std::vector<uint8_t> clip, uint16_t pixels = PIXELS) {
+  AnimMemorySource mem;
+  mem.begin(clip.data(), static_cast<uint32_t>(clip.size()));
+  static AnimPlayer player;
+  static uint8_t frame[HOST_FRAME_BYTES];
+  player.begin(mem.source(), frame, pixels);
+  for (uint32_t t = 0; t < 1000 && player.playing(); t += 10) player.update(t);
+  return player.status == ANIM_ERROR ? player.error : ANIM_ERR_NONE;
+}
+
+void testMalformedClipsRejected() {
+  std::vector<AnimFrame> frames = {animFrame(movingFrame(0), 10), animFrame(movingFrame(1), 10)};
+  const std::vector<uint8_t> good = pixelgrid::encodeAnimation(frames, false);
+  ASSERT_EQ_U32(playError(good), ANIM_ERR_NONE);
+
+  std::vector<uint8_t> clip = good;
+  clip[0] = 'X';
+  ASSERT_EQ_U32(playError(clip), ANIM_ERR_HEADER);
+
+  // A clip for a different board size
+  ASSERT_EQ_U32(playError(good, 256), ANIM_ERR_SIZE);
+
+  // Second frame's length field beyond the payload buffer
+  clip = good;
+  size_t second = ANIM_HEADER_BYTES + ANIM_FRAME_HEADER_BYTES + animReadU16(&good[ANIM_HEADER_BYTES + 2]);
+  animWriteU16(&clip[second + 2], ANIM_PAYLOAD_MAX + 1);
+  ASSERT_EQ_U32(playError(clip), ANIM_ERR_TOO_LARGE);
+
+  // The first frame may not be a delta: there is nothing to apply it to
+  std::vector<uint8_t> delta = pixelgrid::encodeFrameXorDelta(movingFrame(0).grb, movingFrame(1).grb, PIXELS);
+  clip.assign(good.begin(), good.begin() + ANIM_HEADER_BYTES);
+  clip[8] = 1;
+  clip.push_back(10);
+  clip.push_back(0);
+  clip.push_back(static_cast<uint8_t>(delta.size()));
+  clip.push_back(static_cast<uint8_t>(delta.size() >> 8));
+  clip.insert(clip.end(), delta.begin(), delta.end());
+  ASSERT_EQ_U32(playError(clip), ANIM_ERR_FRAME);
+
+  // The stream buffer takes a packet whole or not at all
+  static AnimStreamRing ring;
+  ring.reset();
+  std::vector<uint8_t> big(ANIM_STREAM_BYTES - 10, 1);
+  ASSERT_TRUE(ring.push(big.data(), static_cast<uint16_t>(big.size())));
+  ASSERT_TRUE(!ring.push(big.data(), 11));
+  ASSERT_EQ_U32(ring.space(), 10);
+}
+
+const uint8_t* pixelAt(const pixelgrid::Image& img, uint32_t x, uint32_t y) {
+  return &img.rgba[(y * img.width + x) * 4];
+}
+
+void testPngDecodes() {
+  pixelgrid::Image img;
+  std::string error;
+  ASSERT_TRUE(pixelgrid::decodePng(PNG_RGB_10X20, sizeof(PNG_RGB_10X20), img, error));
+  ASSERT_EQ_U32(img.width, 10);
+  ASSERT_EQ_U32(img.height, 20);
+  bool allMatch = true;
+  for (uint32_t y = 0; y < 20; ++y) {
+    for (uint32_t x = 0; x < 10; ++x) {
+      const uint8_t* p = pixelAt(img, x, y);
+      allMatch = allMatch && p[0] == x * 25 && p[1] == y * 12 && p[2] == (x + y) * 8 && p[3] == 255;
+    }
+  }
+  ASSERT_TRUE(allMatch);
+
+  // At the board's size every pixel lands on its own cell
+  HostFrame f = pixelgrid::imageToFrame(img);
+  const uint8_t* cell = f.grb + HostFrame::index(3, 17) * 3;
+  ASSERT_EQ_U32(cell[0], 17 * 12);
+  ASSERT_EQ_U32(cell[1], 3 * 25);
+  ASSERT_EQ_U32(cell[2], 20 * 8);
+
+  ASSERT_TRUE(pixelgrid::decodePng(PNG_PALETTE_2BIT, sizeof(PNG_PALETTE_2BIT), img, error));
+  ASSERT_EQ_U32(img.width, 5);
+  ASSERT_EQ_U32(img.height, 3);
+  const uint8_t palette[4][4] = {{255, 0, 0, 255}, {0, 255, 0, 128}, {0, 0, 255, 255}, {255, 255, 255, 255}};
+  allMatch = true;
+  for (uint32_t y = 0; y < 3; ++y) {
+    for (uint32_t x = 0; x < 5; ++x) allMatch = allMatch && std::memcmp(pixelAt(img, x, y), palette[(x + y) % 4], 4) == 0;
+  }
+  ASSERT_TRUE(allMatch);
+
+  // A zlib stream with a stored block, then a corrupted checksum
+  const uint8_t stored[] = {0x78, 0x01, 0x01, 0x03, 0x00, 0xFC, 0xFF, 'a', 'b', 'c', 0x02, 0x4D, 0x01, 0x27};
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(pixelgrid::zlibInflate(stored, sizeof(stored), out));
+  ASSERT_TRUE(out == std::vector<uint8_t>({'a', 'b', 'c'}));
+  uint8_t bad[sizeof(stored)];
+  std::memcpy(bad, stored, sizeof(stored));
+  bad[sizeof(bad) - 1] ^= 1;
+  ASSERT_TRUE(!pixelgrid::zlibInflate(bad, sizeof(bad), out));
+
+  std::vector<uint8_t> truncated(PNG_RGB_10X20, PNG_RGB_10X20 + sizeof(PNG_RGB_10X20) / 2);
+  ASSERT_TRUE(!pixelgrid::decodePng(truncated.data(), truncated.size(), img, error));
+}
+
+void testGifFramesAreComposed() {
+  std::vector<pixelgrid::ImageFrame> frames;
+  std::string error;
+  ASSERT_TRUE(pixelgrid::decodeGif(GIF_TWO_FRAMES, sizeof(GIF_TWO_FRAMES), frames, error));
+  ASSERT_EQ_U32(frames.size(), 2);
+  if (frames.size() != 2) return;
+  ASSERT_EQ_U32(frames[0].delayMs, 200);
+  ASSERT_EQ_U32(frames[1].delayMs, 100);  // a 0 delay plays at 100 ms
+
+  const uint8_t red[4] = {255, 0, 0, 255}, green[4] = {0, 255, 0, 255}, blue[4] = {0, 0, 255, 255};
+  const pixelgrid::Image& a = frames[0].image;
+  ASSERT_EQ_U32(a.width, 4);
+  ASSERT_EQ_U32(a.height, 3);
+  ASSERT_TRUE(std::memcmp(pixelAt(a, 0, 0), red, 4) == 0);
+  ASSERT_TRUE(std::memcmp(pixelAt(a, 3, 1), green, 4) == 0);
+  ASSERT_TRUE(std::memcmp(pixelAt(a, 2, 2), blue, 4) == 0);
+
+  // The patch at (1,1): transparent pixels keep the first frame
+  const pixelgrid::Image& b = frames[1].image;
+  ASSERT_TRUE(std::memcmp(pixelAt(b, 1, 1), red, 4) == 0);
+  ASSERT_TRUE(std::memcmp(pixelAt(b, 2, 1), blue, 4) == 0);
+  ASSERT_TRUE(std::memcmp(pixelAt(b, 1, 2), green, 4) == 0);
+  ASSERT_TRUE(std::memcmp(pixelAt(b, 2, 2), blue, 4) == 0);
+  ASSERT_TRUE(std::memcmp(pixelAt(b, 0, 0), red, 4) == 0);
+
+  const uint8_t notGif[] = {'G', 'I', 'F', '8', '9', 'b'};
+  ASSERT_TRUE(!pixelgrid::decodeGif(notGif, sizeof(notGif), frames, error));
+}
+
+}  // namespace
+
+int main() {
+  testClipPlaysEveryFrameOnTime();
+  testStreamedClipUsesFixedBuffer();
+  testLoopingClipStartsOver();
+  testMalformedClipsRejected();
+  testPngDecodes();
+  testGifFramesAreComposed();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
@@ -0,0 +1,198 @@
+// The arcade image's framework (Arcade.h) with both games linked in, as
+// Games/Arcade builds them. Includes Breakout's headers to reach its game;
+// Tetris is only driven through the Game interface.
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include <PixelGridCore.h>
+#include <Breakout/Game.h>
+#include "support/TestAssert.h"
+
+namespace {
+
+const uint8_t BTN1 = 0x01;
+const uint8_t JOY_LEFT = 1u << CABINET_LINE_JOY_LEFT;
+const uint8_t JOY_RIGHT = 1u << CABINET_LINE_JOY_RIGHT;
+
+// The Arcade sketch's cabinet
+Adafruit_NeoPixel strip(256, 5, NEO_GRB + NEO_KHZ800);
+GameInput input;
+Cabinet cabinet;
+
+void beginCabinet() {
+  static bool begun = false;
+  if (begun) return;
+  static const uint8_t pins[] = { 3, 4, 10, 6, 9, 7, 8, 12 };
+  input.begin(pins, sizeof(pins), 18);
+  cabinet.begin(strip, input, 10, 20);
+  begun = true;
+}
+
+// Holds the lines down (then lets them go) long enough to debounce, then
+// runs passes of the arcade until one is a frame: the press is seen once
+uint32_t gameMs = 1000;
+
+void frame(Arcade& arcade) {
+  Game* game = arcade.current();
+  uint16_t period = arcade.state == ARCADE_PLAYING ? game->frameMs() : ARCADE_MENU_FRAME_MS;
+  gameMs += period;
+  arcade.loop(gameMs);
+}
+
+void press(Arcade& arcade, uint8_t lines) {
+  input.edge(lines, micros());
+  delay(25);
+  frame(arcade);
+  input.edge(0, micros());
+  delay(25);
+  frame(arcade);
+}
+
+// ARC-001
+void testRegistryInNameOrder() {
+  ASSERT_EQ_U32(GameRegistry::count(), 2);
+  ASSERT_TRUE(std::strcmp(GameRegistry::at(0)->name(), "BREAKOUT") == 0);
+  ASSERT_TRUE(std::strcmp(GameRegistry::at(1)->name(), "TETRIS") == 0);
+  ASSERT_TRUE(GameRegistry::at(2) == nullptr);
+}
+
+// ARC-002
+void testFrameClockCadence() {
+  FrameClock c;
+  ASSERT_TRUE(c.due(0, 16));
+  ASSERT_TRUE(!c.due(10, 16));
+  ASSERT_TRUE(c.due(16, 16));
+  // A late pass keeps the cadence: the next frame is still at 48
+  ASSERT_TRUE(c.due(33, 16));
+  ASSERT_TRUE(!c.due(47, 16));
+  ASSERT_TRUE(c.due(48, 16));
+  // A whole period behind: one frame, then the cadence starts again
+  ASSERT_TRUE(c.due(200, 16));
+  ASSERT_TRUE(!c.due(201, 16));
+  ASSERT_TRUE(!c.due(215, 16));
+  ASSERT_TRUE(c.due(216, 16));
+  // Across the millis() wrap
+  c.restart();
+  ASSERT_TRUE(c.due(0xFFFFFFF8u, 16));
+  ASSERT_TRUE(!c.due(0xFFFFFFFFu, 16));
+  ASSERT_TRUE(c.due(8, 16));
+}
+
+// ARC-003
+void testMenuPicksAndStarts() {
+  beginCabinet();
+  Arcade arcade;
+  arcade.begin(cabinet, gameMs);
+  ASSERT_TRUE(arcade.state == ARCADE_MENU);
+  ASSERT_EQ_U32(arcade.selected, 0);
+
+  press(arcade, JOY_RIGHT);
+  ASSERT_EQ_U32(arcade.selected, 1);
+  press(arcade, JOY_RIGHT);
+  ASSERT_EQ_U32(arcade.selected, 0); // wraps
+  press(arcade, JOY_LEFT);
+  ASSERT_EQ_U32(arcade.selected, 1);
+  ASSERT_TRUE(arcade.state == ARCADE_MENU);
+
+  press(arcade, BTN1);
+  ASSERT_TRUE(arcade.state == ARCADE_PLAYING);
+  ASSERT_TRUE(std::strcmp(arcade.current()->name(), "TETRIS") == 0);
+  ASSERT_TRUE(!arcade.current()->finished());
+}
+
+// ARC-004
+void testFinishedGameBackToMenu() {
+  beginCabinet();
+  Arcade arcade;
+  arcade.begin(cabinet, gameMs);
+  press(arcade, BTN1);
+  ASSERT_TRUE(arcade.state == ARCADE_PLAYING);
+  ASSERT_TRUE(std::strcmp(arcade.current()->name(), "BREAKOUT") == 0);
+
+  // The button that started the game did not serve
+  ASSERT_TRUE(game.ballStuck);
+  press(arcade, BTN1);
+  ASSERT_TRUE(!game.ballStuck);
+
+  // Game over stays on the game until a button
+  game.gameOver = true;
+  frame(arcade);
+  frame(arcade);
+  ASSERT_TRUE(arcade.state == ARCADE_PLAYING);
+  press(arcade, BTN1);
+  ASSERT_TRUE(arcade.state == ARCADE_MENU);
+  ASSERT_EQ_U32(arcade.selected, 0);
+  // The menu shows a fresh game as the preview
+  ASSERT_TRUE(!game.gameOver);
+}
+
+// ARC-005
+void testResumeKeepsTheGame() {
+  beginCabinet();
+  Arcade arcade;
+  arcade.begin(cabinet, gameMs);
+  press(arcade, BTN1);
+  game.score = 120;
+  arcade.resume(gameMs);
+  ASSERT_TRUE(arcade.state == ARCADE_PLAYING);
+  ASSERT_EQ_U32(game.score, 120);
+  frame(arcade);
+  ASSERT_EQ_U32(game.score, 120);
+}
+
+// ARC-006
+void testSerializeRoundTrips() {
+  beginCabinet();
+  static uint8_t saved[2048];
+  static uint8_t again[2048];
+  for (uint8_t i = 0; i < GameRegistry::count(); ++i) {
+    Game* g = GameRegistry::at(i);
+    g->begin(cabinet);
+    g->reset(0);
+    for (uint32_t t = 16; t < 2000; t += 16) g->update(t);
+
+    uint16_t n = g->serialize(saved, sizeof(saved));
+    ASSERT_TRUE(n > 2);
+    ASSERT_EQ_U32(g->serialize(saved, (uint16_t)(n - 1)), 0); // too small
+
+    g->reset(5000);
+    ASSERT_TRUE(g->deserialize(saved, n));
+    ASSERT_EQ_U32(g->serialize(again, sizeof(again)), n);
+    ASSERT_TRUE(std::memcmp(saved, again, n) == 0);
+
+    // Anything but this game's own snapshot is refused
+    ASSERT_TRUE(!g->deserialize(saved, (uint16_t)(n - 1)));
+    saved[0] ^= 1;
+    ASSERT_TRUE(!g->deserialize(saved, n));
+  }
+
+  // Breakout's state comes back field for field
+  Game* breakout = GameRegistry::at(0);
+  breakout->reset(0);
+  game.score = 340;
+  game.paddleX = 6;
+  uint16_t n = breakout->serialize(saved, sizeof(saved));
+  breakout->reset(0);
+  ASSERT_TRUE(breakout->deserialize(saved, n));
+  ASSERT_EQ_U32(game.score, 340);
+  ASSERT_EQ_U32((uint32_t)game.paddleX, 6);
+}
+
+}  // namespace
+
+int main() {
+  testRegistryInNameOrder();
+  testFrameClockCadence();
+  testMenuPicksAndStarts();
+  testFinishedGameBackToMenu();
+  testResumeKeepsTheGame();
+  testSerializeRoundTrips();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
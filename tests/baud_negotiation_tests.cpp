@@ -0,0 +1,147 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+
+#include "BaudNegotiation.h"
+#include "HostBaud.h"
+#include "support/PtyDevice.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+bool waitFor(const std::atomic<uint32_t>& v, uint32_t want, int ms) {
+  for (int i = 0; i < ms; ++i) {
+    if (v == want) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return v == want;
+}
+
+}  // namespace
+
+using ptydevice::Link;
+
+void testSwitchConfirmFallbackUnit() {
+  HostBaudSwitch sw;
+  sw.reset(0);
+  uint8_t ack[HOST_BAUD_ACK_BYTES];
+
+  ASSERT_EQ_U32(sw.request(921600, 100, ack), 921600);
+  ASSERT_EQ_U32(hostReadU32(ack), 921600);
+  ASSERT_EQ_U32(ack[4], HOST_BAUD_SWITCHING);
+
+  // No PBBC in time: back to the old rate
+  ASSERT_EQ_U32(sw.poll(100 + HOST_BAUD_CONFIRM_MS - 1), 0);
+  ASSERT_EQ_U32(sw.poll(100 + HOST_BAUD_CONFIRM_MS), HOST_DEFAULT_BAUD);
+  ASSERT_EQ_U32(sw.current, HOST_DEFAULT_BAUD);
+
+  // Confirmed rate sticks while packets keep arriving
+  sw.request(2000000, 1000, ack);
+  sw.confirm(ack);
+  ASSERT_EQ_U32(ack[4], HOST_BAUD_CONFIRMED);
+  sw.noteActivity(1000 + HOST_BAUD_IDLE_MS - 1);
+  ASSERT_EQ_U32(sw.poll(1000 + HOST_BAUD_IDLE_MS), 0);
+  ASSERT_EQ_U32(sw.current, 2000000);
+
+  // ...and drops to the default once the link goes quiet
+  ASSERT_EQ_U32(sw.poll(1000 + 2 * HOST_BAUD_IDLE_MS), HOST_DEFAULT_BAUD);
+
+  ASSERT_EQ_U32(sw.request(12345, 2000, ack), 0);
+  ASSERT_EQ_U32(ack[4], HOST_BAUD_REJECTED);
+  ASSERT_EQ_U32(hostReadU32(ack), HOST_DEFAULT_BAUD);
+}
+
+void testNegotiateOverPty() {
+  Link link;
+  pixelgrid::DeviceStreamParser rx;
+  ASSERT_TRUE(link.open());
+  link.start();
+
+  pixelgrid::BaudResult r = pixelgrid::negotiateBaud(link.host, rx, 921600);
+  ASSERT_TRUE(r == pixelgrid::BaudResult::Switched);
+  ASSERT_EQ_U32(link.host.baud(), 921600);
+  ASSERT_EQ_U32(link.device.lineBaud, 921600);
+
+  // The confirmed rate survives past the confirmation window
+  std::this_thread::sleep_for(std::chrono::milliseconds(HOST_BAUD_CONFIRM_MS + 100));
+  ASSERT_EQ_U32(link.device.lineBaud, 921600);
+
+  r = pixelgrid::negotiateBaud(link.host, rx, 2000000);
+  ASSERT_TRUE(r == pixelgrid::BaudResult::Switched);
+  ASSERT_EQ_U32(link.host.baud(), 2000000);
+}
+
+void testUnsupportedRateRejected() {
+  Link link;
+  pixelgrid::DeviceStreamParser rx;
+  ASSERT_TRUE(link.open());
+  link.start();
+
+  pixelgrid::BaudResult r = pixelgrid::negotiateBaud(link.host, rx, 57600);
+  ASSERT_TRUE(r == pixelgrid::BaudResult::Rejected);
+  ASSERT_EQ_U32(link.host.baud(), HOST_DEFAULT_BAUD);
+  ASSERT_EQ_U32(link.device.lineBaud, HOST_DEFAULT_BAUD);
+}
+
+void testSilentDeviceTimesOut() {
+  Link link;
+  pixelgrid::DeviceStreamParser rx;
+  ASSERT_TRUE(link.open());
+  link.device.answer = false;
+  link.start();
+
+  auto start = std::chrono::steady_clock::now();
+  pixelgrid::BaudResult r = pixelgrid::negotiateBaud(link.host, rx, 921600, 100);
+  auto took = std::chrono::steady_clock::now() - start;
+
+  ASSERT_TRUE(r == pixelgrid::BaudResult::NoAnswer);
+  ASSERT_EQ_U32(link.host.baud(), HOST_DEFAULT_BAUD);
+  ASSERT_TRUE(took < std::chrono::milliseconds(1000));
+}
+
+void testLostConfirmFallsBackOnBothSides() {
+  Link link;
+  pixelgrid::DeviceStreamParser rx;
+  ASSERT_TRUE(link.open());
+  link.device.ignoreConfirm = true;
+  link.start();
+
+  pixelgrid::BaudResult r = pixelgrid::negotiateBaud(link.host, rx, 921600);
+  ASSERT_TRUE(r == pixelgrid::BaudResult::FellBack);
+  ASSERT_EQ_U32(link.host.baud(), HOST_DEFAULT_BAUD);
+  ASSERT_TRUE(waitFor(link.device.lineBaud, HOST_DEFAULT_BAUD, static_cast<int>(HOST_BAUD_CONFIRM_MS)));
+}
+
+void testLostConfirmAckRetried() {
+  Link link;
+  pixelgrid::DeviceStreamParser rx;
+  ASSERT_TRUE(link.open());
+  link.device.dropConfirmAcks = 1;
+  link.start();
+
+  // The device took the PBBC, so the host must not go back without it
+  pixelgrid::BaudResult r = pixelgrid::negotiateBaud(link.host, rx, 921600, 100);
+  ASSERT_TRUE(r == pixelgrid::BaudResult::Switched);
+  ASSERT_EQ_U32(link.host.baud(), 921600);
+  std::this_thread::sleep_for(std::chrono::milliseconds(HOST_BAUD_CONFIRM_MS + 100));
+  ASSERT_EQ_U32(link.device.lineBaud, 921600);
+}
+
+int main() {
+  testSwitchConfirmFallbackUnit();
+  testNegotiateOverPty();
+  testUnsupportedRateRejected();
+  testSilentDeviceTimesOut();
+  testLostConfirmFallsBackOnBothSides();
+  testLostConfirmAckRetried();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
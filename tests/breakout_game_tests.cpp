@@ -0,0 +1,281 @@
+#include <cstdio>
+#include <cstdint>
+
+#include "Game.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+// A served game with no bricks and no balls; tests add what they need
+void emptyField(BreakoutGame& game) {
+  game.seed(1);
+  game.reset(0);
+  for (uint8_t y = 0; y < BRICK_H; ++y) game.brickRows[y] = 0;
+  game.balls.clear();
+  game.ballStuck = false;
+}
+
+int16_t cells(float c) {
+  return static_cast<int16_t>(c * BALL_ONE);
+}
+
+int16_t cellOf(int16_t q) {
+  return static_cast<int16_t>(q >> BALL_FRAC_BITS);
+}
+
+}  // namespace
+
+void testBrickDropShiftsRows() {
+  BreakoutGame game{};
+  game.seed(1);
+  game.reset(0);
+  uint8_t topWheel = game.brickRowWheel[BRICK_TOP];
+
+  game.brickDropTick();
+
+  ASSERT_TRUE(!game.gameOver);
+  ASSERT_EQ_I32(game.brickRows[INITIAL_FILLED_ROWS], BRICK_ROW_FULL);
+  ASSERT_EQ_I32(game.brickRows[INITIAL_FILLED_ROWS + 1], 0);
+  ASSERT_EQ_I32(game.brickRowWheel[BRICK_TOP + 1], topWheel);
+  ASSERT_EQ_I32(game.brickRows[BRICK_TOP], BRICK_ROW_FULL);
+  ASSERT_EQ_I32(game.brickRowWheel[BRICK_TOP], (uint8_t)(INITIAL_FILLED_ROWS * COLOR_STEP));
+}
+
+void testBrickDropIntoPaddleLaneEndsGame() {
+  BreakoutGame game{};
+  emptyField(game);
+  game.brickRows[BRICK_BOTTOM] = 0x001;
+  game.brickRows[BRICK_TOP] = 0x200;
+
+  game.brickDropTick();
+
+  ASSERT_TRUE(game.gameOver);
+  ASSERT_EQ_I32(game.brickRows[BRICK_TOP], 0x200);
+  ASSERT_EQ_I32(game.brickRows[BRICK_BOTTOM], 0x001);
+}
+
+void testBrickDropFollowsUpdateTime() {
+  BreakoutGame game{};
+  game.seed(1);
+  game.reset(1000);
+  game.brickDropMs = 500;
+
+  game.update(1499);
+  ASSERT_EQ_I32(game.brickRows[INITIAL_FILLED_ROWS], 0);
+  game.update(1500);
+  ASSERT_EQ_I32(game.brickRows[INITIAL_FILLED_ROWS], BRICK_ROW_FULL);
+  ASSERT_EQ_I32(game.tBrickDrop, 1500);
+}
+
+void testBallBouncesOffSideWall() {
+  BreakoutGame game{};
+  emptyField(game);
+  game.balls.add(cells(0.1f), cells(10.5f), -40, -40);
+
+  game.stepFrame();
+
+  ASSERT_EQ_I32(game.balls.vx[0], 40);
+  ASSERT_EQ_I32(game.balls.vy[0], -40);
+  ASSERT_EQ_I32(cellOf(game.balls.x[0]), 0);
+  ASSERT_TRUE(game.balls.x[0] >= 0);
+}
+
+void testBallBreaksBrickAndReflects() {
+  BreakoutGame game{};
+  emptyField(game);
+  game.brickRows[5] = 1u << 4;
+  game.balls.add(cells(4.5f), cells(6.1f), 0, -40);
+
+  game.stepFrame();
+
+  ASSERT_EQ_I32(game.brickRows[5], 0);
+  ASSERT_EQ_I32(game.score, 10);
+  ASSERT_EQ_I32(game.bricksHit, 1);
+  ASSERT_EQ_I32(game.balls.vy[0], 40);
+  ASSERT_EQ_I32(cellOf(game.balls.y[0]), 6);
+}
+
+void testFastBallCannotTunnel() {
+  BreakoutGame game{};
+  emptyField(game);
+  game.brickRows[5] = BRICK_ROW_FULL;
+  // Three cells a frame: a per-frame position test would jump row 5
+  game.balls.add(cells(4.5f), cells(9.5f), 100, -3 * BALL_ONE);
+
+  game.stepFrame();
+  game.stepFrame();
+
+  ASSERT_EQ_I32(game.bricksHit, 1);
+  ASSERT_TRUE(game.balls.vy[0] > 0);
+  ASSERT_TRUE(cellOf(game.balls.y[0]) >= 6);
+  ASSERT_EQ_I32(game.brickRows[5], BRICK_ROW_FULL & ~(1u << 4));
+}
+
+void testBallThroughCornerHitsDiagonalBrick() {
+  BreakoutGame game{};
+  emptyField(game);
+  game.brickRows[5] = 1u << 5;
+  // Both edges are crossed on the same step (moving up, the ball is in the
+  // next row one unit past the edge)
+  game.balls.add(cells(4.75f), (int16_t)(cells(6.25f) - 1), 64, -64);
+
+  game.stepFrame();
+
+  ASSERT_EQ_I32(game.brickRows[5], 0);
+  ASSERT_EQ_I32(game.balls.vx[0], -64);
+  ASSERT_EQ_I32(game.balls.vy[0], 64);
+}
+
+void testPaddleAngleFromHitPosition() {
+  BreakoutGame edge{};
+  emptyField(edge);
+  edge.paddleX = 3;
+  edge.balls.add(cells(3.1f), cells(18.9f), 0, 64);
+  edge.stepFrame();
+
+  BreakoutGame middle{};
+  emptyField(middle);
+  middle.paddleX = 3;
+  middle.balls.add(cells(4.4f), cells(18.9f), 0, 64);
+  middle.stepFrame();
+
+  // Left end: 60 degrees off vertical, to the left
+  ASSERT_EQ_I32(edge.balls.vx[0], -222 * BALL_SPEED / BALL_ONE);
+  ASSERT_EQ_I32(edge.balls.vy[0], -128 * BALL_SPEED / BALL_ONE);
+  // Just left of the middle: 15 degrees
+  ASSERT_EQ_I32(middle.balls.vx[0], -66 * BALL_SPEED / BALL_ONE);
+  ASSERT_EQ_I32(middle.balls.vy[0], -247 * BALL_SPEED / BALL_ONE);
+  ASSERT_EQ_I32(cellOf(edge.balls.y[0]), PADDLE_Y - 1);
+  ASSERT_TRUE(!edge.gameOver);
+}
+
+void testMissedBallEndsGame() {
+  BreakoutGame game{};
+  emptyField(game);
+  game.paddleX = 0;
+  game.balls.add(cells(8.5f), cells(18.5f), 0, 128);
+  game.balls.add(cells(1.5f), cells(10.5f), 0, 0);
+
+  for (uint8_t i = 0; i < 8; ++i) game.stepFrame();
+  // One ball left in play: not over yet
+  ASSERT_EQ_I32(game.balls.count, 1);
+  ASSERT_TRUE(!game.gameOver);
+
+  game.balls.vy[0] = 128;
+  game.paddleX = 5;
+  for (uint8_t i = 0; i < 24; ++i) game.stepFrame();
+  ASSERT_EQ_I32(game.balls.count, 0);
+  ASSERT_TRUE(game.gameOver);
+}
+
+void testSpeedUpEveryNBricks() {
+  BreakoutGame game{};
+  emptyField(game);
+  game.speedupEvery = 3;
+  game.bricksHit = 2;
+  game.brickRows[5] = 1u << 4;
+  game.balls.add(cells(4.5f), cells(6.1f), 0, 0);
+  game.balls.add(cells(1.5f), cells(12.5f), 0, 0);
+  game.aimBall(0, 0, -BALL_ONE);
+  game.aimBall(1, BALL_ONE, 0);
+
+  game.stepFrame();
+
+  ASSERT_EQ_I32(game.ballSpeed, BALL_SPEED + BALL_SPEEDUP);
+  ASSERT_EQ_I32(game.balls.vy[0], BALL_SPEED + BALL_SPEEDUP);
+  ASSERT_EQ_I32(game.balls.vx[1], BALL_SPEED + BALL_SPEEDUP);
+}
+
+void testPowerUpsApplyWhenCaught() {
+  BreakoutGame game{};
+  emptyField(game);
+  game.paddleX = 3;
+  // Crossing the field level, clear of the paddle
+  game.balls.add(cells(0.5f), cells(10.5f), 40, 0);
+  game.ballSpeed = BALL_SPEED + 30;
+
+  game.powerUps.add(cells(4.5f), cells(18.95f), 0, POWERUP_FALL, POWERUP_WIDE);
+  game.powerUps.add(cells(8.5f), cells(18.95f), 0, POWERUP_FALL, POWERUP_MULTI);
+  game.stepFrame();
+  // Wide caught, multi-ball missed the paddle but is still falling
+  ASSERT_EQ_I32(game.paddleW, PADDLE_W_WIDE);
+  ASSERT_EQ_I32(game.paddleX, 2);
+  ASSERT_EQ_I32(game.powerUps.count, 1);
+  for (uint8_t i = 0; i < 16; ++i) game.stepFrame();
+  ASSERT_EQ_I32(game.powerUps.count, 0);
+  ASSERT_EQ_I32(game.balls.count, 1);
+
+  game.powerUps.add(cells(4.5f), cells(18.95f), 0, POWERUP_FALL, POWERUP_MULTI);
+  game.powerUps.add(cells(3.5f), cells(18.95f), 0, POWERUP_FALL, POWERUP_SLOW);
+  int16_t vx = game.balls.vx[0];
+  game.stepFrame();
+  ASSERT_EQ_I32(game.balls.count, 2);
+  ASSERT_EQ_I32(game.balls.vx[1], -game.balls.vx[0]);
+  ASSERT_EQ_I32(game.ballSpeed, BALL_SPEED + 30 - BALL_SLOWDOWN);
+  ASSERT_EQ_I32(game.balls.vx[0], vx * (BALL_SPEED + 30 - BALL_SLOWDOWN) / (BALL_SPEED + 30));
+
+  for (uint16_t i = 0; i < WIDE_PADDLE_FRAMES; ++i) game.stepFrame();
+  ASSERT_EQ_I32(game.paddleW, PADDLE_W);
+  ASSERT_EQ_I32(game.widePaddleFrames, 0);
+}
+
+void testEntityPoolRemoveKeepsPacked() {
+  EntityPool<3> pool;
+  ASSERT_EQ_I32(pool.add(10, 0, 0, 0), 0);
+  ASSERT_EQ_I32(pool.add(20, 0, 0, 0), 1);
+  ASSERT_EQ_I32(pool.add(30, 0, 0, 0, 7), 2);
+  ASSERT_EQ_I32(pool.add(40, 0, 0, 0), 3);
+
+  pool.remove(0);
+
+  ASSERT_EQ_I32(pool.count, 2);
+  ASSERT_EQ_I32(pool.x[0], 30);
+  ASSERT_EQ_I32(pool.kind[0], 7);
+  ASSERT_EQ_I32(pool.x[1], 20);
+}
+
+void testSameSeedSameGame() {
+  BreakoutGame a{};
+  BreakoutGame b{};
+  a.seed(42);
+  b.seed(42);
+  a.reset(0);
+  b.reset(0);
+  a.serveBall();
+  b.serveBall();
+  for (uint32_t f = 0; f < 3000 && !a.gameOver; ++f) {
+    int8_t dx = (int8_t)((f / 40) % 3) - 1;
+    a.movePaddle(dx);
+    b.movePaddle(dx);
+    a.update(f * FRAME_MS);
+    b.update(f * FRAME_MS);
+  }
+
+  ASSERT_EQ_I32(a.score, b.score);
+  ASSERT_EQ_I32(a.balls.x[0], b.balls.x[0]);
+  ASSERT_TRUE(a.gameOver == b.gameOver);
+}
+
+int main() {
+  testBrickDropShiftsRows();
+  testBrickDropIntoPaddleLaneEndsGame();
+  testBrickDropFollowsUpdateTime();
+  testBallBouncesOffSideWall();
+  testBallBreaksBrickAndReflects();
+  testFastBallCannotTunnel();
+  testBallThroughCornerHitsDiagonalBrick();
+  testPaddleAngleFromHitPosition();
+  testMissedBallEndsGame();
+  testSpeedUpEveryNBricks();
+  testPowerUpsApplyWhenCaught();
+  testEntityPoolRemoveKeepsPacked();
+  testSameSeedSameGame();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
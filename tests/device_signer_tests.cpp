@@ -0,0 +1,164 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DeviceSigner.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+Bytes bytes(const std::string& s) { return Bytes(s.begin(), s.end()); }
+
+std::string hex(const uint8_t* d, size_t n) {
+  static const char DIGITS[] = "0123456789abcdef";
+  std::string out;
+  for (size_t i = 0; i < n; ++i) {
+    out += DIGITS[d[i] >> 4];
+    out += DIGITS[d[i] & 15];
+  }
+  return out;
+}
+
+std::string sha256Hex(const Bytes& data) {
+  uint8_t out[SHA256_BYTES];
+  mbedtls_sha256(data.data(), data.size(), out, 0);
+  return hex(out, sizeof(out));
+}
+
+std::string signHex(const Bytes& key, const Bytes& msg) {
+  DeviceSigner signer;
+  signer.begin(key.data(), key.size());
+  uint8_t mac[SHA256_BYTES];
+  if (!signer.sign(msg.data(), msg.size(), mac)) return "";
+  return hex(mac, sizeof(mac));
+}
+
+// HMAC straight from RFC 2104, one hash over each concatenation
+std::string referenceHmacHex(Bytes key, const Bytes& msg) {
+  if (key.size() > SHA256_BLOCK_BYTES) {
+    uint8_t k[SHA256_BYTES];
+    mbedtls_sha256(key.data(), key.size(), k, 0);
+    key.assign(k, k + SHA256_BYTES);
+  }
+  key.resize(SHA256_BLOCK_BYTES, 0);
+  Bytes inner, outer;
+  for (uint8_t b : key) inner.push_back(b ^ 0x36);
+  for (uint8_t b : key) outer.push_back(b ^ 0x5c);
+  inner.insert(inner.end(), msg.begin(), msg.end());
+  uint8_t digest[SHA256_BYTES];
+  mbedtls_sha256(inner.data(), inner.size(), digest, 0);
+  outer.insert(outer.end(), digest, digest + SHA256_BYTES);
+  return sha256Hex(outer);
+}
+
+// FIPS 180-2 examples
+void testSha256Vectors() {
+  ASSERT_TRUE(sha256Hex(bytes("")) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  ASSERT_TRUE(sha256Hex(bytes("abc")) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  ASSERT_TRUE(sha256Hex(bytes("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")) ==
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+  // A million 'a's, fed in uneven pieces across block boundaries
+  mbedtls_sha256_context s;
+  mbedtls_sha256_init(&s);
+  ASSERT_EQ_I32(mbedtls_sha256_starts(&s, 0), 0);
+  Bytes a(1000, 'a');
+  size_t fed = 0;
+  for (size_t step = 1; fed < 1000000; step = step % 97 + 1) {
+    size_t n = 1000000 - fed < step ? 1000000 - fed : step;
+    mbedtls_sha256_update(&s, a.data(), n);
+    fed += n;
+  }
+  uint8_t out[SHA256_BYTES];
+  mbedtls_sha256_finish(&s, out);
+  mbedtls_sha256_free(&s);
+  ASSERT_TRUE(hex(out, sizeof(out)) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+// RFC 4231 test cases 1-4, 6 and 7
+void testHmacRfc4231() {
+  ASSERT_TRUE(signHex(Bytes(20, 0x0b), bytes("Hi There")) ==
+              "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+  ASSERT_TRUE(signHex(bytes("Jefe"), bytes("what do ya want for nothing?")) ==
+              "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+  ASSERT_TRUE(signHex(Bytes(20, 0xaa), Bytes(50, 0xdd)) ==
+              "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe");
+  Bytes key4;
+  for (uint8_t i = 1; i <= 25; ++i) key4.push_back(i);
+  ASSERT_TRUE(signHex(key4, Bytes(50, 0xcd)) == "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b");
+  ASSERT_TRUE(signHex(Bytes(131, 0xaa), bytes("Test Using Larger Than Block-Size Key - Hash Key First")) ==
+              "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+  ASSERT_TRUE(signHex(Bytes(131, 0xaa),
+                      bytes("This is a test using a larger than block-size key and a larger than block-size data. "
+                            "The key needs to be hashed before being used by the HMAC algorithm.")) ==
+              "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2");
+}
+
+// Canonical score messages as NetSubmit.h signs them, checked against
+// Python's hmac module (what the score server uses)
+void testCanonicalMessages() {
+  ASSERT_TRUE(signHex(bytes("emulator"), bytes("game_code=EMU&score=1234&ts=1700000000&nonce=0123456789abcdef")) ==
+              "24dfe8c8cff8aea7828157263915fab456a45901b95d00e993fc9e77a724f41d");
+  std::string longKey;
+  for (int i = 0; i < 6; ++i) longKey += "TETRIS-secret-";
+  ASSERT_TRUE(signHex(bytes(longKey), bytes("game_code=TETRIS&score=987654&ts=1760000000&nonce=fedcba9876543210")) ==
+              "f97b105e42396f93e9a00defa3d1e666b72eb152010fa5b9763116e924115f76");
+}
+
+// Every key and message length around the block size, against the
+// reference, with one signer signing many messages
+void testMatchesReferenceHmac() {
+  std::mt19937 rng(38);
+  bool allMatch = true;
+  for (size_t keyLen : {0u, 1u, 8u, 31u, 32u, 63u, 64u, 65u, 100u, 128u, 200u}) {
+    Bytes key(keyLen);
+    for (uint8_t& b : key) b = static_cast<uint8_t>(rng());
+    DeviceSigner signer;
+    signer.begin(key.data(), key.size());
+    for (size_t msgLen = 0; msgLen <= 200; ++msgLen) {
+      Bytes msg(msgLen);
+      for (uint8_t& b : msg) b = static_cast<uint8_t>(rng());
+      uint8_t mac[SHA256_BYTES];
+      signer.sign(msg.data(), msg.size(), mac);
+      if (hex(mac, sizeof(mac)) != referenceHmacHex(key, msg)) {
+        std::printf("  key %zu bytes, message %zu bytes\n", keyLen, msgLen);
+        allMatch = false;
+      }
+    }
+  }
+  ASSERT_TRUE(allMatch);
+}
+
+void testSignerNeedsKey() {
+  DeviceSigner signer;
+  uint8_t mac[SHA256_BYTES];
+  ASSERT_TRUE(!signer.ready());
+  ASSERT_TRUE(!signer.sign(reinterpret_cast<const uint8_t*>("x"), 1, mac));
+  signer.begin("Jefe");
+  ASSERT_TRUE(signer.ready());
+  ASSERT_TRUE(signer.sign(reinterpret_cast<const uint8_t*>("what do ya want for nothing?"), 28, mac));
+  ASSERT_TRUE(hex(mac, sizeof(mac)) == "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+}
+
+}  // namespace
+
+int main() {
+  testSha256Vectors();
+  testHmacRfc4231();
+  testCanonicalMessages();
+  testMatchesReferenceHmac();
+  testSignerNeedsKey();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "FrameCodec.h"
+#include "FrameEncoder.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+const uint16_t PIXELS = 256;
+const uint16_t BYTES = PIXELS * 3;
+
+void setPixel(std::vector<uint8_t>& f, uint16_t px, uint8_t g, uint8_t r, uint8_t b) {
+  f[px * 3 + 0] = g;
+  f[px * 3 + 1] = r;
+  f[px * 3 + 2] = b;
+}
+
+// Dark background with a few coloured blocks, like a Tetris board mid-game.
+std::vector<uint8_t> typicalGameFrame(uint8_t shift) {
+  std::vector<uint8_t> f(BYTES);
+  for (uint16_t px = 0; px < PIXELS; ++px) setPixel(f, px, 6, 6, 12);
+  for (uint16_t px = 150; px < 200; ++px) setPixel(f, px, 220, 0, 220);
+  for (uint16_t i = 0; i < 4; ++i) setPixel(f, (uint16_t)(40 + shift + i * 20), 0, 220, 0);
+  return f;
+}
+
+std::vector<uint8_t> noiseFrame(uint32_t seed) {
+  std::vector<uint8_t> f(BYTES);
+  for (uint16_t i = 0; i < BYTES; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    f[i] = static_cast<uint8_t>(seed >> 16);
+  }
+  return f;
+}
+
+bool roundTrip(const std::vector<uint8_t>& payload, std::vector<uint8_t> reference, const std::vector<uint8_t>& expected) {
+  if (!decodeFrame(payload.data(), static_cast<uint16_t>(payload.size()), reference.data(), PIXELS)) return false;
+  return reference == expected;
+}
+
+}  // namespace
+
+void testRleRoundTrip() {
+  std::vector<uint8_t> frame = typicalGameFrame(0);
+  std::vector<uint8_t> payload = pixelgrid::encodeFrameRle(frame.data(), PIXELS);
+
+  ASSERT_TRUE(roundTrip(payload, std::vector<uint8_t>(BYTES), frame));
+  ASSERT_TRUE(payload.size() < 64);
+}
+
+void testXorDeltaRoundTrip() {
+  std::vector<uint8_t> prev = typicalGameFrame(0);
+  std::vector<uint8_t> frame = typicalGameFrame(1);
+  std::vector<uint8_t> payload = pixelgrid::encodeFrameXorDelta(prev.data(), frame.data(), PIXELS);
+
+  ASSERT_TRUE(roundTrip(payload, prev, frame));
+  ASSERT_TRUE(payload.size() < 48);
+}
+
+void testXorDeltaOfIdenticalFrameIsTiny() {
+  std::vector<uint8_t> frame = typicalGameFrame(3);
+  std::vector<uint8_t> payload = pixelgrid::encodeFrameXorDelta(frame.data(), frame.data(), PIXELS);
+
+  // One (255, 0) run to cross the 255-pixel skip limit, then nothing
+  ASSERT_TRUE(payload.size() <= 3);
+  ASSERT_TRUE(roundTrip(payload, frame, frame));
+}
+
+void testPaletteRoundTrip() {
+  std::vector<uint8_t> frame = typicalGameFrame(2);
+  std::vector<uint8_t> payload;
+
+  ASSERT_TRUE(pixelgrid::encodeFramePalette4(frame.data(), PIXELS, payload));
+  ASSERT_EQ_U32(payload.size(), 1 + 1 + 3 * 3 + PIXELS / 2);
+  ASSERT_TRUE(roundTrip(payload, std::vector<uint8_t>(BYTES), frame));
+
+  std::vector<uint8_t> noisy = noiseFrame(7);
+  ASSERT_TRUE(!pixelgrid::encodeFramePalette4(noisy.data(), PIXELS, payload));
+}
+
+void testBestPicksSmallestAndFallsBackToRaw() {
+  std::vector<uint8_t> prev = typicalGameFrame(0);
+  std::vector<uint8_t> frame = typicalGameFrame(1);
+
+  std::vector<uint8_t> best = pixelgrid::encodeFrameBest(prev.data(), frame.data(), PIXELS);
+  ASSERT_EQ_U32(best[0], FRAME_ENC_XOR_DELTA);
+  // Typical game frames shrink by well over 10x
+  ASSERT_TRUE(best.size() * 10 < BYTES);
+  ASSERT_TRUE(roundTrip(best, prev, frame));
+
+  std::vector<uint8_t> keyframe = pixelgrid::encodeFrameBest(nullptr, frame.data(), PIXELS);
+  ASSERT_TRUE(keyframe[0] != FRAME_ENC_XOR_DELTA);
+  ASSERT_TRUE(roundTrip(keyframe, std::vector<uint8_t>(BYTES), frame));
+
+  std::vector<uint8_t> noisy = noiseFrame(11);
+  ASSERT_TRUE(pixelgrid::encodeFrameBest(nullptr, noisy.data(), PIXELS).empty());
+}
+
+void testMalformedPayloadsRejected() {
+  std::vector<uint8_t> frame(BYTES);
+
+  const uint8_t unknown[] = {0x7F, 1, 2, 3};
+  ASSERT_TRUE(!decodeFrame(unknown, sizeof(unknown), frame.data(), PIXELS));
+
+  // RLE run past the end of the frame
+  std::vector<uint8_t> rle = {FRAME_ENC_RLE};
+  for (int i = 0; i < 2; ++i) rle.insert(rle.end(), {200, 1, 2, 3});
+  ASSERT_TRUE(!decodeFrame(rle.data(), static_cast<uint16_t>(rle.size()), frame.data(), PIXELS));
+
+  // Delta literal count larger than the bytes that follow
+  const uint8_t delta[] = {FRAME_ENC_XOR_DELTA, 0, 5, 1, 2, 3};
+  ASSERT_TRUE(!decodeFrame(delta, sizeof(delta), frame.data(), PIXELS));
+
+  // Palette index beyond the palette
+  std::vector<uint8_t> pal = {FRAME_ENC_PALETTE4, 1, 9, 9, 9};
+  pal.insert(pal.end(), PIXELS / 2, 0x01);
+  ASSERT_TRUE(!decodeFrame(pal.data(), static_cast<uint16_t>(pal.size()), frame.data(), PIXELS));
+}
+
+int main() {
+  testRleRoundTrip();
+  testXorDeltaRoundTrip();
+  testXorDeltaOfIdenticalFrameIsTiny();
+  testPaletteRoundTrip();
+  testBestPicksSmallestAndFallsBackToRaw();
+  testMalformedPayloadsRejected();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
@@ -0,0 +1,599 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <Adafruit_NeoPixel.h>
+
+#include "FrameEncoder.h"
+#include "HostInput.h"
+#include "HostProtocol.h"
+#include "HostRuntime.h"
+#include "InputReport.h"
+#include "PacketWriter.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+// Serial stand-in: hands out at most `chunk` bytes per available() call so
+// tests can reproduce a slow host trickling a packet in.
+struct FakeStream {
+  std::vector<uint8_t> data;
+  size_t pos = 0;
+  size_t chunk = 0; // 0 = everything
+  size_t released = 0;
+
+  void feed(const std::vector<uint8_t>& bytes) { data.insert(data.end(), bytes.begin(), bytes.end()); }
+
+  int available() {
+    size_t left = data.size() - pos;
+    if (chunk == 0) released = left;
+    else if (released == 0) released = left < chunk ? left : chunk;
+    return static_cast<int>(released);
+  }
+
+  size_t readBytes(char* out, size_t n) {
+    if (n > released) n = released;
+    std::memcpy(out, data.data() + pos, n);
+    pos += n;
+    released -= n;
+    return n;
+  }
+};
+
+struct Capture {
+  uint8_t frame[HOST_FRAME_BYTES];
+  uint16_t stripCap = 600; // matrix part of the strip buffer (PBFS)
+  uint16_t lastType = 0;
+  uint16_t lastLen = 0;
+  uint8_t lastPayload[HOST_SCRATCH_SIZE];
+  int frames = 0;
+  int others = 0;
+};
+
+uint8_t* captureTarget(void* ctx, uint16_t type, uint16_t len, uint16_t& cap) {
+  Capture* c = static_cast<Capture*>(ctx);
+  if (type == HOST_PKT_FRAME && len == HOST_FRAME_BYTES) {
+    cap = sizeof(c->frame);
+    return c->frame;
+  }
+  if (type == HOST_PKT_FRAME_STRIP && len <= HOST_FRAME_BYTES) {
+    cap = c->stripCap;
+    return c->frame;
+  }
+  return nullptr;
+}
+
+void captureOnPacket(void* ctx, uint16_t type, const uint8_t* payload, uint16_t len) {
+  Capture* c = static_cast<Capture*>(ctx);
+  c->lastType = type;
+  c->lastLen = len;
+  if (payload == c->frame) {
+    c->frames++;
+    return;
+  }
+  if (len > sizeof(c->lastPayload)) {
+    // framed frames arrive in the parser's buffer
+    std::memcpy(c->frame, payload, len);
+    c->frames++;
+    return;
+  }
+  c->others++;
+  std::memcpy(c->lastPayload, payload, len);
+}
+
+void initParser(HostParser& parser, Capture& cap) {
+  HostParserCallbacks cb;
+  cb.ctx = &cap;
+  cb.payloadTarget = captureTarget;
+  cb.onPacket = captureOnPacket;
+  parser.begin(cb);
+}
+
+std::vector<uint8_t> packet(char t0, char t1, const std::vector<uint8_t>& payload, uint16_t declaredLen) {
+  std::vector<uint8_t> out = {'P', 'B', static_cast<uint8_t>(t0), static_cast<uint8_t>(t1),
+                              static_cast<uint8_t>(declaredLen & 0xFF), static_cast<uint8_t>(declaredLen >> 8)};
+  out.insert(out.end(), payload.begin(), payload.end());
+  return out;
+}
+
+std::vector<uint8_t> packet(char t0, char t1, const std::vector<uint8_t>& payload) {
+  return packet(t0, t1, payload, static_cast<uint16_t>(payload.size()));
+}
+
+std::vector<uint8_t> framePayload(uint8_t seed) {
+  std::vector<uint8_t> p(HOST_FRAME_BYTES);
+  for (size_t i = 0; i < p.size(); ++i) p[i] = static_cast<uint8_t>(seed + i * 7);
+  return p;
+}
+
+std::vector<uint8_t> framedPacket(uint8_t seq, char t0, char t1, const std::vector<uint8_t>& payload) {
+  return pixelgrid::buildFramedPacket(seq, hostPacketType(t0, t1), payload.data(), payload.size());
+}
+
+void pollAll(HostParser& parser, FakeStream& s) {
+  while (s.pos < s.data.size() || parser.ringUsed() > 0) parser.poll(s);
+}
+
+// The firmware's HostRuntime on an emulated cabinet: a 10 x 20 grid at the
+// start of the strip and the LCD digits after it
+struct Cabinet {
+  static const uint16_t MATRIX_BYTES = 10 * 20 * 3;
+
+  Adafruit_NeoPixel strip{256};
+  Pixel_Grid grid{&strip, 0, 20, 10};
+  LCD_Panel lcd{&strip, 200, 6, Adafruit_NeoPixel::Color(255, 255, 255)};
+  HostRuntime runtime;
+  int frames = 0;
+
+  Cabinet() { runtime.begin(&strip, &grid, &lcd, 10, 20); }
+  ~Cabinet() { Serial.detach(); }
+
+  // Polls the runtime until it has parsed all of `bytes`
+  void feed(const std::vector<uint8_t>& bytes) {
+    Serial.attachMemory(bytes.data(), bytes.size());
+    bool more = true;
+    while (more) {
+      bool frame = runtime.poll();
+      if (frame) ++frames;
+      more = frame || Serial.available() > 0;
+    }
+    Serial.detach();
+  }
+};
+
+}  // namespace
+
+void testFrameInOneRead() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  FakeStream s;
+  std::vector<uint8_t> payload = framePayload(3);
+  s.feed(packet('F', 'R', payload));
+
+  parser.poll(s);
+
+  ASSERT_EQ_U32(cap.frames, 1);
+  ASSERT_TRUE(std::memcmp(cap.frame, payload.data(), HOST_FRAME_BYTES) == 0);
+}
+
+void testTrickledFrameNeverBlocks() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  FakeStream s;
+  s.chunk = 7;
+  s.feed(packet('F', 'R', framePayload(9)));
+
+  // Each poll only sees a few bytes; nothing is dispatched until the last one.
+  int polls = 0;
+  while (s.pos < s.data.size()) {
+    ASSERT_EQ_U32(cap.frames, 0);
+    parser.poll(s);
+    ++polls;
+  }
+  ASSERT_EQ_U32(cap.frames, 1);
+  ASSERT_TRUE(polls > 100);
+}
+
+void testLcdAndHudPackets() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  FakeStream s;
+  s.feed(packet('L', 'C', {'H', 'E', 'L', 'L', 'O'}));
+  parser.poll(s);
+  ASSERT_EQ_U32(cap.lastType, HOST_PKT_LCD_TEXT);
+  ASSERT_EQ_U32(cap.lastLen, 5);
+  ASSERT_TRUE(std::memcmp(cap.lastPayload, "HELLO", 5) == 0);
+
+  std::vector<uint8_t> hud(15, 1);
+  s.feed(packet('7', 'S', hud));
+  parser.poll(s);
+  ASSERT_EQ_U32(cap.lastType, HOST_PKT_HUD_7SEG);
+  ASSERT_EQ_U32(cap.lastLen, 15);
+}
+
+void testResyncAfterGarbage() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  // The leading 0x00 opens a framed packet. It decodes to a bogus length
+  // that ends on the first PBLC's 'P', so that packet is lost along with
+  // the garbage; the parser resyncs on the plain stream for the next one.
+  FakeStream s;
+  s.feed({0x00, 'x', 'P', 'P', 'Q', 0xFF});
+  s.feed(packet('L', 'C', {'1', '2'}));
+  s.feed(packet('L', 'C', {'3', '4', '5'}));
+  pollAll(parser, s);
+
+  ASSERT_EQ_U32(cap.others, 1);
+  ASSERT_EQ_U32(cap.lastLen, 3);
+  ASSERT_EQ_U32(cap.lastPayload[0], '3');
+  ASSERT_EQ_U32(parser.stats.corrupt, 1);
+  ASSERT_TRUE(parser.stats.resyncBytes > 0);
+}
+
+void testWrongLengthFrameIsSkipped() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  // A short PBFR lands in scratch (truncated) and must not desync the stream.
+  FakeStream s;
+  std::vector<uint8_t> shortFrame(100, 'P');
+  s.feed(packet('F', 'R', shortFrame));
+  s.feed(packet('L', 'C', {'O', 'K'}));
+  parser.poll(s);
+
+  ASSERT_EQ_U32(cap.frames, 0);
+  ASSERT_EQ_U32(cap.lastType, HOST_PKT_LCD_TEXT);
+  ASSERT_TRUE(std::memcmp(cap.lastPayload, "OK", 2) == 0);
+}
+
+void testPausesAfterDirectFrame() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  FakeStream s;
+  std::vector<uint8_t> first = framePayload(1);
+  std::vector<uint8_t> second = framePayload(2);
+  s.feed(packet('F', 'R', first));
+  s.feed(packet('F', 'R', second));
+
+  // First poll hands over exactly one frame and leaves the second untouched.
+  parser.poll(s);
+  ASSERT_EQ_U32(cap.frames, 1);
+  ASSERT_TRUE(std::memcmp(cap.frame, first.data(), HOST_FRAME_BYTES) == 0);
+
+  parser.poll(s);
+  ASSERT_EQ_U32(cap.frames, 2);
+  ASSERT_TRUE(std::memcmp(cap.frame, second.data(), HOST_FRAME_BYTES) == 0);
+}
+
+void testStripFrameIsCappedToTarget() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+  std::memset(cap.frame, 0xEE, sizeof(cap.frame));
+
+  // Full 768-byte PBFS: only the first 600 bytes land in the target.
+  FakeStream s;
+  std::vector<uint8_t> payload = framePayload(5);
+  s.feed(packet('F', 'S', payload));
+  s.feed(packet('L', 'C', {'A'}));
+
+  parser.poll(s);
+  ASSERT_EQ_U32(cap.frames, 1);
+  ASSERT_EQ_U32(cap.lastLen, 600);
+  ASSERT_TRUE(std::memcmp(cap.frame, payload.data(), 600) == 0);
+  ASSERT_EQ_U32(cap.frame[600], 0xEE);
+
+  parser.poll(s);
+  ASSERT_EQ_U32(cap.lastType, HOST_PKT_LCD_TEXT);
+}
+
+void testHalfReceivedStripFrameNotShown() {
+  Cabinet c;
+  // What the game last drew
+  std::memset(c.strip.getPixels(), 0x5A, Cabinet::MATRIX_BYTES);
+
+  std::vector<uint8_t> payload = framePayload(5);
+  std::vector<uint8_t> pkt = packet('F', 'S', payload);
+  std::vector<uint8_t> head(pkt.begin(), pkt.begin() + 300);
+  std::vector<uint8_t> tail(pkt.begin() + 300, pkt.end());
+
+  c.feed(head);
+  ASSERT_EQ_U32(c.frames, 0);
+  bool untouched = true;
+  for (uint16_t i = 0; i < Cabinet::MATRIX_BYTES; ++i) untouched = untouched && c.strip.getPixels()[i] == 0x5A;
+  ASSERT_TRUE(untouched);
+
+  c.feed(tail);
+  ASSERT_EQ_U32(c.frames, 1);
+  ASSERT_TRUE(c.runtime.frameInStrip);
+  ASSERT_TRUE(std::memcmp(c.strip.getPixels(), payload.data(), Cabinet::MATRIX_BYTES) == 0);
+}
+
+void testStripFrameInvalidatesDeltaReference() {
+  Cabinet c;
+  std::vector<uint8_t> key = framePayload(3);
+  std::vector<uint8_t> next = key;
+  next[0] ^= 0x40;
+  next[31] ^= 0x11;
+  std::vector<uint8_t> delta = pixelgrid::encodeFrameXorDelta(key.data(), next.data(), HOST_FRAME_BYTES / 3);
+
+  c.feed(packet('F', 'R', key));
+  c.feed(packet('F', 'S', framePayload(9)));
+  ASSERT_EQ_U32(c.frames, 2);
+
+  // The delta is against the PBFR, which is no longer on screen
+  c.feed(packet('D', 'F', delta));
+  ASSERT_EQ_U32(c.frames, 2);
+  ASSERT_TRUE(c.runtime.frameInStrip);
+
+  c.feed(packet('F', 'R', key));
+  c.feed(packet('D', 'F', delta));
+  ASSERT_EQ_U32(c.frames, 4);
+  ASSERT_TRUE(std::memcmp(c.runtime.grb, next.data(), HOST_FRAME_BYTES) == 0);
+}
+
+void testFramedFramesDispatched() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  // Contains zeros, and a run long enough to need 0xFF COBS blocks
+  FakeStream s;
+  std::vector<uint8_t> first = framePayload(3);
+  std::vector<uint8_t> second(HOST_FRAME_BYTES, 0xAB);
+  s.feed(framedPacket(0, 'F', 'R', first));
+  s.feed(framedPacket(1, 'F', 'R', second));
+
+  parser.poll(s);
+  ASSERT_EQ_U32(cap.frames, 1);
+  ASSERT_TRUE(std::memcmp(cap.frame, first.data(), HOST_FRAME_BYTES) == 0);
+
+  pollAll(parser, s);
+  ASSERT_EQ_U32(cap.frames, 2);
+  ASSERT_TRUE(std::memcmp(cap.frame, second.data(), HOST_FRAME_BYTES) == 0);
+  ASSERT_EQ_U32(parser.stats.framed, 2);
+  ASSERT_EQ_U32(parser.stats.corrupt, 0);
+  ASSERT_EQ_U32(parser.stats.dropped, 0);
+}
+
+void testFramedCorruptionCounted() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  FakeStream s;
+  s.feed(framedPacket(0, '7', 'S', std::vector<uint8_t>(15, 0)));
+  std::vector<uint8_t> bad = framedPacket(1, 'L', 'C', {'B', 'A', 'D'});
+  bad[bad.size() / 2] ^= 0x10;
+  s.feed(bad);
+  // Truncated: the closing zero arrives too early
+  std::vector<uint8_t> cut = framedPacket(2, 'L', 'C', {'C', 'U', 'T'});
+  cut.erase(cut.end() - 3, cut.end() - 1);
+  s.feed(cut);
+  s.feed(framedPacket(3, 'L', 'C', {'O', 'K'}));
+  pollAll(parser, s);
+
+  ASSERT_EQ_U32(cap.others, 2);
+  ASSERT_TRUE(std::memcmp(cap.lastPayload, "OK", 2) == 0);
+  ASSERT_EQ_U32(parser.stats.corrupt, 2);
+  // Only packets that passed the CRC advance the sequence
+  ASSERT_EQ_U32(parser.stats.dropped, 2);
+}
+
+void testDeltaRefusedAfterCorruptFrame() {
+  Cabinet c;
+  std::vector<uint8_t> f[3];
+  f[0] = framePayload(3);
+  f[1] = f[0];
+  f[1][0] ^= 0x40;
+  f[2] = f[1];
+  f[2][31] ^= 0x11;
+  std::vector<uint8_t> delta1 = pixelgrid::encodeFrameXorDelta(f[0].data(), f[1].data(), HOST_FRAME_BYTES / 3);
+  std::vector<uint8_t> delta2 = pixelgrid::encodeFrameXorDelta(f[1].data(), f[2].data(), HOST_FRAME_BYTES / 3);
+
+  c.feed(framedPacket(0, 'F', 'R', f[0]));
+  ASSERT_EQ_U32(c.frames, 1);
+
+  // Frame 1 fails its CRC, so frame 2's delta has no reference
+  std::vector<uint8_t> bad = framedPacket(1, 'D', 'F', delta1);
+  bad[bad.size() / 2] = static_cast<uint8_t>(bad[bad.size() / 2] == 1 ? 2 : 1);
+  c.feed(bad);
+  c.feed(framedPacket(2, 'D', 'F', delta2));
+  ASSERT_EQ_U32(c.runtime.stats().corrupt, 1);
+  ASSERT_EQ_U32(c.frames, 1);
+  ASSERT_TRUE(std::memcmp(c.runtime.grb, f[0].data(), HOST_FRAME_BYTES) == 0);
+
+  c.feed(framedPacket(3, 'F', 'R', f[1]));
+  c.feed(framedPacket(4, 'D', 'F', delta2));
+  ASSERT_EQ_U32(c.frames, 3);
+  ASSERT_TRUE(std::memcmp(c.runtime.grb, f[2].data(), HOST_FRAME_BYTES) == 0);
+}
+
+void testSequenceGapsAndReordering() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  FakeStream s;
+  const uint8_t seqs[] = {250, 251, 254, 255, 0, 3, 1};
+  for (uint8_t seq : seqs) s.feed(framedPacket(seq, 'L', 'C', {seq}));
+  pollAll(parser, s);
+
+  // 252, 253 and 1, 2 missing (across the wrap); the late 1 is discarded
+  ASSERT_EQ_U32(cap.others, 6);
+  ASSERT_EQ_U32(parser.stats.dropped, 4);
+  ASSERT_EQ_U32(parser.stats.outOfOrder, 1);
+  ASSERT_EQ_U32(cap.lastPayload[0], 3);
+
+  // A host that restarts its counter is followed once three stale packets
+  // in a row (the late 1 counts) have been seen
+  for (uint8_t seq = 0; seq < 4; ++seq) s.feed(framedPacket(seq, 'L', 'C', {seq}));
+  pollAll(parser, s);
+  ASSERT_EQ_U32(parser.stats.outOfOrder, 2);
+  ASSERT_EQ_U32(cap.others, 9);
+  ASSERT_EQ_U32(cap.lastPayload[0], 3);
+}
+
+void testPlainAndFramedInterleave() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  FakeStream s;
+  s.chunk = 5;
+  s.feed(packet('L', 'C', {'A'}));
+  s.feed(framedPacket(0, 'L', 'C', {'B'}));
+  s.feed(packet('L', 'C', {'C'}));
+  s.feed(framedPacket(1, '7', 'S', std::vector<uint8_t>(15, 0)));
+  s.feed(packet('L', 'C', {'D'}));
+
+  std::string seen;
+  while (s.pos < s.data.size() || parser.ringUsed() > 0) {
+    int before = cap.others;
+    parser.poll(s);
+    if (cap.others != before && cap.lastType == HOST_PKT_LCD_TEXT) seen += static_cast<char>(cap.lastPayload[0]);
+  }
+
+  ASSERT_TRUE(seen == "ABCD");
+  ASSERT_EQ_U32(cap.others, 5);
+  ASSERT_EQ_U32(parser.stats.packets, 5);
+  ASSERT_EQ_U32(parser.stats.framed, 2);
+  ASSERT_EQ_U32(parser.stats.resyncBytes, 0);
+}
+
+void testStrayZeroOnPlainStream() {
+  HostParser parser;
+  Capture cap;
+  initParser(parser, cap);
+
+  // A zero that isn't a frame start costs at most the packets it overlaps
+  FakeStream s;
+  s.feed({0x00});
+  for (int i = 0; i < 4; ++i) s.feed(packet('L', 'C', {static_cast<uint8_t>('0' + i)}));
+  pollAll(parser, s);
+
+  ASSERT_EQ_U32(cap.others, 3);
+  ASSERT_EQ_U32(cap.lastPayload[0], '3');
+  ASSERT_EQ_U32(parser.stats.corrupt, 1);
+}
+
+void testStatusPayloadRoundTrip() {
+  HostLinkStats in;
+  in.packets = 70000;
+  in.framed = 1;
+  in.corrupt = 2;
+  in.dropped = 3;
+  in.outOfOrder = 4;
+  in.resyncBytes = 0x01020304;
+
+  uint8_t wire[HOST_STATUS_BYTES];
+  hostStatsPayload(in, wire);
+  std::vector<uint8_t> pkt = pixelgrid::buildPacket(HOST_PKT_STATUS, wire, sizeof(wire));
+  ASSERT_EQ_U32(pkt.size(), HOST_HEADER_BYTES + HOST_STATUS_BYTES);
+  ASSERT_EQ_U32(pkt[2], 'S');
+  ASSERT_EQ_U32(pkt[3], 'T');
+
+  HostLinkStats out;
+  ASSERT_TRUE(pixelgrid::parseStatusPayload(pkt.data() + HOST_HEADER_BYTES, HOST_STATUS_BYTES, out));
+  ASSERT_EQ_U32(out.packets, 70000);
+  ASSERT_EQ_U32(out.outOfOrder, 4);
+  ASSERT_EQ_U32(out.resyncBytes, 0x01020304);
+  ASSERT_TRUE(!pixelgrid::parseStatusPayload(wire, 3, out));
+
+  // With the PBSQ token echoed after the counters
+  uint8_t tokened[HOST_STATUS_BYTES + HOST_STATUS_TOKEN_BYTES];
+  hostStatsPayload(in, tokened);
+  hostWriteU32(tokened + HOST_STATUS_BYTES, 0xCAFE0042);
+  pixelgrid::StatusReply reply;
+  ASSERT_TRUE(pixelgrid::parseStatusReply(tokened, sizeof(tokened), reply));
+  ASSERT_TRUE(reply.hasToken);
+  ASSERT_EQ_U32(reply.token, 0xCAFE0042);
+  ASSERT_EQ_U32(reply.stats.dropped, 3);
+  ASSERT_TRUE(pixelgrid::parseStatusReply(wire, sizeof(wire), reply));
+  ASSERT_TRUE(!reply.hasToken);
+  ASSERT_TRUE(!pixelgrid::parseStatusReply(tokened, sizeof(tokened) - 1, reply));
+}
+
+void testInputQueueReportsEveryEdge() {
+  HostInputQueue q;
+  uint8_t wire[HOST_INPUT_REPORT_MAX_BYTES];
+  pixelgrid::InputReport r;
+
+  // The first sample is the starting state and is reported at once
+  q.note(0x04, 1000);
+  ASSERT_TRUE(q.due(1000));
+  uint16_t len = q.take(1000, wire);
+  ASSERT_TRUE(pixelgrid::parseInputReport(wire, len, r));
+  ASSERT_EQ_U32(r.bits, 0x04);
+  ASSERT_EQ_U32(r.events.size(), 0);
+
+  // Edges inside the report spacing queue up instead of merging
+  q.note(0x04, 1500);
+  q.note(0x05, 2000);
+  q.note(0x04, 2100);
+  ASSERT_TRUE(!q.due(2100));
+  ASSERT_TRUE(q.due(1000 + HOST_INPUT_REPORT_MIN_US));
+  len = q.take(5000, wire);
+  ASSERT_EQ_U32(len, HOST_INPUT_HEADER_BYTES + 2 * HOST_INPUT_EVENT_BYTES);
+  ASSERT_TRUE(pixelgrid::parseInputReport(wire, len, r));
+  ASSERT_EQ_U32(r.deviceUs, 5000);
+  ASSERT_EQ_U32(r.events.size(), 2);
+  ASSERT_EQ_U32(r.events[0].bits, 0x05);
+  ASSERT_EQ_U32(r.events[0].us, 2000);
+  ASSERT_EQ_U32(r.events[1].bits, 0x04);
+  ASSERT_EQ_U32(r.events[1].us, 2100);
+  ASSERT_EQ_U32(r.lost, 0);
+  ASSERT_TRUE(!q.due(20000));
+
+  // A full queue keeps the newest edges and counts the rest
+  for (uint32_t i = 0; i < HOST_INPUT_MAX_EVENTS + 3; ++i) q.note(static_cast<uint8_t>(i & 1), 10000 + i);
+  len = q.take(20000, wire);
+  ASSERT_TRUE(pixelgrid::parseInputReport(wire, len, r));
+  ASSERT_EQ_U32(r.events.size(), HOST_INPUT_MAX_EVENTS);
+  ASSERT_EQ_U32(r.lost, 3);
+  ASSERT_EQ_U32(r.events.back().us, 10000 + HOST_INPUT_MAX_EVENTS + 2);
+
+  ASSERT_TRUE(!pixelgrid::parseInputReport(wire, len - 1, r));
+}
+
+void testPongEchoesTokenWithDeviceTime() {
+  const uint8_t ping[HOST_PING_BYTES] = {0x78, 0x56, 0x34, 0x12};
+  uint8_t pong[HOST_PONG_BYTES];
+  hostPongPayload(ping, 0xCAFEF00D, pong);
+
+  uint32_t token = 0, deviceUs = 0;
+  ASSERT_TRUE(pixelgrid::parsePong(pong, sizeof(pong), token, deviceUs));
+  ASSERT_EQ_U32(token, 0x12345678);
+  ASSERT_EQ_U32(deviceUs, 0xCAFEF00D);
+  ASSERT_TRUE(!pixelgrid::parsePong(pong, 4, token, deviceUs));
+
+  // Offset from the shortest round trip; device times map across a wrap
+  pixelgrid::DeviceClock clock;
+  clock.addSample(1000000, 1000400, 0xFFFFFF00u);  // rtt 400
+  clock.addSample(2000000, 2000100, 0x000F4140u);  // rtt 100, 1 s later (device wrapped)
+  ASSERT_EQ_U32(static_cast<uint32_t>(clock.bestRttUs()), 100);
+  ASSERT_EQ_U32(static_cast<uint32_t>(clock.toHostUs(0x000F4140u + 500) - 2000050), 500);
+  ASSERT_EQ_U32(static_cast<uint32_t>(2000050 - clock.toHostUs(0xFFFFFF00u)), 1000000);
+}
+
+int main() {
+  testFrameInOneRead();
+  testTrickledFrameNeverBlocks();
+  testLcdAndHudPackets();
+  testResyncAfterGarbage();
+  testWrongLengthFrameIsSkipped();
+  testPausesAfterDirectFrame();
+  testStripFrameIsCappedToTarget();
+  testHalfReceivedStripFrameNotShown();
+  testStripFrameInvalidatesDeltaReference();
+  testFramedFramesDispatched();
+  testFramedCorruptionCounted();
+  testDeltaRefusedAfterCorruptFrame();
+  testSequenceGapsAndReordering();
+  testPlainAndFramedInterleave();
+  testStrayZeroOnPlainStream();
+  testStatusPayloadRoundTrip();
+  testInputQueueReportsEveryEdge();
+  testPongEchoesTokenWithDeviceTime();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
@@ -0,0 +1,349 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "HostSession.h"
+#include "support/PtyDevice.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using ptydevice::Link;
+
+// Incompressible frame, so every send is a full PBFR
+pixelgrid::HostFrame noiseFrame(uint32_t seed) {
+  pixelgrid::HostFrame f;
+  for (uint8_t& b : f.grb) {
+    seed = seed * 1103515245u + 12345u;
+    b = static_cast<uint8_t>(seed >> 16);
+  }
+  return f;
+}
+
+bool deviceFrameIs(Link& link, const pixelgrid::HostFrame& f) {
+  std::lock_guard<std::mutex> lock(link.device.mu);
+  return link.device.frameValid && std::memcmp(link.device.frame, f.grb, sizeof(f.grb)) == 0;
+}
+
+// Services until nothing is pending or in flight (or ms run out)
+void drain(pixelgrid::HostSession& session, int ms) {
+  Clock::time_point end = Clock::now() + std::chrono::milliseconds(ms);
+  while (Clock::now() < end && (session.framePending() || session.inFlight() > 0)) session.service(2);
+  // Let the device finish parsing the last packets
+  for (int i = 0; i < 20; ++i) session.service(2);
+}
+
+}  // namespace
+
+void testFrameTextAndHudReachDevice() {
+  Link link;
+  ASSERT_TRUE(link.open());
+  link.start();
+  pixelgrid::HostSession session(link.host);
+
+  pixelgrid::HostFrame f;
+  f.set(0, 0, 255, 0, 0);
+  f.set(1, 0, 0, 255, 0);
+  f.set(9, 19, 0, 0, 255);
+  session.submitFrame(f);
+  session.setLcdText("HELLO");
+  pixelgrid::HostHud hud;
+  hud.masks[1] = 0x3F;
+  hud.score = 123;
+  session.setHud(hud);
+  drain(session, 1000);
+
+  ASSERT_TRUE(deviceFrameIs(link, f));
+  std::lock_guard<std::mutex> lock(link.device.mu);
+  ASSERT_TRUE(link.device.lcd == "HELLO");
+  ASSERT_EQ_U32(link.device.hud.size(), 15);
+  ASSERT_EQ_U32(link.device.hud[1], 0x3F);
+  ASSERT_EQ_U32(link.device.hud[12], 1);
+  ASSERT_EQ_U32(link.device.hud[14], 3);
+  // Serpentine layout: column 1 runs bottom to top
+  ASSERT_EQ_U32(pixelgrid::HostFrame::index(1, 0), 39);
+}
+
+void testInputBytesReceived() {
+  Link link;
+  ASSERT_TRUE(link.open());
+  link.start();
+  pixelgrid::HostSessionConfig cfg;
+  cfg.inputReports = false;
+  pixelgrid::HostSession session(link.host, cfg);
+
+  link.device.sendInput(0x21);
+  link.device.sendInput(0x00);
+
+  std::vector<uint8_t> got;
+  uint8_t bits;
+  for (int i = 0; i < 50 && got.size() < 2; ++i) {
+    session.service(5);
+    while (session.popInput(bits)) got.push_back(bits);
+  }
+  ASSERT_EQ_U32(got.size(), 2);
+  if (got.size() == 2) {
+    ASSERT_EQ_U32(got[0], 0x21);
+    ASSERT_EQ_U32(got[1], 0x00);
+  }
+}
+
+void testSlowDeviceMergesFramesAndMeasuresBandwidth() {
+  Link link;
+  link.device.bytesPerMs = 20; // ~20 KB/s end to end, ~25 full frames/s
+  ASSERT_TRUE(link.open());
+  link.start();
+
+  pixelgrid::HostSessionConfig cfg;
+  cfg.maxFps = 1000;
+  pixelgrid::HostSession session(link.host, cfg);
+
+  size_t maxInFlight = 0;
+  pixelgrid::HostFrame last;
+  Clock::time_point end = Clock::now() + std::chrono::milliseconds(1000);
+  for (uint32_t i = 0; Clock::now() < end; ++i) {
+    last = noiseFrame(i);
+    session.submitFrame(last);
+    session.service(1);
+    if (session.inFlight() > maxInFlight) maxInFlight = session.inFlight();
+  }
+  drain(session, 1000);
+
+  const pixelgrid::HostSessionStats& st = session.stats();
+  ASSERT_TRUE(st.deviceConfirms);
+  ASSERT_TRUE(st.framesMerged > st.framesSent);
+  ASSERT_TRUE(maxInFlight <= cfg.maxInFlight);
+  // Latest wins: the device ends up on the last submitted frame
+  ASSERT_TRUE(deviceFrameIs(link, last));
+  ASSERT_TRUE(st.linkBytesPerSec > 10000 && st.linkBytesPerSec < 30000);
+}
+
+void testFirmwareWithoutStatusIsPacedOnTime() {
+  Link link;
+  link.device.answerStatus = false;
+  ASSERT_TRUE(link.open());
+  link.start();
+
+  pixelgrid::HostSessionConfig cfg;
+  cfg.maxFps = 1000;
+  pixelgrid::HostSession session(link.host, cfg); // 115200 baud: ~14 frames/s
+
+  Clock::time_point end = Clock::now() + std::chrono::milliseconds(500);
+  for (uint32_t i = 0; Clock::now() < end; ++i) {
+    session.submitFrame(noiseFrame(i));
+    session.service(1);
+  }
+
+  const pixelgrid::HostSessionStats& st = session.stats();
+  ASSERT_TRUE(!st.deviceConfirms);
+  ASSERT_TRUE(st.framesSent >= 4 && st.framesSent <= 10);
+}
+
+void testIdleSessionKeepsHostModeAlive() {
+  Link link;
+  ASSERT_TRUE(link.open());
+  link.start();
+
+  pixelgrid::HostSessionConfig cfg;
+  cfg.keepAliveMs = 100;
+  pixelgrid::HostSession session(link.host, cfg);
+
+  pixelgrid::HostFrame f;
+  f.fill(10, 20, 30);
+  session.submitFrame(f);
+  Clock::time_point end = Clock::now() + std::chrono::milliseconds(450);
+  while (Clock::now() < end) session.service(5);
+
+  const pixelgrid::HostSessionStats& st = session.stats();
+  ASSERT_TRUE(st.framesSent >= 4);
+  // Repeats are tiny XOR deltas
+  ASSERT_TRUE(st.bytesSent < 200);
+  ASSERT_TRUE(deviceFrameIs(link, f));
+}
+
+uint32_t deviceKeyframes(Link& link) {
+  std::lock_guard<std::mutex> lock(link.device.mu);
+  return link.device.keyframes;
+}
+
+// A small change per frame, so every send after a keyframe is a delta
+pixelgrid::HostFrame movingFrame(uint32_t i) {
+  pixelgrid::HostFrame f;
+  f.fill(5, 5, 5);
+  f.set(static_cast<uint8_t>(i % pixelgrid::HostFrame::W), 0, 200, 0, 0);
+  return f;
+}
+
+void testLostFrameForcesKeyframe() {
+  Link link;
+  ASSERT_TRUE(link.open());
+  link.start();
+
+  pixelgrid::HostSessionConfig cfg;
+  cfg.framed = true;
+  cfg.confirmTimeoutMs = 50;
+  pixelgrid::HostSession session(link.host, cfg);
+
+  uint32_t i = 0;
+  pixelgrid::HostFrame last;
+  auto sendFrames = [&](int n) {
+    for (int k = 0; k < n; ++k) {
+      last = movingFrame(i++);
+      session.submitFrame(last);
+      drain(session, 500);
+    }
+  };
+  sendFrames(3);
+  ASSERT_EQ_U32(deviceKeyframes(link), 1);
+
+  // A framed packet fails its CRC on the device: the next PBST shows it
+  pixelgrid::PacketWriter junk(true);
+  std::vector<uint8_t> bad = junk.build(HOST_PKT_LCD_TEXT, reinterpret_cast<const uint8_t*>("LOST"), 4);
+  bad[bad.size() / 2] = static_cast<uint8_t>(bad[bad.size() / 2] == 1 ? 2 : 1);
+  ASSERT_TRUE(link.host.write(bad.data(), bad.size()));
+  sendFrames(3);
+  ASSERT_EQ_U32(session.stats().deviceLink.corrupt, 1);
+  ASSERT_EQ_U32(deviceKeyframes(link), 2);
+
+  // A confirmation that times out
+  link.device.stallNextStatusMs = 150;
+  sendFrames(1);
+  for (int k = 0; k < 100; ++k) session.service(2);
+  sendFrames(2);
+  ASSERT_TRUE(session.stats().framesUnconfirmed >= 1);
+  ASSERT_EQ_U32(deviceKeyframes(link), 3);
+  ASSERT_EQ_U32(session.stats().keyframesForced, 2);
+  ASSERT_TRUE(deviceFrameIs(link, last));
+}
+
+void testLateConfirmationIgnored() {
+  Link link;
+  ASSERT_TRUE(link.open());
+  link.start();
+
+  pixelgrid::HostSessionConfig cfg;
+  cfg.confirmTimeoutMs = 100;
+  pixelgrid::HostSession session(link.host, cfg);
+
+  session.submitFrame(movingFrame(0));
+  drain(session, 500);
+
+  // The device stalls past the timeout, then answers the expired frame's
+  // PBSQ just before the next frame's
+  link.device.stallNextStatusMs = 150;
+  session.submitFrame(movingFrame(1));
+  Clock::time_point end = Clock::now() + std::chrono::milliseconds(110);
+  while (Clock::now() < end) session.service(2);
+  ASSERT_EQ_U32(session.stats().framesUnconfirmed, 1);
+  session.submitFrame(movingFrame(2));
+  drain(session, 500);
+
+  const pixelgrid::HostSessionStats& st = session.stats();
+  ASSERT_EQ_U32(st.lateConfirms, 1);
+  ASSERT_EQ_U32(st.framesConfirmed, 2);
+  ASSERT_EQ_U32(st.framesConfirmed + st.framesUnconfirmed, st.framesSent);
+}
+
+// Services until the device has switched to PBIN reports and a ping came back
+bool waitForInputReports(Link& link, pixelgrid::HostSession& session) {
+  for (int i = 0; i < 200; ++i) {
+    session.service(2);
+    std::lock_guard<std::mutex> lock(link.device.mu);
+    if (link.device.inputMode == HOST_INPUT_MODE_REPORTS && session.deviceClock().valid()) return true;
+  }
+  return false;
+}
+
+std::vector<pixelgrid::InputEdge> collectEdges(pixelgrid::HostSession& session, size_t want, int ms) {
+  std::vector<pixelgrid::InputEdge> edges;
+  pixelgrid::InputEdge e;
+  Clock::time_point end = Clock::now() + std::chrono::milliseconds(ms);
+  while (edges.size() < want && Clock::now() < end) {
+    session.service(2);
+    while (session.popInputEdge(e)) edges.push_back(e);
+  }
+  return edges;
+}
+
+void testTapShorterThanThrottleKeepsBothEdges() {
+  Link link;
+  link.device.clockOffsetUs = 123456789;
+  ASSERT_TRUE(link.open());
+  link.start();
+
+  pixelgrid::HostSessionConfig cfg;
+  cfg.pingEveryMs = 20;
+  pixelgrid::HostSession session(link.host, cfg);
+  ASSERT_TRUE(waitForInputReports(link, session));
+
+  // Press and release within microseconds: 'b' bytes throttled to 15 ms
+  // would have merged these
+  int64_t pressUs = ptydevice::nowUs();
+  link.device.sendInput(0x01);
+  link.device.sendInput(0x00);
+
+  std::vector<pixelgrid::InputEdge> edges = collectEdges(session, 2, 500);
+  ASSERT_EQ_U32(edges.size(), 2);
+  if (edges.size() == 2) {
+    ASSERT_EQ_U32(edges[0].bits, 0x01);
+    ASSERT_EQ_U32(edges[1].bits, 0x00);
+    ASSERT_TRUE(edges[0].timestamped && edges[1].timestamped);
+    ASSERT_TRUE(static_cast<int32_t>(edges[1].deviceUs - edges[0].deviceUs) >= 0);
+    // Placed on the host clock through the ping offset, not the arrival time
+    ASSERT_TRUE(edges[0].hostUs > pressUs - 2000 && edges[0].hostUs < pressUs + 2000);
+    ASSERT_TRUE(edges[1].receivedUs >= edges[1].hostUs);
+  }
+  ASSERT_EQ_U32(session.stats().inputEdges, 2);
+  ASSERT_EQ_U32(session.stats().inputEdgesLost, 0);
+}
+
+void testPingMapsDeviceClockAcrossWrap() {
+  Link link;
+  // The device's micros() wraps about 100 ms into the test
+  link.device.clockOffsetUs = 0xFFFFFFFFu - static_cast<uint32_t>(ptydevice::nowUs()) - 100000u;
+  ASSERT_TRUE(link.open());
+  link.start();
+
+  pixelgrid::HostSessionConfig cfg;
+  cfg.pingEveryMs = 10;
+  pixelgrid::HostSession session(link.host, cfg);
+  Clock::time_point end = Clock::now() + std::chrono::milliseconds(250);
+  while (Clock::now() < end) session.service(2);
+
+  const pixelgrid::DeviceClock& clock = session.deviceClock();
+  ASSERT_TRUE(clock.valid());
+  {
+    std::lock_guard<std::mutex> lock(link.device.mu);
+    ASSERT_TRUE(link.device.pings >= 10);
+  }
+  ASSERT_TRUE(session.stats().pingRttMs > 0 && session.stats().pingRttMs < 50);
+  ASSERT_TRUE(clock.bestRttUs() <= clock.lastRttUs());
+
+  int64_t hostUs = ptydevice::nowUs();
+  int64_t mapped = clock.toHostUs(link.device.micros());
+  ASSERT_TRUE(mapped > hostUs - 2000 && mapped < hostUs + 2000);
+}
+
+int main() {
+  testFrameTextAndHudReachDevice();
+  testInputBytesReceived();
+  testSlowDeviceMergesFramesAndMeasuresBandwidth();
+  testFirmwareWithoutStatusIsPacedOnTime();
+  testIdleSessionKeepsHostModeAlive();
+  testTapShorterThanThrottleKeepsBothEdges();
+  testPingMapsDeviceClockAcrossWrap();
+  testLostFrameForcesKeyframe();
+  testLateConfirmationIgnored();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
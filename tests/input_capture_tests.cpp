@@ -0,0 +1,375 @@
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+
+#include "Input.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+// INCAP-001
+void testRingOrderAndOverflow() {
+  InputEdgeRing<8> ring;
+  InputEdge e;
+  ASSERT_TRUE(!ring.pop(e));
+
+  // Several laps, so the free-running indices wrap past 255
+  uint32_t next = 0;
+  for (uint32_t lap = 0; lap < 100; ++lap) {
+    for (uint8_t i = 0; i < 5; ++i) ASSERT_TRUE(ring.push({ next + i, i, 1, static_cast<uint8_t>(1u << i) }));
+    for (uint8_t i = 0; i < 5; ++i) {
+      ASSERT_TRUE(ring.pop(e));
+      ASSERT_EQ_U32(e.us, next + i);
+      ASSERT_EQ_U32(e.levels, 1u << i);
+    }
+    next += 5;
+  }
+
+  for (uint8_t i = 0; i < 8; ++i) ASSERT_TRUE(ring.push({ i, 0, 0, 0 }));
+  ASSERT_TRUE(!ring.push({ 99, 0, 0, 0 }));
+  ASSERT_TRUE(!ring.push({ 100, 0, 0, 0 }));
+  ASSERT_EQ_U32(ring.dropped(), 2);
+  // The oldest edges are kept
+  for (uint8_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(ring.pop(e));
+    ASSERT_EQ_U32(e.us, i);
+  }
+  ASSERT_TRUE(!ring.pop(e));
+}
+
+// INCAP-002
+void testRingAcrossThreads() {
+  static InputEdgeRing<INPUT_EDGE_RING_SIZE> ring;
+  const uint32_t COUNT = 200000;
+  std::thread producer([] {
+    for (uint32_t i = 0; i < COUNT;) {
+      uint8_t down = static_cast<uint8_t>(i >> 8);
+      if (ring.push({ i, static_cast<uint8_t>(i), down, static_cast<uint8_t>(down ? 1u << (i & 7) : 0) })) ++i;
+      else std::this_thread::yield();
+    }
+  });
+
+  uint32_t expected = 0;
+  bool inOrder = true;
+  InputEdge e;
+  while (expected < COUNT) {
+    if (!ring.pop(e)) continue;
+    inOrder = inOrder && e.us == expected && e.line == static_cast<uint8_t>(expected) &&
+              e.down == static_cast<uint8_t>(expected >> 8) &&
+              e.levels == (e.down ? 1u << (expected & 7) : 0u);
+    ++expected;
+  }
+  producer.join();
+  ASSERT_TRUE(inOrder);
+  ASSERT_TRUE(!ring.pop(e));
+}
+
+// INCAP-003
+void testCaptureRecordsPinChanges() {
+  static InputCapture capture;
+  const uint8_t pins[] = { 20, 21 };
+  capture.begin(pins, 2);
+
+  uint32_t before = micros();
+  emuSetPin(21, LOW);
+  emuSetPin(21, LOW);  // no change, no interrupt
+  emuSetPin(20, LOW);
+  emuSetPin(21, HIGH);
+
+  InputEdge e;
+  ASSERT_TRUE(capture.pop(e));
+  ASSERT_EQ_U32(e.line, 1);
+  ASSERT_EQ_U32(e.down, 1);
+  ASSERT_TRUE(static_cast<int32_t>(e.us - before) >= 0);
+  ASSERT_TRUE(capture.pop(e));
+  ASSERT_EQ_U32(e.line, 0);
+  ASSERT_EQ_U32(e.down, 1);
+  ASSERT_TRUE(capture.pop(e));
+  ASSERT_EQ_U32(e.line, 1);
+  ASSERT_EQ_U32(e.down, 0);
+  ASSERT_TRUE(!capture.pop(e));
+  ASSERT_TRUE(capture.down(0));
+  ASSERT_TRUE(!capture.down(1));
+  emuSetPin(20, HIGH);
+  while (capture.pop(e)) {
+  }
+}
+
+// INCAP-004
+void testDebounceOnEdgeTimes() {
+  const uint32_t P = DEBOUNCE_MS * 1000 / INPUT_DEBOUNCE_SAMPLES;
+  InputDebouncer d;
+  d.begin(0, 1000, DEBOUNCE_MS * 1000);
+
+  // Line 2 bounces for 3 ms; the press dates from its first edge
+  d.edge(0x04, 100000);
+  d.edge(0x00, 101000);
+  d.edge(0x04, 103000);
+  ASSERT_EQ_U32(d.settle(110000), 0);
+  // Four samples in a row must see it, so it lands within one sample
+  // period before the debounce time is up
+  ASSERT_EQ_U32(d.settle(103000 + DEBOUNCE_MS * 1000 - P - 1), 0);
+  ASSERT_EQ_U32(d.settle(103000 + DEBOUNCE_MS * 1000), 0x04);
+  ASSERT_EQ_U32(d.changedUs(2), 100000);
+
+  // A glitch shorter than a sample period changes nothing
+  d.edge(0x00, 200000);
+  d.edge(0x04, 200000 + P / 2);
+  ASSERT_EQ_U32(d.settle(300000), 0x04);
+
+  // An edge newer than the time passed to settle() isn't clocked yet
+  d.edge(0x00, 400000);
+  ASSERT_EQ_U32(d.settle(399000), 0x04);
+  ASSERT_EQ_U32(d.settle(420000), 0x00);
+  ASSERT_EQ_U32(d.changedUs(2), 400000);
+}
+
+// INCAP-005
+void testRepeatCountsFromPress() {
+  static Input input;
+  input.begin();
+  // Times from here on are made up, starting a little after begin()
+  const uint32_t t0 = millis() + 1000;
+  input.resetRepeatTimers(t0 - 1000);
+  const uint8_t L = INPUT_BIT(LINE_JOY_LEFT);
+
+  auto stepAt = [&](uint32_t ms) {
+    input.update(ms, ms * 1000);
+    int8_t dx = input.joystickRepeatDx(ms);
+    input.latch();
+    return dx;
+  };
+
+  // Pressed at t0, first seen by a pass 30 ms later
+  input.edge(L, t0 * 1000);
+  input.update(t0 + 30, (t0 + 30) * 1000);
+  ASSERT_TRUE(input.pressed() & L);
+  ASSERT_EQ_U32(input.changedMs(LINE_JOY_LEFT), t0);
+  ASSERT_TRUE(input.joystickRepeatDx(t0 + 30) == -1);
+  input.latch();
+
+  ASSERT_TRUE(stepAt(t0 + MOVE_REPEAT_START_MS - 1) == 0);
+  ASSERT_TRUE(stepAt(t0 + MOVE_REPEAT_START_MS) == -1);
+  // Repeats keep their spacing when a pass is a little late
+  ASSERT_TRUE(stepAt(t0 + MOVE_REPEAT_START_MS + MOVE_REPEAT_MS + 10) == -1);
+  ASSERT_TRUE(stepAt(t0 + MOVE_REPEAT_START_MS + 2 * MOVE_REPEAT_MS - 1) == 0);
+  ASSERT_TRUE(stepAt(t0 + MOVE_REPEAT_START_MS + 2 * MOVE_REPEAT_MS) == -1);
+  // A long stall owes every repeat that fell due in it
+  uint32_t stall = t0 + MOVE_REPEAT_START_MS + 10 * MOVE_REPEAT_MS;
+  ASSERT_TRUE(stepAt(stall) == -8);
+  ASSERT_TRUE(stepAt(stall + 1) == 0);
+  ASSERT_TRUE(stepAt(stall + MOVE_REPEAT_MS) == -1);
+
+  input.edge(0, (stall + 100) * 1000);
+  input.update(stall + 200, (stall + 200) * 1000);
+  ASSERT_TRUE(input.released() & L);
+  ASSERT_TRUE(input.joystickRepeatDx(stall + 200) == 0);
+  input.latch();
+}
+
+// INCAP-006
+void testDroppedEdgesResync() {
+  static Input input;
+  input.begin();
+  InputEdge e;
+  while (input.capture().pop(e)) {
+  }
+  input.update(0, 0);
+
+  // More changes than the ring holds, ending pressed
+  for (uint32_t i = 0; i < INPUT_EDGE_RING_SIZE + 11; ++i) emuSetPin(PIN_BTN2, i % 2 ? HIGH : LOW);
+  ASSERT_TRUE(digitalRead(PIN_BTN2) == LOW);
+
+  uint32_t nowUs = micros();
+  uint32_t nowMs = millis();
+  input.update(nowMs, nowUs);
+  ASSERT_TRUE(input.debouncer().raw() & INPUT_BIT(LINE_BTN2));
+  input.update(nowMs + DEBOUNCE_MS, nowUs + DEBOUNCE_MS * 1000);
+  ASSERT_TRUE(input.held() & INPUT_BIT(LINE_BTN2));
+  ASSERT_EQ_U32(input.capture().takeDropped(), 0);
+  emuSetPin(PIN_BTN2, HIGH);
+}
+
+// INCAP-007
+void testVerticalCounterLanes() {
+  VerticalCounter vc;
+  vc.reset(0x0F);
+
+  // Lanes 4-7 go down, lanes 0-3 up; lane 0 bounces back on the second sample
+  ASSERT_EQ_U32(vc.clock(0xF0), 0);
+  ASSERT_EQ_U32(vc.clock(0xF1), 0);
+  ASSERT_EQ_U32(vc.clock(0xF0), 0);
+  ASSERT_EQ_U32(vc.clock(0xF0), 0xFE);
+  ASSERT_EQ_U32(vc.state, 0xF1);
+  // Lane 0 counted again from its bounce: two samples so far
+  ASSERT_EQ_U32(vc.clock(0xF0), 0);
+  ASSERT_EQ_U32(vc.clock(0xF0), 0x01);
+  ASSERT_EQ_U32(vc.state, 0xF0);
+  // Steady input leaves it alone
+  for (int i = 0; i < 10; ++i) ASSERT_EQ_U32(vc.clock(0xF0), 0);
+  ASSERT_EQ_U32(vc.c0 | vc.c1, 0);
+}
+
+// INCAP-008
+void testPortReadsBothBanks() {
+  InputPort port;
+  const uint8_t pins[] = { 2, 31, 33, 47 };
+  port.begin(pins, 4);
+  ASSERT_EQ_U32(port.lineMask(), 0x0F);
+  ASSERT_EQ_U32(port.read(), 0);
+
+  emuSetPin(31, LOW);
+  emuSetPin(33, LOW);
+  ASSERT_EQ_U32(port.read(), 0x06);
+  ASSERT_EQ_U32(gpioInputBank(0) & (1u << 31), 0);
+  ASSERT_EQ_U32(gpioInputBank(1) & (1u << 1), 0);
+  emuSetPin(31, HIGH);
+  emuSetPin(47, LOW);
+  ASSERT_EQ_U32(port.read(), 0x0C);
+  emuSetPin(33, HIGH);
+  emuSetPin(47, HIGH);
+  ASSERT_EQ_U32(port.read(), 0);
+}
+
+// INCAP-009
+void testMasksGiveEdgesAndHostByte() {
+  static Input input;
+  input.begin();
+  const uint32_t t0 = millis() + 1000;
+
+  input.edge(INPUT_BIT(LINE_BTN3) | INPUT_BIT(LINE_JOY_DOWN), t0 * 1000);
+  input.update(t0 + DEBOUNCE_MS, (t0 + DEBOUNCE_MS) * 1000);
+  InputState s = input.sampleEdgesOnly();
+  ASSERT_TRUE(s.rotLeftPressed && !s.rotRightPressed && !s.holdPressed);
+  ASSERT_TRUE(s.anyButtonPressed);
+  ASSERT_TRUE(s.downHeld && !s.leftHeld && !s.rightHeld);
+  // Host bit order: btn1 btn2 btn3 up down left right btn4
+  ASSERT_EQ_U32(input.held(), 0x14);
+  ASSERT_EQ_U32(input.changed(), 0x14);
+  input.latch();
+
+  s = input.sampleEdgesOnly();
+  ASSERT_TRUE(!s.rotLeftPressed && !s.anyButtonPressed && s.downHeld);
+
+  input.edge(INPUT_BIT(LINE_JOY_DOWN) | INPUT_BIT(LINE_BTN4), (t0 + 100) * 1000);
+  input.update(t0 + 200, (t0 + 200) * 1000);
+  ASSERT_EQ_U32(input.pressed(), 0x80);
+  ASSERT_EQ_U32(input.released(), 0x04);
+  s = input.sampleEdgesOnly();
+  ASSERT_TRUE(s.rotRightPressed && s.anyButtonPressed && !s.rotLeftPressed);
+  input.latch();
+}
+
+// INCAP-010
+void testEventsOldestFirst() {
+  static Input input;
+  input.begin();
+  const uint32_t t0 = millis() + 1000;
+  InputEvent e;
+
+  // Down pressed 3 ms after btn2, both settled by the same pass
+  input.edge(INPUT_BIT(LINE_BTN2), t0 * 1000);
+  input.edge(INPUT_BIT(LINE_BTN2) | INPUT_BIT(LINE_JOY_DOWN), t0 * 1000 + 3000);
+  input.update(t0 + 50, (t0 + 50) * 1000);
+  ASSERT_TRUE(input.popEvent(e));
+  ASSERT_EQ_U32(e.us, t0 * 1000);
+  ASSERT_EQ_U32(e.held, 0x02);
+  ASSERT_TRUE(input.popEvent(e));
+  ASSERT_EQ_U32(e.us, t0 * 1000 + 3000);
+  ASSERT_EQ_U32(e.held, 0x12);
+  ASSERT_TRUE(!input.popEvent(e));
+  input.latch();
+
+  // Releases too; latch() drops what wasn't read
+  input.edge(INPUT_BIT(LINE_JOY_DOWN), (t0 + 100) * 1000);
+  input.update(t0 + 150, (t0 + 150) * 1000);
+  ASSERT_EQ_U32(input.released(), 0x02);
+  input.latch();
+  ASSERT_TRUE(!input.popEvent(e));
+  input.update(t0 + 160, (t0 + 160) * 1000);
+  ASSERT_TRUE(!input.popEvent(e));
+}
+
+// INCAP-011
+void testRepeatPerLine() {
+  static GameInput input;
+  const uint8_t pins[] = { 40, 41, 42 };
+  input.begin(pins, 3, DEBOUNCE_MS);
+  input.setRepeat(0, 100, 20);
+  input.setRepeat(1, 300, 50);
+  const uint32_t t0 = millis() + 1000;
+  input.resetRepeat(t0 - 1000);
+
+  input.edge(0x07, t0 * 1000);
+  input.update(t0 + 20, (t0 + 20) * 1000);
+  uint32_t steps[3] = { 0, 0, 0 };
+  for (uint32_t ms = t0 + 20; ms <= t0 + 400; ++ms) {
+    input.update(ms, ms * 1000);
+    for (uint8_t line = 0; line < 3; ++line) steps[line] += input.repeat(line, ms) ? 1 : 0;
+    input.latch();
+  }
+  // Press, DAS, then ARR up to 400 ms after the press
+  ASSERT_EQ_U32(steps[0], 1 + 1 + (400 - 100) / 20);
+  ASSERT_EQ_U32(steps[1], 1 + 1 + (400 - 300) / 50);
+  // No repeat set: the press only
+  ASSERT_EQ_U32(steps[2], 1);
+}
+
+// INCAP-012
+void testRepeatFasterThanPasses() {
+  static GameInput input;
+  const uint8_t pins[] = { 43, 44 };
+  input.begin(pins, 2, DEBOUNCE_MS);
+  input.setRepeat(0, 100, 5);
+  input.setRepeat(1, 100, 0);
+  const uint32_t t0 = millis() + 1000;
+  input.resetRepeat(t0 - 1000);
+
+  // Both pressed at t0, passes every 16 ms
+  input.edge(0x03, t0 * 1000);
+  uint32_t steps = 0;
+  uint32_t passes = 0;
+  for (uint32_t ms = t0 + 20; ms <= t0 + 260; ms += 16, ++passes) {
+    input.update(ms, ms * 1000);
+    uint8_t n = input.repeat(0, ms);
+    steps += n;
+    uint8_t all = input.repeat(1, ms);
+    // ARR 0: the press, then everything from DAS on
+    ASSERT_TRUE(ms < t0 + 100 ? all == (ms == t0 + 20 ? 1 : 0) : all == INPUT_REPEAT_ALL);
+    input.latch();
+  }
+  // Press, DAS at 100 ms, then one per 5 ms up to the last pass at 260 ms
+  ASSERT_EQ_U32(steps, 1 + 1 + (260 - 100) / 5);
+  ASSERT_TRUE(steps > passes);
+
+  // Releasing ends it
+  input.edge(0, (t0 + 300) * 1000);
+  input.update(t0 + 330, (t0 + 330) * 1000);
+  ASSERT_EQ_U32(input.repeat(0, t0 + 330), 0);
+  ASSERT_EQ_U32(input.repeat(1, t0 + 330), 0);
+}
+
+}  // namespace
+
+int main() {
+  testRingOrderAndOverflow();
+  testRingAcrossThreads();
+  testCaptureRecordsPinChanges();
+  testDebounceOnEdgeTimes();
+  testRepeatCountsFromPress();
+  testDroppedEdgesResync();
+  testVerticalCounterLanes();
+  testPortReadsBothBanks();
+  testMasksGiveEdgesAndHostByte();
+  testEventsOldestFirst();
+  testRepeatPerLine();
+  testRepeatFasterThanPasses();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
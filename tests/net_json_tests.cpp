@@ -0,0 +1,202 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "NetJson.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+std::string base64Url(const std::string& s) {
+  char out[64];
+  size_t n = base64UrlEncode(reinterpret_cast<const uint8_t*>(s.data()), s.size(), out, sizeof(out));
+  return std::string(out, n);
+}
+
+// Every callback as "depth key=value", or "depth }" for a closed object
+struct Events {
+  std::vector<std::string> seen;
+
+  static void record(void* ctx, JsonEvent event, uint8_t depth, const char* key, const char* value) {
+    std::string e = std::to_string(depth) + " ";
+    e += event == JSON_OBJECT_END ? std::string("}") : std::string(key) + "=" + value;
+    static_cast<Events*>(ctx)->seen.push_back(e);
+  }
+};
+
+void scan(JsonScanner& s, Events& ev, const std::string& body, size_t chunk) {
+  s.begin(Events::record, &ev);
+  for (size_t i = 0; i < body.size(); i += chunk) {
+    size_t n = body.size() - i < chunk ? body.size() - i : chunk;
+    s.feed(reinterpret_cast<const uint8_t*>(body.data() + i), n);
+  }
+}
+
+// RFC 4648 section 10 vectors, without padding
+void testBase64UrlVectors() {
+  ASSERT_TRUE(base64Url("") == "");
+  ASSERT_TRUE(base64Url("f") == "Zg");
+  ASSERT_TRUE(base64Url("fo") == "Zm8");
+  ASSERT_TRUE(base64Url("foo") == "Zm9v");
+  ASSERT_TRUE(base64Url("foob") == "Zm9vYg");
+  ASSERT_TRUE(base64Url("fooba") == "Zm9vYmE");
+  ASSERT_TRUE(base64Url("foobar") == "Zm9vYmFy");
+  // The two characters that differ from plain base64
+  ASSERT_TRUE(base64Url("\xfb\xff\xbf") == "-_-_");
+  ASSERT_EQ_U32(base64UrlLength(32), 43);
+
+  char small[5];
+  const uint8_t data[4] = {1, 2, 3, 4};
+  ASSERT_EQ_U32(base64UrlEncode(data, 4, small, sizeof(small)), 0);
+  char exact[7];
+  ASSERT_EQ_U32(base64UrlEncode(data, 4, exact, sizeof(exact)), 6);
+}
+
+void testWriterBuildsRecord() {
+  char buf[128];
+  JsonWriter w(buf, sizeof(buf));
+  const uint8_t sig[3] = {0xfb, 0xff, 0xbf};
+  w.beginObject();
+  w.field("score", 1234L);
+  w.field("game_code", "TETRIS");
+  w.field("ts", -5L);
+  w.fieldBase64Url("sig", sig, sizeof(sig));
+  w.beginArray("none");
+  w.endArray();
+  w.endObject();
+  ASSERT_TRUE(w.ok());
+  ASSERT_TRUE(std::string(w.c_str()) == "{\"score\":1234,\"game_code\":\"TETRIS\",\"ts\":-5,\"sig\":\"-_-_\",\"none\":[]}");
+  ASSERT_EQ_U32(w.length(), std::strlen(buf));
+}
+
+void testWriterEscapesAndNests() {
+  char buf[128];
+  JsonWriter w(buf, sizeof(buf));
+  w.beginObject();
+  w.beginArray("codes");
+  w.beginObject();
+  w.field("s", "a\"b\\c\n");
+  w.endObject();
+  w.beginObject();
+  w.field("n", 0L);
+  w.endObject();
+  w.endArray();
+  w.endObject();
+  ASSERT_TRUE(w.ok());
+  ASSERT_TRUE(std::string(w.c_str()) == "{\"codes\":[{\"s\":\"a\\\"b\\\\c\\u000a\"},{\"n\":0}]}");
+
+  // Unbalanced
+  JsonWriter open(buf, sizeof(buf));
+  open.beginObject();
+  ASSERT_TRUE(!open.ok());
+  JsonWriter extra(buf, sizeof(buf));
+  extra.endArray();
+  ASSERT_TRUE(!extra.ok());
+}
+
+void testWriterOverflowStaysTerminated() {
+  char buf[16];
+  std::memset(buf, 'x', sizeof(buf));
+  JsonWriter w(buf, 12);
+  w.beginObject();
+  w.field("game_code", "TETRIS");
+  w.endObject();
+  ASSERT_TRUE(!w.ok());
+  ASSERT_TRUE(w.length() < 12);
+  ASSERT_EQ_U32(std::strlen(buf), w.length());
+  ASSERT_TRUE(buf[12] == 'x');
+
+  // No room for the signature itself
+  char sigBuf[20];
+  JsonWriter s(sigBuf, sizeof(sigBuf));
+  const uint8_t mac[32] = {0};
+  s.beginObject();
+  s.fieldBase64Url("sig", mac, sizeof(mac));
+  s.endObject();
+  ASSERT_TRUE(!s.ok());
+  ASSERT_EQ_U32(std::strlen(sigBuf), s.length());
+}
+
+void testScannerFindsCodeInAnyChunking() {
+  const std::string body =
+      "{ \"ok\": true, \"n\": -12.5e3, \"code\" : \"ABC123\", \"meta\": {\"code\": \"inner\"}, \"list\": [\"x\", null] }";
+  for (size_t chunk : {1u, 2u, 7u, 1000u}) {
+    JsonScanner s;
+    Events ev;
+    scan(s, ev, body, chunk);
+    ASSERT_TRUE(!s.error());
+    ASSERT_EQ_U32(ev.seen.size(), 5);
+    if (ev.seen.size() != 5) continue;
+    ASSERT_TRUE(ev.seen[0] == "1 code=ABC123");
+    ASSERT_TRUE(ev.seen[1] == "2 code=inner");
+    ASSERT_TRUE(ev.seen[2] == "2 }");
+    ASSERT_TRUE(ev.seen[3] == "2 =x");
+    ASSERT_TRUE(ev.seen[4] == "1 }");
+  }
+}
+
+void testScannerBatchResults() {
+  const std::string body =
+      "{\"results\":[{\"nonce\":\"0123456789abcdef\",\"code\":\"ABC123\"},"
+      "{\"nonce\":\"fedcba9876543210\",\"error\":\"bad \\\"sig\\\" \\u0041\\n\"}]}";
+  JsonScanner s;
+  Events ev;
+  scan(s, ev, body, 3);
+  ASSERT_TRUE(!s.error());
+  ASSERT_EQ_U32(ev.seen.size(), 7);
+  if (ev.seen.size() != 7) return;
+  ASSERT_TRUE(ev.seen[0] == "3 nonce=0123456789abcdef");
+  ASSERT_TRUE(ev.seen[1] == "3 code=ABC123");
+  ASSERT_TRUE(ev.seen[2] == "3 }");
+  ASSERT_TRUE(ev.seen[4] == "3 error=bad \"sig\" A\n");
+  ASSERT_TRUE(ev.seen[5] == "3 }");
+  ASSERT_TRUE(ev.seen[6] == "1 }");
+}
+
+void testScannerLimits() {
+  JsonScanner s;
+  Events ev;
+  scan(s, ev, "{\"code\":\"" + std::string(40, 'Z') + "\",\"a_very_long_member_name\":\"v\"}", 5);
+  ASSERT_TRUE(!s.error());
+  ASSERT_TRUE(s.truncated());
+  ASSERT_EQ_U32(ev.seen.size(), 3);
+  if (ev.seen.size() == 3) {
+    ASSERT_TRUE(ev.seen[0] == "1 code=" + std::string(JSON_VALUE_MAX, 'Z'));
+    ASSERT_TRUE(ev.seen[1] == "1 a_very_long_mem=v");
+  }
+
+  // An error page, and mismatched brackets
+  Events html;
+  scan(s, html, "<html>502</html>", 4);
+  ASSERT_TRUE(html.seen.empty());
+  Events bad;
+  scan(s, bad, "{\"code\":\"X\"]", 4);
+  ASSERT_TRUE(s.error());
+  ASSERT_EQ_U32(bad.seen.size(), 1);
+
+  Events deep;
+  scan(s, deep, std::string(JSON_MAX_DEPTH + 1, '['), 1);
+  ASSERT_TRUE(s.error());
+}
+
+}  // namespace
+
+int main() {
+  testBase64UrlVectors();
+  testWriterBuildsRecord();
+  testWriterEscapesAndNests();
+  testWriterOverflowStaysTerminated();
+  testScannerFindsCodeInAnyChunking();
+  testScannerBatchResults();
+  testScannerLimits();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
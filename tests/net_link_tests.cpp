@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <cstdint>
+
+#include "NetLink.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+// Stands in for Wi-Fi and SNTP: counts calls; the tests deliver the events
+struct FakeDriver {
+  uint32_t joins = 0;
+  uint32_t leaves = 0;
+  uint32_t syncs = 0;
+  bool clockSet = false;
+
+  void join() { joins++; }
+  void leave() { leaves++; }
+  void startTimeSync() { syncs++; }
+  bool timeValid() { return clockSet; }
+};
+
+using Link = NetLink<FakeDriver>;
+
+void testBootJoinsAndSyncs() {
+  FakeDriver d;
+  Link link(d);
+  link.poll(0);
+  ASSERT_EQ_U32(d.joins, 0);  // nothing before begin()
+
+  link.begin(100);
+  ASSERT_EQ_U32(d.joins, 1);
+  ASSERT_EQ_U32(link.state(), LINK_JOINING);
+  link.poll(2000);
+  ASSERT_TRUE(!link.ready());
+
+  link.onConnected();
+  link.poll(2100);
+  ASSERT_EQ_U32(link.state(), LINK_SYNCING);
+  ASSERT_EQ_U32(d.syncs, 1);
+  ASSERT_TRUE(!link.ready());
+
+  link.onTimeSynced();
+  link.poll(2200);
+  ASSERT_TRUE(link.ready());
+  ASSERT_EQ_U32(link.readyCount(), 1);
+
+  // Polling a ready link does nothing
+  for (uint32_t t = 2300; t < 200000; t += 1000) link.poll(t);
+  ASSERT_TRUE(link.ready());
+  ASSERT_EQ_U32(d.joins, 1);
+  ASSERT_EQ_U32(d.syncs, 1);
+  ASSERT_EQ_U32(d.leaves, 0);
+}
+
+void testValidClockSkipsSync() {
+  FakeDriver d;
+  d.clockSet = true;
+  Link link(d);
+  link.begin(0);
+  link.onConnected();
+  link.poll(10);
+  link.poll(20);
+  ASSERT_TRUE(link.ready());
+  ASSERT_EQ_U32(d.syncs, 0);
+}
+
+void testJoinTimeoutBacksOff() {
+  FakeDriver d;
+  Link link(d);
+  link.begin(0);
+
+  // Each failed attempt reports a disconnect; only the timeout gives up
+  link.onDisconnected();
+  link.poll(1000);
+  ASSERT_EQ_U32(link.state(), LINK_JOINING);
+
+  uint32_t now = 0;
+  uint32_t expectedWait = NET_LINK_RETRY_MIN_MS;
+  for (uint32_t attempt = 1; attempt <= 8; ++attempt) {
+    now += NET_LINK_JOIN_TIMEOUT_MS;
+    link.poll(now);
+    ASSERT_EQ_U32(link.state(), LINK_WAIT);
+    ASSERT_EQ_U32(d.leaves, attempt);
+    link.poll(now + expectedWait - 1);
+    ASSERT_EQ_U32(d.joins, attempt);
+    now += expectedWait;
+    link.poll(now);
+    ASSERT_EQ_U32(d.joins, attempt + 1);
+    ASSERT_EQ_U32(link.state(), LINK_JOINING);
+    expectedWait = expectedWait * 2 > NET_LINK_RETRY_MAX_MS ? NET_LINK_RETRY_MAX_MS : expectedWait * 2;
+  }
+  ASSERT_EQ_U32(expectedWait, NET_LINK_RETRY_MAX_MS);
+
+  // A join that works resets the wait for the next drop
+  link.onConnected();
+  d.clockSet = true;
+  link.poll(now + 1);
+  link.poll(now + 2);
+  ASSERT_TRUE(link.ready());
+  link.onDisconnected();
+  link.poll(now + 3);
+  ASSERT_EQ_U32(link.state(), LINK_WAIT);
+  link.poll(now + 3 + NET_LINK_RETRY_MIN_MS);
+  ASSERT_EQ_U32(link.state(), LINK_JOINING);
+}
+
+void testDropAndReconnect() {
+  FakeDriver d;
+  d.clockSet = true;
+  Link link(d);
+  link.begin(0);
+  link.onConnected();
+  link.poll(1);
+  link.poll(2);
+  ASSERT_TRUE(link.ready());
+
+  // Dropped and back before the next poll still counts as a drop
+  link.onDisconnected();
+  link.onConnected();
+  link.poll(3);
+  ASSERT_TRUE(!link.ready());
+  ASSERT_EQ_U32(link.state(), LINK_WAIT);
+  ASSERT_EQ_U32(d.leaves, 1);
+
+  link.poll(3 + NET_LINK_RETRY_MIN_MS);
+  ASSERT_EQ_U32(d.joins, 2);
+  link.poll(3 + NET_LINK_RETRY_MIN_MS + 5);
+  ASSERT_TRUE(!link.ready());  // the old connection's event doesn't count
+  link.onConnected();
+  link.poll(3 + NET_LINK_RETRY_MIN_MS + 10);
+  link.poll(3 + NET_LINK_RETRY_MIN_MS + 11);
+  ASSERT_TRUE(link.ready());
+  ASSERT_EQ_U32(link.readyCount(), 2);
+}
+
+void testBlockedNtpRetriesWithoutRejoining() {
+  FakeDriver d;
+  Link link(d);
+  link.begin(0);
+  link.onConnected();
+  link.poll(10);
+  ASSERT_EQ_U32(d.syncs, 1);
+  link.poll(10 + NET_LINK_SYNC_TIMEOUT_MS);
+  ASSERT_EQ_U32(d.syncs, 2);
+  link.poll(10 + 2 * NET_LINK_SYNC_TIMEOUT_MS);
+  ASSERT_EQ_U32(d.syncs, 3);
+  ASSERT_EQ_U32(link.state(), LINK_SYNCING);
+  ASSERT_EQ_U32(d.joins, 1);
+  ASSERT_EQ_U32(d.leaves, 0);
+
+  // The clock set by some other way counts too
+  d.clockSet = true;
+  link.poll(20 + 2 * NET_LINK_SYNC_TIMEOUT_MS);
+  ASSERT_TRUE(link.ready());
+}
+
+void testDropWhileSyncing() {
+  FakeDriver d;
+  Link link(d);
+  link.begin(0);
+  link.onConnected();
+  link.poll(10);
+  link.onDisconnected();
+  link.onTimeSynced();
+  link.poll(20);
+  ASSERT_EQ_U32(link.state(), LINK_WAIT);
+  ASSERT_TRUE(!link.ready());
+}
+
+}  // namespace
+
+int main() {
+  testBootJoinsAndSyncs();
+  testValidClockSkipsSync();
+  testJoinTimeoutBacksOff();
+  testDropAndReconnect();
+  testBlockedNtpRetriesWithoutRejoining();
+  testDropWhileSyncing();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
@@ -0,0 +1,236 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <LittleFS.h>
+
+#include "ScoreJournal.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+using Journal = ScoreJournal<fs::FS>;
+
+const char* PATH = "/scores.log";
+const char* TMP_PATH = "/scores.tmp";
+
+// A fresh directory mounted as the flash file system
+struct TestFs {
+  fs::FS fs;
+  std::string dir;
+
+  TestFs() {
+    char tmpl[] = "/tmp/pixelgrid_journal_XXXXXX";
+    dir = mkdtemp(tmpl);
+    fs.begin(dir);
+  }
+  ~TestFs() {
+    fs.remove(PATH);
+    fs.remove(TMP_PATH);
+    std::remove(dir.c_str());
+  }
+
+  std::vector<uint8_t> read(const char* path) {
+    std::vector<uint8_t> out;
+    File f = fs.open(path, "r");
+    int c;
+    while (f && (c = f.read()) >= 0) out.push_back(static_cast<uint8_t>(c));
+    return out;
+  }
+  void write(const char* path, const std::vector<uint8_t>& bytes) {
+    File f = fs.open(path, "w");
+    f.write(bytes.data(), bytes.size());
+  }
+};
+
+uint32_t appendScore(Journal& j, uint32_t score) {
+  char nonce[JOURNAL_NONCE_CHARS + 1];
+  std::snprintf(nonce, sizeof(nonce), "%016lx", static_cast<unsigned long>(score * 2654435761u));
+  uint32_t id = 0;
+  ASSERT_TRUE(j.append(score, 1750000000u + score, nonce, id));
+  return id;
+}
+
+void testScoresSurviveRestart() {
+  TestFs t;
+  {
+    Journal j(t.fs, PATH, TMP_PATH);
+    ASSERT_TRUE(j.begin());
+    ASSERT_EQ_U32(j.pending(), 0);
+    ASSERT_EQ_U32(appendScore(j, 120), 1);
+    ASSERT_EQ_U32(appendScore(j, 4500), 2);
+    ASSERT_EQ_U32(appendScore(j, 77), 3);
+  }
+
+  Journal j(t.fs, PATH, TMP_PATH);
+  ASSERT_TRUE(j.begin());
+  ASSERT_EQ_U32(j.pending(), 3);
+  ASSERT_EQ_U32(j.droppedBytes(), 0);
+  JournalScore s[4];
+  ASSERT_EQ_U32(j.peek(s, 4), 3);
+  ASSERT_EQ_U32(s[0].id, 1);
+  ASSERT_EQ_U32(s[0].score, 120);
+  ASSERT_EQ_U32(s[1].score, 4500);
+  ASSERT_EQ_U32(s[1].playedAt, 1750004500u);
+  ASSERT_EQ_U32(s[2].id, 3);
+  ASSERT_TRUE(std::string(s[2].nonce).size() == JOURNAL_NONCE_CHARS);
+  char expected[JOURNAL_NONCE_CHARS + 1];
+  std::snprintf(expected, sizeof(expected), "%016lx", static_cast<unsigned long>(77u * 2654435761u));
+  ASSERT_TRUE(std::string(s[2].nonce) == expected);
+}
+
+void testDoneRetiresInOrder() {
+  TestFs t;
+  Journal j(t.fs, PATH, TMP_PATH);
+  ASSERT_TRUE(j.begin());
+  for (uint32_t i = 1; i <= 5; ++i) appendScore(j, i * 10);
+
+  JournalScore s[2];
+  ASSERT_EQ_U32(j.peek(s, 2), 2);
+  ASSERT_EQ_U32(s[1].id, 2);
+  ASSERT_TRUE(j.markDone(s[1].id));
+  ASSERT_EQ_U32(j.pending(), 3);
+  ASSERT_EQ_U32(j.peek(s, 2), 2);
+  ASSERT_EQ_U32(s[0].id, 3);
+  ASSERT_EQ_U32(s[0].score, 30);
+
+  // Nothing is retired twice, and only ids that exist can be
+  ASSERT_TRUE(!j.markDone(2));
+  ASSERT_TRUE(!j.markDone(6));
+
+  Journal again(t.fs, PATH, TMP_PATH);
+  ASSERT_TRUE(again.begin());
+  ASSERT_EQ_U32(again.pending(), 3);
+  ASSERT_EQ_U32(appendScore(again, 60), 6);
+  ASSERT_TRUE(again.markDone(6));
+  ASSERT_EQ_U32(again.pending(), 0);
+  ASSERT_EQ_U32(again.peek(s, 2), 0);
+}
+
+// Power lost in the middle of an append leaves a partial record at the end
+void testTornTailIsDropped() {
+  TestFs t;
+  {
+    Journal j(t.fs, PATH, TMP_PATH);
+    ASSERT_TRUE(j.begin());
+    appendScore(j, 1);
+    appendScore(j, 2);
+  }
+  std::vector<uint8_t> bytes = t.read(PATH);
+  bytes.resize(bytes.size() - 5);
+  t.write(PATH, bytes);
+
+  {
+    Journal j(t.fs, PATH, TMP_PATH);
+    ASSERT_TRUE(j.begin());
+    ASSERT_EQ_U32(j.pending(), 1);
+    ASSERT_EQ_U32(j.droppedBytes(), JOURNAL_RECORD_MAX - 5);
+    ASSERT_TRUE(!t.fs.exists(TMP_PATH));
+    // The tail is gone from the file, so a new score lands where it is read
+    ASSERT_EQ_U32(appendScore(j, 3), 2);
+  }
+
+  Journal j(t.fs, PATH, TMP_PATH);
+  ASSERT_TRUE(j.begin());
+  ASSERT_EQ_U32(j.droppedBytes(), 0);
+  JournalScore s[4];
+  ASSERT_EQ_U32(j.peek(s, 4), 2);
+  ASSERT_EQ_U32(s[0].score, 1);
+  ASSERT_EQ_U32(s[1].score, 3);
+}
+
+void testCorruptRecordEndsJournal() {
+  TestFs t;
+  {
+    Journal j(t.fs, PATH, TMP_PATH);
+    ASSERT_TRUE(j.begin());
+    for (uint32_t i = 1; i <= 3; ++i) appendScore(j, i);
+  }
+  std::vector<uint8_t> bytes = t.read(PATH);
+  bytes[JOURNAL_RECORD_MAX + 6] ^= 0x01;  // a bit of the second score
+  t.write(PATH, bytes);
+
+  Journal j(t.fs, PATH, TMP_PATH);
+  ASSERT_TRUE(j.begin());
+  ASSERT_EQ_U32(j.pending(), 1);
+  ASSERT_EQ_U32(j.droppedBytes(), 2 * JOURNAL_RECORD_MAX);
+  ASSERT_EQ_U32(j.nextId(), 2);
+}
+
+void testCompactionKeepsIds() {
+  TestFs t;
+  Journal j(t.fs, PATH, TMP_PATH);
+  ASSERT_TRUE(j.begin());
+  uint32_t id = 0;
+  uint32_t largest = 0;
+  for (uint32_t i = 0; i < 200; ++i) {
+    id = appendScore(j, i);
+    largest = j.fileBytes() > largest ? j.fileBytes() : largest;
+    ASSERT_TRUE(j.markDone(id));
+  }
+  ASSERT_TRUE(largest > JOURNAL_COMPACT_BYTES);
+  ASSERT_TRUE(largest <= JOURNAL_COMPACT_BYTES + JOURNAL_RECORD_MAX + JOURNAL_DONE_BYTES + 4);
+  ASSERT_EQ_U32(id, 200);
+
+  // A score still pending is kept through a rewrite
+  uint32_t keep = appendScore(j, 9999);
+  Journal again(t.fs, PATH, TMP_PATH);
+  ASSERT_TRUE(again.begin());
+  ASSERT_EQ_U32(again.nextId(), keep + 1);
+  ASSERT_EQ_U32(again.pending(), 1);
+  ASSERT_TRUE(again.fileBytes() < JOURNAL_COMPACT_BYTES);
+  JournalScore s;
+  ASSERT_EQ_U32(again.peek(&s, 1), 1);
+  ASSERT_EQ_U32(s.id, keep);
+  ASSERT_EQ_U32(s.score, 9999);
+}
+
+void testInterruptedRewriteRecovers() {
+  TestFs t;
+  {
+    Journal j(t.fs, PATH, TMP_PATH);
+    ASSERT_TRUE(j.begin());
+    appendScore(j, 5);
+    appendScore(j, 6);
+  }
+  std::vector<uint8_t> good = t.read(PATH);
+
+  // Cut short before the rename: the journal itself is intact
+  t.write(TMP_PATH, std::vector<uint8_t>(good.begin(), good.begin() + 7));
+  {
+    Journal j(t.fs, PATH, TMP_PATH);
+    ASSERT_TRUE(j.begin());
+    ASSERT_EQ_U32(j.pending(), 2);
+    ASSERT_TRUE(!t.fs.exists(TMP_PATH));
+  }
+
+  // Only the rewritten copy is left
+  t.fs.remove(PATH);
+  t.write(TMP_PATH, good);
+  Journal j(t.fs, PATH, TMP_PATH);
+  ASSERT_TRUE(j.begin());
+  ASSERT_EQ_U32(j.pending(), 2);
+  ASSERT_TRUE(t.fs.exists(PATH));
+  ASSERT_TRUE(!t.fs.exists(TMP_PATH));
+}
+
+}  // namespace
+
+int main() {
+  testScoresSurviveRestart();
+  testDoneRetiresInOrder();
+  testTornTailIsDropped();
+  testCorruptRecordEndsJournal();
+  testCompactionKeepsIds();
+  testInterruptedRewriteRecovers();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
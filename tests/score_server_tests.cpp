@@ -0,0 +1,158 @@
+#include <cstdio>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+#include "DeviceSigner.h"
+#include "NetJson.h"
+#include "ScoreServer.h"
+#include "support/TestAssert.h"
+
+namespace {
+
+using pixelgrid::ScoreResponse;
+using pixelgrid::ScoreServer;
+using pixelgrid::ScoreServerConfig;
+
+int now() { return static_cast<int>(std::time(nullptr)); }
+
+// A record signed the way NetSubmit.h signs one
+std::string record(int score, int ts, const char* nonce, const char* secret = "emulator",
+                   const char* gameCode = "EMU") {
+  char msg[128];
+  size_t len = canonicalDeviceMessage(msg, sizeof(msg), gameCode, score, ts, nonce);
+  DeviceSigner signer;
+  signer.begin(secret);
+  uint8_t mac[SHA256_BYTES];
+  signer.sign(reinterpret_cast<const uint8_t*>(msg), len, mac);
+
+  char buf[256];
+  JsonWriter w(buf, sizeof(buf));
+  w.beginObject();
+  w.field("score", static_cast<long>(score));
+  w.field("game_code", gameCode);
+  w.field("ts", static_cast<long>(ts));
+  w.field("nonce", nonce);
+  w.fieldBase64Url("sig", mac, sizeof(mac));
+  w.endObject();
+  return w.c_str();
+}
+
+bool isCodeBody(const std::string& body) {
+  // {"code":"NNNNNN"}
+  if (body.size() != 17 || body.compare(0, 9, "{\"code\":\"") != 0) return false;
+  for (size_t i = 9; i < 15; ++i) {
+    if (body[i] < '0' || body[i] > '9') return false;
+  }
+  return body.compare(15, 2, "\"}") == 0;
+}
+
+// SERVER-001
+void testAcceptsSignedRecord() {
+  ScoreServer server;
+  ScoreResponse r = server.handle("POST", "/api/codes", record(1234, now(), "0011223344556677"));
+  ASSERT_EQ_U32(r.status, 200);
+  ASSERT_TRUE(isCodeBody(r.body));
+  ASSERT_EQ_U32(server.stats().accepted, 1);
+}
+
+// SERVER-002
+void testRejectsBadSignature() {
+  ScoreServer server;
+  ScoreResponse r = server.handle("POST", "/api/codes", record(1234, now(), "a1", "wrong secret"));
+  ASSERT_EQ_U32(r.status, 401);
+
+  // A signed record with a changed score
+  std::string tampered = record(1234, now(), "a2");
+  tampered.replace(tampered.find("1234"), 4, "9999");
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes", tampered).status, 401);
+  ASSERT_EQ_U32(server.stats().rejected, 2);
+  ASSERT_EQ_U32(server.stats().accepted, 0);
+}
+
+// SERVER-003
+void testTimestampWindow() {
+  ScoreServer server;
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes", record(1, now() - 115, "t1")).status, 200);
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes", record(1, now() + 115, "t2")).status, 200);
+  ScoreResponse stale = server.handle("POST", "/api/codes", record(1, now() - 130, "t3"));
+  ASSERT_EQ_U32(stale.status, 400);
+  ASSERT_TRUE(stale.body.find("timestamp outside window") != std::string::npos);
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes", record(1, now() + 130, "t4")).status, 400);
+
+  ScoreServerConfig skewed;
+  skewed.clockOffsetS = 200;
+  ScoreServer ahead(skewed);
+  ASSERT_EQ_U32(ahead.handle("POST", "/api/codes", record(1, now(), "t5")).status, 400);
+}
+
+// SERVER-004
+void testReplayGetsSameCode() {
+  ScoreServer server;
+  int ts = now();
+  ScoreResponse first = server.handle("POST", "/api/codes", record(50, ts, "replayed"));
+  ScoreResponse again = server.handle("POST", "/api/codes", record(50, ts, "replayed"));
+  ASSERT_EQ_U32(again.status, 200);
+  ASSERT_TRUE(first.body == again.body);
+  ASSERT_EQ_U32(server.stats().accepted, 2);
+  ASSERT_EQ_U32(server.stats().replays, 1);
+}
+
+// SERVER-005
+void testBatchMixedResults() {
+  ScoreServer server;
+  int ts = now();
+  std::string body = "{\"codes\":[" + record(10, ts, "b1") + "," + record(20, ts, "b2", "wrong") + "," +
+                     record(30, ts - 500, "b3") + "]}";
+  ScoreResponse r = server.handle("POST", "/api/codes/batch", body);
+  ASSERT_EQ_U32(r.status, 200);
+  ASSERT_TRUE(r.body.find("{\"nonce\":\"b1\",\"code\":\"") != std::string::npos);
+  ASSERT_TRUE(r.body.find("{\"nonce\":\"b2\",\"error\":\"bad signature\"}") != std::string::npos);
+  ASSERT_TRUE(r.body.find("{\"nonce\":\"b3\",\"error\":\"timestamp outside window\"}") != std::string::npos);
+  ASSERT_EQ_U32(server.stats().accepted, 1);
+  ASSERT_EQ_U32(server.stats().rejected, 2);
+
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes/batch", "{\"codes\":[]}").status, 400);
+}
+
+// SERVER-006
+void testBatchDisabled() {
+  ScoreServerConfig config;
+  config.batch = false;
+  ScoreServer server(config);
+  std::string body = "{\"codes\":[" + record(10, now(), "n1") + "]}";
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes/batch", body).status, 404);
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes", record(10, now(), "n1")).status, 200);
+}
+
+// SERVER-007
+void testMalformedRequests() {
+  ScoreServer server;
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes", "{\"score\":").status, 400);
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes", "[]").status, 400);
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes", "{\"score\":1}").status, 400);
+  ASSERT_EQ_U32(server.handle("POST", "/api/codes", record(1, now(), "g1", "emulator", "XYZ")).status, 400);
+  ASSERT_EQ_U32(server.handle("GET", "/api/codes", "").status, 405);
+  ASSERT_EQ_U32(server.handle("POST", "/api/other", "{}").status, 404);
+  ASSERT_EQ_U32(server.stats().accepted, 0);
+}
+
+}  // namespace
+
+int main() {
+  testAcceptsSignedRecord();
+  testRejectsBadSignature();
+  testTimestampWindow();
+  testReplayGetsSameCode();
+  testBatchMixedResults();
+  testBatchDisabled();
+  testMalformedRequests();
+
+  if (failures == 0) {
+    std::printf("All tests passed.\n");
+    return 0;
+  }
+
+  std::printf("%d test(s) failed.\n", failures);
+  return 1;
+}
@@ -10,5 +10,10 @@ class Adafruit_NeoPixel {
          | static_cast<uint32_t>(b);
   }
 
+  static uint32_t ColorHSV(uint16_t, uint8_t = 255, uint8_t = 255) { return 0; }
+  static uint32_t gamma32(uint32_t x) { return x; }
+
+  uint8_t* getPixels() const { return nullptr; }
+
   void show() {}
 };
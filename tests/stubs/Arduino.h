@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #ifndef INPUT_PULLUP
 #define INPUT_PULLUP 0x2
@@ -11,8 +13,19 @@
 #define LOW 0x0
 #endif
 
+#ifndef CHANGE
+#define CHANGE 0x03
+#endif
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
 inline void pinMode(uint8_t, uint8_t) {}
 inline int digitalRead(uint8_t) { return LOW; }
+inline uint32_t gpioInputBank(uint8_t) { return 0; }
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterruptArg(uint8_t, void (*)(void*), void*, int) {}
 
 inline uint32_t& fakeMillisRef() {
   static uint32_t fakeMillis = 0;
@@ -27,6 +40,10 @@ inline void setMillis(uint32_t value) {
   fakeMillisRef() = value;
 }
 
+inline uint32_t micros() {
+  return fakeMillisRef() * 1000u;
+}
+
 inline long random(long max) {
   return (max > 0) ? 0 : 0;
 }
@@ -5,11 +5,16 @@
 class Pixel_Grid {
  public:
   void setGridCellColour(uint16_t, uint16_t, uint32_t) {}
+  uint16_t numPixels() { return 0; }
   void render() {}
 };
 
 class LCD_Panel {
  public:
   void changeCharArray(const char*) {}
+  void setDigitOnColour(uint16_t, uint32_t) {}
+  void setDigitOffColour(uint16_t, uint32_t) {}
+  void setDigitSegments(uint16_t, uint8_t) {}
+  void setDigitChar(uint16_t, char) {}
   void render() {}
 };
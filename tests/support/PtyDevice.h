@@ -0,0 +1,266 @@
+#pragma once
+// Minimal board stand-in for host-library tests: runs HostParser and the
+// link-control handling from PixelGridcore's HostRuntime.h on the slave end of
+// a pty, in a thread. It can be throttled to emulate a slow link or device.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "FrameCodec.h"
+#include "HostBaud.h"
+#include "HostInput.h"
+#include "HostProtocol.h"
+#include "PacketWriter.h"
+#include "SerialPort.h"
+
+namespace ptydevice {
+
+inline uint32_t nowMs() {
+  using namespace std::chrono;
+  return static_cast<uint32_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+inline int64_t nowUs() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Stream over the slave fd for HostParser::poll(). bytesPerMs > 0 limits how
+// much is handed out per millisecond.
+struct FdStream {
+  int fd = -1;
+  uint32_t bytesPerMs = 0;
+  uint32_t budget = 0;
+  uint32_t lastMs = 0;
+
+  int available() {
+    int n = 0;
+    if (ioctl(fd, FIONREAD, &n) != 0) return 0;
+    if (bytesPerMs == 0) return n;
+
+    uint32_t t = nowMs();
+    budget += (t - lastMs) * bytesPerMs;
+    lastMs = t;
+    if (budget > 4 * bytesPerMs) budget = 4 * bytesPerMs;
+    return n < static_cast<int>(budget) ? n : static_cast<int>(budget);
+  }
+
+  size_t readBytes(char* out, size_t n) {
+    ssize_t got = ::read(fd, out, n);
+    if (got <= 0) return 0;
+    if (bytesPerMs) budget -= static_cast<uint32_t>(got);
+    return static_cast<size_t>(got);
+  }
+};
+
+struct PtyDevice {
+  int fd = -1;
+  HostParser parser;
+  HostBaudSwitch baud;
+  std::atomic<bool> stop{false};
+  std::atomic<uint32_t> lineBaud{HOST_DEFAULT_BAUD};
+
+  // Behaviour, set before start()
+  bool answer = true;          // false: ignores every packet
+  bool ignoreConfirm = false;  // true: PBBC is lost on the way
+  uint8_t dropConfirmAcks = 0; // the first PBBC answers are lost on the way back
+  bool answerStatus = true;    // false: firmware without PBSQ support
+  uint32_t bytesPerMs = 0;     // 0: unthrottled
+  uint32_t clockOffsetUs = 0;  // device micros() = host clock + this
+  // The device stalls this long before answering the next PBSQ; any time
+  std::atomic<uint32_t> stallNextStatusMs{0};
+
+  // What arrived (guarded by mu)
+  std::mutex mu;
+  uint8_t frame[HOST_FRAME_BYTES] = {};
+  bool frameValid = false;
+  uint32_t frames = 0;
+  uint32_t keyframes = 0;      // PBFR and PBDF that don't need a reference
+  std::string lcd;
+  std::vector<uint8_t> hud;
+  uint8_t inputMode = HOST_INPUT_MODE_BYTES;
+  HostInputQueue input;
+  uint8_t inputBits = 0;
+  uint32_t pings = 0;
+
+  uint32_t micros() const { return static_cast<uint32_t>(nowUs()) + clockOffsetUs; }
+
+  void send(uint16_t type, const uint8_t* payload, uint16_t len) {
+    std::vector<uint8_t> pkt = pixelgrid::buildPacket(type, payload, len);
+    ssize_t w = ::write(fd, pkt.data(), pkt.size());
+    (void)w;
+  }
+
+  // Like HostRuntime::reportInput(): a 'b' byte, or an edge queued for the next PBIN
+  void sendInput(uint8_t bits) {
+    std::lock_guard<std::mutex> lock(mu);
+    inputBits = bits;
+    if (inputMode == HOST_INPUT_MODE_REPORTS) {
+      input.note(bits, micros());
+      return;
+    }
+    const uint8_t msg[2] = {'b', bits};
+    ssize_t w = ::write(fd, msg, sizeof(msg));
+    (void)w;
+  }
+
+  void flushInput() {
+    std::lock_guard<std::mutex> lock(mu);
+    if (inputMode != HOST_INPUT_MODE_REPORTS || !input.due(micros())) return;
+    uint8_t report[HOST_INPUT_REPORT_MAX_BYTES];
+    uint16_t len = input.take(micros(), report);
+    send(HOST_PKT_INPUT, report, len);
+  }
+
+  uint8_t rxFrame[HOST_FRAME_BYTES];
+
+  // PBFR and PBDF need more than the parser's scratch buffer
+  static uint8_t* payloadTarget(void* ctx, uint16_t type, uint16_t len, uint16_t& cap) {
+    PtyDevice* d = static_cast<PtyDevice*>(ctx);
+    if ((type == HOST_PKT_FRAME && len == HOST_FRAME_BYTES) ||
+        (type == HOST_PKT_FRAME_DELTA && len <= HOST_FRAME_BYTES)) {
+      cap = sizeof(d->rxFrame);
+      return d->rxFrame;
+    }
+    return nullptr;
+  }
+
+  static void onPacket(void* ctx, uint16_t type, const uint8_t* payload, uint16_t len) {
+    static_cast<PtyDevice*>(ctx)->handle(type, payload, len);
+  }
+
+  void handle(uint16_t type, const uint8_t* payload, uint16_t len) {
+    baud.noteActivity(nowMs());
+    if (!answer) return;
+
+    uint8_t ack[HOST_BAUD_ACK_BYTES];
+    std::lock_guard<std::mutex> lock(mu);
+    switch (type) {
+      case HOST_PKT_BAUD_REQ:
+        if (len == HOST_BAUD_REQ_BYTES) {
+          uint32_t next = baud.request(hostReadU32(payload), nowMs(), ack);
+          send(HOST_PKT_BAUD_ACK, ack, sizeof(ack));
+          if (next) lineBaud = next;
+        }
+        break;
+      case HOST_PKT_BAUD_CONFIRM:
+        if (ignoreConfirm) break;
+        baud.confirm(ack);
+        if (dropConfirmAcks) {
+          dropConfirmAcks--;
+          break;
+        }
+        send(HOST_PKT_BAUD_ACK, ack, sizeof(ack));
+        break;
+      case HOST_PKT_STATUS_REQ:
+        if (uint32_t stall = stallNextStatusMs.exchange(0)) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(stall));
+        }
+        if (answerStatus) {
+          uint8_t st[HOST_STATUS_BYTES + HOST_STATUS_TOKEN_BYTES];
+          hostStatsPayload(parser.stats, st);
+          uint16_t n = HOST_STATUS_BYTES;
+          if (len == HOST_STATUS_TOKEN_BYTES) {
+            std::memcpy(st + n, payload, len);
+            n += len;
+          }
+          send(HOST_PKT_STATUS, st, n);
+        }
+        break;
+      case HOST_PKT_FRAME:
+        if (len != HOST_FRAME_BYTES) break;
+        std::memcpy(frame, payload, len);
+        frameValid = true;
+        frames++;
+        keyframes++;
+        break;
+      case HOST_PKT_FRAME_DELTA:
+        if (len == 0 || (frameEncodingIsDelta(payload[0]) && !frameValid)) break;
+        frameValid = decodeFrame(payload, len, frame, HOST_FRAME_BYTES / 3);
+        if (frameValid) frames++;
+        if (frameValid && !frameEncodingIsDelta(payload[0])) keyframes++;
+        break;
+      case HOST_PKT_INPUT_MODE:
+        if (len != 1) break;
+        inputMode = payload[0];
+        input.reset();
+        input.note(inputBits, micros());
+        break;
+      case HOST_PKT_PING:
+        if (len == HOST_PING_BYTES) {
+          uint8_t pong[HOST_PONG_BYTES];
+          hostPongPayload(payload, micros(), pong);
+          send(HOST_PKT_PONG, pong, sizeof(pong));
+          pings++;
+        }
+        break;
+      case HOST_PKT_LCD_TEXT:
+        lcd.assign(reinterpret_cast<const char*>(payload), len);
+        break;
+      case HOST_PKT_HUD_7SEG:
+        hud.assign(payload, payload + len);
+        break;
+    }
+  }
+
+  void run() {
+    HostParserCallbacks cb;
+    cb.ctx = this;
+    cb.payloadTarget = payloadTarget;
+    cb.onPacket = onPacket;
+    parser.begin(cb);
+    baud.reset(nowMs());
+
+    FdStream s;
+    s.fd = fd;
+    s.bytesPerMs = bytesPerMs;
+    s.lastMs = nowMs();
+    while (!stop) {
+      uint32_t fallback = baud.poll(nowMs());
+      if (fallback) lineBaud = fallback;
+      parser.poll(s);
+      flushInput();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+};
+
+// Host port on the pty master, device thread on the slave
+struct Link {
+  pixelgrid::SerialPort host;
+  PtyDevice device;
+  std::thread thread;
+
+  bool open() {
+    std::string slave;
+    if (!host.openPty(slave)) return false;
+    device.fd = ::open(slave.c_str(), O_RDWR | O_NOCTTY);
+    if (device.fd < 0) return false;
+    termios tio;
+    tcgetattr(device.fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(device.fd, TCSANOW, &tio);
+    return true;
+  }
+
+  void start() { thread = std::thread([this] { device.run(); }); }
+
+  ~Link() {
+    device.stop = true;
+    if (thread.joinable()) thread.join();
+    if (device.fd >= 0) ::close(device.fd);
+  }
+};
+
+}  // namespace ptydevice
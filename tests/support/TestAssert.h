@@ -0,0 +1,62 @@
+#pragma once
+// Assertion helpers shared by the single-file test programs. A failed check
+// prints the expression and its location and counts towards `failures`,
+// which main() reports once every test has run.
+
+#include <cstdint>
+#include <cstdio>
+
+inline int failures = 0;
+
+inline void assertTrue(bool value, const char* expr, const char* file, int line) {
+  if (!value) {
+    std::printf("FAIL: %s (%s:%d)\n", expr, file, line);
+    ++failures;
+  }
+}
+
+inline void assertEqU32(uint32_t actual, uint32_t expected, const char* expr, const char* file, int line) {
+  if (actual != expected) {
+    std::printf("FAIL: %s expected %lu got %lu (%s:%d)\n", expr,
+                static_cast<unsigned long>(expected),
+                static_cast<unsigned long>(actual),
+                file, line);
+    ++failures;
+  }
+}
+
+inline void assertEqU16(uint16_t actual, uint16_t expected, const char* expr, const char* file, int line) {
+  if (actual != expected) {
+    std::printf("FAIL: %s expected %u got %u (%s:%d)\n", expr,
+                static_cast<unsigned>(expected),
+                static_cast<unsigned>(actual),
+                file, line);
+    ++failures;
+  }
+}
+
+inline void assertEqU8(uint8_t actual, uint8_t expected, const char* expr, const char* file, int line) {
+  if (actual != expected) {
+    std::printf("FAIL: %s expected %u got %u (%s:%d)\n", expr,
+                static_cast<unsigned>(expected),
+                static_cast<unsigned>(actual),
+                file, line);
+    ++failures;
+  }
+}
+
+inline void assertEqI32(int32_t actual, int32_t expected, const char* expr, const char* file, int line) {
+  if (actual != expected) {
+    std::printf("FAIL: %s expected %ld got %ld (%s:%d)\n", expr,
+                static_cast<long>(expected),
+                static_cast<long>(actual),
+                file, line);
+    ++failures;
+  }
+}
+
+#define ASSERT_TRUE(expr) assertTrue((expr), #expr, __FILE__, __LINE__)
+#define ASSERT_EQ_U32(actual, expected) assertEqU32((actual), (expected), #actual, __FILE__, __LINE__)
+#define ASSERT_EQ_U16(actual, expected) assertEqU16((actual), (expected), #actual, __FILE__, __LINE__)
+#define ASSERT_EQ_U8(actual, expected) assertEqU8((actual), (expected), #actual, __FILE__, __LINE__)
+#define ASSERT_EQ_I32(actual, expected) assertEqI32((actual), (expected), #actual, __FILE__, __LINE__)
@@ -2,48 +2,10 @@
 #include <cstdint>
 
 #include "Game.h"
+#include "support/TestAssert.h"
 
 namespace {
 
-int failures = 0;
-
-void assertTrue(bool value, const char* expr, const char* file, int line) {
-  if (!value) {
-    std::printf("FAIL: %s (%s:%d)\n", expr, file, line);
-    ++failures;
-  }
-}
-
-void assertEqU32(uint32_t actual, uint32_t expected, const char* expr, const char* file, int line) {
-  if (actual != expected) {
-    std::printf("FAIL: %s expected %lu got %lu (%s:%d)\n", expr,
-                static_cast<unsigned long>(expected),
-                static_cast<unsigned long>(actual),
-                file, line);
-    ++failures;
-  }
-}
-
-void assertEqU8(uint8_t actual, uint8_t expected, const char* expr, const char* file, int line) {
-  if (actual != expected) {
-    std::printf("FAIL: %s expected %u got %u (%s:%d)\n", expr,
-                static_cast<unsigned>(expected),
-                static_cast<unsigned>(actual),
-                file, line);
-    ++failures;
-  }
-}
-
-void assertEqU16(uint16_t actual, uint16_t expected, const char* expr, const char* file, int line) {
-  if (actual != expected) {
-    std::printf("FAIL: %s expected %u got %u (%s:%d)\n", expr,
-                static_cast<unsigned>(expected),
-                static_cast<unsigned>(actual),
-                file, line);
-    ++failures;
-  }
-}
-
 uint16_t countFilled(const TetrisGame& game) {
   uint16_t count = 0;
   for (uint8_t y = 0; y < PLAY_H; ++y) {
@@ -58,11 +20,6 @@ uint16_t countFilled(const TetrisGame& game) {
 
 }  // namespace
 
-#define ASSERT_TRUE(expr) assertTrue((expr), #expr, __FILE__, __LINE__)
-#define ASSERT_EQ_U32(actual, expected) assertEqU32((actual), (expected), #actual, __FILE__, __LINE__)
-#define ASSERT_EQ_U16(actual, expected) assertEqU16((actual), (expected), #actual, __FILE__, __LINE__)
-#define ASSERT_EQ_U8(actual, expected) assertEqU8((actual), (expected), #actual, __FILE__, __LINE__)
-
 void testValidAtBounds() {
   TetrisGame game{};
   game.clearBoard();
@@ -156,6 +113,39 @@ void testSoftDropDelay() {
   ASSERT_EQ_U16(delay, SOFT_DROP_MIN_MS);
 }
 
+void testSlideStopsAtWallsAndBlocks() {
+  TetrisGame game{};
+  game.clearBoard();
+  game.curPiece.type = 1;  // O, columns 1-2 of its box
+  game.curPiece.rot = 0;
+  game.curX = 4;
+  game.curY = 5;
+
+  ASSERT_TRUE(game.slideX(-2) == -2);
+  ASSERT_TRUE(game.curX == 2);
+  // Further than the wall: stops against it
+  ASSERT_TRUE(game.slideX(-W) == -3);
+  ASSERT_TRUE(game.curX == -1);
+  ASSERT_TRUE(game.slideX(-1) == 0);
+  ASSERT_TRUE(game.slideX(W) == W - 2);
+  ASSERT_TRUE(game.curX == W - 3);
+
+  // A block beside the lower row stops it, without passing through
+  game.board[6][3] = 1;
+  ASSERT_TRUE(game.slideX(-W) == -(W - 3 - 3));
+  ASSERT_TRUE(game.curX == 3);
+  ASSERT_TRUE(game.validAt(game.curX, game.curY, game.curPiece.rot));
+
+  // A vertical I sits in the third column of its box
+  game.clearBoard();
+  game.curPiece.type = 0;
+  game.curPiece.rot = 1;
+  game.curX = 3;
+  ASSERT_TRUE(game.slideX(-W) == -5);
+  ASSERT_TRUE(game.curX == -2);
+  ASSERT_TRUE(game.validAt(game.curX, game.curY, game.curPiece.rot));
+}
+
 int main() {
   testValidAtBounds();
   testClearLinesSingle();
@@ -164,6 +154,7 @@ int main() {
   testHoldLocksAfterUse();
   testLockOnFailedMoveDown();
   testSoftDropDelay();
+  testSlideStopsAtWallsAndBlocks();
 
   if (failures == 0) {
     std::printf("All tests passed.\n");